@@ -38,6 +38,7 @@ static void syntax(void)
     printf("                        (JPEG only; not applicable to y4m)\n");
     printf("    --no-strict       : Disable strict decoding, which disables strict validation checks and errors\n");
     printf("    -i,--info         : Decode all frames and display all image information instead of saving to disk\n");
+    printf("    --progressive     : Decode each layer of a progressive (layered) image as its own frame (with --info)\n");
     printf("    --ignore-icc      : If the input file contains an embedded ICC profile, ignore it (no-op if absent)\n");
     printf("\n");
     avifPrintVersions();
@@ -54,6 +55,7 @@ int main(int argc, char * argv[])
     avifBool infoOnly = AVIF_FALSE;
     avifChromaUpsampling chromaUpsampling = AVIF_CHROMA_UPSAMPLING_AUTOMATIC;
     avifBool ignoreICC = AVIF_FALSE;
+    avifBool allowProgressive = AVIF_FALSE;
     avifBool rawColor = AVIF_FALSE;
     avifStrictFlags strictFlags = AVIF_STRICT_ENABLED;
 
@@ -130,6 +132,8 @@ int main(int argc, char * argv[])
             infoOnly = AVIF_TRUE;
         } else if (!strcmp(arg, "--ignore-icc")) {
             ignoreICC = AVIF_TRUE;
+        } else if (!strcmp(arg, "--progressive")) {
+            allowProgressive = AVIF_TRUE;
         } else {
             // Positional argument
             if (!inputFilename) {
@@ -161,6 +165,7 @@ int main(int argc, char * argv[])
         decoder->maxThreads = jobs;
         decoder->codecChoice = codecChoice;
         decoder->strictFlags = strictFlags;
+        decoder->allowProgressive = allowProgressive;
         avifResult result = avifDecoderSetIOFile(decoder, inputFilename);
         if (result != AVIF_RESULT_OK) {
             fprintf(stderr, "Cannot open file for read: %s\n", inputFilename);
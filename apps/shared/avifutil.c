@@ -115,6 +115,7 @@ void avifImageDump(avifImage * avif, uint32_t gridCols, uint32_t gridRows)
 void avifContainerDump(avifDecoder * decoder)
 {
     avifImageDumpInternal(decoder->image, 0, 0, decoder->alphaPresent);
+    printf(" * Progressive    : %s\n", avifProgressiveStateToString(decoder->progressiveState));
 }
 
 void avifPrintVersions(void)
@@ -465,6 +465,16 @@ AVIF_API void avifImageAllocatePlanes(avifImage * image, avifPlanesFlags planes)
 AVIF_API void avifImageFreePlanes(avifImage * image, avifPlanesFlags planes);     // Ignores already-freed planes
 AVIF_API void avifImageStealPlanes(avifImage * dstImage, avifImage * srcImage, avifPlanesFlags planes);
 
+// Makes dstImage a view of the rect region of srcImage, without copying any pixel: dstImage's planes
+// point into srcImage's planes, with srcImage's row bytes, and dstImage doesn't own them
+// (imageOwnsYUVPlanes and imageOwnsAlphaPlane are AVIF_FALSE). Any planes dstImage owned are freed
+// first. The other properties of srcImage (depth, format, CICP, transforms...) are copied, but not
+// its ICC profile, Exif or XMP, which dstImage keeps as they were. rect must be non-empty and lie
+// within srcImage, and rect->x and rect->y must be multiples of the chroma subsampling, or
+// AVIF_RESULT_INVALID_ARGUMENT is returned. srcImage's planes must outlive the view; dstImage is
+// destroyed with avifImageDestroy() as usual.
+AVIF_API avifResult avifImageSetViewRect(avifImage * dstImage, const avifImage * srcImage, const avifCropRect * rect);
+
 // ---------------------------------------------------------------------------
 // Understanding maxThreads
 //
@@ -477,17 +487,39 @@ AVIF_API void avifImageStealPlanes(avifImage * dstImage, avifImage * srcImage, a
 // As an important example, when encoding an image sequence that has an alpha channel, two
 // long-lived underlying AV1 encoders must simultaneously exist (one for color, one for alpha). For
 // each additional frame fed into libavif, its YUV planes are fed into one instance of the AV1
-// encoder, and its alpha plane is fed into another. These operations happen serially, so only one
-// of these AV1 encoders is ever active at a time. However, the AV1 encoders might pre-create a
-// pool of worker threads upon initialization, so during this process, twice the amount of worker
-// threads actually simultaneously exist on the machine, but half of them are guaranteed to be
-// sleeping.
+// encoder, and its alpha plane is fed into another. These operations run concurrently, each AV1
+// encoder being given its share of maxThreads (half of them here). However, the AV1 encoders might
+// pre-create a pool of worker threads upon initialization, so more threads than maxThreads might
+// simultaneously exist on the machine, though no more than maxThreads of them are ever busy.
 //
 // This design ensures that AV1 implementations are given as many threads as possible to ensure a
-// speedy encode or decode, despite the complexities of occasionally needing two AV1 codec instances
-// (due to alpha payloads being separate from color payloads). If your system has a hard ceiling on
-// the number of threads that can ever be in flight at a given time, please account for this
-// accordingly.
+// speedy encode or decode, despite the complexities of occasionally needing several AV1 codec
+// instances (due to alpha payloads being separate from color payloads, and to grid cells). If your
+// system has a hard ceiling on the number of threads that can ever be in flight at a given time,
+// please account for this accordingly.
+
+// ---------------------------------------------------------------------------
+// avifThreadPool
+//
+// Without a thread pool, each decoder and every AV1 codec instance of an encoder uses up to the
+// maxThreads it was given, so a process running many decoders and encoders at once can create far
+// more threads than there are cores. A pool shared by any number of decoders and encoders (see
+// avifDecoder.threadPool and avifEncoder.threadPool) caps their threads as a whole: when it
+// creates its codecs, a decoder or encoder reserves up to maxThreads of the pool's maxThreads and
+// splits what it got between its codecs, and gives them back when the codecs are destroyed. When
+// the pool is exhausted, it gets a single thread (the calling one).
+//
+// A decoder spreads its threads over the tiles of the image first (the cells of a grid, and the
+// color and alpha items), decoding them concurrently on the pool's worker threads, and gives what
+// is left to each tile's codec, up to what the size of a tile can keep busy. Without a pool, a
+// decoder with maxThreads > 1 creates one of its own for images made of several tiles. An encoder
+// does the same with the AV1 items of each frame (the cells of a grid, the alpha and thumbnail
+// items), encoding them concurrently.
+//
+// The pool must outlive the decoders and encoders using it.
+typedef struct avifThreadPool avifThreadPool;
+AVIF_API avifThreadPool * avifThreadPoolCreate(int maxThreads);
+AVIF_API void avifThreadPoolDestroy(avifThreadPool * threadPool);
 
 // ---------------------------------------------------------------------------
 // Optional YUV<->RGB support
@@ -501,15 +533,17 @@ AVIF_API void avifImageStealPlanes(avifImage * dstImage, avifImage * srcImage, a
 
 // avifImageRGBToYUV() and avifImageYUVToRGB() will perform depth rescaling and limited<->full range
 // conversion, if necessary. Pixels in an avifRGBImage buffer are always full range, and conversion
-// routines will fail if the width and height don't match the associated avifImage.
+// routines will fail if the width and height don't match the associated avifImage (with the
+// exception of avifImageYUVToRGB() downscaling, see avifRGBImage.downscaling).
 
 // If libavif is built with libyuv fast paths enabled, libavif will use libyuv for conversion from
 // YUV to RGB if the following requirements are met:
 //
-// * YUV depth: 8
+// * YUV depth: 8, or 10 (420/422, and 444 with libyuv 1780 or later)
 // * RGB depth: 8
 // * rgb.chromaUpsampling: AVIF_CHROMA_UPSAMPLING_AUTOMATIC, AVIF_CHROMA_UPSAMPLING_FASTEST
-// * rgb.format: AVIF_RGB_FORMAT_RGBA, AVIF_RGB_FORMAT_BGRA (420/422 support for AVIF_RGB_FORMAT_ABGR, AVIF_RGB_FORMAT_ARGB)
+// * rgb.width and rgb.height match the avifImage (no downscaling)
+// * rgb.format: AVIF_RGB_FORMAT_RGBA, AVIF_RGB_FORMAT_BGRA, AVIF_RGB_FORMAT_ABGR, AVIF_RGB_FORMAT_ARGB
 // * CICP is one of the following combinations (CP/TC/MC/Range):
 //   * x/x/[2|5|6]/Full
 //   * [5|6]/x/12/Full
@@ -537,10 +571,21 @@ typedef enum avifChromaUpsampling
     AVIF_CHROMA_UPSAMPLING_BILINEAR = 4      // Uses bilinear filter (built-in)
 } avifChromaUpsampling;
 
+// Filters available to avifImageYUVToRGB() when the avifRGBImage is smaller than the avifImage.
+// Filtering happens on the converted RGB values (after chroma upsampling), so no full size RGB
+// buffer is ever needed. Color is weighted by alpha while filtering.
+typedef enum avifDownscaling
+{
+    AVIF_DOWNSCALING_NONE = 0,     // rgb->width and rgb->height must match the avifImage
+    AVIF_DOWNSCALING_NEAREST = 1,  // Picks the input pixel under each output pixel's center (fastest)
+    AVIF_DOWNSCALING_BILINEAR = 2, // Interpolates the 4 input pixels around each output pixel's center
+    AVIF_DOWNSCALING_BOX = 3       // Averages all input pixels covered by each output pixel (area filter, best quality)
+} avifDownscaling;
+
 typedef struct avifRGBImage
 {
-    uint32_t width;       // must match associated avifImage
-    uint32_t height;      // must match associated avifImage
+    uint32_t width;       // must match associated avifImage, unless downscaling is enabled (see below)
+    uint32_t height;      // must match associated avifImage, unless downscaling is enabled (see below)
     uint32_t depth;       // legal depths [8, 10, 12, 16]. if depth>8, pixels must be uint16_t internally
     avifRGBFormat format; // all channels are always full range
     avifChromaUpsampling chromaUpsampling; // Defaults to AVIF_CHROMA_UPSAMPLING_AUTOMATIC: How to upsample non-4:4:4 UV (ignored for 444) when converting to RGB.
@@ -551,6 +596,10 @@ typedef struct avifRGBImage
 
     uint8_t * pixels;
     uint32_t rowBytes;
+
+    avifDownscaling downscaling; // Defaults to AVIF_DOWNSCALING_NONE. Otherwise, width and height may be set smaller than the
+                                 // avifImage's (but not zero), and avifImageYUVToRGB() scales down to them while converting.
+                                 // Unused when converting to YUV.
 } avifRGBImage;
 
 // Sets rgb->width, rgb->height, and rgb->depth to image->width, image->height, and image->depth.
@@ -567,6 +616,16 @@ AVIF_API void avifRGBImageFreePixels(avifRGBImage * rgb);
 AVIF_API avifResult avifImageRGBToYUV(avifImage * image, const avifRGBImage * rgb);
 AVIF_API avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb);
 
+// avifRGBConverter: avifImageYUVToRGB() for repeated conversions (e.g. every frame of an animation).
+// avifImageYUVToRGB() derives its lookup tables and coefficients from the avifImage's depth, format,
+// range, CICP and alpha settings and the avifRGBImage's depth, format and alpha settings on every call.
+// A converter keeps them around (off the stack) and only rebuilds them when one of those changes, so
+// the only per-call work left is the conversion itself. Results are identical to avifImageYUVToRGB().
+typedef struct avifRGBConverter avifRGBConverter;
+AVIF_API avifRGBConverter * avifRGBConverterCreate(void);
+AVIF_API void avifRGBConverterDestroy(avifRGBConverter * converter);
+AVIF_API avifResult avifRGBConverterYUVToRGB(avifRGBConverter * converter, const avifImage * image, avifRGBImage * rgb);
+
 // Premultiply handling functions.
 // (Un)premultiply is automatically done by the main conversion functions above,
 // so usually you don't need to call these. They are there for convenience.
@@ -673,7 +732,8 @@ typedef struct avifIO
     // If true, *all* memory regions returned from *all* calls to read are guaranteed to be
     // persistent and exist for the lifetime of the avifIO object. If false, libavif will make
     // in-memory copies of samples and metadata content, and a memory region returned from read must
-    // only persist until the next call to read.
+    // only persist until the next call to read. Copies of image sequence samples are released as soon
+    // as they are decoded, and read again if the same frame is decoded again (e.g. after seeking).
     avifBool persistent;
 
     // The contents of this are defined by the avifIO implementation, and should be fully destroyed
@@ -735,10 +795,29 @@ typedef enum avifDecoderSource
     // This is where avifs image sequences store their images.
     AVIF_DECODER_SOURCE_TRACKS,
 
-    // Decode the thumbnail item. Currently unimplemented.
-    // AVIF_DECODER_SOURCE_THUMBNAIL_ITEM
+    // Use the thumbnail item ('thmb' reference to the primary item) and its aux (alpha) item, if any.
+    // Never chosen by AVIF_DECODER_SOURCE_AUTO.
+    AVIF_DECODER_SOURCE_THUMBNAIL_ITEM
 } avifDecoderSource;
 
+// Progressive (layered) decoding of a single image. See avifDecoder.allowProgressive.
+typedef enum avifProgressiveState
+{
+    // The primary item isn't layered (no a1lx property), so it can only be decoded as a single image.
+    AVIF_PROGRESSIVE_STATE_UNAVAILABLE = 0,
+
+    // The primary item is layered, but decoder->allowProgressive is false, so it is decoded as a
+    // single image (its highest quality layer).
+    AVIF_PROGRESSIVE_STATE_AVAILABLE,
+
+    // The primary item is layered and decoder->allowProgressive is true. decoder->imageCount is the
+    // number of layers, and each avifDecoderNextImage() call refines decoder->image with the next
+    // layer. The first layer only needs the first layer's bytes, so when streaming (see
+    // AVIF_RESULT_WAITING_ON_IO) a preview can be shown well before the whole file has arrived.
+    AVIF_PROGRESSIVE_STATE_ACTIVE
+} avifProgressiveState;
+AVIF_API const char * avifProgressiveStateToString(avifProgressiveState progressiveState);
+
 // Information about the timing of a single image in an image sequence
 typedef struct avifImageTiming
 {
@@ -749,6 +828,24 @@ typedef struct avifImageTiming
     uint64_t durationInTimescales; // duration in "timescales"
 } avifImageTiming;
 
+// Allocator for the memory that decoded frames are written into (see
+// avifDecoder.frameBufferAllocator). Each frame buffer a codec needs is a block obtained from
+// alloc(), in which the codec lays out the planes itself, and which is given back with release()
+// once the codec no longer references it. The planes of decoder->image point into these blocks.
+// A block is never released before the frame it holds has stopped being decoder->image, so a
+// caller that defers reusing released blocks can keep decoded frames without avifImageCopy().
+//
+// alloc() returns at least size bytes aligned to alignment (a power of two), or NULL to fail the
+// decode. Both functions may be called from the codecs' worker threads and must be thread-safe.
+typedef void * (*avifFrameBufferAllocFunc)(void * userData, size_t size, size_t alignment);
+typedef void (*avifFrameBufferReleaseFunc)(void * userData, void * buffer);
+typedef struct avifFrameBufferAllocator
+{
+    avifFrameBufferAllocFunc alloc;
+    avifFrameBufferReleaseFunc release;
+    void * userData;
+} avifFrameBufferAllocator;
+
 typedef struct avifDecoder
 {
     // Defaults to AVIF_CODEC_CHOICE_AUTO: Preference determined by order in availableCodecs table (avif.c)
@@ -793,7 +890,9 @@ typedef struct avifDecoder
     // These can be useful if your avifIO implementation heavily uses AVIF_RESULT_WAITING_ON_IO for
     // streaming data, as some of these payloads are (unfortunately) packed at the end of the file,
     // which will cause avifDecoderParse() to return AVIF_RESULT_WAITING_ON_IO until it finds them.
-    // If you don't actually leverage this data, it is best to ignore it here.
+    // If you don't actually leverage this data, it is best to ignore it here. Ignored Exif and XMP
+    // items are never requested from the avifIO. Use avifDecoderReadMetadata() to fetch them later
+    // on. (Properties libavif doesn't know are always skipped.) See also ignoreICC below.
     avifBool ignoreExif;
     avifBool ignoreXMP;
 
@@ -806,6 +905,34 @@ typedef struct avifDecoder
     // Strict flags. Defaults to AVIF_STRICT_DISABLED. See avifStrictFlag definitions above.
     avifStrictFlags strictFlags;
 
+    // If true and maxThreads > 1, image sequences are decoded with frame parallelism by the codecs
+    // supporting it (libgav1): the upcoming frames are handed to the codec ahead of time and decode
+    // concurrently while the current one is in use. This favors the throughput of playing a
+    // sequence with avifDecoderNextImage() over the latency of any single frame (and of seeking).
+    // Defaults to AVIF_FALSE.
+    avifBool frameParallel;
+
+    // If alloc is set, the codecs (dav1d, libaom, libgav1) decode into blocks obtained from this
+    // allocator instead of into memory of their own. The codecs pick it up when they are created,
+    // so set it before the first decode. See avifFrameBufferAllocator. Defaults to all NULL.
+    avifFrameBufferAllocator frameBufferAllocator;
+
+    // If set, the threads of this decoder's codecs are reserved from this pool, and grid tiles are
+    // decoded concurrently on its worker threads. Not owned by the decoder. See avifThreadPool.
+    avifThreadPool * threadPool;
+
+    // If true, a layered (a1lx) primary item without a layer selector (lsel) is decoded one layer
+    // per avifDecoderNextImage() call instead of as a single image. Defaults to AVIF_FALSE.
+    avifBool allowProgressive;
+
+    // Set by avifDecoderParse(). See avifProgressiveState.
+    avifProgressiveState progressiveState;
+
+    // Like ignoreExif and ignoreXMP, for the ICC profile. An ignored ICC profile still arrives with
+    // the meta box it is stored in, but isn't copied into the avifImage. Use avifDecoderReadMetadata()
+    // to fetch it later on. Defaults to AVIF_FALSE.
+    avifBool ignoreICC;
+
     // stats from the most recent read, possibly 0s if reading an image sequence
     avifIOStats ioStats;
 
@@ -862,6 +989,25 @@ AVIF_API avifResult avifDecoderNextImage(avifDecoder * decoder);
 AVIF_API avifResult avifDecoderNthImage(avifDecoder * decoder, uint32_t frameIndex);
 AVIF_API avifResult avifDecoderReset(avifDecoder * decoder);
 
+// Decoder index - avifDecoderParse() spends most of its time reading and walking the ftyp, meta and
+// moov boxes and building item and sample tables from them. After a successful avifDecoderParse(),
+// avifDecoderExportIndex() serializes that parsed state into outIndex (free it with avifRWDataFree()).
+// Passing it to avifDecoderParseWithIndex() (in place of avifDecoderParse(), with the IO already set)
+// restores it without parsing any boxes, then resets the decoder exactly like avifDecoderParse().
+//
+// The index records the size of the file (avifIO's sizeHint) and a hash of the boxes it was built
+// from, which avifDecoderParseWithIndex() checks against the decoder's IO; this still reads those
+// boxes, but doesn't parse them. If the index doesn't match the file, or was written by a different
+// build of libavif, AVIF_RESULT_INVALID_ARGUMENT is returned and the caller should fall back to
+// avifDecoderParse(). An index is not meant to be shared across libavif versions or platforms.
+//
+// An index must only come from a trusted source, such as a cache the application wrote itself: it
+// ends with a hash of its contents, which catches truncated or corrupted indices, and the fields the
+// decoder relies on are checked again when it is restored, but it is otherwise trusted like the
+// parsed state it replaces and is not validated as thoroughly as a file passed to avifDecoderParse().
+AVIF_API avifResult avifDecoderExportIndex(const avifDecoder * decoder, avifRWData * outIndex);
+AVIF_API avifResult avifDecoderParseWithIndex(avifDecoder * decoder, const avifROData * index);
+
 // Keyframe information
 // frameIndex - 0-based, matching avifDecoder->imageIndex, bound by avifDecoder->imageCount
 // "nearest" keyframe means the keyframe prior to this frame index (returns frameIndex if it is a keyframe)
@@ -869,10 +1015,49 @@ AVIF_API avifResult avifDecoderReset(avifDecoder * decoder);
 AVIF_API avifBool avifDecoderIsKeyframe(const avifDecoder * decoder, uint32_t frameIndex);
 AVIF_API uint32_t avifDecoderNearestKeyframe(const avifDecoder * decoder, uint32_t frameIndex);
 
+// Reads the ICC profile, Exif and XMP of the image being decoded into image (typically
+// decoder->image), regardless of ignoreICC, ignoreExif and ignoreXMP. This allows deferring the
+// metadata until it turns out to be needed: its Exif and XMP items are only requested from the
+// avifIO at this point, so this may return AVIF_RESULT_WAITING_ON_IO.
+// This function may be used after a successful call (AVIF_RESULT_OK) to avifDecoderParse().
+AVIF_API avifResult avifDecoderReadMetadata(avifDecoder * decoder, avifImage * image);
+
 // Timing helper - This does not change the current image or invoke the codec (safe to call repeatedly)
 // This function may be used after a successful call (AVIF_RESULT_OK) to avifDecoderParse().
 AVIF_API avifResult avifDecoderNthImageTiming(const avifDecoder * decoder, uint32_t frameIndex, avifImageTiming * outTiming);
 
+// Bounded-memory alternative to avifDecoderNextImage() + avifImageYUVToRGB(). This decodes the next
+// image and hands it to rowsFunc as consecutive strips of RGB rows (top to bottom), so that a full
+// size avifRGBImage never has to be allocated. For grid images, the tiles are read, decoded
+// (concurrently, as in avifDecoderNextImage()) and converted one row of tiles at a time, so the
+// canvas is never assembled. Once a row has been copied out, its tiles' codecs, decoded frames and
+// sample data are released (the first tile is kept until the end, to check the other tiles against),
+// so memory is about one row of tiles worth of compressed and decoded data plus one strip of RGB,
+// regardless of the size of the canvas.
+//
+// Set up rgb with avifRGBImageSetDefaults(rgb, decoder->image) after avifDecoderParse() and adjust
+// its format/depth/etc as usual; rgb->pixels is not used (the strip buffer is owned by the decoder
+// and is only valid during the callback). On success, rgb->width and rgb->height are set to the
+// size of the decoded image. rowIndex is the canvas row of the first row in pixels, and rowCount
+// the number of rows in the strip. Returning anything but AVIF_RESULT_OK from rowsFunc aborts the
+// decode and is passed back to the caller.
+//
+// Notes:
+// * For grid images, decoder->image only receives the image's properties; its planes are left empty.
+// * If this fails or returns AVIF_RESULT_WAITING_ON_IO part way through a grid image, the tiles
+//   released so far are decoded again by the next call, which starts over from the first row.
+// * Chroma upsampling is done per strip, so AVIF_CHROMA_UPSAMPLING_BILINEAR treats strip boundaries
+//   as image edges.
+typedef avifResult (*avifRGBRowsFunc)(void * userData,
+                                      uint32_t rowIndex,
+                                      const uint8_t * pixels,
+                                      uint32_t rowBytes,
+                                      uint32_t rowCount);
+AVIF_API avifResult avifDecoderNextImageRGBRows(avifDecoder * decoder,
+                                                avifRGBImage * rgb,
+                                                avifRGBRowsFunc rowsFunc,
+                                                void * userData);
+
 // ---------------------------------------------------------------------------
 // avifExtent
 
@@ -912,6 +1097,9 @@ struct avifCodecSpecificOptions;
 // * Quality range: [AVIF_QUANTIZER_BEST_QUALITY - AVIF_QUANTIZER_WORST_QUALITY]
 // * To enable tiling, set tileRowsLog2 > 0 and/or tileColsLog2 > 0.
 //   Tiling values range [0-6], where the value indicates a request for 2^n tiles in that dimension.
+//   If autoTiling is true, tileRowsLog2 and tileColsLog2 are ignored and the tiling of each AV1
+//   item is chosen from its size and the encoder's threads: about one tile per thread, but no
+//   tile smaller than 512x512 pixels, as small tiles cost quality and size.
 // * Speed range: [AVIF_SPEED_SLOWEST - AVIF_SPEED_FASTEST]. Slower should make for a better quality
 //   image in less bytes. AVIF_SPEED_DEFAULT means "Leave the AV1 codec to its default speed settings"./
 //   If avifEncoder uses rav1e, the speed value is directly passed through (0-10). If libaom is used,
@@ -933,6 +1121,48 @@ typedef struct avifEncoder
     int keyframeInterval; // How many frames between automatic forced keyframes; 0 to disable (default).
     uint64_t timescale;   // timescale of the media (Hz)
 
+    // Number of additional, higher quality spatial layers to encode each single (non-grid) image
+    // item with, in the range [0-3]. When non-zero, every AV1 item is written as a layered image
+    // (with an a1lx property) whose first layer is a coarse, low quality version of the image, and
+    // the layers of the color and alpha items are interleaved in the mdat so that the first layer
+    // of both arrives first. See avifDecoder.allowProgressive. Only supported by libaom, which
+    // encodes layers in its realtime mode, at most at the speed of avifEncoder.speed 8; 0 to
+    // disable (default).
+    int extraLayerCount;
+
+    // If non-zero, single image encodes larger than this also store a thumbnail item (referencing the
+    // primary item via 'thmb') downscaled so that its longest side is thumbnailSize pixels. Images with
+    // premultiplied alpha are not given a thumbnail. Decode it with AVIF_DECODER_SOURCE_THUMBNAIL_ITEM.
+    // 0 to disable (default).
+    uint32_t thumbnailSize;
+
+    // If non-zero, avifEncoderAddImage() calls without AVIF_ADD_IMAGE_FLAG_SINGLE copy the image into
+    // a queue of up to asyncQueueSize frames and return right away; the frames are encoded in order
+    // on a worker thread, so that the caller can decode or convert the next frame in the meantime.
+    // avifEncoderAddImage() only blocks while the queue is full. An error hit on the worker thread is
+    // returned by the next avifEncoderAddImage() call, or by avifEncoderFinish(), which waits for the
+    // queue to drain. Encoder settings must not be changed while frames are queued. 0 to encode on
+    // the calling thread (default).
+    uint32_t asyncQueueSize;
+
+    // If non-zero, single images (AVIF_ADD_IMAGE_FLAG_SINGLE, as with avifEncoderWrite()) wider or
+    // taller than gridCellSize pixels are split into a grid of cells of at most gridCellSize x
+    // gridCellSize pixels (128 at least), encoded concurrently (see avifThreadPool). The cells point
+    // into the image's planes; only the bottom and right cells are copied, when the image can't be
+    // split evenly and they have to be padded. If autoTiling is true and gridCellSize is 0, images
+    // larger than what AV1 allows in a frame (level 6.3) are split into cells of 4096 pixels. Images
+    // that can't make a valid grid (less than 64 pixels in a dimension, odd dimensions when chroma is
+    // subsampled) are encoded whole. 0 to disable (default).
+    uint32_t gridCellSize;
+
+    // If set, the threads of this encoder's codecs are reserved from this pool. Not owned by the
+    // encoder. See avifThreadPool.
+    avifThreadPool * threadPool;
+
+    // If true, tileRowsLog2 and tileColsLog2 are ignored and the tiling of each AV1 item is chosen
+    // from its size (see Notes above). Defaults to AVIF_FALSE.
+    avifBool autoTiling;
+
     // stats from the most recent write
     avifIOStats ioStats;
 
@@ -997,6 +1227,32 @@ AVIF_API avifBool avifImageUsesU16(const avifImage * image);
 // either the brand 'avif' or 'avis' (or both), without performing any allocations.
 AVIF_API avifBool avifPeekCompatibleFileType(const avifROData * input);
 
+// Basic properties of an AVIF file, as reported by avifPeekImageInfo().
+typedef struct avifImageInfo
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    avifPixelFormat yuvFormat;
+    avifBool alphaPresent;
+    uint32_t imageCount;  // 1 for still images
+    uint32_t gridRows;    // 0 unless the primary item is a grid
+    uint32_t gridColumns; // 0 unless the primary item is a grid
+
+    // On AVIF_RESULT_OK, how many bytes from the start of input were needed to fill in this struct.
+    // On AVIF_RESULT_TRUNCATED_DATA, the minimum input size to retry with; the retry may in turn ask
+    // for more (e.g. when a box header had to be read to learn the size of the box).
+    size_t bytesNeeded;
+} avifImageInfo;
+
+// Fills in info from the ftyp and meta/moov boxes at the beginning of input, without performing any
+// allocations or creating any codecs. The same item and track selection as avifDecoderParse() (with
+// AVIF_DECODER_SOURCE_AUTO) is used, but far less is validated, so a successful peek doesn't
+// guarantee that decoding will succeed. Returns AVIF_RESULT_TRUNCATED_DATA (and sets
+// info->bytesNeeded) if input doesn't contain enough of the file, which makes it possible to probe a
+// file with one or two small ranged reads.
+AVIF_API avifResult avifPeekImageInfo(const avifROData * input, avifImageInfo * info);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
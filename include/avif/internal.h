@@ -65,6 +65,11 @@ void * avifArrayPushPtr(void * arrayStruct);
 void avifArrayPush(void * arrayStruct, void * element);
 void avifArrayDestroy(void * arrayStruct);
 
+// Makes view a shallow copy of image (metadata included) whose planes point into the width x height
+// region at (x, y) of image's planes, with image's row bytes. x and y must be multiples of the
+// chroma subsampling. The view doesn't own any of it, so it must not be given to avifImageDestroy().
+void avifImageSetView(avifImage * view, const avifImage * image, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
 typedef struct avifAlphaParams
 {
     uint32_t width;
@@ -89,6 +94,10 @@ typedef struct avifAlphaParams
 avifBool avifFillAlpha(const avifAlphaParams * const params);
 avifBool avifReformatAlpha(const avifAlphaParams * const params);
 
+// (Un)premultiplies a single row of width 4-channel pixels (interleaved per format) in place.
+void avifRGBRowPremultiplyAlpha(uint8_t * row, uint32_t width, uint32_t depth, avifRGBFormat format);
+void avifRGBRowUnpremultiplyAlpha(uint8_t * row, uint32_t width, uint32_t depth, avifRGBFormat format);
+
 typedef enum avifReformatMode
 {
     AVIF_REFORMAT_MODE_YUV_COEFFICIENTS = 0, // Normal YUV conversion using coefficients
@@ -155,6 +164,45 @@ avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb);
 avifResult avifRGBImagePremultiplyAlphaLibYUV(avifRGBImage * rgb);
 avifResult avifRGBImageUnpremultiplyAlphaLibYUV(avifRGBImage * rgb);
 
+// ---------------------------------------------------------------------------
+// Threads (thread.c): pthreads, or Win32 threads on Windows
+
+typedef struct avifThread avifThread;
+typedef struct avifMutex avifMutex;
+typedef struct avifCond avifCond;
+typedef void (*avifThreadFunc)(void * userData);
+
+// Returns NULL if the thread can't be started; callers are expected to fall back to doing the work
+// on the calling thread.
+avifThread * avifThreadCreate(avifThreadFunc func, void * userData);
+void avifThreadJoin(avifThread * thread); // Waits for the thread to return, then frees it
+avifMutex * avifMutexCreate(void);
+void avifMutexDestroy(avifMutex * mutex);
+void avifMutexLock(avifMutex * mutex);
+void avifMutexUnlock(avifMutex * mutex);
+avifCond * avifCondCreate(void);
+void avifCondDestroy(avifCond * cond);
+void avifCondWait(avifCond * cond, avifMutex * mutex);
+void avifCondSignal(avifCond * cond);
+void avifCondBroadcast(avifCond * cond);
+
+// avifThreadPool (see avif.h). avifThreadPoolReserve() takes up to wanted threads out of the pool's
+// budget for the lifetime of a decoder's or encoder's codecs, and returns how many it took (possibly
+// 0, in which case the caller works on its own thread only). Give them back with
+// avifThreadPoolRelease().
+int avifThreadPoolReserve(avifThreadPool * threadPool, int wanted);
+void avifThreadPoolRelease(avifThreadPool * threadPool, int count);
+
+// Calls func(userData, index) for every index in [0, count), on the calling thread and on up to
+// (maxConcurrency - 1) of the pool's workers at once, and returns once all calls have returned.
+// With a NULL threadPool, all calls are made on the calling thread.
+typedef void (*avifThreadPoolTaskFunc)(void * userData, uint32_t index);
+void avifThreadPoolRun(avifThreadPool * threadPool,
+                       uint32_t count,
+                       uint32_t maxConcurrency,
+                       avifThreadPoolTaskFunc func,
+                       void * userData);
+
 // ---------------------------------------------------------------------------
 // avifCodecDecodeInput
 
@@ -165,16 +213,26 @@ typedef struct avifDecodeSample
     avifBool partialData; // if true, data exists but doesn't have all of the sample in it
 
     uint32_t itemID; // if non-zero, data comes from a mergedExtents buffer in an avifDecoderItem, not a file offset
-    uint64_t offset; // used only when itemID is zero, ignored and set to 0 when itemID is non-zero
+    uint64_t offset; // file offset when itemID is zero, otherwise offset into the item (non-zero for later layers of a layered item)
     size_t size;
     avifBool sync; // is sync sample (keyframe)
+
+    avifBool selectSpatialLayer; // if true, the codec only outputs the frame of spatial layer spatialID (lsel)
+    uint8_t spatialID;
 } avifDecodeSample;
 AVIF_ARRAY_DECLARE(avifDecodeSampleArray, avifDecodeSample, sample);
 
+struct avifSampleTable;
+
 typedef struct avifCodecDecodeInput
 {
+    // For image sequences, samples holds only the most recently requested sample (sampleIndex), which
+    // is resolved on demand from sampleTable instead of expanding the whole table up front.
     avifDecodeSampleArray samples;
-    avifBool alpha; // if true, this is decoding an alpha plane
+    const struct avifSampleTable * sampleTable; // owned by the track; NULL for items
+    uint32_t sampleIndex;
+    avifBool alpha;     // if true, this is decoding an alpha plane
+    avifBool allLayers; // if true, the codec must output every spatial layer (progressive layers or lsel)
 } avifCodecDecodeInput;
 
 avifCodecDecodeInput * avifCodecDecodeInputCreate(void);
@@ -220,6 +278,12 @@ struct avifCodecInternal;
 
 typedef avifBool (*avifCodecOpenFunc)(struct avifCodec * codec, avifDecoder * decoder); // decode only
 typedef avifBool (*avifCodecGetNextImageFunc)(struct avifCodec * codec, const avifDecodeSample * sample, avifBool alpha, avifImage * image);
+// Optional, decode only. Hands the codec an upcoming sample of an image sequence, which getNextImage()
+// will later be called with, so that the codec can start decoding it while the current frame is in
+// use. Samples are prefetched in order, at most lookahead of them past the one last given to
+// getNextImage(). The sample data is only valid during the call. Returning AVIF_FALSE (e.g. when
+// the codec's queue is full) just stops prefetching for now.
+typedef avifBool (*avifCodecPrefetchFunc)(struct avifCodec * codec, const avifDecodeSample * sample);
 // EncodeImage and EncodeFinish are not required to always emit a sample, but when all images are
 // encoded and EncodeFinish is called, the number of samples emitted must match the number of submitted frames.
 // avifCodecEncodeImageFunc may return AVIF_RESULT_UNKNOWN_ERROR to automatically emit the appropriate
@@ -241,9 +305,17 @@ typedef struct avifCodec
     struct avifCodecInternal * internal;  // up to each codec to use how it wants
                                           //
     avifDiagnostics * diag;               // Shallow copy; owned by avifEncoder or avifDecoder
+    uint8_t operatingPoint;               // Decoding only; the AV1 operating point to decode (a1op)
+    avifBool allLayers;                   // Decoding only; if true, output every spatial layer instead of only the highest one
+    avifBool imageSequence;               // Decoding only; if true, the samples are the frames of a track
+    uint32_t lookahead;                   // Decoding only; set by open() if the codec accepts samples through prefetch
+    int maxThreads;                       // Threads the codec may use; set before open() or the first encodeImage()
+    int tileRowsLog2;                     // Encoding only; the AV1 tiling, from the avifEncoder or chosen by autoTiling
+    int tileColsLog2;                     //
 
     avifCodecOpenFunc open;
     avifCodecGetNextImageFunc getNextImage;
+    avifCodecPrefetchFunc prefetch;
     avifCodecEncodeImageFunc encodeImage;
     avifCodecEncodeFinishFunc encodeFinish;
     avifCodecDestroyInternalFunc destroyInternal;
@@ -276,10 +348,16 @@ void avifDiagnosticsPrintf(avifDiagnostics * diag, const char * format, ...);
 
 typedef size_t avifBoxMarker;
 
+// Packs a four-character code (box type, property type, ...) into a big-endian uint32_t, the same
+// value avifBoxHeader.fourcc holds, so that box types can be dispatched with a switch.
+#define AVIF_FOURCC(a, b, c, d) \
+    (((uint32_t)(uint8_t)(a) << 24) | ((uint32_t)(uint8_t)(b) << 16) | ((uint32_t)(uint8_t)(c) << 8) | (uint32_t)(uint8_t)(d))
+
 typedef struct avifBoxHeader
 {
     size_t size;
     uint8_t type[4];
+    uint32_t fourcc; // type as an AVIF_FOURCC() value
 } avifBoxHeader;
 
 typedef struct avifROStream
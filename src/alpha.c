@@ -6,6 +6,11 @@
 #include <assert.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define AVIF_ALPHA_SSE2
+#include <emmintrin.h>
+#endif
+
 static int calcMaxChannel(uint32_t depth, avifRange range)
 {
     int maxChannel = (int)((1 << depth) - 1);
@@ -39,347 +44,353 @@ avifBool avifFillAlpha(const avifAlphaParams * const params)
     return AVIF_TRUE;
 }
 
-// Note: The [limited -> limited] paths are here for completeness, but in practice those
-//       paths will never be used, as avifRGBImage is always full range.
-avifBool avifReformatAlpha(const avifAlphaParams * const params)
+// Converts a single alpha value as described by params. Used to build the lookup table in
+// avifReformatAlpha(), so it is only ever called once per possible source value.
+static int avifReformatAlphaValue(const avifAlphaParams * const params, int srcAlpha)
 {
-    const int srcMaxChannel = (1 << params->srcDepth) - 1;
-    const int dstMaxChannel = (1 << params->dstDepth) - 1;
-    const float srcMaxChannelF = (float)srcMaxChannel;
-    const float dstMaxChannelF = (float)dstMaxChannel;
-
     if (params->srcDepth == params->dstDepth) {
         // no depth rescale
+        if ((params->srcRange == AVIF_RANGE_LIMITED) && (params->dstRange == AVIF_RANGE_FULL)) {
+            return avifLimitedToFullY(params->srcDepth, srcAlpha);
+        }
+        if ((params->srcRange == AVIF_RANGE_FULL) && (params->dstRange == AVIF_RANGE_LIMITED)) {
+            return avifFullToLimitedY(params->dstDepth, srcAlpha);
+        }
+        return srcAlpha;
+    }
 
-        if ((params->srcRange == AVIF_RANGE_FULL) && (params->dstRange == AVIF_RANGE_FULL)) {
-            // no depth rescale, no range conversion
-
-            if (params->srcDepth > 8) {
-                // no depth rescale, no range conversion, uint16_t -> uint16_t
+    // depth rescale
+    const int dstMaxChannel = (1 << params->dstDepth) - 1;
+    if (params->srcRange == AVIF_RANGE_LIMITED) {
+        srcAlpha = avifLimitedToFullY(params->srcDepth, srcAlpha);
+    }
+    float alphaF = (float)srcAlpha / (float)((1 << params->srcDepth) - 1);
+    int dstAlpha = (int)(0.5f + (alphaF * (float)dstMaxChannel));
+    dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
+    if (params->dstRange == AVIF_RANGE_LIMITED) {
+        dstAlpha = avifFullToLimitedY(params->dstDepth, dstAlpha);
+    }
+    return dstAlpha;
+}
 
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                    }
+// Note: The [limited -> limited] paths are here for completeness, but in practice those
+//       paths will never be used, as avifRGBImage is always full range.
+avifBool avifReformatAlpha(const avifAlphaParams * const params)
+{
+    if ((params->srcDepth == params->dstDepth) && (params->srcRange == params->dstRange)) {
+        // no depth rescale, no range conversion: a plain (possibly strided) copy
+
+        if (params->srcDepth > 8) {
+            for (uint32_t j = 0; j < params->height; ++j) {
+                uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
+                uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
+                if ((params->srcPixelBytes == 2) && (params->dstPixelBytes == 2)) {
+                    memcpy(dstRow, srcRow, params->width * 2);
+                    continue;
                 }
-            } else {
-                // no depth rescale, no range conversion, uint8_t -> uint8_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        dstRow[i * params->dstPixelBytes] = srcRow[i * params->srcPixelBytes];
-                    }
+                for (uint32_t i = 0; i < params->width; ++i) {
+                    *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
                 }
             }
-        } else if ((params->srcRange == AVIF_RANGE_LIMITED) && (params->dstRange == AVIF_RANGE_FULL)) {
-            // limited -> full
-
-            if (params->srcDepth > 8) {
-                // no depth rescale, limited -> full, uint16_t -> uint16_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        int srcAlpha = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                        int dstAlpha = avifLimitedToFullY(params->srcDepth, srcAlpha);
-                        *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = (uint16_t)dstAlpha;
-                    }
+        } else {
+            for (uint32_t j = 0; j < params->height; ++j) {
+                uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
+                uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
+                if ((params->srcPixelBytes == 1) && (params->dstPixelBytes == 1)) {
+                    memcpy(dstRow, srcRow, params->width);
+                    continue;
                 }
-            } else {
-                // no depth rescale, limited -> full, uint8_t -> uint8_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        int srcAlpha = srcRow[i * params->srcPixelBytes];
-                        int dstAlpha = avifLimitedToFullY(params->srcDepth, srcAlpha);
-                        dstRow[i * params->dstPixelBytes] = (uint8_t)dstAlpha;
-                    }
+                for (uint32_t i = 0; i < params->width; ++i) {
+                    dstRow[i * params->dstPixelBytes] = srcRow[i * params->srcPixelBytes];
                 }
             }
-        } else if ((params->srcRange == AVIF_RANGE_FULL) && (params->dstRange == AVIF_RANGE_LIMITED)) {
-            // full -> limited
-
-            if (params->srcDepth > 8) {
-                // no depth rescale, full -> limited, uint16_t -> uint16_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        int srcAlpha = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                        int dstAlpha = avifFullToLimitedY(params->dstDepth, srcAlpha);
-                        *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = (uint16_t)dstAlpha;
-                    }
-                }
-            } else {
-                // no depth rescale, full -> limited, uint8_t -> uint8_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        int srcAlpha = srcRow[i * params->srcPixelBytes];
-                        int dstAlpha = avifFullToLimitedY(params->dstDepth, srcAlpha);
-                        dstRow[i * params->dstPixelBytes] = (uint8_t)dstAlpha;
-                    }
+        }
+        return AVIF_TRUE;
+    }
+
+    // Every other depth/range combination is a pure function of the source value, so evaluate it
+    // once per possible source value and leave only a table lookup in the per-pixel loops. Source
+    // values beyond the maximum for srcDepth clamp to it, which every conversion above would do anyway.
+    const uint16_t srcMaxChannel = (uint16_t)((1 << params->srcDepth) - 1);
+    uint16_t * table = (uint16_t *)avifAlloc(sizeof(uint16_t) * ((size_t)srcMaxChannel + 1));
+    for (int v = 0; v <= srcMaxChannel; ++v) {
+        table[v] = (uint16_t)avifReformatAlphaValue(params, v);
+    }
+
+    if (params->srcDepth > 8) {
+        if (params->dstDepth > 8) {
+            // uint16_t -> uint16_t
+            for (uint32_t j = 0; j < params->height; ++j) {
+                uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
+                uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
+                for (uint32_t i = 0; i < params->width; ++i) {
+                    const uint16_t srcAlpha = AVIF_MIN(*((uint16_t *)&srcRow[i * params->srcPixelBytes]), srcMaxChannel);
+                    *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = table[srcAlpha];
                 }
             }
-        } else if ((params->srcRange == AVIF_RANGE_LIMITED) && (params->dstRange == AVIF_RANGE_LIMITED)) {
-            // limited -> limited
-
-            if (params->srcDepth > 8) {
-                // no depth rescale, limited -> limited, uint16_t -> uint16_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                    }
-                }
-            } else {
-                // no depth rescale, limited -> limited, uint8_t -> uint8_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        dstRow[i * params->dstPixelBytes] = srcRow[i * params->srcPixelBytes];
-                    }
+        } else {
+            // uint16_t -> uint8_t
+            for (uint32_t j = 0; j < params->height; ++j) {
+                uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
+                uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
+                for (uint32_t i = 0; i < params->width; ++i) {
+                    const uint16_t srcAlpha = AVIF_MIN(*((uint16_t *)&srcRow[i * params->srcPixelBytes]), srcMaxChannel);
+                    dstRow[i * params->dstPixelBytes] = (uint8_t)table[srcAlpha];
                 }
             }
         }
-
     } else {
-        // depth rescale
-
-        if ((params->srcRange == AVIF_RANGE_FULL) && (params->dstRange == AVIF_RANGE_FULL)) {
-            // depth rescale, no range conversion
-
-            if (params->srcDepth > 8) {
-                if (params->dstDepth > 8) {
-                    // depth rescale, no range conversion, uint16_t -> uint16_t
-
-                    for (uint32_t j = 0; j < params->height; ++j) {
-                        uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                        uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                        for (uint32_t i = 0; i < params->width; ++i) {
-                            int srcAlpha = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                            float alphaF = (float)srcAlpha / srcMaxChannelF;
-                            int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                            dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                            *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = (uint16_t)dstAlpha;
-                        }
-                    }
-                } else {
-                    // depth rescale, no range conversion, uint16_t -> uint8_t
-
-                    for (uint32_t j = 0; j < params->height; ++j) {
-                        uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                        uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                        for (uint32_t i = 0; i < params->width; ++i) {
-                            int srcAlpha = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                            float alphaF = (float)srcAlpha / srcMaxChannelF;
-                            int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                            dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                            dstRow[i * params->dstPixelBytes] = (uint8_t)dstAlpha;
-                        }
-                    }
-                }
-            } else {
-                // depth rescale, no range conversion, uint8_t -> uint16_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        int srcAlpha = srcRow[i * params->srcPixelBytes];
-                        float alphaF = (float)srcAlpha / srcMaxChannelF;
-                        int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                        dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                        *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = (uint16_t)dstAlpha;
-                    }
+        if (params->dstDepth > 8) {
+            // uint8_t -> uint16_t
+            for (uint32_t j = 0; j < params->height; ++j) {
+                uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
+                uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
+                for (uint32_t i = 0; i < params->width; ++i) {
+                    *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = table[srcRow[i * params->srcPixelBytes]];
                 }
-
-                // If (srcDepth == 8), dstDepth must be >8 otherwise we'd be in the (params->srcDepth == params->dstDepth) block above.
-                // assert(params->dstDepth > 8);
             }
-        } else if ((params->srcRange == AVIF_RANGE_LIMITED) && (params->dstRange == AVIF_RANGE_FULL)) {
-            // limited -> full
-
-            if (params->srcDepth > 8) {
-                if (params->dstDepth > 8) {
-                    // depth rescale, limited -> full, uint16_t -> uint16_t
-
-                    for (uint32_t j = 0; j < params->height; ++j) {
-                        uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                        uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                        for (uint32_t i = 0; i < params->width; ++i) {
-                            int srcAlpha = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                            srcAlpha = avifLimitedToFullY(params->srcDepth, srcAlpha);
-                            float alphaF = (float)srcAlpha / srcMaxChannelF;
-                            int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                            dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                            *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = (uint16_t)dstAlpha;
-                        }
-                    }
-                } else {
-                    // depth rescale, limited -> full, uint16_t -> uint8_t
-
-                    for (uint32_t j = 0; j < params->height; ++j) {
-                        uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                        uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                        for (uint32_t i = 0; i < params->width; ++i) {
-                            int srcAlpha = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                            srcAlpha = avifLimitedToFullY(params->srcDepth, srcAlpha);
-                            float alphaF = (float)srcAlpha / srcMaxChannelF;
-                            int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                            dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                            dstRow[i * params->dstPixelBytes] = (uint8_t)dstAlpha;
-                        }
-                    }
-                }
-            } else {
-                // depth rescale, limited -> full, uint8_t -> uint16_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        int srcAlpha = srcRow[i * params->srcPixelBytes];
-                        srcAlpha = avifLimitedToFullY(params->srcDepth, srcAlpha);
-                        float alphaF = (float)srcAlpha / srcMaxChannelF;
-                        int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                        dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                        *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = (uint16_t)dstAlpha;
-                    }
+        } else {
+            // uint8_t -> uint8_t (range conversion only)
+            for (uint32_t j = 0; j < params->height; ++j) {
+                uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
+                uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
+                for (uint32_t i = 0; i < params->width; ++i) {
+                    dstRow[i * params->dstPixelBytes] = (uint8_t)table[srcRow[i * params->srcPixelBytes]];
                 }
-
-                // If (srcDepth == 8), dstDepth must be >8 otherwise we'd be in the (params->srcDepth == params->dstDepth) block above.
-                // assert(params->dstDepth > 8);
             }
-        } else if ((params->srcRange == AVIF_RANGE_FULL) && (params->dstRange == AVIF_RANGE_LIMITED)) {
-            // full -> limited
-
-            if (params->srcDepth > 8) {
-                if (params->dstDepth > 8) {
-                    // depth rescale, full -> limited, uint16_t -> uint16_t
-
-                    for (uint32_t j = 0; j < params->height; ++j) {
-                        uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                        uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                        for (uint32_t i = 0; i < params->width; ++i) {
-                            int srcAlpha = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                            float alphaF = (float)srcAlpha / srcMaxChannelF;
-                            int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                            dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                            dstAlpha = avifFullToLimitedY(params->dstDepth, dstAlpha);
-                            *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = (uint16_t)dstAlpha;
-                        }
-                    }
-                } else {
-                    // depth rescale, full -> limited, uint16_t -> uint8_t
-
-                    for (uint32_t j = 0; j < params->height; ++j) {
-                        uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                        uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                        for (uint32_t i = 0; i < params->width; ++i) {
-                            int srcAlpha = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                            float alphaF = (float)srcAlpha / srcMaxChannelF;
-                            int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                            dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                            dstAlpha = avifFullToLimitedY(params->dstDepth, dstAlpha);
-                            dstRow[i * params->dstPixelBytes] = (uint8_t)dstAlpha;
-                        }
-                    }
-                }
-            } else {
-                // depth rescale, full -> limited, uint8_t -> uint16_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        int srcAlpha = srcRow[i * params->srcPixelBytes];
-                        float alphaF = (float)srcAlpha / srcMaxChannelF;
-                        int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                        dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                        dstAlpha = avifFullToLimitedY(params->dstDepth, dstAlpha);
-                        *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = (uint16_t)dstAlpha;
-                    }
-                }
+        }
+    }
 
-                // If (srcDepth == 8), dstDepth must be >8 otherwise we'd be in the (params->srcDepth == params->dstDepth) block above.
-                // assert(params->dstDepth > 8);
-            }
-        } else if ((params->srcRange == AVIF_RANGE_LIMITED) && (params->dstRange == AVIF_RANGE_LIMITED)) {
-            // limited -> limited
-
-            if (params->srcDepth > 8) {
-                if (params->dstDepth > 8) {
-                    // depth rescale, limited -> limited, uint16_t -> uint16_t
-
-                    for (uint32_t j = 0; j < params->height; ++j) {
-                        uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                        uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                        for (uint32_t i = 0; i < params->width; ++i) {
-                            int srcAlpha = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                            srcAlpha = avifLimitedToFullY(params->srcDepth, srcAlpha);
-                            float alphaF = (float)srcAlpha / srcMaxChannelF;
-                            int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                            dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                            dstAlpha = avifFullToLimitedY(params->dstDepth, dstAlpha);
-                            *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = (uint16_t)dstAlpha;
-                        }
-                    }
-                } else {
-                    // depth rescale, limited -> limited, uint16_t -> uint8_t
-
-                    for (uint32_t j = 0; j < params->height; ++j) {
-                        uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                        uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                        for (uint32_t i = 0; i < params->width; ++i) {
-                            int srcAlpha = *((uint16_t *)&srcRow[i * params->srcPixelBytes]);
-                            srcAlpha = avifLimitedToFullY(params->srcDepth, srcAlpha);
-                            float alphaF = (float)srcAlpha / srcMaxChannelF;
-                            int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                            dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                            dstAlpha = avifFullToLimitedY(params->dstDepth, dstAlpha);
-                            dstRow[i * params->dstPixelBytes] = (uint8_t)dstAlpha;
-                        }
-                    }
-                }
-            } else {
-                // depth rescale, limited -> limited, uint8_t -> uint16_t
-
-                for (uint32_t j = 0; j < params->height; ++j) {
-                    uint8_t * srcRow = &params->srcPlane[params->srcOffsetBytes + (j * params->srcRowBytes)];
-                    uint8_t * dstRow = &params->dstPlane[params->dstOffsetBytes + (j * params->dstRowBytes)];
-                    for (uint32_t i = 0; i < params->width; ++i) {
-                        int srcAlpha = srcRow[i * params->srcPixelBytes];
-                        srcAlpha = avifLimitedToFullY(params->srcDepth, srcAlpha);
-                        float alphaF = (float)srcAlpha / srcMaxChannelF;
-                        int dstAlpha = (int)(0.5f + (alphaF * dstMaxChannelF));
-                        dstAlpha = AVIF_CLAMP(dstAlpha, 0, dstMaxChannel);
-                        dstAlpha = avifFullToLimitedY(params->dstDepth, dstAlpha);
-                        *((uint16_t *)&dstRow[i * params->dstPixelBytes]) = (uint16_t)dstAlpha;
-                    }
-                }
+    avifFree(table);
+    return AVIF_TRUE;
+}
 
-                // If (srcDepth == 8), dstDepth must be >8 otherwise we'd be in the (params->srcDepth == params->dstDepth) block above.
-                // assert(params->dstDepth > 8);
-            }
+// The (un)premultiply helpers below are branch-free, and give the same results as round(c * a / max)
+// and round(c * max / a) (halves up, clamped to max) would:
+//
+// * Premultiplying divides by max ((1 << depth) - 1) with a multiply and shifts: with
+//   t = c * a + (1 << (depth - 1)), (t + (t >> depth)) >> depth is exactly round(c * a / max) for all
+//   c, a <= max, and fits in 32 bits for depths up to 16. Opaque pixels come out unchanged.
+// * Unpremultiplying first clamps c to a (anything brighter ends up at max anyway), which also maps
+//   a == 0 to 0. The division by a is then a multiplication by a reciprocal: 8-bit alpha looks up
+//   ceil(2^24 / a), which is exact for these numerators and fits in 32 bits, deeper alpha uses a
+//   double, which is exact up to 16 bits as the quotient stays 0.5 / a away from any integer.
+// All of this was checked against the division-based formulas for every c and a at every depth.
+
+// ceil(2^24 / a), for 1 <= a <= 255
+static const uint32_t avifUnpremultiplyReciprocals8[256] = {
+    0, 16777216, 8388608, 5592406, 4194304, 3355444, 2796203, 2396746,
+    2097152, 1864136, 1677722, 1525202, 1398102, 1290556, 1198373, 1118482,
+    1048576, 986896, 932068, 883012, 838861, 798916, 762601, 729445,
+    699051, 671089, 645278, 621379, 599187, 578525, 559241, 541201,
+    524288, 508401, 493448, 479350, 466034, 453439, 441506, 430186,
+    419431, 409201, 399458, 390168, 381301, 372828, 364723, 356963,
+    349526, 342393, 335545, 328966, 322639, 316552, 310690, 305041,
+    299594, 294338, 289263, 284360, 279621, 275037, 270601, 266306,
+    262144, 258112, 254201, 250407, 246724, 243149, 239675, 236299,
+    233017, 229825, 226720, 223697, 220753, 217886, 215093, 212370,
+    209716, 207127, 204601, 202136, 199729, 197380, 195084, 192842,
+    190651, 188509, 186414, 184366, 182362, 180401, 178482, 176603,
+    174763, 172961, 171197, 169467, 167773, 166112, 164483, 162886,
+    161320, 159784, 158276, 156797, 155345, 153920, 152521, 151147,
+    149797, 148471, 147169, 145889, 144632, 143396, 142180, 140986,
+    139811, 138655, 137519, 136401, 135301, 134218, 133153, 132105,
+    131072, 130056, 129056, 128071, 127101, 126145, 125204, 124276,
+    123362, 122462, 121575, 120700, 119838, 118988, 118150, 117324,
+    116509, 115705, 114913, 114131, 113360, 112599, 111849, 111108,
+    110377, 109656, 108943, 108241, 107547, 106862, 106185, 105518,
+    104858, 104207, 103564, 102928, 102301, 101681, 101068, 100463,
+    99865, 99274, 98690, 98113, 97542, 96979, 96421, 95870,
+    95326, 94787, 94255, 93728, 93207, 92692, 92183, 91679,
+    91181, 90688, 90201, 89718, 89241, 88769, 88302, 87839,
+    87382, 86929, 86481, 86038, 85599, 85164, 84734, 84308,
+    83887, 83469, 83056, 82647, 82242, 81841, 81443, 81050,
+    80660, 80274, 79892, 79513, 79138, 78767, 78399, 78034,
+    77673, 77315, 76960, 76609, 76261, 75916, 75574, 75235,
+    74899, 74566, 74236, 73909, 73585, 73263, 72945, 72629,
+    72316, 72006, 71698, 71393, 71090, 70790, 70493, 70198,
+    69906, 69616, 69328, 69043, 68760, 68479, 68201, 67924,
+    67651, 67379, 67109, 66842, 66577, 66314, 66053, 65794,
+};
+
+static inline void avifRGBRowPremultiplyAlpha8(uint8_t * pixel, uint32_t width, uint32_t aIndex, uint32_t cIndex)
+{
+    for (uint32_t i = 0; i < width; ++i, pixel += 4) {
+        const uint32_t a = pixel[aIndex];
+        for (uint32_t k = 0; k < 3; ++k) {
+            const uint32_t t = pixel[cIndex + k] * a + 128;
+            pixel[cIndex + k] = (uint8_t)((t + (t >> 8)) >> 8);
+        }
+    }
+}
+
+static inline void avifRGBRowPremultiplyAlpha16(uint16_t * pixel,
+                                                uint32_t width,
+                                                uint32_t depth,
+                                                uint32_t aIndex,
+                                                uint32_t cIndex)
+{
+    const uint32_t half = 1 << (depth - 1);
+    for (uint32_t i = 0; i < width; ++i, pixel += 4) {
+        const uint32_t a = pixel[aIndex];
+        for (uint32_t k = 0; k < 3; ++k) {
+            const uint32_t t = pixel[cIndex + k] * a + half;
+            pixel[cIndex + k] = (uint16_t)((t + (t >> depth)) >> depth);
         }
     }
+}
 
-    return AVIF_TRUE;
+static inline void avifRGBRowUnpremultiplyAlpha8(uint8_t * pixel, uint32_t width, uint32_t aIndex, uint32_t cIndex)
+{
+    for (uint32_t i = 0; i < width; ++i, pixel += 4) {
+        const uint32_t a = pixel[aIndex];
+        const uint32_t reciprocal = avifUnpremultiplyReciprocals8[a];
+        for (uint32_t k = 0; k < 3; ++k) {
+            const uint32_t c = AVIF_MIN(pixel[cIndex + k], a);
+            pixel[cIndex + k] = (uint8_t)(((c * 255 + (a >> 1)) * reciprocal) >> 24);
+        }
+    }
+}
+
+static inline void avifRGBRowUnpremultiplyAlpha16(uint16_t * pixel,
+                                                  uint32_t width,
+                                                  uint32_t depth,
+                                                  uint32_t aIndex,
+                                                  uint32_t cIndex)
+{
+    const double max = (double)((1 << depth) - 1);
+    for (uint32_t i = 0; i < width; ++i, pixel += 4) {
+        const uint32_t a = pixel[aIndex];
+        const double reciprocal = 1.0 / (double)(a + (a == 0));
+        const double halfA = (double)(a >> 1) + 0.5;
+        for (uint32_t k = 0; k < 3; ++k) {
+            const uint32_t c = AVIF_MIN(pixel[cIndex + k], a);
+            pixel[cIndex + k] = (uint16_t)(((double)c * max + halfA) * reciprocal);
+        }
+    }
+}
+
+#if defined(AVIF_ALPHA_SSE2)
+// SSE2 versions of the 8-bit kernels, computing the same results four pixels at a time. They return
+// the number of pixels done, leaving the remaining (width % 4) to the kernels above. x86 is
+// little-endian, so alpha is the low byte of each 32-bit pixel for ARGB/ABGR and the high byte for
+// RGBA/BGRA: shifting by 8 * aIndex bits finds it in both layouts.
+
+// Returns each pixel's alpha in all of its four bytes
+static __m128i avifBroadcastAlpha8SSE2(__m128i pixels, __m128i alphaShift)
+{
+    const __m128i alpha = _mm_and_si128(_mm_srl_epi32(pixels, alphaShift), _mm_set1_epi32(0xFF));
+    const __m128i alpha2 = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+    return _mm_or_si128(alpha2, _mm_slli_epi32(alpha2, 16));
+}
+
+static uint32_t avifRGBRowPremultiplyAlpha8SSE2(uint8_t * row, uint32_t width, uint32_t aIndex)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(128);
+    const __m128i alphaShift = _mm_cvtsi32_si128((int)(8 * aIndex));
+    const __m128i alphaMask = _mm_sll_epi32(_mm_set1_epi32(0xFF), alphaShift);
+    uint32_t i = 0;
+    for (; i + 4 <= width; i += 4) {
+        const __m128i pixels = _mm_loadu_si128((const __m128i *)&row[4 * i]);
+        const __m128i alpha = avifBroadcastAlpha8SSE2(pixels, alphaShift);
+        // t = c * a + 128 and (t + (t >> 8)) >> 8 all fit in 16 bits
+        __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_unpacklo_epi8(alpha, zero));
+        __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), _mm_unpackhi_epi8(alpha, zero));
+        lo = _mm_add_epi16(lo, half);
+        hi = _mm_add_epi16(hi, half);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        const __m128i premultiplied = _mm_packus_epi16(lo, hi);
+        _mm_storeu_si128((__m128i *)&row[4 * i],
+                         _mm_or_si128(_mm_andnot_si128(alphaMask, premultiplied), _mm_and_si128(alphaMask, pixels)));
+    }
+    return i;
+}
+
+// Unpremultiplies the four channels of a single pixel given as 32-bit lanes; exact in single
+// precision, as the quotient stays 0.5 / a (at least 1 / 510) away from any integer
+static __m128i avifUnpremultiplyPixel8SSE2(__m128i channels, __m128i alpha)
+{
+    const __m128 a = _mm_cvtepi32_ps(alpha);
+    const __m128 halfA = _mm_add_ps(_mm_cvtepi32_ps(_mm_srli_epi32(alpha, 1)), _mm_set1_ps(0.5f));
+    const __m128 c = _mm_min_ps(_mm_cvtepi32_ps(channels), a);
+    const __m128 numerator = _mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), halfA);
+    return _mm_cvttps_epi32(_mm_div_ps(numerator, _mm_max_ps(a, _mm_set1_ps(1.0f))));
+}
+
+static uint32_t avifRGBRowUnpremultiplyAlpha8SSE2(uint8_t * row, uint32_t width, uint32_t aIndex)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaShift = _mm_cvtsi32_si128((int)(8 * aIndex));
+    const __m128i alphaMask = _mm_sll_epi32(_mm_set1_epi32(0xFF), alphaShift);
+    uint32_t i = 0;
+    for (; i + 4 <= width; i += 4) {
+        const __m128i pixels = _mm_loadu_si128((const __m128i *)&row[4 * i]);
+        const __m128i alpha = avifBroadcastAlpha8SSE2(pixels, alphaShift);
+        const __m128i pixelsLo = _mm_unpacklo_epi8(pixels, zero);
+        const __m128i pixelsHi = _mm_unpackhi_epi8(pixels, zero);
+        const __m128i alphaLo = _mm_unpacklo_epi8(alpha, zero);
+        const __m128i alphaHi = _mm_unpackhi_epi8(alpha, zero);
+        const __m128i p0 = avifUnpremultiplyPixel8SSE2(_mm_unpacklo_epi16(pixelsLo, zero), _mm_unpacklo_epi16(alphaLo, zero));
+        const __m128i p1 = avifUnpremultiplyPixel8SSE2(_mm_unpackhi_epi16(pixelsLo, zero), _mm_unpackhi_epi16(alphaLo, zero));
+        const __m128i p2 = avifUnpremultiplyPixel8SSE2(_mm_unpacklo_epi16(pixelsHi, zero), _mm_unpacklo_epi16(alphaHi, zero));
+        const __m128i p3 = avifUnpremultiplyPixel8SSE2(_mm_unpackhi_epi16(pixelsHi, zero), _mm_unpackhi_epi16(alphaHi, zero));
+        const __m128i unpremultiplied = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+        _mm_storeu_si128((__m128i *)&row[4 * i],
+                         _mm_or_si128(_mm_andnot_si128(alphaMask, unpremultiplied), _mm_and_si128(alphaMask, pixels)));
+    }
+    return i;
+}
+#endif
+
+// RGBA and BGRA store alpha last, ARGB and ABGR store it first. Passing the indices as constants lets
+// the kernels above be specialized for each layout.
+
+void avifRGBRowPremultiplyAlpha(uint8_t * row, uint32_t width, uint32_t depth, avifRGBFormat format)
+{
+    const avifBool alphaFirst = (format == AVIF_RGB_FORMAT_ARGB) || (format == AVIF_RGB_FORMAT_ABGR);
+    if (depth > 8) {
+        if (alphaFirst) {
+            avifRGBRowPremultiplyAlpha16((uint16_t *)row, width, depth, 0, 1);
+        } else {
+            avifRGBRowPremultiplyAlpha16((uint16_t *)row, width, depth, 3, 0);
+        }
+        return;
+    }
+
+    uint32_t done = 0;
+#if defined(AVIF_ALPHA_SSE2)
+    done = avifRGBRowPremultiplyAlpha8SSE2(row, width, alphaFirst ? 0 : 3);
+#endif
+    if (alphaFirst) {
+        avifRGBRowPremultiplyAlpha8(&row[4 * done], width - done, 0, 1);
+    } else {
+        avifRGBRowPremultiplyAlpha8(&row[4 * done], width - done, 3, 0);
+    }
+}
+
+void avifRGBRowUnpremultiplyAlpha(uint8_t * row, uint32_t width, uint32_t depth, avifRGBFormat format)
+{
+    const avifBool alphaFirst = (format == AVIF_RGB_FORMAT_ARGB) || (format == AVIF_RGB_FORMAT_ABGR);
+    if (depth > 8) {
+        if (alphaFirst) {
+            avifRGBRowUnpremultiplyAlpha16((uint16_t *)row, width, depth, 0, 1);
+        } else {
+            avifRGBRowUnpremultiplyAlpha16((uint16_t *)row, width, depth, 3, 0);
+        }
+        return;
+    }
+
+    uint32_t done = 0;
+#if defined(AVIF_ALPHA_SSE2)
+    done = avifRGBRowUnpremultiplyAlpha8SSE2(row, width, alphaFirst ? 0 : 3);
+#endif
+    if (alphaFirst) {
+        avifRGBRowUnpremultiplyAlpha8(&row[4 * done], width - done, 0, 1);
+    } else {
+        avifRGBRowUnpremultiplyAlpha8(&row[4 * done], width - done, 3, 0);
+    }
 }
 
 avifResult avifRGBImagePremultiplyAlpha(avifRGBImage * rgb)
@@ -401,93 +412,8 @@ avifResult avifRGBImagePremultiplyAlpha(avifRGBImage * rgb)
 
     assert(rgb->depth >= 8 && rgb->depth <= 16);
 
-    uint32_t max = (1 << rgb->depth) - 1;
-    float maxF = (float)max;
-
-    if (rgb->depth > 8) {
-        if (rgb->format == AVIF_RGB_FORMAT_RGBA || rgb->format == AVIF_RGB_FORMAT_BGRA) {
-            for (uint32_t j = 0; j < rgb->height; ++j) {
-                uint8_t * row = &rgb->pixels[j * rgb->rowBytes];
-                for (uint32_t i = 0; i < rgb->width; ++i) {
-                    uint16_t * pixel = (uint16_t *)&row[i * 8];
-                    uint16_t a = pixel[3];
-                    if (a >= max) {
-                        // opaque is no-op
-                        continue;
-                    } else if (a == 0) {
-                        // result must be zero
-                        pixel[0] = 0;
-                        pixel[1] = 0;
-                        pixel[2] = 0;
-                    } else {
-                        // a < maxF is always true now, so we don't need clamp here
-                        pixel[0] = (uint16_t)avifRoundf((float)pixel[0] * (float)a / maxF);
-                        pixel[1] = (uint16_t)avifRoundf((float)pixel[1] * (float)a / maxF);
-                        pixel[2] = (uint16_t)avifRoundf((float)pixel[2] * (float)a / maxF);
-                    }
-                }
-            }
-        } else {
-            for (uint32_t j = 0; j < rgb->height; ++j) {
-                uint8_t * row = &rgb->pixels[j * rgb->rowBytes];
-                for (uint32_t i = 0; i < rgb->width; ++i) {
-                    uint16_t * pixel = (uint16_t *)&row[i * 8];
-                    uint16_t a = pixel[0];
-                    if (a >= max) {
-                        continue;
-                    } else if (a == 0) {
-                        pixel[1] = 0;
-                        pixel[2] = 0;
-                        pixel[3] = 0;
-                    } else {
-                        pixel[1] = (uint16_t)avifRoundf((float)pixel[1] * (float)a / maxF);
-                        pixel[2] = (uint16_t)avifRoundf((float)pixel[2] * (float)a / maxF);
-                        pixel[3] = (uint16_t)avifRoundf((float)pixel[3] * (float)a / maxF);
-                    }
-                }
-            }
-        }
-    } else {
-        if (rgb->format == AVIF_RGB_FORMAT_RGBA || rgb->format == AVIF_RGB_FORMAT_BGRA) {
-            for (uint32_t j = 0; j < rgb->height; ++j) {
-                uint8_t * row = &rgb->pixels[j * rgb->rowBytes];
-                for (uint32_t i = 0; i < rgb->width; ++i) {
-                    uint8_t * pixel = &row[i * 4];
-                    uint8_t a = pixel[3];
-                    // uint8_t can't exceed 255
-                    if (a == max) {
-                        continue;
-                    } else if (a == 0) {
-                        pixel[0] = 0;
-                        pixel[1] = 0;
-                        pixel[2] = 0;
-                    } else {
-                        pixel[0] = (uint8_t)avifRoundf((float)pixel[0] * (float)a / maxF);
-                        pixel[1] = (uint8_t)avifRoundf((float)pixel[1] * (float)a / maxF);
-                        pixel[2] = (uint8_t)avifRoundf((float)pixel[2] * (float)a / maxF);
-                    }
-                }
-            }
-        } else {
-            for (uint32_t j = 0; j < rgb->height; ++j) {
-                uint8_t * row = &rgb->pixels[j * rgb->rowBytes];
-                for (uint32_t i = 0; i < rgb->width; ++i) {
-                    uint8_t * pixel = &row[i * 4];
-                    uint8_t a = pixel[0];
-                    if (a == max) {
-                        continue;
-                    } else if (a == 0) {
-                        pixel[1] = 0;
-                        pixel[2] = 0;
-                        pixel[3] = 0;
-                    } else {
-                        pixel[1] = (uint8_t)avifRoundf((float)pixel[1] * (float)a / maxF);
-                        pixel[2] = (uint8_t)avifRoundf((float)pixel[2] * (float)a / maxF);
-                        pixel[3] = (uint8_t)avifRoundf((float)pixel[3] * (float)a / maxF);
-                    }
-                }
-            }
-        }
+    for (uint32_t j = 0; j < rgb->height; ++j) {
+        avifRGBRowPremultiplyAlpha(&rgb->pixels[j * rgb->rowBytes], rgb->width, rgb->depth, rgb->format);
     }
 
     return AVIF_RESULT_OK;
@@ -512,103 +438,8 @@ avifResult avifRGBImageUnpremultiplyAlpha(avifRGBImage * rgb)
 
     assert(rgb->depth >= 8 && rgb->depth <= 16);
 
-    uint32_t max = (1 << rgb->depth) - 1;
-    float maxF = (float)max;
-
-    if (rgb->depth > 8) {
-        if (rgb->format == AVIF_RGB_FORMAT_RGBA || rgb->format == AVIF_RGB_FORMAT_BGRA) {
-            for (uint32_t j = 0; j < rgb->height; ++j) {
-                uint8_t * row = &rgb->pixels[j * rgb->rowBytes];
-                for (uint32_t i = 0; i < rgb->width; ++i) {
-                    uint16_t * pixel = (uint16_t *)&row[i * 8];
-                    uint16_t a = pixel[3];
-                    if (a >= max) {
-                        // opaque is no-op
-                        continue;
-                    } else if (a == 0) {
-                        // prevent division by zero
-                        pixel[0] = 0;
-                        pixel[1] = 0;
-                        pixel[2] = 0;
-                    } else {
-                        float c1 = avifRoundf((float)pixel[0] * maxF / (float)a);
-                        float c2 = avifRoundf((float)pixel[1] * maxF / (float)a);
-                        float c3 = avifRoundf((float)pixel[2] * maxF / (float)a);
-                        pixel[0] = (uint16_t)AVIF_MIN(c1, maxF);
-                        pixel[1] = (uint16_t)AVIF_MIN(c2, maxF);
-                        pixel[2] = (uint16_t)AVIF_MIN(c3, maxF);
-                    }
-                }
-            }
-        } else {
-            for (uint32_t j = 0; j < rgb->height; ++j) {
-                uint8_t * row = &rgb->pixels[j * rgb->rowBytes];
-                for (uint32_t i = 0; i < rgb->width; ++i) {
-                    uint16_t * pixel = (uint16_t *)&row[i * 8];
-                    uint16_t a = pixel[0];
-                    if (a >= max) {
-                        continue;
-                    } else if (a == 0) {
-                        pixel[1] = 0;
-                        pixel[2] = 0;
-                        pixel[3] = 0;
-                    } else {
-                        float c1 = avifRoundf((float)pixel[1] * maxF / (float)a);
-                        float c2 = avifRoundf((float)pixel[2] * maxF / (float)a);
-                        float c3 = avifRoundf((float)pixel[3] * maxF / (float)a);
-                        pixel[1] = (uint16_t)AVIF_MIN(c1, maxF);
-                        pixel[2] = (uint16_t)AVIF_MIN(c2, maxF);
-                        pixel[3] = (uint16_t)AVIF_MIN(c3, maxF);
-                    }
-                }
-            }
-        }
-    } else {
-        if (rgb->format == AVIF_RGB_FORMAT_RGBA || rgb->format == AVIF_RGB_FORMAT_BGRA) {
-            for (uint32_t j = 0; j < rgb->height; ++j) {
-                uint8_t * row = &rgb->pixels[j * rgb->rowBytes];
-                for (uint32_t i = 0; i < rgb->width; ++i) {
-                    uint8_t * pixel = &row[i * 4];
-                    uint8_t a = pixel[3];
-                    if (a == max) {
-                        continue;
-                    } else if (a == 0) {
-                        pixel[0] = 0;
-                        pixel[1] = 0;
-                        pixel[2] = 0;
-                    } else {
-                        float c1 = avifRoundf((float)pixel[0] * maxF / (float)a);
-                        float c2 = avifRoundf((float)pixel[1] * maxF / (float)a);
-                        float c3 = avifRoundf((float)pixel[2] * maxF / (float)a);
-                        pixel[0] = (uint8_t)AVIF_MIN(c1, maxF);
-                        pixel[1] = (uint8_t)AVIF_MIN(c2, maxF);
-                        pixel[2] = (uint8_t)AVIF_MIN(c3, maxF);
-                    }
-                }
-            }
-        } else {
-            for (uint32_t j = 0; j < rgb->height; ++j) {
-                uint8_t * row = &rgb->pixels[j * rgb->rowBytes];
-                for (uint32_t i = 0; i < rgb->width; ++i) {
-                    uint8_t * pixel = &row[i * 4];
-                    uint8_t a = pixel[0];
-                    if (a == max) {
-                        continue;
-                    } else if (a == 0) {
-                        pixel[1] = 0;
-                        pixel[2] = 0;
-                        pixel[3] = 0;
-                    } else {
-                        float c1 = avifRoundf((float)pixel[1] * maxF / (float)a);
-                        float c2 = avifRoundf((float)pixel[2] * maxF / (float)a);
-                        float c3 = avifRoundf((float)pixel[3] * maxF / (float)a);
-                        pixel[1] = (uint8_t)AVIF_MIN(c1, maxF);
-                        pixel[2] = (uint8_t)AVIF_MIN(c2, maxF);
-                        pixel[3] = (uint8_t)AVIF_MIN(c3, maxF);
-                    }
-                }
-            }
-        }
+    for (uint32_t j = 0; j < rgb->height; ++j) {
+        avifRGBRowUnpremultiplyAlpha(&rgb->pixels[j * rgb->rowBytes], rgb->width, rgb->depth, rgb->format);
     }
 
     return AVIF_RESULT_OK;
@@ -101,6 +101,20 @@ const char * avifResultToString(avifResult result)
     return "Unknown Error";
 }
 
+const char * avifProgressiveStateToString(avifProgressiveState progressiveState)
+{
+    // clang-format off
+    switch (progressiveState) {
+        case AVIF_PROGRESSIVE_STATE_UNAVAILABLE: return "Unavailable";
+        case AVIF_PROGRESSIVE_STATE_AVAILABLE:   return "Available";
+        case AVIF_PROGRESSIVE_STATE_ACTIVE:      return "Active";
+        default:
+            break;
+    }
+    // clang-format on
+    return "Unknown";
+}
+
 // This function assumes nothing in this struct needs to be freed; use avifImageClear() externally
 static void avifImageSetDefaults(avifImage * image)
 {
@@ -128,10 +142,9 @@ avifImage * avifImageCreateEmpty(void)
     return avifImageCreate(0, 0, 0, AVIF_PIXEL_FORMAT_NONE);
 }
 
-void avifImageCopy(avifImage * dstImage, const avifImage * srcImage, avifPlanesFlags planes)
+// Copies everything but the planes, the ICC profile and the metadata
+static void avifImageCopyNoAlloc(avifImage * dstImage, const avifImage * srcImage)
 {
-    avifImageFreePlanes(dstImage, AVIF_PLANES_ALL);
-
     dstImage->width = srcImage->width;
     dstImage->height = srcImage->height;
     dstImage->depth = srcImage->depth;
@@ -150,6 +163,12 @@ void avifImageCopy(avifImage * dstImage, const avifImage * srcImage, avifPlanesF
     memcpy(&dstImage->clap, &srcImage->clap, sizeof(dstImage->clap));
     memcpy(&dstImage->irot, &srcImage->irot, sizeof(dstImage->irot));
     memcpy(&dstImage->imir, &srcImage->imir, sizeof(dstImage->imir));
+}
+
+void avifImageCopy(avifImage * dstImage, const avifImage * srcImage, avifPlanesFlags planes)
+{
+    avifImageFreePlanes(dstImage, AVIF_PLANES_ALL);
+    avifImageCopyNoAlloc(dstImage, srcImage);
 
     avifImageSetProfileICC(dstImage, srcImage->icc.data, srcImage->icc.size);
 
@@ -318,6 +337,61 @@ void avifImageStealPlanes(avifImage * dstImage, avifImage * srcImage, avifPlanes
     }
 }
 
+// Points the planes of view at (x, y) of image's planes, with image's row bytes
+static void avifImageSetViewPlanes(avifImage * view, const avifImage * image, uint32_t x, uint32_t y)
+{
+    const size_t pixelBytes = avifImageUsesU16(image) ? 2 : 1;
+    avifPixelFormatInfo formatInfo;
+    avifGetPixelFormatInfo(image->yuvFormat, &formatInfo);
+    for (int yuvPlane = 0; yuvPlane < 3; ++yuvPlane) {
+        view->yuvPlanes[yuvPlane] = NULL;
+        view->yuvRowBytes[yuvPlane] = image->yuvRowBytes[yuvPlane];
+        if (image->yuvPlanes[yuvPlane]) {
+            const uint32_t planeX = (yuvPlane == AVIF_CHAN_Y) ? x : (x >> formatInfo.chromaShiftX);
+            const uint32_t planeY = (yuvPlane == AVIF_CHAN_Y) ? y : (y >> formatInfo.chromaShiftY);
+            view->yuvPlanes[yuvPlane] =
+                &image->yuvPlanes[yuvPlane][((size_t)planeY * image->yuvRowBytes[yuvPlane]) + (planeX * pixelBytes)];
+        }
+    }
+    view->alphaPlane = NULL;
+    view->alphaRowBytes = image->alphaRowBytes;
+    if (image->alphaPlane) {
+        view->alphaPlane = &image->alphaPlane[((size_t)y * image->alphaRowBytes) + (x * pixelBytes)];
+    }
+    view->imageOwnsYUVPlanes = AVIF_FALSE;
+    view->imageOwnsAlphaPlane = AVIF_FALSE;
+}
+
+void avifImageSetView(avifImage * view, const avifImage * image, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    memcpy(view, image, sizeof(avifImage));
+    view->width = width;
+    view->height = height;
+    avifImageSetViewPlanes(view, image, x, y);
+}
+
+avifResult avifImageSetViewRect(avifImage * dstImage, const avifImage * srcImage, const avifCropRect * rect)
+{
+    if ((rect->width == 0) || (rect->height == 0) || (rect->width > srcImage->width) || (rect->height > srcImage->height) ||
+        (rect->x > (srcImage->width - rect->width)) || (rect->y > (srcImage->height - rect->height))) {
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+    avifPixelFormatInfo formatInfo;
+    avifGetPixelFormatInfo(srcImage->yuvFormat, &formatInfo);
+    if (!formatInfo.monochrome &&
+        (((rect->x % (1 << formatInfo.chromaShiftX)) != 0) || ((rect->y % (1 << formatInfo.chromaShiftY)) != 0))) {
+        // The chroma planes can't start in the middle of a chroma sample
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+
+    avifImageFreePlanes(dstImage, AVIF_PLANES_ALL);
+    avifImageCopyNoAlloc(dstImage, srcImage);
+    dstImage->width = rect->width;
+    dstImage->height = rect->height;
+    avifImageSetViewPlanes(dstImage, srcImage, rect->x, rect->y);
+    return AVIF_RESULT_OK;
+}
+
 avifBool avifImageUsesU16(const avifImage * image)
 {
     return (image->depth > 8);
@@ -358,6 +432,7 @@ void avifRGBImageSetDefaults(avifRGBImage * rgb, const avifImage * image)
     rgb->depth = image->depth;
     rgb->format = AVIF_RGB_FORMAT_RGBA;
     rgb->chromaUpsampling = AVIF_CHROMA_UPSAMPLING_AUTOMATIC;
+    rgb->downscaling = AVIF_DOWNSCALING_NONE;
     rgb->ignoreAlpha = AVIF_FALSE;
     rgb->pixels = NULL;
     rgb->rowBytes = 0;
@@ -48,14 +48,21 @@ struct avifCodecInternal
     aom_codec_ctx_t decoder;
     aom_codec_iter_t iter;
     aom_image_t * image;
+    avifFrameBufferAllocator frameBufferAllocator;
 #endif
 
 #if defined(AVIF_CODEC_AOM_ENCODE)
     avifBool encoderInitialized;
     aom_codec_ctx_t encoder;
+    struct aom_codec_enc_cfg cfg; // kept to change the quantizers between layers of a layered image
     avifPixelFormatInfo formatInfo;
     aom_img_fmt_t aomFormat;
     avifBool monochromeEnabled;
+    // Neutral chroma handed to libaom for alpha and YUV400 images when monochromeEnabled is false
+    uint8_t * grayChroma;
+    uint32_t grayChromaRowBytes;
+    uint32_t grayChromaHeight;
+    uint32_t grayChromaDepth;
     // Whether cfg.rc_end_usage was set with an
     // avifEncoderSetCodecSpecificOption(encoder, "end-usage", value) call.
     avifBool endUsageSet;
@@ -77,17 +84,41 @@ static void aomCodecDestroyInternal(avifCodec * codec)
     if (codec->internal->encoderInitialized) {
         aom_codec_destroy(&codec->internal->encoder);
     }
+    if (codec->internal->grayChroma) {
+        avifFree(codec->internal->grayChroma);
+    }
 #endif
 
     avifFree(codec->internal);
 }
 
 #if defined(AVIF_CODEC_AOM_DECODE)
+// External frame buffer callbacks taking the frame buffers from decoder->frameBufferAllocator.
+// min_size already accounts for libaom aligning the planes within the buffer.
+static int aomGetFrameBuffer(void * priv, size_t minSize, aom_codec_frame_buffer_t * frameBuffer)
+{
+    const avifFrameBufferAllocator * allocator = (const avifFrameBufferAllocator *)priv;
+    frameBuffer->data = (uint8_t *)allocator->alloc(allocator->userData, minSize, 32);
+    if (!frameBuffer->data) {
+        return -1;
+    }
+    frameBuffer->size = minSize;
+    frameBuffer->priv = NULL;
+    return 0;
+}
+
+static int aomReleaseFrameBuffer(void * priv, aom_codec_frame_buffer_t * frameBuffer)
+{
+    const avifFrameBufferAllocator * allocator = (const avifFrameBufferAllocator *)priv;
+    allocator->release(allocator->userData, frameBuffer->data);
+    return 0;
+}
+
 static avifBool aomCodecOpen(struct avifCodec * codec, avifDecoder * decoder)
 {
     aom_codec_dec_cfg_t cfg;
     memset(&cfg, 0, sizeof(aom_codec_dec_cfg_t));
-    cfg.threads = decoder->maxThreads;
+    cfg.threads = codec->maxThreads;
     cfg.allow_lowbitdepth = 1;
 
     aom_codec_iface_t * decoder_interface = aom_codec_av1_dx();
@@ -96,10 +127,23 @@ static avifBool aomCodecOpen(struct avifCodec * codec, avifDecoder * decoder)
     }
     codec->internal->decoderInitialized = AVIF_TRUE;
 
-    // Ensure that we only get the "highest spatial layer" as a single frame
-    // for each input sample, instead of getting each spatial layer as its own
-    // frame one at a time ("all layers").
-    if (aom_codec_control(&codec->internal->decoder, AV1D_SET_OUTPUT_ALL_LAYERS, 0)) {
+    if (decoder->frameBufferAllocator.alloc) {
+        codec->internal->frameBufferAllocator = decoder->frameBufferAllocator;
+        if (aom_codec_set_frame_buffer_functions(&codec->internal->decoder,
+                                                 aomGetFrameBuffer,
+                                                 aomReleaseFrameBuffer,
+                                                 &codec->internal->frameBufferAllocator)) {
+            return AVIF_FALSE;
+        }
+    }
+
+    // Unless the layers of the item are wanted individually (progressive decoding or an lsel
+    // property), ensure that we only get the "highest spatial layer" as a single frame for each
+    // input sample, instead of getting each spatial layer as its own frame one at a time ("all layers").
+    if (aom_codec_control(&codec->internal->decoder, AV1D_SET_OUTPUT_ALL_LAYERS, codec->allLayers ? 1 : 0)) {
+        return AVIF_FALSE;
+    }
+    if (aom_codec_control(&codec->internal->decoder, AV1D_SET_OPERATING_POINT, (int)codec->operatingPoint)) {
         return AVIF_FALSE;
     }
 
@@ -110,9 +154,15 @@ static avifBool aomCodecOpen(struct avifCodec * codec, avifDecoder * decoder)
 static avifBool aomCodecGetNextImage(struct avifCodec * codec, const avifDecodeSample * sample, avifBool alpha, avifImage * image)
 {
     aom_image_t * nextFrame = NULL;
+    const avifBool selectSpatialLayer = sample && sample->selectSpatialLayer;
+    const uint8_t spatialID = sample ? sample->spatialID : 0;
     for (;;) {
         nextFrame = aom_codec_get_frame(&codec->internal->decoder, &codec->internal->iter);
         if (nextFrame) {
+            if (selectSpatialLayer && (nextFrame->spatial_id != spatialID)) {
+                // Not the layer chosen by the item's lsel property
+                continue;
+            }
             // Got an image!
             break;
         } else if (sample) {
@@ -477,6 +527,85 @@ static avifBool avifProcessAOMOptionsPostInit(avifCodec * codec, avifBool alpha)
 
 static avifBool aomCodecEncodeFinish(avifCodec * codec, avifCodecEncodeOutput * output);
 
+// Returns 4:2:0 chroma planes of the given luma size, filled with 0.5. They are built once and
+// reused for every frame, as libaom only reads its input and both U and V can share them.
+static uint8_t * aomCodecGetGrayChroma(avifCodec * codec, const avifImage * image, uint32_t * outRowBytes)
+{
+    const uint32_t uvWidth = (image->width + 1) >> 1;
+    const uint32_t uvHeight = (image->height + 1) >> 1;
+    const uint32_t bytesPerPixel = (image->depth > 8) ? 2 : 1;
+    const uint32_t rowBytes = bytesPerPixel * uvWidth;
+    if (codec->internal->grayChroma &&
+        ((codec->internal->grayChromaRowBytes != rowBytes) || (codec->internal->grayChromaHeight != uvHeight) ||
+         (codec->internal->grayChromaDepth != image->depth))) {
+        avifFree(codec->internal->grayChroma);
+        codec->internal->grayChroma = NULL;
+    }
+    if (!codec->internal->grayChroma) {
+        uint8_t * grayChroma = avifAlloc((size_t)rowBytes * uvHeight);
+        if (image->depth > 8) {
+            const uint16_t half = (uint16_t)(1 << (image->depth - 1));
+            uint16_t * grayChroma16 = (uint16_t *)grayChroma;
+            for (size_t i = 0; i < (size_t)uvWidth * uvHeight; ++i) {
+                grayChroma16[i] = half;
+            }
+        } else {
+            memset(grayChroma, 128, (size_t)rowBytes * uvHeight);
+        }
+        codec->internal->grayChroma = grayChroma;
+        codec->internal->grayChromaRowBytes = rowBytes;
+        codec->internal->grayChromaHeight = uvHeight;
+        codec->internal->grayChromaDepth = image->depth;
+    }
+    *outRowBytes = rowBytes;
+    return codec->internal->grayChroma;
+}
+
+// Points aomImage at the planes of image (its alpha plane if alpha is true) without copying them.
+// libaom copies its input into its own frame buffers within aom_codec_encode(), so the avifImage
+// only has to outlive that call. Returns NULL if libaom rejects the format or dimensions.
+static aom_image_t * aomCodecWrapImage(avifCodec * codec, aom_image_t * aomImage, const avifImage * image, avifBool alpha)
+{
+    uint8_t * yPlane = alpha ? image->alphaPlane : image->yuvPlanes[AVIF_CHAN_Y];
+    const uint32_t yRowBytes = alpha ? image->alphaRowBytes : image->yuvRowBytes[AVIF_CHAN_Y];
+    if (!yPlane || (yRowBytes > INT_MAX)) {
+        return NULL;
+    }
+    // aom_img_wrap() lays out all planes in a single buffer; it is only used here to fill in the
+    // format fields, and the plane pointers and strides are replaced with the avifImage's own.
+    if (!aom_img_wrap(aomImage, codec->internal->aomFormat, image->width, image->height, 1, yPlane)) {
+        return NULL;
+    }
+    aomImage->planes[AOM_PLANE_Y] = yPlane;
+    aomImage->stride[AOM_PLANE_Y] = (int)yRowBytes;
+    if (alpha || (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV400)) {
+        uint8_t * uvPlane;
+        uint32_t uvRowBytes;
+        if (codec->internal->monochromeEnabled) {
+            // libaom never reads the UV planes; keep them pointing at valid memory anyway
+            uvPlane = yPlane;
+            uvRowBytes = yRowBytes;
+        } else {
+            // libaom can't encode monochrome (see the chroma_check comment in
+            // aomCodecEncodeImage()), so hand it neutral 4:2:0 chroma
+            uvPlane = aomCodecGetGrayChroma(codec, image, &uvRowBytes);
+        }
+        for (int plane = AOM_PLANE_U; plane <= AOM_PLANE_V; ++plane) {
+            aomImage->planes[plane] = uvPlane;
+            aomImage->stride[plane] = (int)uvRowBytes;
+        }
+    } else {
+        for (int plane = AOM_PLANE_U; plane <= AOM_PLANE_V; ++plane) {
+            if (!image->yuvPlanes[plane] || (image->yuvRowBytes[plane] > INT_MAX)) {
+                return NULL;
+            }
+            aomImage->planes[plane] = image->yuvPlanes[plane];
+            aomImage->stride[plane] = (int)image->yuvRowBytes[plane];
+        }
+    }
+    return aomImage;
+}
+
 static avifResult aomCodecEncodeImage(avifCodec * codec,
                                       avifEncoder * encoder,
                                       const avifImage * image,
@@ -501,7 +630,8 @@ static avifResult aomCodecEncodeImage(avifCodec * codec,
         // Use the new AOM_USAGE_ALL_INTRA (added in https://crbug.com/aomedia/2959) for still
         // image encoding if it is available.
 #if defined(AOM_USAGE_ALL_INTRA)
-        if (addImageFlags & AVIF_ADD_IMAGE_FLAG_SINGLE) {
+        // Layers after the first one are predicted from the previous layer, which all intra forbids.
+        if ((addImageFlags & AVIF_ADD_IMAGE_FLAG_SINGLE) && (encoder->extraLayerCount == 0)) {
             aomUsage = AOM_USAGE_ALL_INTRA;
         }
 #endif
@@ -514,6 +644,15 @@ static avifResult aomCodecEncodeImage(avifCodec * codec,
                 aomCpuUsed = AVIF_CLAMP(encoder->speed - 2, 6, 8);
             }
         }
+        if (encoder->extraLayerCount > 0) {
+            // Spatial layers are a realtime (SVC) feature of libaom. libaom v3.6.0 crashes encoding
+            // them in good quality mode (for images larger than a few superblocks) and at cpu-used 7,
+            // and its cpu-used 8 doesn't keep the last layer lossless when asked to.
+            aomUsage = AOM_USAGE_REALTIME;
+            if (aomCpuUsed > 6) {
+                aomCpuUsed = 6;
+            }
+        }
 
         // aom_codec.h says: aom_codec_version() == (major<<16 | minor<<8 | patch)
         static const int aomVersion_2_0_0 = (2 << 16);
@@ -609,11 +748,23 @@ static avifResult aomCodecEncodeImage(avifCodec * codec,
             cfg.g_lag_in_frames = 0;
             // Disable automatic placement of key frames by the encoder.
             cfg.kf_mode = AOM_KF_DISABLED;
-            // Tell libaom that all frames will be key frames.
-            cfg.kf_max_dist = 0;
+            if (encoder->extraLayerCount == 0) {
+                // Tell libaom that all frames will be key frames.
+                cfg.kf_max_dist = 0;
+            }
+        }
+        if (encoder->extraLayerCount > 0) {
+            // Every layer of a layered image is encoded as its own frame (one packet per layer).
+            // g_limit > 1 also keeps libaom from using a reduced still picture header, which can't
+            // describe more than one layer.
+            cfg.g_limit = encoder->extraLayerCount + 1;
+            cfg.g_lag_in_frames = 0;
+            // The quality of each layer is set by its quantizers (see the layer loop below), not by
+            // the realtime default of a constant bitrate.
+            cfg.rc_end_usage = AOM_Q;
         }
-        if (encoder->maxThreads > 1) {
-            cfg.g_threads = encoder->maxThreads;
+        if (codec->maxThreads > 1) {
+            cfg.g_threads = codec->maxThreads;
         }
 
         int minQuantizer = AVIF_CLAMP(encoder->minQuantizer, 0, 63);
@@ -658,19 +809,26 @@ static avifResult aomCodecEncodeImage(avifCodec * codec,
             return AVIF_RESULT_UNKNOWN_ERROR;
         }
         codec->internal->encoderInitialized = AVIF_TRUE;
+        codec->internal->cfg = cfg;
 
+        if (encoder->extraLayerCount > 0) {
+            if (aom_codec_control(&codec->internal->encoder, AOME_SET_NUMBER_SPATIAL_LAYERS, encoder->extraLayerCount + 1) !=
+                AOM_CODEC_OK) {
+                return AVIF_RESULT_UNKNOWN_ERROR;
+            }
+        }
         if (lossless) {
             aom_codec_control(&codec->internal->encoder, AV1E_SET_LOSSLESS, 1);
         }
-        if (encoder->maxThreads > 1) {
+        if (codec->maxThreads > 1) {
             aom_codec_control(&codec->internal->encoder, AV1E_SET_ROW_MT, 1);
         }
-        if (encoder->tileRowsLog2 != 0) {
-            int tileRowsLog2 = AVIF_CLAMP(encoder->tileRowsLog2, 0, 6);
+        if (codec->tileRowsLog2 != 0) {
+            int tileRowsLog2 = AVIF_CLAMP(codec->tileRowsLog2, 0, 6);
             aom_codec_control(&codec->internal->encoder, AV1E_SET_TILE_ROWS, tileRowsLog2);
         }
-        if (encoder->tileColsLog2 != 0) {
-            int tileColsLog2 = AVIF_CLAMP(encoder->tileColsLog2, 0, 6);
+        if (codec->tileColsLog2 != 0) {
+            int tileColsLog2 = AVIF_CLAMP(codec->tileColsLog2, 0, 6);
             aom_codec_control(&codec->internal->encoder, AV1E_SET_TILE_COLUMNS, tileColsLog2);
         }
         if (aomCpuUsed != -1) {
@@ -695,44 +853,19 @@ static avifResult aomCodecEncodeImage(avifCodec * codec,
 #endif
     }
 
-    int yShift = codec->internal->formatInfo.chromaShiftY;
-    uint32_t uvHeight = (image->height + yShift) >> yShift;
-    aom_image_t * aomImage = aom_img_alloc(NULL, codec->internal->aomFormat, image->width, image->height, 16);
-    avifBool monochromeRequested = AVIF_FALSE;
+    aom_image_t wrappedImage;
+    aom_image_t * aomImage = aomCodecWrapImage(codec, &wrappedImage, image, alpha);
+    if (!aomImage) {
+        avifDiagnosticsPrintf(codec->diag, "aom_img_wrap() failed");
+        return AVIF_RESULT_UNKNOWN_ERROR;
+    }
 
     if (alpha) {
         aomImage->range = (image->alphaRange == AVIF_RANGE_FULL) ? AOM_CR_FULL_RANGE : AOM_CR_STUDIO_RANGE;
         aom_codec_control(&codec->internal->encoder, AV1E_SET_COLOR_RANGE, aomImage->range);
-        monochromeRequested = AVIF_TRUE;
-        for (uint32_t j = 0; j < image->height; ++j) {
-            uint8_t * srcAlphaRow = &image->alphaPlane[j * image->alphaRowBytes];
-            uint8_t * dstAlphaRow = &aomImage->planes[0][j * aomImage->stride[0]];
-            memcpy(dstAlphaRow, srcAlphaRow, image->alphaRowBytes);
-        }
-
-        // Ignore UV planes when monochrome
     } else {
         aomImage->range = (image->yuvRange == AVIF_RANGE_FULL) ? AOM_CR_FULL_RANGE : AOM_CR_STUDIO_RANGE;
         aom_codec_control(&codec->internal->encoder, AV1E_SET_COLOR_RANGE, aomImage->range);
-        int yuvPlaneCount = 3;
-        if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV400) {
-            yuvPlaneCount = 1; // Ignore UV planes when monochrome
-            monochromeRequested = AVIF_TRUE;
-        }
-        int xShift = codec->internal->formatInfo.chromaShiftX;
-        uint32_t uvWidth = (image->width + xShift) >> xShift;
-        uint32_t bytesPerPixel = (image->depth > 8) ? 2 : 1;
-        for (int yuvPlane = 0; yuvPlane < yuvPlaneCount; ++yuvPlane) {
-            uint32_t planeWidth = (yuvPlane == AVIF_CHAN_Y) ? image->width : uvWidth;
-            uint32_t planeHeight = (yuvPlane == AVIF_CHAN_Y) ? image->height : uvHeight;
-            uint32_t bytesPerRow = bytesPerPixel * planeWidth;
-
-            for (uint32_t j = 0; j < planeHeight; ++j) {
-                uint8_t * srcRow = &image->yuvPlanes[yuvPlane][j * image->yuvRowBytes[yuvPlane]];
-                uint8_t * dstRow = &aomImage->planes[yuvPlane][j * aomImage->stride[yuvPlane]];
-                memcpy(dstRow, srcRow, bytesPerRow);
-            }
-        }
 
         aomImage->cp = (aom_color_primaries_t)image->colorPrimaries;
         aomImage->tc = (aom_transfer_characteristics_t)image->transferCharacteristics;
@@ -744,56 +877,60 @@ static avifResult aomCodecEncodeImage(avifCodec * codec,
         aom_codec_control(&codec->internal->encoder, AV1E_SET_CHROMA_SAMPLE_POSITION, aomImage->csp);
     }
 
-    if (monochromeRequested && !codec->internal->monochromeEnabled) {
-        // The user requested monochrome (via alpha or YUV400) but libaom cannot currently support
-        // monochrome (see chroma_check comment above). Manually set UV planes to 0.5.
-
-        // aomImage is always 420 when we're monochrome
-        uint32_t monoUVWidth = (image->width + 1) >> 1;
-        uint32_t monoUVHeight = (image->height + 1) >> 1;
-
-        for (int yuvPlane = 1; yuvPlane < 3; ++yuvPlane) {
-            if (image->depth > 8) {
-                const uint16_t half = 1 << (image->depth - 1);
-                for (uint32_t j = 0; j < monoUVHeight; ++j) {
-                    uint16_t * dstRow = (uint16_t *)&aomImage->planes[yuvPlane][j * aomImage->stride[yuvPlane]];
-                    for (uint32_t i = 0; i < monoUVWidth; ++i) {
-                        dstRow[i] = half;
-                    }
-                }
-            } else {
-                const uint8_t half = 128;
-                size_t planeSize = (size_t)monoUVHeight * aomImage->stride[yuvPlane];
-                memset(aomImage->planes[yuvPlane], half, planeSize);
+    // A layered image is the same picture encoded once per spatial layer, starting from a coarse
+    // quantizer and converging to the requested one in the last layer. Each layer refines the
+    // previous one and comes out as its own packet (sample).
+    const int lastLayerIndex = encoder->extraLayerCount;
+    for (int layerIndex = 0; layerIndex <= lastLayerIndex; ++layerIndex) {
+        aom_enc_frame_flags_t encodeFlags = 0;
+        if (addImageFlags & AVIF_ADD_IMAGE_FLAG_FORCE_KEYFRAME) {
+            encodeFlags |= AOM_EFLAG_FORCE_KF;
+        }
+        if (lastLayerIndex > 0) {
+            struct aom_codec_enc_cfg * cfg = &codec->internal->cfg;
+            int minQuantizer = AVIF_CLAMP(alpha ? encoder->minQuantizerAlpha : encoder->minQuantizer, 0, 63);
+            int maxQuantizer = AVIF_CLAMP(alpha ? encoder->maxQuantizerAlpha : encoder->maxQuantizer, 0, 63);
+            minQuantizer += ((63 - minQuantizer) * (lastLayerIndex - layerIndex)) / lastLayerIndex;
+            maxQuantizer += ((63 - maxQuantizer) * (lastLayerIndex - layerIndex)) / lastLayerIndex;
+            cfg->rc_min_quantizer = minQuantizer;
+            cfg->rc_max_quantizer = maxQuantizer;
+            if (aom_codec_enc_config_set(&codec->internal->encoder, cfg) != AOM_CODEC_OK) {
+                return AVIF_RESULT_UNKNOWN_ERROR;
+            }
+            if ((cfg->rc_end_usage == AOM_Q) && !codec->internal->cqLevelSet) {
+                aom_codec_control(&codec->internal->encoder, AOME_SET_CQ_LEVEL, (minQuantizer + maxQuantizer) / 2);
+            }
+            aom_codec_control(&codec->internal->encoder, AV1E_SET_LOSSLESS, (minQuantizer == 0) && (maxQuantizer == 0));
+            aom_codec_control(&codec->internal->encoder, AOME_SET_SPATIAL_LAYER_ID, layerIndex);
+            if (layerIndex > 0) {
+                // Only predict from the previous layer, and leave the other references alone.
+                encodeFlags = AOM_EFLAG_NO_REF_LAST2 | AOM_EFLAG_NO_REF_LAST3 | AOM_EFLAG_NO_REF_GF | AOM_EFLAG_NO_REF_ARF |
+                              AOM_EFLAG_NO_REF_BWD | AOM_EFLAG_NO_REF_ARF2 | AOM_EFLAG_NO_UPD_GF | AOM_EFLAG_NO_UPD_ARF;
             }
         }
-    }
-
-    aom_enc_frame_flags_t encodeFlags = 0;
-    if (addImageFlags & AVIF_ADD_IMAGE_FLAG_FORCE_KEYFRAME) {
-        encodeFlags |= AOM_EFLAG_FORCE_KF;
-    }
-    if (aom_codec_encode(&codec->internal->encoder, aomImage, 0, 1, encodeFlags) != AOM_CODEC_OK) {
-        avifDiagnosticsPrintf(codec->diag,
-                              "aom_codec_encode() failed: %s: %s",
-                              aom_codec_error(&codec->internal->encoder),
-                              aom_codec_error_detail(&codec->internal->encoder));
-        return AVIF_RESULT_UNKNOWN_ERROR;
-    }
-
-    aom_codec_iter_t iter = NULL;
-    for (;;) {
-        const aom_codec_cx_pkt_t * pkt = aom_codec_get_cx_data(&codec->internal->encoder, &iter);
-        if (pkt == NULL) {
-            break;
+        if (aom_codec_encode(&codec->internal->encoder, aomImage, 0, 1, encodeFlags) != AOM_CODEC_OK) {
+            avifDiagnosticsPrintf(codec->diag,
+                                  "aom_codec_encode() failed: %s: %s",
+                                  aom_codec_error(&codec->internal->encoder),
+                                  aom_codec_error_detail(&codec->internal->encoder));
+            return AVIF_RESULT_UNKNOWN_ERROR;
         }
-        if (pkt->kind == AOM_CODEC_CX_FRAME_PKT) {
-            avifCodecEncodeOutputAddSample(output, pkt->data.frame.buf, pkt->data.frame.sz, (pkt->data.frame.flags & AOM_FRAME_IS_KEY));
+
+        aom_codec_iter_t iter = NULL;
+        for (;;) {
+            const aom_codec_cx_pkt_t * pkt = aom_codec_get_cx_data(&codec->internal->encoder, &iter);
+            if (pkt == NULL) {
+                break;
+            }
+            if (pkt->kind == AOM_CODEC_CX_FRAME_PKT) {
+                avifCodecEncodeOutputAddSample(output,
+                                               pkt->data.frame.buf,
+                                               pkt->data.frame.sz,
+                                               (pkt->data.frame.flags & AOM_FRAME_IS_KEY));
+            }
         }
     }
 
-    aom_img_free(aomImage);
-
     if (addImageFlags & AVIF_ADD_IMAGE_FLAG_SINGLE) {
         // Flush and clean up encoder resources early to save on overhead when encoding alpha or grid images
 
@@ -29,13 +29,51 @@ struct avifCodecInternal
     Dav1dPicture dav1dPicture;
     avifBool hasPicture;
     avifRange colorRange;
+    avifFrameBufferAllocator frameBufferAllocator;
 };
 
-static void avifDav1dFreeCallback(const uint8_t * buf, void * cookie)
+// Dav1dPicAllocator callbacks placing pictures in blocks from decoder->frameBufferAllocator. The
+// layout is the one of dav1d's default allocator: planes padded to 128 pixels, with strides bumped
+// off multiples of 1024 bytes to avoid cache set aliasing.
+static int avifDav1dAllocPicture(Dav1dPicture * picture, void * cookie)
 {
-    // This data is owned by the decoder; nothing to free here
-    (void)buf;
-    (void)cookie;
+    const avifFrameBufferAllocator * allocator = (const avifFrameBufferAllocator *)cookie;
+    const int hbd = picture->p.bpc > 8;
+    const int alignedWidth = (picture->p.w + 127) & ~127;
+    const int alignedHeight = (picture->p.h + 127) & ~127;
+    const int hasChroma = picture->p.layout != DAV1D_PIXEL_LAYOUT_I400;
+    const int chromaShiftX = picture->p.layout != DAV1D_PIXEL_LAYOUT_I444;
+    const int chromaShiftY = picture->p.layout == DAV1D_PIXEL_LAYOUT_I420;
+    ptrdiff_t yStride = (ptrdiff_t)alignedWidth << hbd;
+    ptrdiff_t uvStride = hasChroma ? (yStride >> chromaShiftX) : 0;
+    if (!(yStride & 1023)) {
+        yStride += DAV1D_PICTURE_ALIGNMENT;
+    }
+    if (hasChroma && !(uvStride & 1023)) {
+        uvStride += DAV1D_PICTURE_ALIGNMENT;
+    }
+    const size_t ySize = (size_t)yStride * alignedHeight;
+    const size_t uvSize = (size_t)uvStride * (alignedHeight >> chromaShiftY);
+
+    // dav1d may read (but not use) up to DAV1D_PICTURE_ALIGNMENT bytes past the end of the picture
+    const size_t size = ySize + (2 * uvSize) + DAV1D_PICTURE_ALIGNMENT;
+    uint8_t * data = (uint8_t *)allocator->alloc(allocator->userData, size, DAV1D_PICTURE_ALIGNMENT);
+    if (!data) {
+        return DAV1D_ERR(ENOMEM);
+    }
+    picture->stride[0] = yStride;
+    picture->stride[1] = uvStride;
+    picture->data[0] = data;
+    picture->data[1] = hasChroma ? (data + ySize) : NULL;
+    picture->data[2] = hasChroma ? (data + ySize + uvSize) : NULL;
+    picture->allocator_data = data;
+    return 0;
+}
+
+static void avifDav1dReleasePicture(Dav1dPicture * picture, void * cookie)
+{
+    const avifFrameBufferAllocator * allocator = (const avifFrameBufferAllocator *)cookie;
+    allocator->release(allocator->userData, picture->allocator_data);
 }
 
 static void dav1dCodecDestroyInternal(avifCodec * codec)
@@ -53,8 +91,21 @@ static avifBool dav1dCodecOpen(avifCodec * codec, avifDecoder * decoder)
 {
     if (codec->internal->dav1dContext == NULL) {
         // Give all available threads to decode a single frame as fast as possible
+#if DAV1D_API_VERSION_MAJOR >= 6
+        codec->internal->dav1dSettings.max_frame_delay = 1;
+        codec->internal->dav1dSettings.n_threads = AVIF_CLAMP(codec->maxThreads, 1, DAV1D_MAX_THREADS);
+#else
         codec->internal->dav1dSettings.n_frame_threads = 1;
-        codec->internal->dav1dSettings.n_tile_threads = AVIF_CLAMP(decoder->maxThreads, 1, DAV1D_MAX_TILE_THREADS);
+        codec->internal->dav1dSettings.n_tile_threads = AVIF_CLAMP(codec->maxThreads, 1, DAV1D_MAX_TILE_THREADS);
+#endif // DAV1D_API_VERSION_MAJOR >= 6
+        codec->internal->dav1dSettings.operating_point = codec->operatingPoint;
+        codec->internal->dav1dSettings.all_layers = codec->allLayers;
+        if (decoder->frameBufferAllocator.alloc) {
+            codec->internal->frameBufferAllocator = decoder->frameBufferAllocator;
+            codec->internal->dav1dSettings.allocator.cookie = &codec->internal->frameBufferAllocator;
+            codec->internal->dav1dSettings.allocator.alloc_picture_callback = avifDav1dAllocPicture;
+            codec->internal->dav1dSettings.allocator.release_picture_callback = avifDav1dReleasePicture;
+        }
 
         if (dav1d_open(&codec->internal->dav1dContext, &codec->internal->dav1dSettings) != 0) {
             return AVIF_FALSE;
@@ -69,10 +120,14 @@ static avifBool dav1dCodecGetNextImage(struct avifCodec * codec, const avifDecod
     Dav1dPicture nextFrame;
     memset(&nextFrame, 0, sizeof(Dav1dPicture));
 
+    // dav1d keeps whatever it hasn't consumed of a sample across calls, and the sample's data may be
+    // released as soon as this returns, so hand dav1d a copy it owns.
     Dav1dData dav1dData;
-    if (dav1d_data_wrap(&dav1dData, sample->data.data, sample->data.size, avifDav1dFreeCallback, NULL) != 0) {
+    uint8_t * dav1dDataBuffer = dav1d_data_create(&dav1dData, sample->data.size);
+    if (!dav1dDataBuffer) {
         return AVIF_FALSE;
     }
+    memcpy(dav1dDataBuffer, sample->data.data, sample->data.size);
 
     for (;;) {
         if (dav1dData.data) {
@@ -96,6 +151,9 @@ static avifBool dav1dCodecGetNextImage(struct avifCodec * codec, const avifDecod
                 dav1d_data_unref(&dav1dData);
             }
             return AVIF_FALSE;
+        } else if (sample->selectSpatialLayer && (nextFrame.frame_hdr->spatial_id != sample->spatialID)) {
+            // Not the layer chosen by the item's lsel property
+            dav1d_picture_unref(&nextFrame);
         } else {
             // Got a picture!
             gotPicture = AVIF_TRUE;
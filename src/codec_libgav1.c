@@ -7,12 +7,36 @@
 
 #include <string.h>
 
+// A frame buffer handed to libgav1 through its get_frame_buffer callback. Buffers are recycled once
+// libgav1 releases them (it holds on to reference frames and to the last output frame), so that a
+// sequence decodes without allocating once the pool has grown to the number of frames in use.
+typedef struct avifGav1FrameBuffer
+{
+    uint8_t * data;
+    size_t size;
+    avifBool inUse;
+} avifGav1FrameBuffer;
+AVIF_ARRAY_DECLARE(avifGav1FrameBufferArray, avifGav1FrameBuffer *, buffer);
+
 struct avifCodecInternal
 {
     Libgav1DecoderSettings gav1Settings;
     Libgav1Decoder * gav1Decoder;
     const Libgav1DecoderBuffer * gav1Image;
     avifRange colorRange;
+
+    // If set (decoder->frameBufferAllocator), frame buffers come from it rather than from the pool
+    avifFrameBufferAllocator frameBufferAllocator;
+
+    // In frame parallel mode, libgav1 calls the frame buffer callbacks from its worker threads
+    avifMutex * frameBuffersMutex;
+    avifGav1FrameBufferArray frameBuffers;
+
+    // Copies of the samples given to gav1CodecPrefetch(), oldest first, which libgav1 reads until
+    // their frame is dequeued by gav1CodecGetNextImage().
+    avifRWData * prefetchedSamples;
+    uint32_t prefetchedHead;
+    uint32_t prefetchedCount;
 };
 
 static void gav1CodecDestroyInternal(avifCodec * codec)
@@ -20,13 +44,128 @@ static void gav1CodecDestroyInternal(avifCodec * codec)
     if (codec->internal->gav1Decoder != NULL) {
         Libgav1DecoderDestroy(codec->internal->gav1Decoder);
     }
+    for (uint32_t i = 0; i < codec->internal->frameBuffers.count; ++i) {
+        avifGav1FrameBuffer * frameBuffer = codec->internal->frameBuffers.buffer[i];
+        avifFree(frameBuffer->data);
+        avifFree(frameBuffer);
+    }
+    avifArrayDestroy(&codec->internal->frameBuffers);
+    avifMutexDestroy(codec->internal->frameBuffersMutex);
+    if (codec->internal->prefetchedSamples) {
+        for (uint32_t i = 0; i < codec->lookahead; ++i) {
+            avifRWDataFree(&codec->internal->prefetchedSamples[i]);
+        }
+        avifFree(codec->internal->prefetchedSamples);
+    }
     avifFree(codec->internal);
 }
 
+static Libgav1StatusCode gav1GetFrameBuffer(void * callbackPrivateData,
+                                            int bitdepth,
+                                            Libgav1ImageFormat imageFormat,
+                                            int width,
+                                            int height,
+                                            int leftBorder,
+                                            int rightBorder,
+                                            int topBorder,
+                                            int bottomBorder,
+                                            int strideAlignment,
+                                            Libgav1FrameBuffer * frameBuffer)
+{
+    struct avifCodecInternal * internal = (struct avifCodecInternal *)callbackPrivateData;
+    Libgav1FrameBufferInfo info;
+    Libgav1StatusCode status = Libgav1ComputeFrameBufferInfo(bitdepth,
+                                                             imageFormat,
+                                                             width,
+                                                             height,
+                                                             leftBorder,
+                                                             rightBorder,
+                                                             topBorder,
+                                                             bottomBorder,
+                                                             strideAlignment,
+                                                             &info);
+    if (status != kLibgav1StatusOk) {
+        return status;
+    }
+    const size_t size = info.y_buffer_size + (2 * info.uv_buffer_size);
+
+    if (internal->frameBufferAllocator.alloc) {
+        uint8_t * data = (uint8_t *)internal->frameBufferAllocator.alloc(internal->frameBufferAllocator.userData,
+                                                                         size,
+                                                                         (size_t)AVIF_MAX(strideAlignment, 1));
+        if (!data) {
+            return kLibgav1StatusOutOfMemory;
+        }
+        uint8_t * uBuffer = (info.uv_buffer_size > 0) ? (data + info.y_buffer_size) : NULL;
+        uint8_t * vBuffer = (info.uv_buffer_size > 0) ? (uBuffer + info.uv_buffer_size) : NULL;
+        return Libgav1SetFrameBuffer(&info, data, uBuffer, vBuffer, data, frameBuffer);
+    }
+
+    // Take the first free buffer that is large enough, or else grow a free one, or else add one
+    avifMutexLock(internal->frameBuffersMutex);
+    avifGav1FrameBuffer * buffer = NULL;
+    for (uint32_t i = 0; i < internal->frameBuffers.count; ++i) {
+        avifGav1FrameBuffer * candidate = internal->frameBuffers.buffer[i];
+        if (!candidate->inUse && (!buffer || (buffer->size < size))) {
+            buffer = candidate;
+            if (buffer->size >= size) {
+                break;
+            }
+        }
+    }
+    if (!buffer) {
+        buffer = (avifGav1FrameBuffer *)avifAlloc(sizeof(avifGav1FrameBuffer));
+        memset(buffer, 0, sizeof(avifGav1FrameBuffer));
+        avifGav1FrameBuffer ** slot = (avifGav1FrameBuffer **)avifArrayPushPtr(&internal->frameBuffers);
+        *slot = buffer;
+    }
+    buffer->inUse = AVIF_TRUE;
+    avifMutexUnlock(internal->frameBuffersMutex);
+
+    if (buffer->size < size) {
+        avifFree(buffer->data);
+        buffer->data = (uint8_t *)avifAlloc(size);
+        buffer->size = size;
+    }
+    uint8_t * uBuffer = (info.uv_buffer_size > 0) ? (buffer->data + info.y_buffer_size) : NULL;
+    uint8_t * vBuffer = (info.uv_buffer_size > 0) ? (uBuffer + info.uv_buffer_size) : NULL;
+    return Libgav1SetFrameBuffer(&info, buffer->data, uBuffer, vBuffer, buffer, frameBuffer);
+}
+
+static void gav1ReleaseFrameBuffer(void * callbackPrivateData, void * bufferPrivateData)
+{
+    struct avifCodecInternal * internal = (struct avifCodecInternal *)callbackPrivateData;
+    if (internal->frameBufferAllocator.alloc) {
+        internal->frameBufferAllocator.release(internal->frameBufferAllocator.userData, bufferPrivateData);
+        return;
+    }
+    avifGav1FrameBuffer * buffer = (avifGav1FrameBuffer *)bufferPrivateData;
+    avifMutexLock(internal->frameBuffersMutex);
+    buffer->inUse = AVIF_FALSE;
+    avifMutexUnlock(internal->frameBuffersMutex);
+}
+
 static avifBool gav1CodecOpen(avifCodec * codec, avifDecoder * decoder)
 {
     if (codec->internal->gav1Decoder == NULL) {
-        codec->internal->gav1Settings.threads = decoder->maxThreads;
+        codec->internal->gav1Settings.threads = codec->maxThreads;
+        codec->internal->gav1Settings.operating_point = codec->operatingPoint;
+        codec->internal->gav1Settings.output_all_layers = codec->allLayers;
+        codec->internal->gav1Settings.get_frame_buffer = gav1GetFrameBuffer;
+        codec->internal->gav1Settings.release_frame_buffer = gav1ReleaseFrameBuffer;
+        codec->internal->gav1Settings.callback_private_data = codec->internal;
+        codec->internal->frameBufferAllocator = decoder->frameBufferAllocator;
+
+        // Frame parallel decoding spreads the threads over consecutive frames rather than the tiles
+        // and rows of a single frame, which needs several frames to be enqueued (see prefetch).
+        // Layered samples are left alone, as their frames depend on each other.
+        if (decoder->frameParallel && (codec->maxThreads > 1) && codec->imageSequence && !codec->allLayers) {
+            codec->internal->gav1Settings.frame_parallel = 1;
+            codec->internal->gav1Settings.blocking_dequeue = 1;
+            codec->lookahead = (uint32_t)codec->maxThreads;
+            codec->internal->prefetchedSamples = (avifRWData *)avifAlloc(sizeof(avifRWData) * codec->lookahead);
+            memset(codec->internal->prefetchedSamples, 0, sizeof(avifRWData) * codec->lookahead);
+        }
 
         if (Libgav1DecoderCreate(&codec->internal->gav1Settings, &codec->internal->gav1Decoder) != kLibgav1StatusOk) {
             return AVIF_FALSE;
@@ -35,13 +174,37 @@ static avifBool gav1CodecOpen(avifCodec * codec, avifDecoder * decoder)
     return AVIF_TRUE;
 }
 
-static avifBool gav1CodecGetNextImage(struct avifCodec * codec, const avifDecodeSample * sample, avifBool alpha, avifImage * image)
+static avifBool gav1CodecPrefetch(struct avifCodec * codec, const avifDecodeSample * sample)
 {
+    if (codec->internal->prefetchedCount == codec->lookahead) {
+        return AVIF_FALSE;
+    }
+    // libgav1 doesn't copy the data, and the caller's copy doesn't outlive this call
+    const uint32_t slot = (codec->internal->prefetchedHead + codec->internal->prefetchedCount) % codec->lookahead;
+    avifRWData * data = &codec->internal->prefetchedSamples[slot];
+    avifRWDataSet(data, sample->data.data, sample->data.size);
     if (Libgav1DecoderEnqueueFrame(codec->internal->gav1Decoder,
-                                   sample->data.data,
-                                   sample->data.size,
+                                   data->data,
+                                   data->size,
                                    /*user_private_data=*/0,
                                    /*buffer_private_data=*/NULL) != kLibgav1StatusOk) {
+        // Most likely kLibgav1StatusTryAgain (the decoder's queue is full); getNextImage() will
+        // enqueue this sample itself.
+        return AVIF_FALSE;
+    }
+    ++codec->internal->prefetchedCount;
+    return AVIF_TRUE;
+}
+
+static avifBool gav1CodecGetNextImage(struct avifCodec * codec, const avifDecodeSample * sample, avifBool alpha, avifImage * image)
+{
+    // Samples come in order, so if any were prefetched, the oldest one is this sample.
+    const avifBool prefetched = (codec->internal->prefetchedCount > 0);
+    if (!prefetched && (Libgav1DecoderEnqueueFrame(codec->internal->gav1Decoder,
+                                                   sample->data.data,
+                                                   sample->data.size,
+                                                   /*user_private_data=*/0,
+                                                   /*buffer_private_data=*/NULL) != kLibgav1StatusOk)) {
         return AVIF_FALSE;
     }
     // Each Libgav1DecoderDequeueFrame() call invalidates the output frame
@@ -49,11 +212,21 @@ static avifBool gav1CodecGetNextImage(struct avifCodec * codec, const avifDecode
     // our pointer to the previous output frame.
     codec->internal->gav1Image = NULL;
     const Libgav1DecoderBuffer * nextFrame = NULL;
-    if (Libgav1DecoderDequeueFrame(codec->internal->gav1Decoder, &nextFrame) != kLibgav1StatusOk) {
-        return AVIF_FALSE;
-    }
+    do {
+        if (Libgav1DecoderDequeueFrame(codec->internal->gav1Decoder, &nextFrame) != kLibgav1StatusOk) {
+            return AVIF_FALSE;
+        }
+        // Skip the layers that weren't chosen by the item's lsel property, if any
+    } while (nextFrame && sample->selectSpatialLayer && (nextFrame->spatial_id != sample->spatialID));
     // Got an image!
 
+    if (prefetched) {
+        // libgav1 is done with this sample's data
+        avifRWDataFree(&codec->internal->prefetchedSamples[codec->internal->prefetchedHead]);
+        codec->internal->prefetchedHead = (codec->internal->prefetchedHead + 1) % codec->lookahead;
+        --codec->internal->prefetchedCount;
+    }
+
     if (nextFrame) {
         codec->internal->gav1Image = nextFrame;
         codec->internal->colorRange = (nextFrame->color_range == kLibgav1ColorRangeStudio) ? AVIF_RANGE_LIMITED : AVIF_RANGE_FULL;
@@ -152,10 +325,13 @@ avifCodec * avifCodecCreateGav1(void)
     memset(codec, 0, sizeof(struct avifCodec));
     codec->open = gav1CodecOpen;
     codec->getNextImage = gav1CodecGetNextImage;
+    codec->prefetch = gav1CodecPrefetch;
     codec->destroyInternal = gav1CodecDestroyInternal;
 
     codec->internal = (struct avifCodecInternal *)avifAlloc(sizeof(struct avifCodecInternal));
     memset(codec->internal, 0, sizeof(struct avifCodecInternal));
     Libgav1DecoderSettingsInitDefault(&codec->internal->gav1Settings);
+    codec->internal->frameBuffersMutex = avifMutexCreate();
+    avifArrayCreate(&codec->internal->frameBuffers, sizeof(avifGav1FrameBuffer *), 4);
     return codec;
 }
@@ -59,6 +59,11 @@ static avifResult rav1eCodecEncodeImage(avifCodec * codec,
     RaConfig * rav1eConfig = NULL;
     RaFrame * rav1eFrame = NULL;
 
+    if (encoder->extraLayerCount > 0) {
+        avifDiagnosticsPrintf(codec->diag, "rav1e does not support layered (progressive) encoding");
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+
     if (!codec->internal->rav1eContext) {
         if (codec->csOptions->count > 0) {
             // None are currently supported!
@@ -115,7 +120,7 @@ static avifResult rav1eCodecEncodeImage(avifCodec * codec,
         if (rav1e_config_parse_int(rav1eConfig, "height", image->height) == -1) {
             goto cleanup;
         }
-        if (rav1e_config_parse_int(rav1eConfig, "threads", encoder->maxThreads) == -1) {
+        if (rav1e_config_parse_int(rav1eConfig, "threads", codec->maxThreads) == -1) {
             goto cleanup;
         }
 
@@ -133,14 +138,14 @@ static avifResult rav1eCodecEncodeImage(avifCodec * codec,
         if (rav1e_config_parse_int(rav1eConfig, "quantizer", maxQuantizer) == -1) {
             goto cleanup;
         }
-        if (encoder->tileRowsLog2 != 0) {
-            int tileRowsLog2 = AVIF_CLAMP(encoder->tileRowsLog2, 0, 6);
+        if (codec->tileRowsLog2 != 0) {
+            int tileRowsLog2 = AVIF_CLAMP(codec->tileRowsLog2, 0, 6);
             if (rav1e_config_parse_int(rav1eConfig, "tile_rows", 1 << tileRowsLog2) == -1) {
                 goto cleanup;
             }
         }
-        if (encoder->tileColsLog2 != 0) {
-            int tileColsLog2 = AVIF_CLAMP(encoder->tileColsLog2, 0, 6);
+        if (codec->tileColsLog2 != 0) {
+            int tileColsLog2 = AVIF_CLAMP(codec->tileColsLog2, 0, 6);
             if (rav1e_config_parse_int(rav1eConfig, "tile_cols", 1 << tileColsLog2) == -1) {
                 goto cleanup;
             }
@@ -19,9 +19,13 @@ typedef struct avifCodecInternal
     EbComponentType * svt_encoder;
 
     EbSvtAv1EncConfiguration * svt_config;
+
+    // svt_av1_enc_send_picture() copies the picture into the encoder's own input buffers, so a
+    // single header is enough and is reused for every frame.
+    EbBufferHeaderType input_buffer;
+    EbSvtIOFormat input_picture_buffer;
 } avifCodecInternal;
 
-static avifBool allocate_svt_buffers(EbBufferHeaderType ** input_buf);
 static avifResult dequeue_frame(avifCodec * codec, avifCodecEncodeOutput * output, avifBool done_sending_pics);
 
 static avifResult svtCodecEncodeImage(avifCodec * codec,
@@ -33,9 +37,13 @@ static avifResult svtCodecEncodeImage(avifCodec * codec,
 {
     avifResult result = AVIF_RESULT_UNKNOWN_ERROR;
     EbColorFormat color_format = EB_YUV420;
-    EbBufferHeaderType * input_buffer = NULL;
     EbErrorType res = EB_ErrorNone;
 
+    if (encoder->extraLayerCount > 0) {
+        avifDiagnosticsPrintf(codec->diag, "SVT-AV1 does not support layered (progressive) encoding");
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+
     int y_shift = 0;
     // EbColorRange svt_range;
     if (alpha) {
@@ -85,7 +93,7 @@ static avifResult svtCodecEncodeImage(avifCodec * codec,
 
         svt_config->source_width = image->width;
         svt_config->source_height = image->height;
-        svt_config->logical_processors = encoder->maxThreads;
+        svt_config->logical_processors = codec->maxThreads;
         svt_config->enable_adaptive_quantization = AVIF_FALSE;
         // disable 2-pass
         svt_config->rc_firstpass_stats_out = AVIF_FALSE;
@@ -99,12 +107,12 @@ static avifResult svtCodecEncodeImage(avifCodec * codec,
             svt_config->qp = AVIF_CLAMP(encoder->maxQuantizer, 0, 63);
         }
 
-        if (encoder->tileRowsLog2 != 0) {
-            int tileRowsLog2 = AVIF_CLAMP(encoder->tileRowsLog2, 0, 6);
+        if (codec->tileRowsLog2 != 0) {
+            int tileRowsLog2 = AVIF_CLAMP(codec->tileRowsLog2, 0, 6);
             svt_config->tile_rows = 1 << tileRowsLog2;
         }
-        if (encoder->tileColsLog2 != 0) {
-            int tileColsLog2 = AVIF_CLAMP(encoder->tileColsLog2, 0, 6);
+        if (codec->tileColsLog2 != 0) {
+            int tileColsLog2 = AVIF_CLAMP(codec->tileColsLog2, 0, 6);
             svt_config->tile_columns = 1 << tileColsLog2;
         }
         if (encoder->speed != AVIF_SPEED_DEFAULT) {
@@ -129,10 +137,12 @@ static avifResult svtCodecEncodeImage(avifCodec * codec,
         }
     }
 
-    if (!allocate_svt_buffers(&input_buffer)) {
-        goto cleanup;
-    }
-    EbSvtIOFormat * input_picture_buffer = (EbSvtIOFormat *)input_buffer->p_buffer;
+    EbBufferHeaderType * input_buffer = &codec->internal->input_buffer;
+    EbSvtIOFormat * input_picture_buffer = &codec->internal->input_picture_buffer;
+    memset(input_picture_buffer, 0, sizeof(EbSvtIOFormat));
+    input_buffer->size = sizeof(EbBufferHeaderType);
+    input_buffer->p_buffer = (uint8_t *)input_picture_buffer;
+    input_buffer->p_app_private = NULL;
 
     int bytesPerPixel = image->depth > 8 ? 2 : 1;
     if (alpha) {
@@ -166,14 +176,11 @@ static avifResult svtCodecEncodeImage(avifCodec * codec,
         goto cleanup;
     }
 
+    // Only collect the packets that are already done; svt_av1_enc_get_packet() doesn't block until
+    // the EOS is sent, so the frames still in SVT's pipeline keep encoding while the caller
+    // prepares the next one.
     result = dequeue_frame(codec, output, AVIF_FALSE);
 cleanup:
-    if (input_buffer) {
-        if (input_buffer->p_buffer) {
-            avifFree(input_buffer->p_buffer);
-        }
-        avifFree(input_buffer);
-    }
     return result;
 }
 
@@ -230,24 +237,6 @@ avifCodec * avifCodecCreateSvt(void)
     return codec;
 }
 
-static avifBool allocate_svt_buffers(EbBufferHeaderType ** input_buf)
-{
-    *input_buf = avifAlloc(sizeof(EbBufferHeaderType));
-    if (!(*input_buf)) {
-        return AVIF_FALSE;
-    }
-    (*input_buf)->p_buffer = avifAlloc(sizeof(EbSvtIOFormat));
-    if (!(*input_buf)->p_buffer) {
-        return AVIF_FALSE;
-    }
-    memset((*input_buf)->p_buffer, 0, sizeof(EbSvtIOFormat));
-    (*input_buf)->size = sizeof(EbBufferHeaderType);
-    (*input_buf)->p_app_private = NULL;
-    (*input_buf)->pic_type = EB_AV1_INVALID_PICTURE;
-
-    return AVIF_TRUE;
-}
-
 static avifResult dequeue_frame(avifCodec * codec, avifCodecEncodeOutput * output, avifBool done_sending_pics)
 {
     EbErrorType res;
@@ -6,6 +6,7 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define AUXTYPE_SIZE 64
@@ -30,6 +31,9 @@
 // }
 static const size_t VISUALSAMPLEENTRY_SIZE = 78;
 
+// Height (in rows) of the RGB strips delivered by avifDecoderNextImageRGBRows() for non-grid images
+static const uint32_t RGB_ROWS_STRIP_HEIGHT = 64;
+
 static const char xmpContentType[] = CONTENT_TYPE_XMP;
 static const size_t xmpContentTypeSize = sizeof(xmpContentType);
 
@@ -90,6 +94,26 @@ typedef struct avifPixelInformationProperty
     uint8_t planeCount;
 } avifPixelInformationProperty;
 
+// a1op
+typedef struct avifOperatingPointSelectorProperty
+{
+    uint8_t opIndex;
+} avifOperatingPointSelectorProperty;
+
+// lsel
+#define AVIF_LAYER_ID_ALL 0xFFFF
+typedef struct avifLayerSelectorProperty
+{
+    uint16_t layerID; // AVIF_LAYER_ID_ALL if no specific layer is selected
+} avifLayerSelectorProperty;
+
+// a1lx
+#define MAX_AV1_LAYER_COUNT 4
+typedef struct avifAV1LayeredImageIndexingProperty
+{
+    uint32_t layerSize[MAX_AV1_LAYER_COUNT - 1]; // the last layer's size is implied by the item size
+} avifAV1LayeredImageIndexingProperty;
+
 // ---------------------------------------------------------------------------
 // Top-level structures
 
@@ -98,7 +122,7 @@ struct avifMeta;
 // Temporary storage for ipco/stsd contents until they can be associated and memcpy'd to an avifDecoderItem
 typedef struct avifProperty
 {
-    uint8_t type[4];
+    uint32_t type; // AVIF_FOURCC()
     union
     {
         avifImageSpatialExtents ispe;
@@ -110,19 +134,105 @@ typedef struct avifProperty
         avifImageRotation irot;
         avifImageMirror imir;
         avifPixelInformationProperty pixi;
+        avifOperatingPointSelectorProperty a1op;
+        avifLayerSelectorProperty lsel;
+        avifAV1LayeredImageIndexingProperty a1lx;
     } u;
 } avifProperty;
 AVIF_ARRAY_DECLARE(avifPropertyArray, avifProperty, prop);
 
-static const avifProperty * avifPropertyArrayFind(const avifPropertyArray * properties, const char * type)
+// The property types parsed by avifParseItemPropertyContainerBox(); any other property is ignored
+typedef enum avifPropertyKind
 {
-    for (uint32_t propertyIndex = 0; propertyIndex < properties->count; ++propertyIndex) {
-        avifProperty * prop = &properties->prop[propertyIndex];
-        if (!memcmp(prop->type, type, 4)) {
-            return prop;
-        }
+    AVIF_PROPERTY_ISPE = 0,
+    AVIF_PROPERTY_AUXC,
+    AVIF_PROPERTY_COLR,
+    AVIF_PROPERTY_AV1C,
+    AVIF_PROPERTY_PASP,
+    AVIF_PROPERTY_CLAP,
+    AVIF_PROPERTY_IROT,
+    AVIF_PROPERTY_IMIR,
+    AVIF_PROPERTY_PIXI,
+    AVIF_PROPERTY_A1OP,
+    AVIF_PROPERTY_LSEL,
+    AVIF_PROPERTY_A1LX,
+
+    AVIF_PROPERTY_KIND_COUNT // also returned for unsupported property types
+} avifPropertyKind;
+
+static avifPropertyKind avifPropertyKindFromType(uint32_t type)
+{
+    switch (type) {
+        case AVIF_FOURCC('i', 's', 'p', 'e'):
+            return AVIF_PROPERTY_ISPE;
+        case AVIF_FOURCC('a', 'u', 'x', 'C'):
+            return AVIF_PROPERTY_AUXC;
+        case AVIF_FOURCC('c', 'o', 'l', 'r'):
+            return AVIF_PROPERTY_COLR;
+        case AVIF_FOURCC('a', 'v', '1', 'C'):
+            return AVIF_PROPERTY_AV1C;
+        case AVIF_FOURCC('p', 'a', 's', 'p'):
+            return AVIF_PROPERTY_PASP;
+        case AVIF_FOURCC('c', 'l', 'a', 'p'):
+            return AVIF_PROPERTY_CLAP;
+        case AVIF_FOURCC('i', 'r', 'o', 't'):
+            return AVIF_PROPERTY_IROT;
+        case AVIF_FOURCC('i', 'm', 'i', 'r'):
+            return AVIF_PROPERTY_IMIR;
+        case AVIF_FOURCC('p', 'i', 'x', 'i'):
+            return AVIF_PROPERTY_PIXI;
+        case AVIF_FOURCC('a', '1', 'o', 'p'):
+            return AVIF_PROPERTY_A1OP;
+        case AVIF_FOURCC('l', 's', 'e', 'l'):
+            return AVIF_PROPERTY_LSEL;
+        case AVIF_FOURCC('a', '1', 'l', 'x'):
+            return AVIF_PROPERTY_A1LX;
+        default:
+            break;
     }
-    return NULL;
+    return AVIF_PROPERTY_KIND_COUNT;
+}
+
+// The properties of an item or sample description, along with the position of the first property
+// of each kind so that looking one up doesn't scan (and string compare) the whole list.
+typedef struct avifPropertyList
+{
+    avifPropertyArray array;
+    uint32_t index[AVIF_PROPERTY_KIND_COUNT]; // 1 + position in array of the first property of each kind; 0 if absent
+} avifPropertyList;
+
+static void avifPropertyListCreate(avifPropertyList * properties)
+{
+    avifArrayCreate(&properties->array, sizeof(avifProperty), 16);
+    memset(properties->index, 0, sizeof(properties->index));
+}
+
+static void avifPropertyListDestroy(avifPropertyList * properties)
+{
+    avifArrayDestroy(&properties->array);
+}
+
+// Records properties->array.prop[position] in the index, unless an earlier property of the same kind
+// is already there. Properties must be indexed in the order they were pushed.
+static void avifPropertyListIndex(avifPropertyList * properties, uint32_t position)
+{
+    const avifPropertyKind kind = avifPropertyKindFromType(properties->array.prop[position].type);
+    if ((kind != AVIF_PROPERTY_KIND_COUNT) && (properties->index[kind] == 0)) {
+        properties->index[kind] = position + 1;
+    }
+}
+
+static void avifPropertyListAdd(avifPropertyList * properties, const avifProperty * prop)
+{
+    avifProperty * dstProp = (avifProperty *)avifArrayPushPtr(&properties->array);
+    memcpy(dstProp, prop, sizeof(avifProperty));
+    avifPropertyListIndex(properties, properties->array.count - 1);
+}
+
+static const avifProperty * avifPropertyListFind(const avifPropertyList * properties, avifPropertyKind kind)
+{
+    const uint32_t position = properties->index[kind];
+    return position ? &properties->array.prop[position - 1] : NULL;
 }
 
 AVIF_ARRAY_DECLARE(avifExtentArray, avifExtent, extent);
@@ -136,7 +246,7 @@ typedef struct avifDecoderItem
     size_t size;
     uint32_t idatID; // If non-zero, offset is relative to this idat box (iloc construction_method==1)
     avifContentType contentType;
-    avifPropertyArray properties;
+    avifPropertyList properties;
     avifExtentArray extents;       // All extent offsets/sizes
     avifRWData mergedExtents;      // if set, is a single contiguous block of this item's extents (unused when extents.count == 1)
     avifBool ownsMergedExtents;    // if true, mergedExtents must be freed when this item is destroyed
@@ -207,10 +317,21 @@ AVIF_ARRAY_DECLARE(avifSyncSampleArray, avifSyncSample, syncSample);
 typedef struct avifSampleDescription
 {
     uint8_t format[4];
-    avifPropertyArray properties;
+    avifPropertyList properties;
 } avifSampleDescription;
 AVIF_ARRAY_DECLARE(avifSampleDescriptionArray, avifSampleDescription, description);
 
+// A run of consecutive chunks which all hold the same number of samples, as described by a single
+// stsc entry, along with the index of the first sample in the run.
+typedef struct avifSampleTableChunkRun
+{
+    uint32_t firstChunkIndex; // 0-based, unlike avifSampleTableSampleToChunk::firstChunk
+    uint32_t chunkCount;
+    uint32_t samplesPerChunk;
+    uint32_t firstSampleIndex;
+} avifSampleTableChunkRun;
+AVIF_ARRAY_DECLARE(avifSampleTableChunkRunArray, avifSampleTableChunkRun, chunkRun);
+
 typedef struct avifSampleTable
 {
     avifSampleTableChunkArray chunks;
@@ -220,6 +341,10 @@ typedef struct avifSampleTable
     avifSampleTableTimeToSampleArray timeToSamples;
     avifSyncSampleArray syncSamples;
     uint32_t allSamplesSize; // If this is non-zero, sampleSizes will be empty and all samples will be this size
+
+    // Set by avifCodecDecodeInputSetSampleTable(); used by avifSampleTableFindSample().
+    avifSampleTableChunkRunArray chunkRuns;
+    uint32_t sampleCount;
 } avifSampleTable;
 
 static avifSampleTable * avifSampleTableCreate()
@@ -232,6 +357,7 @@ static avifSampleTable * avifSampleTableCreate()
     avifArrayCreate(&sampleTable->sampleSizes, sizeof(avifSampleTableSampleSize), 16);
     avifArrayCreate(&sampleTable->timeToSamples, sizeof(avifSampleTableTimeToSample), 16);
     avifArrayCreate(&sampleTable->syncSamples, sizeof(avifSyncSample), 16);
+    avifArrayCreate(&sampleTable->chunkRuns, sizeof(avifSampleTableChunkRun), 4);
     return sampleTable;
 }
 
@@ -240,13 +366,14 @@ static void avifSampleTableDestroy(avifSampleTable * sampleTable)
     avifArrayDestroy(&sampleTable->chunks);
     for (uint32_t i = 0; i < sampleTable->sampleDescriptions.count; ++i) {
         avifSampleDescription * description = &sampleTable->sampleDescriptions.description[i];
-        avifArrayDestroy(&description->properties);
+        avifPropertyListDestroy(&description->properties);
     }
     avifArrayDestroy(&sampleTable->sampleDescriptions);
     avifArrayDestroy(&sampleTable->sampleToChunks);
     avifArrayDestroy(&sampleTable->sampleSizes);
     avifArrayDestroy(&sampleTable->timeToSamples);
     avifArrayDestroy(&sampleTable->syncSamples);
+    avifArrayDestroy(&sampleTable->chunkRuns);
     avifFree(sampleTable);
 }
 
@@ -298,7 +425,7 @@ static avifPixelFormat avifCodecConfigurationBoxGetFormat(const avifCodecConfigu
     return AVIF_PIXEL_FORMAT_YUV444;
 }
 
-static const avifPropertyArray * avifSampleTableGetProperties(const avifSampleTable * sampleTable)
+static const avifPropertyList * avifSampleTableGetProperties(const avifSampleTable * sampleTable)
 {
     for (uint32_t i = 0; i < sampleTable->sampleDescriptions.count; ++i) {
         const avifSampleDescription * description = &sampleTable->sampleDescriptions.description[i];
@@ -347,108 +474,214 @@ void avifCodecDecodeInputDestroy(avifCodecDecodeInput * decodeInput)
     avifFree(decodeInput);
 }
 
-// Returns how many samples are in the chunk.
-static uint32_t avifGetSampleCountOfChunk(const avifSampleTableSampleToChunkArray * sampleToChunks, uint32_t chunkIndex)
+// Image sequences don't get an avifDecodeSample per frame up front. Instead, the sample table's stsc
+// entries are condensed into chunk runs (one per stsc entry, so independent of the frame count), and
+// each sample's offset and size are looked up when it is requested: a binary search over the runs finds
+// its chunk, and the offset is the chunk's offset plus the sizes of the samples before it in that chunk.
+static avifBool avifCodecDecodeInputSetSampleTable(avifCodecDecodeInput * decodeInput,
+                                                   avifSampleTable * sampleTable,
+                                                   const uint32_t imageCountLimit,
+                                                   avifDiagnostics * diag)
 {
-    uint32_t sampleCount = 0;
-    for (int sampleToChunkIndex = sampleToChunks->count - 1; sampleToChunkIndex >= 0; --sampleToChunkIndex) {
-        const avifSampleTableSampleToChunk * sampleToChunk = &sampleToChunks->sampleToChunk[sampleToChunkIndex];
-        if (sampleToChunk->firstChunk <= (chunkIndex + 1)) {
-            sampleCount = sampleToChunk->samplesPerChunk;
+    sampleTable->chunkRuns.count = 0;
+    sampleTable->sampleCount = 0;
+
+    // avifParseSampleToChunkBox() guarantees that the first_chunk fields start at 1 and strictly
+    // increase, so each entry covers the chunks up to (but not including) the next entry's first chunk.
+    uint64_t sampleCount = 0;
+    for (uint32_t sampleToChunkIndex = 0; sampleToChunkIndex < sampleTable->sampleToChunks.count; ++sampleToChunkIndex) {
+        const avifSampleTableSampleToChunk * sampleToChunk = &sampleTable->sampleToChunks.sampleToChunk[sampleToChunkIndex];
+        if (sampleToChunk->firstChunk > sampleTable->chunks.count) {
+            // This entry (and any after it) describes chunks which don't exist
             break;
         }
+        if (sampleToChunk->samplesPerChunk == 0) {
+            // chunks with 0 samples are invalid
+            avifDiagnosticsPrintf(diag, "Sample table contains a chunk with 0 samples");
+            return AVIF_FALSE;
+        }
+
+        uint32_t endChunk = sampleTable->chunks.count; // 1-based, inclusive
+        if ((sampleToChunkIndex + 1) < sampleTable->sampleToChunks.count) {
+            endChunk = AVIF_MIN(endChunk, sampleTable->sampleToChunks.sampleToChunk[sampleToChunkIndex + 1].firstChunk - 1);
+        }
+
+        avifSampleTableChunkRun * chunkRun = (avifSampleTableChunkRun *)avifArrayPushPtr(&sampleTable->chunkRuns);
+        chunkRun->firstChunkIndex = sampleToChunk->firstChunk - 1;
+        chunkRun->chunkCount = endChunk - chunkRun->firstChunkIndex;
+        chunkRun->samplesPerChunk = sampleToChunk->samplesPerChunk;
+        chunkRun->firstSampleIndex = (uint32_t)sampleCount;
+
+        sampleCount += (uint64_t)chunkRun->chunkCount * chunkRun->samplesPerChunk;
+        if (sampleCount > UINT32_MAX) {
+            avifDiagnosticsPrintf(diag, "Sample table contains too many samples");
+            return AVIF_FALSE;
+        }
     }
-    return sampleCount;
+    if ((sampleTable->chunks.count > 0) && (sampleTable->chunkRuns.count == 0)) {
+        // No stsc box, so every chunk has 0 samples
+        avifDiagnosticsPrintf(diag, "Sample table contains a chunk with 0 samples");
+        return AVIF_FALSE;
+    }
+
+    if (imageCountLimit && (sampleCount > imageCountLimit)) {
+        // This file exceeds the imageCountLimit, bail out
+        avifDiagnosticsPrintf(diag, "Exceeded avifDecoder's imageCountLimit");
+        return AVIF_FALSE;
+    }
+    if ((sampleTable->allSamplesSize == 0) && (sampleCount > sampleTable->sampleSizes.count)) {
+        // We'd run out of samples to sum
+        avifDiagnosticsPrintf(diag, "Truncated sample table");
+        return AVIF_FALSE;
+    }
+
+    sampleTable->sampleCount = (uint32_t)sampleCount;
+    decodeInput->sampleTable = sampleTable;
+    decodeInput->samples.count = 0;
+    return AVIF_TRUE;
 }
 
-static avifBool avifCodecDecodeInputGetSamples(avifCodecDecodeInput * decodeInput,
-                                               avifSampleTable * sampleTable,
-                                               const uint32_t imageCountLimit,
-                                               const uint64_t sizeHint,
-                                               avifDiagnostics * diag)
+static uint32_t avifCodecDecodeInputSampleCount(const avifCodecDecodeInput * decodeInput)
 {
-    if (imageCountLimit) {
-        // Verify that the we're not about to exceed the frame count limit.
+    return decodeInput->sampleTable ? decodeInput->sampleTable->sampleCount : decodeInput->samples.count;
+}
 
-        uint32_t imageCountLeft = imageCountLimit;
-        for (uint32_t chunkIndex = 0; chunkIndex < sampleTable->chunks.count; ++chunkIndex) {
-            // First, figure out how many samples are in this chunk
-            uint32_t sampleCount = avifGetSampleCountOfChunk(&sampleTable->sampleToChunks, chunkIndex);
-            if (sampleCount == 0) {
-                // chunks with 0 samples are invalid
-                avifDiagnosticsPrintf(diag, "Sample table contains a chunk with 0 samples");
-                return AVIF_FALSE;
-            }
+static uint32_t avifSampleTableGetSampleSize(const avifSampleTable * sampleTable, uint32_t sampleIndex)
+{
+    return sampleTable->allSamplesSize ? sampleTable->allSamplesSize : sampleTable->sampleSizes.sampleSize[sampleIndex].size;
+}
 
-            if (sampleCount > imageCountLeft) {
-                // This file exceeds the imageCountLimit, bail out
-                avifDiagnosticsPrintf(diag, "Exceeded avifDecoder's imageCountLimit");
-                return AVIF_FALSE;
-            }
-            imageCountLeft -= sampleCount;
+static avifBool avifSampleTableIsSyncSample(const avifSampleTable * sampleTable, uint32_t sampleIndex)
+{
+    // Assume frame 0 is sync, just in case the stss box is absent in the BMFF. stss entries are
+    // required to be in increasing order.
+    if (sampleIndex == 0) {
+        return AVIF_TRUE;
+    }
+    uint32_t lo = 0;
+    uint32_t hi = sampleTable->syncSamples.count;
+    while (lo < hi) {
+        const uint32_t mid = lo + ((hi - lo) / 2);
+        const uint32_t sampleNumber = sampleTable->syncSamples.syncSample[mid].sampleNumber; // sampleNumber is 1-based
+        if (sampleNumber == (sampleIndex + 1)) {
+            return AVIF_TRUE;
+        }
+        if (sampleNumber < (sampleIndex + 1)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
+    return AVIF_FALSE;
+}
 
-    uint32_t sampleSizeIndex = 0;
-    for (uint32_t chunkIndex = 0; chunkIndex < sampleTable->chunks.count; ++chunkIndex) {
-        avifSampleTableChunk * chunk = &sampleTable->chunks.chunk[chunkIndex];
-
-        // First, figure out how many samples are in this chunk
-        uint32_t sampleCount = avifGetSampleCountOfChunk(&sampleTable->sampleToChunks, chunkIndex);
-        if (sampleCount == 0) {
-            // chunks with 0 samples are invalid
-            avifDiagnosticsPrintf(diag, "Sample table contains a chunk with 0 samples");
-            return AVIF_FALSE;
+// Finds the offset and size of sample sampleIndex (which must be < sampleTable->sampleCount). If
+// prevSample describes sample (sampleIndex - 1), it is used to avoid re-summing the sizes of the
+// samples before this one in its chunk, making sequential lookups O(1).
+static avifBool avifSampleTableFindSample(const avifSampleTable * sampleTable,
+                                          uint32_t sampleIndex,
+                                          const avifDecodeSample * prevSample,
+                                          uint64_t sizeHint,
+                                          avifDecodeSample * outSample,
+                                          avifDiagnostics * diag)
+{
+    // Find the last chunk run starting at or before sampleIndex
+    uint32_t lo = 0;
+    uint32_t hi = sampleTable->chunkRuns.count;
+    while ((hi - lo) > 1) {
+        const uint32_t mid = lo + ((hi - lo) / 2);
+        if (sampleTable->chunkRuns.chunkRun[mid].firstSampleIndex <= sampleIndex) {
+            lo = mid;
+        } else {
+            hi = mid;
         }
+    }
+    const avifSampleTableChunkRun * chunkRun = &sampleTable->chunkRuns.chunkRun[lo];
+    const uint32_t sampleIndexInRun = sampleIndex - chunkRun->firstSampleIndex;
+    const uint32_t chunkIndex = chunkRun->firstChunkIndex + (sampleIndexInRun / chunkRun->samplesPerChunk);
+    const uint32_t sampleIndexInChunk = sampleIndexInRun % chunkRun->samplesPerChunk;
 
-        uint64_t sampleOffset = chunk->offset;
-        for (uint32_t sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex) {
-            uint32_t sampleSize = sampleTable->allSamplesSize;
-            if (sampleSize == 0) {
-                if (sampleSizeIndex >= sampleTable->sampleSizes.count) {
-                    // We've run out of samples to sum
-                    avifDiagnosticsPrintf(diag, "Truncated sample table");
-                    return AVIF_FALSE;
-                }
-                avifSampleTableSampleSize * sampleSizePtr = &sampleTable->sampleSizes.sampleSize[sampleSizeIndex];
-                sampleSize = sampleSizePtr->size;
+    uint64_t sampleOffset;
+    if (prevSample && (sampleIndexInChunk > 0)) {
+        sampleOffset = prevSample->offset + prevSample->size;
+    } else {
+        sampleOffset = sampleTable->chunks.chunk[chunkIndex].offset;
+        for (uint32_t i = sampleIndex - sampleIndexInChunk; i < sampleIndex; ++i) {
+            const uint32_t size = avifSampleTableGetSampleSize(sampleTable, i);
+            if (size > UINT64_MAX - sampleOffset) {
+                avifDiagnosticsPrintf(diag, "Sample table contains an offset/size pair which overflows");
+                return AVIF_FALSE;
             }
+            sampleOffset += size;
+        }
+    }
+    const uint32_t sampleSize = avifSampleTableGetSampleSize(sampleTable, sampleIndex);
 
-            avifDecodeSample * sample = (avifDecodeSample *)avifArrayPushPtr(&decodeInput->samples);
-            sample->offset = sampleOffset;
-            sample->size = sampleSize;
-            sample->sync = AVIF_FALSE; // to potentially be set to true following the outer loop
+    if (sampleSize == 0) {
+        // Every sample must have some data
+        avifDiagnosticsPrintf(diag, "Sample table contains a sample with 0 bytes");
+        return AVIF_FALSE;
+    }
+    if (sampleSize > UINT64_MAX - sampleOffset) {
+        avifDiagnosticsPrintf(diag,
+                              "Sample table contains an offset/size pair which overflows: [%" PRIu64 " / %u]",
+                              sampleOffset,
+                              sampleSize);
+        return AVIF_FALSE;
+    }
+    if (sizeHint && ((sampleOffset + sampleSize) > sizeHint)) {
+        avifDiagnosticsPrintf(diag, "Exceeded avifIO's sizeHint, possibly truncated data");
+        return AVIF_FALSE;
+    }
 
-            if (sampleSize > UINT64_MAX - sampleOffset) {
-                avifDiagnosticsPrintf(diag,
-                                      "Sample table contains an offset/size pair which overflows: [%" PRIu64 " / %u]",
-                                      sampleOffset,
-                                      sampleSize);
-                return AVIF_FALSE;
-            }
-            if (sizeHint && ((sampleOffset + sampleSize) > sizeHint)) {
-                avifDiagnosticsPrintf(diag, "Exceeded avifIO's sizeHint, possibly truncated data");
-                return AVIF_FALSE;
-            }
+    memset(outSample, 0, sizeof(avifDecodeSample));
+    outSample->offset = sampleOffset;
+    outSample->size = sampleSize;
+    outSample->sync = avifSampleTableIsSyncSample(sampleTable, sampleIndex);
+    return AVIF_TRUE;
+}
 
-            sampleOffset += sampleSize;
-            ++sampleSizeIndex;
-        }
+// Returns sample sampleIndex of decodeInput, resolving it from the sample table if necessary. For
+// image sequences, the returned pointer (and any data read into it) is only valid until a different
+// sample is requested from the same decodeInput.
+static avifResult avifCodecDecodeInputGetSample(avifCodecDecodeInput * decodeInput,
+                                                uint32_t sampleIndex,
+                                                uint64_t sizeHint,
+                                                avifDiagnostics * diag,
+                                                avifDecodeSample ** outSample)
+{
+    if (sampleIndex >= avifCodecDecodeInputSampleCount(decodeInput)) {
+        return AVIF_RESULT_NO_IMAGES_REMAINING;
+    }
+    if (!decodeInput->sampleTable) {
+        *outSample = &decodeInput->samples.sample[sampleIndex];
+        return AVIF_RESULT_OK;
     }
 
-    // Mark appropriate samples as sync
-    for (uint32_t syncSampleIndex = 0; syncSampleIndex < sampleTable->syncSamples.count; ++syncSampleIndex) {
-        uint32_t frameIndex = sampleTable->syncSamples.syncSample[syncSampleIndex].sampleNumber - 1; // sampleNumber is 1-based
-        if (frameIndex < decodeInput->samples.count) {
-            decodeInput->samples.sample[frameIndex].sync = AVIF_TRUE;
-        }
+    // samples holds at most one sample here: the last one requested.
+    avifDecodeSample * cachedSample = (decodeInput->samples.count > 0) ? &decodeInput->samples.sample[0] : NULL;
+    if (cachedSample && (decodeInput->sampleIndex == sampleIndex)) {
+        *outSample = cachedSample;
+        return AVIF_RESULT_OK;
     }
 
-    // Assume frame 0 is sync, just in case the stss box is absent in the BMFF. (Unnecessary?)
-    if (decodeInput->samples.count > 0) {
-        decodeInput->samples.sample[0].sync = AVIF_TRUE;
+    avifDecodeSample sample;
+    const avifDecodeSample * prevSample = (cachedSample && ((decodeInput->sampleIndex + 1) == sampleIndex)) ? cachedSample : NULL;
+    if (!avifSampleTableFindSample(decodeInput->sampleTable, sampleIndex, prevSample, sizeHint, &sample, diag)) {
+        return AVIF_RESULT_BMFF_PARSE_FAILED;
     }
-    return AVIF_TRUE;
+
+    if (cachedSample) {
+        if (cachedSample->ownsData) {
+            avifRWDataFree((avifRWData *)&cachedSample->data);
+        }
+    } else {
+        cachedSample = (avifDecodeSample *)avifArrayPushPtr(&decodeInput->samples);
+    }
+    memcpy(cachedSample, &sample, sizeof(avifDecodeSample));
+    decodeInput->sampleIndex = sampleIndex;
+    *outSample = cachedSample;
+    return AVIF_RESULT_OK;
 }
 
 // ---------------------------------------------------------------------------
@@ -461,6 +694,17 @@ static avifBool avifCodecDecodeInputGetSamples(avifCodecDecodeInput * decodeInpu
     VARNAME##_roData.size = SIZE;                       \
     avifROStreamStart(&VARNAME, &VARNAME##_roData, DIAG, CONTEXT)
 
+// 64-bit FNV-1a, used to check that a decoder index belongs to the file it is applied to.
+// Start with AVIF_HASH_SEED, and pass the previous result to continue hashing more bytes.
+#define AVIF_HASH_SEED 0xcbf29ce484222325ULL
+static uint64_t avifHashBytes(uint64_t hash, const uint8_t * data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
 // Use this to keep track of whether or not a child box that must be unique (0 or 1 present) has
 // been seen yet, when parsing a parent box. If the "seen" bit is already set for a given box when
 // it is encountered during parse, an error is thrown. Which bit corresponds to which box is
@@ -487,6 +731,10 @@ typedef struct avifTile
     avifCodecDecodeInput * input;
     struct avifCodec * codec;
     avifImage * image;
+    uint8_t operatingPoint; // from the item's a1op property, if any
+    uint32_t prefetchIndex; // the next sample index to hand to codec->prefetch(), see avifDecoderPrefetchTileSamples()
+    avifResult decodeResult; // set by avifDecoderDecodeTile()
+    avifDiagnostics diag;    // set by avifDecoderDecodeTile(), as tiles can't share decoder->diag while decoding concurrently
 } avifTile;
 AVIF_ARRAY_DECLARE(avifTileArray, avifTile, tile);
 
@@ -509,6 +757,12 @@ typedef struct avifMeta
     // and are then further modified/updated as new information for an item's ID is parsed.
     avifDecoderItemArray items;
 
+    // Open-addressing hash table (linear probing) mapping item IDs to (1 + their index in items), 0
+    // marking an empty slot, so that avifMetaFindItem() does not have to scan every item. Its
+    // capacity is a power of two, kept at least twice items.count.
+    uint32_t * itemIndices;
+    uint32_t itemIndicesCapacity;
+
     // Any ipco boxes explained above are populated into this array as a staging area, which are
     // then duplicated into the appropriate items upon encountering an item property association
     // (ipma) box.
@@ -547,13 +801,16 @@ static void avifMetaDestroy(avifMeta * meta)
 {
     for (uint32_t i = 0; i < meta->items.count; ++i) {
         avifDecoderItem * item = &meta->items.item[i];
-        avifArrayDestroy(&item->properties);
+        avifPropertyListDestroy(&item->properties);
         avifArrayDestroy(&item->extents);
         if (item->ownsMergedExtents) {
             avifRWDataFree(&item->mergedExtents);
         }
     }
     avifArrayDestroy(&meta->items);
+    if (meta->itemIndices) {
+        avifFree(meta->itemIndices);
+    }
     avifArrayDestroy(&meta->properties);
     for (uint32_t i = 0; i < meta->idats.count; ++i) {
         avifDecoderItemData * idat = &meta->idats.idat[i];
@@ -563,26 +820,59 @@ static void avifMetaDestroy(avifMeta * meta)
     avifFree(meta);
 }
 
+// Returns the slot of meta->itemIndices holding itemID, or the empty slot where it would be inserted.
+static uint32_t * avifMetaItemIndexSlot(const avifMeta * meta, uint32_t itemID)
+{
+    const uint32_t mask = meta->itemIndicesCapacity - 1;
+    uint32_t slot = (itemID * 2654435761U) & mask; // Fibonacci hashing; item IDs are often sequential
+    while (meta->itemIndices[slot] && (meta->items.item[meta->itemIndices[slot] - 1].id != itemID)) {
+        slot = (slot + 1) & mask;
+    }
+    return &meta->itemIndices[slot];
+}
+
+// Makes room in meta->itemIndices for one more item, rehashing all items if it has to grow.
+static void avifMetaReserveItemIndex(avifMeta * meta)
+{
+    if (((meta->items.count + 1) * 2) <= meta->itemIndicesCapacity) {
+        return;
+    }
+    if (meta->itemIndices) {
+        avifFree(meta->itemIndices);
+    }
+    meta->itemIndicesCapacity = meta->itemIndicesCapacity ? (meta->itemIndicesCapacity * 2) : 16;
+    meta->itemIndices = (uint32_t *)avifAlloc(sizeof(uint32_t) * meta->itemIndicesCapacity);
+    memset(meta->itemIndices, 0, sizeof(uint32_t) * meta->itemIndicesCapacity);
+    for (uint32_t i = 0; i < meta->items.count; ++i) {
+        *avifMetaItemIndexSlot(meta, meta->items.item[i].id) = i + 1;
+    }
+}
+
+// Returns the item with the given ID, creating it if it has not been seen yet. Item IDs are unique
+// within a meta box, so an item is never created twice.
 static avifDecoderItem * avifMetaFindItem(avifMeta * meta, uint32_t itemID)
 {
     if (itemID == 0) {
         return NULL;
     }
 
-    for (uint32_t i = 0; i < meta->items.count; ++i) {
-        if (meta->items.item[i].id == itemID) {
-            return &meta->items.item[i];
-        }
+    avifMetaReserveItemIndex(meta);
+    uint32_t * slot = avifMetaItemIndexSlot(meta, itemID);
+    if (*slot) {
+        return &meta->items.item[*slot - 1];
     }
 
     avifDecoderItem * item = (avifDecoderItem *)avifArrayPushPtr(&meta->items);
-    avifArrayCreate(&item->properties, sizeof(avifProperty), 16);
+    *slot = meta->items.count;
+    avifPropertyListCreate(&item->properties);
     avifArrayCreate(&item->extents, sizeof(avifExtent), 1);
     item->id = itemID;
     item->meta = meta;
     return item;
 }
 
+AVIF_ARRAY_DECLARE(avifFrameIndexArray, uint32_t, frameIndex);
+
 typedef struct avifDecoderData
 {
     avifMeta * meta; // The root-level meta box
@@ -595,6 +885,20 @@ typedef struct avifDecoderData
     avifDecoderSource source;
     avifDiagnostics * diag;                    // Shallow copy; owned by avifDecoder
     const avifSampleTable * sourceSampleTable; // NULL unless (source == AVIF_DECODER_SOURCE_TRACKS), owned by an avifTrack
+    avifFrameIndexArray keyframes;             // Sorted, unique indices of all sync frames; always starts with 0
+    avifExtentArray containerBoxes;            // Payloads of the ftyp/meta/moov boxes read by avifParse(), in file order
+    uint64_t containerHash;                    // avifHashBytes() of all of containerBoxes' payloads
+    avifRWData index;                          // Copy of the index passed to avifDecoderParseWithIndex(), if any;
+                                               // colr properties point into it
+    const avifPropertyList * colorProperties;  // Properties of the color item or track, set by avifDecoderReset()
+    avifMeta * metadataMeta;                   // Where avifDecoderReset() looked for Exif/XMP (may be NULL), and
+    uint32_t metadataColorID;                  // the item they must describe (see avifDecoderFindMetadata())
+    avifThreadPool * threadPool;               // Pool the tiles' codecs were created with, if any,
+    int reservedThreads;                       // and the threads reserved from it for them
+    avifThreadPool * ownedThreadPool;          // Created for grids when decoder->threadPool is NULL,
+    int ownedThreadPoolSize;                   // with this many threads (decoder->maxThreads)
+    uint32_t tileConcurrency;                  // Tiles decoded at once by avifDecoderDecodeTiles()
+    avifBool tilesReleased;                    // True once avifDecoderReleaseTile() destroyed a tile's codec
     avifBool cicpSet;                          // True if avifDecoder's image has had its CICP set correctly yet.
                                                // This allows nclx colr boxes to override AV1 CICP, as specified in the MIAF
                                                // standard (ISO/IEC 23000-22:2019), section 7.3.6.4:
@@ -610,9 +914,21 @@ static avifDecoderData * avifDecoderDataCreate()
     data->meta = avifMetaCreate();
     avifArrayCreate(&data->tracks, sizeof(avifTrack), 2);
     avifArrayCreate(&data->tiles, sizeof(avifTile), 8);
+    avifArrayCreate(&data->keyframes, sizeof(uint32_t), 16);
+    avifArrayCreate(&data->containerBoxes, sizeof(avifExtent), 3);
+    data->containerHash = AVIF_HASH_SEED;
     return data;
 }
 
+static void avifDecoderDataReleaseThreads(avifDecoderData * data)
+{
+    if (data->threadPool) {
+        avifThreadPoolRelease(data->threadPool, data->reservedThreads);
+        data->threadPool = NULL;
+        data->reservedThreads = 0;
+    }
+}
+
 static void avifDecoderDataResetCodec(avifDecoderData * data)
 {
     for (unsigned int i = 0; i < data->tiles.count; ++i) {
@@ -625,6 +941,8 @@ static void avifDecoderDataResetCodec(avifDecoderData * data)
             tile->codec = NULL;
         }
     }
+    data->tilesReleased = AVIF_FALSE;
+    avifDecoderDataReleaseThreads(data);
 }
 
 static avifTile * avifDecoderDataCreateTile(avifDecoderData * data)
@@ -659,6 +977,7 @@ static void avifDecoderDataClearTiles(avifDecoderData * data)
             tile->image = NULL;
         }
     }
+    avifDecoderDataReleaseThreads(data);
     data->tiles.count = 0;
     data->colorTileCount = 0;
     data->alphaTileCount = 0;
@@ -678,14 +997,22 @@ static void avifDecoderDataDestroy(avifDecoderData * data)
     }
     avifArrayDestroy(&data->tracks);
     avifDecoderDataClearTiles(data);
+    if (data->ownedThreadPool) {
+        avifThreadPoolDestroy(data->ownedThreadPool);
+    }
     avifArrayDestroy(&data->tiles);
+    avifArrayDestroy(&data->keyframes);
+    avifArrayDestroy(&data->containerBoxes);
+    avifRWDataFree(&data->index);
     avifFree(data);
 }
 
 // This returns the max extent that has to be read in order to decode this item. If
 // the item is stored in an idat, the data has already been read during Parse() and
 // this function will return AVIF_RESULT_OK with a 0-byte extent.
-static avifResult avifDecoderItemMaxExtent(const avifDecoderItem * item, avifExtent * outExtent)
+// Returns the range of the file holding the first byteCount bytes of the item's payload (all of it
+// if byteCount is 0), such as the first layers of a progressive item.
+static avifResult avifDecoderItemMaxExtent(const avifDecoderItem * item, uint64_t byteCount, avifExtent * outExtent)
 {
     if (item->extents.count == 0) {
         return AVIF_RESULT_TRUNCATED_DATA;
@@ -713,13 +1040,16 @@ static avifResult avifDecoderItemMaxExtent(const avifDecoderItem * item, avifExt
     assert(item->extents.count != 0);
     uint64_t minOffset = UINT64_MAX;
     uint64_t maxOffset = 0;
-    for (uint32_t extentIter = 0; extentIter < item->extents.count; ++extentIter) {
+    uint64_t remainingBytes = byteCount ? byteCount : UINT64_MAX;
+    for (uint32_t extentIter = 0; (extentIter < item->extents.count) && (remainingBytes > 0); ++extentIter) {
         avifExtent * extent = &item->extents.extent[extentIter];
 
         if (extent->size > UINT64_MAX - extent->offset) {
             return AVIF_RESULT_BMFF_PARSE_FAILED;
         }
-        const uint64_t endOffset = extent->offset + extent->size;
+        const uint64_t usedSize = AVIF_MIN((uint64_t)extent->size, remainingBytes);
+        const uint64_t endOffset = extent->offset + usedSize;
+        remainingBytes -= usedSize;
 
         if (minOffset > extent->offset) {
             minOffset = extent->offset;
@@ -740,14 +1070,14 @@ static avifResult avifDecoderItemMaxExtent(const avifDecoderItem * item, avifExt
 
 static avifResult avifDecoderItemValidateAV1(const avifDecoderItem * item, avifDiagnostics * diag, const avifStrictFlags strictFlags)
 {
-    const avifProperty * av1CProp = avifPropertyArrayFind(&item->properties, "av1C");
+    const avifProperty * av1CProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_AV1C);
     if (!av1CProp) {
         // An av1C box is mandatory in all valid AVIF configurations. Bail out.
         avifDiagnosticsPrintf(diag, "Item ID %u is missing mandatory av1C property", item->id);
         return AVIF_RESULT_BMFF_PARSE_FAILED;
     }
 
-    const avifProperty * pixiProp = avifPropertyArrayFind(&item->properties, "pixi");
+    const avifProperty * pixiProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_PIXI);
     if (!pixiProp && (strictFlags & AVIF_STRICT_PIXI_REQUIRED)) {
         // A pixi box is mandatory in all valid AVIF configurations. Bail out.
         avifDiagnosticsPrintf(diag, "[Strict] Item ID %u is missing mandatory pixi property", item->id);
@@ -770,9 +1100,9 @@ static avifResult avifDecoderItemValidateAV1(const avifDecoderItem * item, avifD
     }
 
     if (strictFlags & AVIF_STRICT_CLAP_VALID) {
-        const avifProperty * clapProp = avifPropertyArrayFind(&item->properties, "clap");
+        const avifProperty * clapProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_CLAP);
         if (clapProp) {
-            const avifProperty * ispeProp = avifPropertyArrayFind(&item->properties, "ispe");
+            const avifProperty * ispeProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_ISPE);
             if (!ispeProp) {
                 avifDiagnosticsPrintf(diag,
                                       "[Strict] Item ID %u is missing an ispe property, so its clap property cannot be validated",
@@ -923,6 +1253,111 @@ static avifResult avifDecoderItemRead(avifDecoderItem * item, avifIO * io, avifR
     return AVIF_RESULT_OK;
 }
 
+// Splits an item's payload into its layers, as described by its a1lx property. Returns the number of
+// layers in outLayerCount, which is 0 if the item isn't layered.
+static avifBool avifDecoderItemGetLayerSizes(const avifDecoderItem * item,
+                                             size_t layerSizes[MAX_AV1_LAYER_COUNT],
+                                             uint32_t * outLayerCount,
+                                             avifDiagnostics * diag)
+{
+    *outLayerCount = 0;
+    const avifProperty * a1lxProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_A1LX);
+    if (!a1lxProp) {
+        return AVIF_TRUE;
+    }
+
+    size_t remainingSize = item->size;
+    for (uint32_t i = 0; i < MAX_AV1_LAYER_COUNT - 1; ++i) {
+        const size_t layerSize = a1lxProp->u.a1lx.layerSize[i];
+        if (layerSize == 0) {
+            // The rest of the payload is the last layer
+            break;
+        }
+        if (layerSize >= remainingSize) {
+            // >= rather than >, as the last layer can't be empty either
+            avifDiagnosticsPrintf(diag, "Item ID %u a1lx layer [%u] does not fit in the item's payload", item->id, i);
+            return AVIF_FALSE;
+        }
+        layerSizes[(*outLayerCount)++] = layerSize;
+        remainingSize -= layerSize;
+    }
+    layerSizes[(*outLayerCount)++] = remainingSize;
+    return AVIF_TRUE;
+}
+
+// A layered item is progressive unless an lsel property picks one of its layers.
+static avifBool avifDecoderItemIsProgressive(const avifDecoderItem * item)
+{
+    const avifProperty * a1lxProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_A1LX);
+    const avifProperty * lselProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_LSEL);
+    return a1lxProp && (a1lxProp->u.a1lx.layerSize[0] != 0) && (!lselProp || (lselProp->u.lsel.layerID == AVIF_LAYER_ID_ALL));
+}
+
+// Creates the samples of a tile decoding a single av01 item. If splitLayers is set (progressive
+// decoding), each layer of the item becomes its own sample, so that the first layer can be decoded as
+// soon as its bytes have arrived. Otherwise the item is a single sample, trimmed to the layer chosen
+// by its lsel property, if any.
+static avifBool avifDecoderDataFillItemTile(avifDecoderData * data,
+                                            avifTile * tile,
+                                            const avifDecoderItem * item,
+                                            avifBool splitLayers)
+{
+    size_t layerSizes[MAX_AV1_LAYER_COUNT];
+    uint32_t layerCount;
+    if (!avifDecoderItemGetLayerSizes(item, layerSizes, &layerCount, data->diag)) {
+        return AVIF_FALSE;
+    }
+
+    const avifProperty * a1opProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_A1OP);
+    tile->operatingPoint = a1opProp ? a1opProp->u.a1op.opIndex : 0;
+
+    if (splitLayers && (layerCount > 1)) {
+        tile->input->allLayers = AVIF_TRUE;
+        uint64_t offset = 0;
+        for (uint32_t layerIndex = 0; layerIndex < layerCount; ++layerIndex) {
+            avifDecodeSample * sample = (avifDecodeSample *)avifArrayPushPtr(&tile->input->samples);
+            sample->itemID = item->id;
+            sample->offset = offset;
+            sample->size = layerSizes[layerIndex];
+            sample->sync = (layerIndex == 0); // Every later layer predicts from the ones before it
+            offset += layerSizes[layerIndex];
+        }
+        return AVIF_TRUE;
+    }
+
+    avifDecodeSample * sample = (avifDecodeSample *)avifArrayPushPtr(&tile->input->samples);
+    sample->itemID = item->id;
+    sample->offset = 0;
+    sample->size = item->size;
+    sample->sync = AVIF_TRUE;
+
+    const avifProperty * lselProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_LSEL);
+    if (lselProp && (lselProp->u.lsel.layerID != AVIF_LAYER_ID_ALL)) {
+        // The codec has to output every layer for the selected one to be picked out of them
+        tile->input->allLayers = AVIF_TRUE;
+        sample->selectSpatialLayer = AVIF_TRUE;
+        sample->spatialID = (uint8_t)lselProp->u.lsel.layerID;
+
+        if (layerCount > 0) {
+            if (lselProp->u.lsel.layerID >= layerCount) {
+                avifDiagnosticsPrintf(data->diag,
+                                      "Item ID %u lsel property selects layer [%u], but its a1lx property only has [%u] layers",
+                                      item->id,
+                                      lselProp->u.lsel.layerID,
+                                      layerCount);
+                return AVIF_FALSE;
+            }
+
+            // The layers after the selected one aren't needed
+            sample->size = 0;
+            for (uint32_t layerIndex = 0; layerIndex <= lselProp->u.lsel.layerID; ++layerIndex) {
+                sample->size += layerSizes[layerIndex];
+            }
+        }
+    }
+    return AVIF_TRUE;
+}
+
 static avifBool avifDecoderDataGenerateImageGridTiles(avifDecoderData * data, avifImageGrid * grid, avifDecoderItem * gridItem, avifBool alpha)
 {
     unsigned int tilesRequested = grid->rows * grid->columns;
@@ -965,75 +1400,64 @@ static avifBool avifDecoderDataGenerateImageGridTiles(avifDecoderData * data, av
             }
 
             avifTile * tile = avifDecoderDataCreateTile(data);
-            avifDecodeSample * sample = (avifDecodeSample *)avifArrayPushPtr(&tile->input->samples);
-            sample->itemID = item->id;
-            sample->offset = 0;
-            sample->size = item->size;
-            sample->sync = AVIF_TRUE;
+            if (!avifDecoderDataFillItemTile(data, tile, item, AVIF_FALSE)) {
+                return AVIF_FALSE;
+            }
             tile->input->alpha = alpha;
 
             if (firstTile) {
                 firstTile = AVIF_FALSE;
 
                 // Adopt the av1C property of the first av01 tile, so that it can be queried from
-                // the top-level color/alpha item during avifDecoderReset().
-                const avifProperty * srcProp = avifPropertyArrayFind(&item->properties, "av1C");
+                // the top-level color/alpha item during avifDecoderReset(). Only do it once, as a
+                // decoder may be reset many times.
+                const avifProperty * srcProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_AV1C);
                 if (!srcProp) {
                     avifDiagnosticsPrintf(data->diag, "Grid image's first tile is missing an av1C property");
                     return AVIF_FALSE;
                 }
-                avifProperty * dstProp = (avifProperty *)avifArrayPushPtr(&gridItem->properties);
-                memcpy(dstProp, srcProp, sizeof(avifProperty));
+                if (!avifPropertyListFind(&gridItem->properties, AVIF_PROPERTY_AV1C)) {
+                    avifPropertyListAdd(&gridItem->properties, srcProp);
+                }
             }
         }
     }
     return AVIF_TRUE;
 }
 
-static avifBool avifDecoderDataFillImageGrid(avifDecoderData * data,
-                                             avifImageGrid * grid,
-                                             avifImage * dstImage,
-                                             unsigned int firstTileIndex,
-                                             unsigned int tileCount,
-                                             avifBool alpha)
+// Returns AVIF_TRUE if two decoded tiles of the same grid agree on every property that must be
+// consistent across a grid image.
+static avifBool avifImageGridTilesMatch(const avifImage * tileImage, const avifImage * firstTileImage)
 {
-    if (tileCount == 0) {
-        avifDiagnosticsPrintf(data->diag, "Cannot fill grid image, no tiles");
-        return AVIF_FALSE;
-    }
-
-    avifTile * firstTile = &data->tiles.tile[firstTileIndex];
-    avifBool firstTileUVPresent = (firstTile->image->yuvPlanes[AVIF_CHAN_U] && firstTile->image->yuvPlanes[AVIF_CHAN_V]);
-
-    // Check for tile consistency: All tiles in a grid image should match in the properties checked below.
-    for (unsigned int i = 1; i < tileCount; ++i) {
-        avifTile * tile = &data->tiles.tile[firstTileIndex + i];
-        avifBool uvPresent = (tile->image->yuvPlanes[AVIF_CHAN_U] && tile->image->yuvPlanes[AVIF_CHAN_V]);
-        if ((tile->image->width != firstTile->image->width) || (tile->image->height != firstTile->image->height) ||
-            (tile->image->depth != firstTile->image->depth) || (tile->image->yuvFormat != firstTile->image->yuvFormat) ||
-            (tile->image->yuvRange != firstTile->image->yuvRange) || (uvPresent != firstTileUVPresent) ||
-            (tile->image->colorPrimaries != firstTile->image->colorPrimaries) ||
-            (tile->image->transferCharacteristics != firstTile->image->transferCharacteristics) ||
-            (tile->image->matrixCoefficients != firstTile->image->matrixCoefficients) ||
-            (tile->image->alphaRange != firstTile->image->alphaRange)) {
-            avifDiagnosticsPrintf(data->diag, "Grid image contains mismatched tiles");
-            return AVIF_FALSE;
-        }
-    }
+    const avifBool uvPresent = (tileImage->yuvPlanes[AVIF_CHAN_U] && tileImage->yuvPlanes[AVIF_CHAN_V]);
+    const avifBool firstUVPresent = (firstTileImage->yuvPlanes[AVIF_CHAN_U] && firstTileImage->yuvPlanes[AVIF_CHAN_V]);
+    return (tileImage->width == firstTileImage->width) && (tileImage->height == firstTileImage->height) &&
+           (tileImage->depth == firstTileImage->depth) && (tileImage->yuvFormat == firstTileImage->yuvFormat) &&
+           (tileImage->yuvRange == firstTileImage->yuvRange) && (uvPresent == firstUVPresent) &&
+           (tileImage->colorPrimaries == firstTileImage->colorPrimaries) &&
+           (tileImage->transferCharacteristics == firstTileImage->transferCharacteristics) &&
+           (tileImage->matrixCoefficients == firstTileImage->matrixCoefficients) &&
+           (tileImage->alphaRange == firstTileImage->alphaRange);
+}
 
+// Validates the grid geometry against the size of its (first) decoded tile.
+static avifBool avifDecoderDataValidateImageGrid(avifDecoderData * data,
+                                                 const avifImageGrid * grid,
+                                                 const avifImage * tileImage,
+                                                 avifBool alpha)
+{
     // Validate grid image size and tile size.
     //
     // HEIF (ISO/IEC 23008-12:2017), Section 6.6.2.3.1:
     //   The tiled input images shall completely "cover" the reconstructed image grid canvas, ...
-    if (((firstTile->image->width * grid->columns) < grid->outputWidth) ||
-        ((firstTile->image->height * grid->rows) < grid->outputHeight)) {
+    if (((tileImage->width * grid->columns) < grid->outputWidth) || ((tileImage->height * grid->rows) < grid->outputHeight)) {
         avifDiagnosticsPrintf(data->diag,
                               "Grid image tiles do not completely cover the image (HEIF (ISO/IEC 23008-12:2017), Section 6.6.2.3.1)");
         return AVIF_FALSE;
     }
     // Tiles in the rightmost column and bottommost row must overlap the reconstructed image grid canvas. See MIAF (ISO/IEC 23000-22:2019), Section 7.3.11.4.2, Figure 2.
-    if (((firstTile->image->width * (grid->columns - 1)) >= grid->outputWidth) ||
-        ((firstTile->image->height * (grid->rows - 1)) >= grid->outputHeight)) {
+    if (((tileImage->width * (grid->columns - 1)) >= grid->outputWidth) ||
+        ((tileImage->height * (grid->rows - 1)) >= grid->outputHeight)) {
         avifDiagnosticsPrintf(data->diag,
                               "Grid image tiles in the rightmost column and bottommost row do not overlap the reconstructed image grid canvas. See MIAF (ISO/IEC 23000-22:2019), Section 7.3.11.4.2, Figure 2");
         return AVIF_FALSE;
@@ -1041,40 +1465,48 @@ static avifBool avifDecoderDataFillImageGrid(avifDecoderData * data,
     // Check the restrictions in MIAF (ISO/IEC 23000-22:2019), Section 7.3.11.4.2.
     //
     // The tile_width shall be greater than or equal to 64, and the tile_height shall be greater than or equal to 64.
-    if ((firstTile->image->width < 64) || (firstTile->image->height < 64)) {
+    if ((tileImage->width < 64) || (tileImage->height < 64)) {
         avifDiagnosticsPrintf(data->diag,
                               "Grid image tiles are smaller than 64x64 (%u/%u). See MIAF (ISO/IEC 23000-22:2019), Section 7.3.11.4.2",
-                              firstTile->image->width,
-                              firstTile->image->height);
+                              tileImage->width,
+                              tileImage->height);
         return AVIF_FALSE;
     }
     if (!alpha) {
-        if ((firstTile->image->yuvFormat == AVIF_PIXEL_FORMAT_YUV422) || (firstTile->image->yuvFormat == AVIF_PIXEL_FORMAT_YUV420)) {
+        if ((tileImage->yuvFormat == AVIF_PIXEL_FORMAT_YUV422) || (tileImage->yuvFormat == AVIF_PIXEL_FORMAT_YUV420)) {
             // The horizontal tile offsets and widths, and the output width, shall be even numbers.
-            if (((firstTile->image->width & 1) != 0) || ((grid->outputWidth & 1) != 0)) {
+            if (((tileImage->width & 1) != 0) || ((grid->outputWidth & 1) != 0)) {
                 avifDiagnosticsPrintf(data->diag,
                                       "Grid image horizontal tile offsets and widths [%u], and the output width [%u], shall be even numbers.",
-                                      firstTile->image->width,
+                                      tileImage->width,
                                       grid->outputWidth);
                 return AVIF_FALSE;
             }
         }
-        if (firstTile->image->yuvFormat == AVIF_PIXEL_FORMAT_YUV420) {
+        if (tileImage->yuvFormat == AVIF_PIXEL_FORMAT_YUV420) {
             // The vertical tile offsets and heights, and the output height, shall be even numbers.
-            if (((firstTile->image->height & 1) != 0) || ((grid->outputHeight & 1) != 0)) {
+            if (((tileImage->height & 1) != 0) || ((grid->outputHeight & 1) != 0)) {
                 avifDiagnosticsPrintf(data->diag,
                                       "Grid image vertical tile offsets and heights [%u], and the output height [%u], shall be even numbers.",
-                                      firstTile->image->height,
+                                      tileImage->height,
                                       grid->outputHeight);
                 return AVIF_FALSE;
             }
         }
     }
+    return AVIF_TRUE;
+}
 
-    // Lazily populate dstImage with the new frame's properties. If we're decoding alpha,
-    // these values must already match.
+// Lazily populate dstImage with the new frame's properties (but not its planes). If we're decoding
+// alpha, these values must already match.
+static avifBool avifDecoderDataPrepareImageGrid(avifDecoderData * data,
+                                                const avifImageGrid * grid,
+                                                avifImage * dstImage,
+                                                const avifImage * tileImage,
+                                                avifBool alpha)
+{
     if ((dstImage->width != grid->outputWidth) || (dstImage->height != grid->outputHeight) ||
-        (dstImage->depth != firstTile->image->depth) || (!alpha && (dstImage->yuvFormat != firstTile->image->yuvFormat))) {
+        (dstImage->depth != tileImage->depth) || (!alpha && (dstImage->yuvFormat != tileImage->yuvFormat))) {
         if (alpha) {
             // Alpha doesn't match size, just bail out
             avifDiagnosticsPrintf(data->diag, "Alpha plane dimensions do not match color plane dimensions");
@@ -1084,105 +1516,157 @@ static avifBool avifDecoderDataFillImageGrid(avifDecoderData * data,
         avifImageFreePlanes(dstImage, AVIF_PLANES_ALL);
         dstImage->width = grid->outputWidth;
         dstImage->height = grid->outputHeight;
-        dstImage->depth = firstTile->image->depth;
-        dstImage->yuvFormat = firstTile->image->yuvFormat;
-        dstImage->yuvRange = firstTile->image->yuvRange;
+        dstImage->depth = tileImage->depth;
+        dstImage->yuvFormat = tileImage->yuvFormat;
+        dstImage->yuvRange = tileImage->yuvRange;
         if (!data->cicpSet) {
             data->cicpSet = AVIF_TRUE;
-            dstImage->colorPrimaries = firstTile->image->colorPrimaries;
-            dstImage->transferCharacteristics = firstTile->image->transferCharacteristics;
-            dstImage->matrixCoefficients = firstTile->image->matrixCoefficients;
+            dstImage->colorPrimaries = tileImage->colorPrimaries;
+            dstImage->transferCharacteristics = tileImage->transferCharacteristics;
+            dstImage->matrixCoefficients = tileImage->matrixCoefficients;
         }
     }
     if (alpha) {
-        dstImage->alphaRange = firstTile->image->alphaRange;
+        dstImage->alphaRange = tileImage->alphaRange;
     }
+    return AVIF_TRUE;
+}
 
-    avifImageAllocatePlanes(dstImage, alpha ? AVIF_PLANES_A : AVIF_PLANES_YUV);
-
+// Copies the visible portion of the decoded tile at (rowIndex, colIndex) of the grid into dstImage,
+// with the tile's top row landing on dstImage's row dstY. dstY is rowIndex * tileHeight when
+// dstImage is the whole canvas, or 0 when dstImage only holds a single row of tiles.
+static void avifDecoderDataCopyImageGridTile(const avifImageGrid * grid,
+                                             const avifImage * tileImage,
+                                             unsigned int rowIndex,
+                                             unsigned int colIndex,
+                                             avifImage * dstImage,
+                                             uint32_t dstY,
+                                             avifBool alpha)
+{
     avifPixelFormatInfo formatInfo;
-    avifGetPixelFormatInfo(firstTile->image->yuvFormat, &formatInfo);
-
-    unsigned int tileIndex = firstTileIndex;
-    size_t pixelBytes = avifImageUsesU16(dstImage) ? 2 : 1;
-    for (unsigned int rowIndex = 0; rowIndex < grid->rows; ++rowIndex) {
-        for (unsigned int colIndex = 0; colIndex < grid->columns; ++colIndex, ++tileIndex) {
-            avifTile * tile = &data->tiles.tile[tileIndex];
+    avifGetPixelFormatInfo(tileImage->yuvFormat, &formatInfo);
+    const size_t pixelBytes = avifImageUsesU16(dstImage) ? 2 : 1;
 
-            unsigned int widthToCopy = firstTile->image->width;
-            unsigned int maxX = firstTile->image->width * (colIndex + 1);
-            if (maxX > grid->outputWidth) {
-                widthToCopy -= maxX - grid->outputWidth;
-            }
+    unsigned int widthToCopy = tileImage->width;
+    unsigned int maxX = tileImage->width * (colIndex + 1);
+    if (maxX > grid->outputWidth) {
+        widthToCopy -= maxX - grid->outputWidth;
+    }
 
-            unsigned int heightToCopy = firstTile->image->height;
-            unsigned int maxY = firstTile->image->height * (rowIndex + 1);
-            if (maxY > grid->outputHeight) {
-                heightToCopy -= maxY - grid->outputHeight;
-            }
+    unsigned int heightToCopy = tileImage->height;
+    unsigned int maxY = tileImage->height * (rowIndex + 1);
+    if (maxY > grid->outputHeight) {
+        heightToCopy -= maxY - grid->outputHeight;
+    }
 
-            // Y and A channels
-            size_t yaColOffset = (size_t)colIndex * firstTile->image->width;
-            size_t yaRowOffset = (size_t)rowIndex * firstTile->image->height;
-            size_t yaRowBytes = widthToCopy * pixelBytes;
+    // Y and A channels
+    size_t yaColOffset = (size_t)colIndex * tileImage->width;
+    size_t yaRowOffset = dstY;
+    size_t yaRowBytes = widthToCopy * pixelBytes;
 
-            if (alpha) {
-                // A
-                for (unsigned int j = 0; j < heightToCopy; ++j) {
-                    uint8_t * src = &tile->image->alphaPlane[j * tile->image->alphaRowBytes];
-                    uint8_t * dst = &dstImage->alphaPlane[(yaColOffset * pixelBytes) + ((yaRowOffset + j) * dstImage->alphaRowBytes)];
-                    memcpy(dst, src, yaRowBytes);
-                }
-            } else {
-                // Y
-                for (unsigned int j = 0; j < heightToCopy; ++j) {
-                    uint8_t * src = &tile->image->yuvPlanes[AVIF_CHAN_Y][j * tile->image->yuvRowBytes[AVIF_CHAN_Y]];
-                    uint8_t * dst =
-                        &dstImage->yuvPlanes[AVIF_CHAN_Y][(yaColOffset * pixelBytes) + ((yaRowOffset + j) * dstImage->yuvRowBytes[AVIF_CHAN_Y])];
-                    memcpy(dst, src, yaRowBytes);
-                }
+    if (alpha) {
+        // A
+        for (unsigned int j = 0; j < heightToCopy; ++j) {
+            const uint8_t * src = &tileImage->alphaPlane[j * tileImage->alphaRowBytes];
+            uint8_t * dst = &dstImage->alphaPlane[(yaColOffset * pixelBytes) + ((yaRowOffset + j) * dstImage->alphaRowBytes)];
+            memcpy(dst, src, yaRowBytes);
+        }
+        return;
+    }
 
-                if (!firstTileUVPresent) {
-                    continue;
-                }
+    // Y
+    for (unsigned int j = 0; j < heightToCopy; ++j) {
+        const uint8_t * src = &tileImage->yuvPlanes[AVIF_CHAN_Y][j * tileImage->yuvRowBytes[AVIF_CHAN_Y]];
+        uint8_t * dst =
+            &dstImage->yuvPlanes[AVIF_CHAN_Y][(yaColOffset * pixelBytes) + ((yaRowOffset + j) * dstImage->yuvRowBytes[AVIF_CHAN_Y])];
+        memcpy(dst, src, yaRowBytes);
+    }
 
-                // UV
-                heightToCopy >>= formatInfo.chromaShiftY;
-                size_t uvColOffset = yaColOffset >> formatInfo.chromaShiftX;
-                size_t uvRowOffset = yaRowOffset >> formatInfo.chromaShiftY;
-                size_t uvRowBytes = yaRowBytes >> formatInfo.chromaShiftX;
-                for (unsigned int j = 0; j < heightToCopy; ++j) {
-                    uint8_t * srcU = &tile->image->yuvPlanes[AVIF_CHAN_U][j * tile->image->yuvRowBytes[AVIF_CHAN_U]];
-                    uint8_t * dstU =
-                        &dstImage->yuvPlanes[AVIF_CHAN_U][(uvColOffset * pixelBytes) + ((uvRowOffset + j) * dstImage->yuvRowBytes[AVIF_CHAN_U])];
-                    memcpy(dstU, srcU, uvRowBytes);
-
-                    uint8_t * srcV = &tile->image->yuvPlanes[AVIF_CHAN_V][j * tile->image->yuvRowBytes[AVIF_CHAN_V]];
-                    uint8_t * dstV =
-                        &dstImage->yuvPlanes[AVIF_CHAN_V][(uvColOffset * pixelBytes) + ((uvRowOffset + j) * dstImage->yuvRowBytes[AVIF_CHAN_V])];
-                    memcpy(dstV, srcV, uvRowBytes);
-                }
-            }
-        }
+    if (!tileImage->yuvPlanes[AVIF_CHAN_U] || !tileImage->yuvPlanes[AVIF_CHAN_V]) {
+        return;
     }
 
-    return AVIF_TRUE;
+    // UV
+    heightToCopy >>= formatInfo.chromaShiftY;
+    size_t uvColOffset = yaColOffset >> formatInfo.chromaShiftX;
+    size_t uvRowOffset = yaRowOffset >> formatInfo.chromaShiftY;
+    size_t uvRowBytes = yaRowBytes >> formatInfo.chromaShiftX;
+    for (unsigned int j = 0; j < heightToCopy; ++j) {
+        const uint8_t * srcU = &tileImage->yuvPlanes[AVIF_CHAN_U][j * tileImage->yuvRowBytes[AVIF_CHAN_U]];
+        uint8_t * dstU =
+            &dstImage->yuvPlanes[AVIF_CHAN_U][(uvColOffset * pixelBytes) + ((uvRowOffset + j) * dstImage->yuvRowBytes[AVIF_CHAN_U])];
+        memcpy(dstU, srcU, uvRowBytes);
+
+        const uint8_t * srcV = &tileImage->yuvPlanes[AVIF_CHAN_V][j * tileImage->yuvRowBytes[AVIF_CHAN_V]];
+        uint8_t * dstV =
+            &dstImage->yuvPlanes[AVIF_CHAN_V][(uvColOffset * pixelBytes) + ((uvRowOffset + j) * dstImage->yuvRowBytes[AVIF_CHAN_V])];
+        memcpy(dstV, srcV, uvRowBytes);
+    }
 }
 
-// If colorId == 0 (a sentinel value as item IDs must be nonzero), accept any found EXIF/XMP metadata. Passing in 0
-// is used when finding metadata in a meta box embedded in a trak box, as any items inside of a meta box that is
-// inside of a trak box are implicitly associated to the track.
-static avifResult avifDecoderFindMetadata(avifDecoder * decoder, avifMeta * meta, avifImage * image, uint32_t colorId)
+static avifBool avifDecoderDataFillImageGrid(avifDecoderData * data,
+                                             avifImageGrid * grid,
+                                             avifImage * dstImage,
+                                             unsigned int firstTileIndex,
+                                             unsigned int tileCount,
+                                             avifBool alpha)
 {
-    if (decoder->ignoreExif && decoder->ignoreXMP) {
-        // Nothing to do!
-        return AVIF_RESULT_OK;
+    if (tileCount == 0) {
+        avifDiagnosticsPrintf(data->diag, "Cannot fill grid image, no tiles");
+        return AVIF_FALSE;
     }
 
-    for (uint32_t itemIndex = 0; itemIndex < meta->items.count; ++itemIndex) {
-        avifDecoderItem * item = &meta->items.item[itemIndex];
-        if (!item->size) {
-            continue;
+    avifTile * firstTile = &data->tiles.tile[firstTileIndex];
+
+    // Check for tile consistency: All tiles in a grid image should match in the properties checked below.
+    for (unsigned int i = 1; i < tileCount; ++i) {
+        avifTile * tile = &data->tiles.tile[firstTileIndex + i];
+        if (!avifImageGridTilesMatch(tile->image, firstTile->image)) {
+            avifDiagnosticsPrintf(data->diag, "Grid image contains mismatched tiles");
+            return AVIF_FALSE;
+        }
+    }
+
+    if (!avifDecoderDataValidateImageGrid(data, grid, firstTile->image, alpha)) {
+        return AVIF_FALSE;
+    }
+    if (!avifDecoderDataPrepareImageGrid(data, grid, dstImage, firstTile->image, alpha)) {
+        return AVIF_FALSE;
+    }
+
+    avifImageAllocatePlanes(dstImage, alpha ? AVIF_PLANES_A : AVIF_PLANES_YUV);
+
+    unsigned int tileIndex = firstTileIndex;
+    for (unsigned int rowIndex = 0; rowIndex < grid->rows; ++rowIndex) {
+        for (unsigned int colIndex = 0; colIndex < grid->columns; ++colIndex, ++tileIndex) {
+            avifTile * tile = &data->tiles.tile[tileIndex];
+            const uint32_t dstY = rowIndex * firstTile->image->height;
+            avifDecoderDataCopyImageGridTile(grid, tile->image, rowIndex, colIndex, dstImage, dstY, alpha);
+        }
+    }
+
+    return AVIF_TRUE;
+}
+
+// If colorId == 0 (a sentinel value as item IDs must be nonzero), accept any found EXIF/XMP metadata. Passing in 0
+// is used when finding metadata in a meta box embedded in a trak box, as any items inside of a meta box that is
+// inside of a trak box are implicitly associated to the track.
+static avifResult avifDecoderFindMetadata(avifDecoder * decoder,
+                                          avifMeta * meta,
+                                          avifImage * image,
+                                          uint32_t colorId,
+                                          avifBool ignoreExif,
+                                          avifBool ignoreXMP)
+{
+    if (ignoreExif && ignoreXMP) {
+        // Nothing to do!
+        return AVIF_RESULT_OK;
+    }
+
+    for (uint32_t itemIndex = 0; itemIndex < meta->items.count; ++itemIndex) {
+        avifDecoderItem * item = &meta->items.item[itemIndex];
+        if (!item->size) {
+            continue;
         }
         if (item->hasUnsupportedEssentialProperty) {
             // An essential property isn't supported by libavif; ignore the item.
@@ -1194,7 +1678,7 @@ static avifResult avifDecoderFindMetadata(avifDecoder * decoder, avifMeta * meta
             continue;
         }
 
-        if (!decoder->ignoreExif && !memcmp(item->type, "Exif", 4)) {
+        if (!ignoreExif && !memcmp(item->type, "Exif", 4)) {
             avifROData exifContents;
             avifResult readResult = avifDecoderItemRead(item, decoder->io, &exifContents, 0, &decoder->diag);
             if (readResult != AVIF_RESULT_OK) {
@@ -1207,7 +1691,7 @@ static avifResult avifDecoderFindMetadata(avifDecoder * decoder, avifMeta * meta
             CHECKERR(avifROStreamReadU32(&exifBoxStream, &exifTiffHeaderOffset), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) exif_tiff_header_offset;
 
             avifImageSetMetadataExif(image, avifROStreamCurrent(&exifBoxStream), avifROStreamRemainingBytes(&exifBoxStream));
-        } else if (!decoder->ignoreXMP && !memcmp(item->type, "mime", 4) &&
+        } else if (!ignoreXMP && !memcmp(item->type, "mime", 4) &&
                    !memcmp(item->contentType.contentType, xmpContentType, xmpContentTypeSize)) {
             avifROData xmpContents;
             avifResult readResult = avifDecoderItemRead(item, decoder->io, &xmpContents, 0, &decoder->diag);
@@ -1577,6 +2061,55 @@ static avifBool avifParsePixelInformationProperty(avifProperty * prop, const uin
     return AVIF_TRUE;
 }
 
+static avifBool avifParseOperatingPointSelectorProperty(avifProperty * prop, const uint8_t * raw, size_t rawLen, avifDiagnostics * diag)
+{
+    BEGIN_STREAM(s, raw, rawLen, diag, "Box[a1op]");
+
+    avifOperatingPointSelectorProperty * a1op = &prop->u.a1op;
+    CHECK(avifROStreamRead(&s, &a1op->opIndex, 1)); // unsigned int(8) op_index;
+    if (a1op->opIndex > 31) {
+        // AV1 sequence headers can describe at most 32 operating points
+        avifDiagnosticsPrintf(diag, "Box[a1op] contains an unsupported operating point [%u]", a1op->opIndex);
+        return AVIF_FALSE;
+    }
+    return AVIF_TRUE;
+}
+
+static avifBool avifParseLayerSelectorProperty(avifProperty * prop, const uint8_t * raw, size_t rawLen, avifDiagnostics * diag)
+{
+    BEGIN_STREAM(s, raw, rawLen, diag, "Box[lsel]");
+
+    avifLayerSelectorProperty * lsel = &prop->u.lsel;
+    CHECK(avifROStreamReadU16(&s, &lsel->layerID)); // unsigned int(16) layer_id;
+    if ((lsel->layerID != AVIF_LAYER_ID_ALL) && (lsel->layerID >= MAX_AV1_LAYER_COUNT)) {
+        // AV1 spatial_id is a 2-bit field
+        avifDiagnosticsPrintf(diag, "Box[lsel] contains an unsupported layer [%u]", lsel->layerID);
+        return AVIF_FALSE;
+    }
+    return AVIF_TRUE;
+}
+
+static avifBool avifParseAV1LayeredImageIndexingProperty(avifProperty * prop, const uint8_t * raw, size_t rawLen, avifDiagnostics * diag)
+{
+    BEGIN_STREAM(s, raw, rawLen, diag, "Box[a1lx]");
+
+    avifAV1LayeredImageIndexingProperty * a1lx = &prop->u.a1lx;
+    uint8_t largeSize = 0;
+    CHECK(avifROStreamRead(&s, &largeSize, 1)); // unsigned int(7) reserved = 0;
+                                                // unsigned int(1) large_size;
+    largeSize &= 1;
+    for (int i = 0; i < MAX_AV1_LAYER_COUNT - 1; ++i) {
+        if (largeSize) {
+            CHECK(avifROStreamReadU32(&s, &a1lx->layerSize[i])); // unsigned int(32) layer_size[3];
+        } else {
+            uint16_t layerSize16;
+            CHECK(avifROStreamReadU16(&s, &layerSize16)); // unsigned int(16) layer_size[3];
+            a1lx->layerSize[i] = layerSize16;
+        }
+    }
+    return AVIF_TRUE;
+}
+
 static avifBool avifParseItemPropertyContainerBox(avifPropertyArray * properties, const uint8_t * raw, size_t rawLen, avifDiagnostics * diag)
 {
     BEGIN_STREAM(s, raw, rawLen, diag, "Box[iprp]");
@@ -1587,25 +2120,47 @@ static avifBool avifParseItemPropertyContainerBox(avifPropertyArray * properties
 
         int propertyIndex = avifArrayPushIndex(properties);
         avifProperty * prop = &properties->prop[propertyIndex];
-        memcpy(prop->type, header.type, 4);
-        if (!memcmp(header.type, "ispe", 4)) {
-            CHECK(avifParseImageSpatialExtentsProperty(prop, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "auxC", 4)) {
-            CHECK(avifParseAuxiliaryTypeProperty(prop, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "colr", 4)) {
-            CHECK(avifParseColourInformationBox(prop, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "av1C", 4)) {
-            CHECK(avifParseAV1CodecConfigurationBoxProperty(prop, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "pasp", 4)) {
-            CHECK(avifParsePixelAspectRatioBoxProperty(prop, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "clap", 4)) {
-            CHECK(avifParseCleanApertureBoxProperty(prop, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "irot", 4)) {
-            CHECK(avifParseImageRotationProperty(prop, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "imir", 4)) {
-            CHECK(avifParseImageMirrorProperty(prop, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "pixi", 4)) {
-            CHECK(avifParsePixelInformationProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+        prop->type = header.fourcc;
+        switch (avifPropertyKindFromType(header.fourcc)) {
+            case AVIF_PROPERTY_ISPE:
+                CHECK(avifParseImageSpatialExtentsProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_AUXC:
+                CHECK(avifParseAuxiliaryTypeProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_COLR:
+                CHECK(avifParseColourInformationBox(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_AV1C:
+                CHECK(avifParseAV1CodecConfigurationBoxProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_PASP:
+                CHECK(avifParsePixelAspectRatioBoxProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_CLAP:
+                CHECK(avifParseCleanApertureBoxProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_IROT:
+                CHECK(avifParseImageRotationProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_IMIR:
+                CHECK(avifParseImageMirrorProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_PIXI:
+                CHECK(avifParsePixelInformationProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_A1OP:
+                CHECK(avifParseOperatingPointSelectorProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_LSEL:
+                CHECK(avifParseLayerSelectorProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_A1LX:
+                CHECK(avifParseAV1LayeredImageIndexingProperty(prop, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_PROPERTY_KIND_COUNT:
+                // Unsupported; kept so that ipma property indices still line up
+                break;
         }
 
         CHECK(avifROStreamSkip(&s, header.size));
@@ -1692,18 +2247,8 @@ static avifBool avifParseItemPropertyAssociation(avifMeta * meta, const uint8_t
             // Copy property to item
             avifProperty * srcProp = &meta->properties.prop[propertyIndex];
 
-            static const char * supportedTypes[] = { "ispe", "auxC", "colr", "av1C", "pasp", "clap", "irot", "imir", "pixi" };
-            size_t supportedTypesCount = sizeof(supportedTypes) / sizeof(supportedTypes[0]);
-            avifBool supportedType = AVIF_FALSE;
-            for (size_t i = 0; i < supportedTypesCount; ++i) {
-                if (!memcmp(srcProp->type, supportedTypes[i], 4)) {
-                    supportedType = AVIF_TRUE;
-                    break;
-                }
-            }
-            if (supportedType) {
-                avifProperty * dstProp = (avifProperty *)avifArrayPushPtr(&item->properties);
-                memcpy(dstProp, srcProp, sizeof(avifProperty));
+            if (avifPropertyKindFromType(srcProp->type) != AVIF_PROPERTY_KIND_COUNT) {
+                avifPropertyListAdd(&item->properties, srcProp);
             } else {
                 if (essential) {
                     // Discovered an essential item property that libavif doesn't support!
@@ -1763,7 +2308,7 @@ static avifBool avifParseItemPropertiesBox(avifMeta * meta, const uint8_t * raw,
 
     avifBoxHeader ipcoHeader;
     CHECK(avifROStreamReadBoxHeader(&s, &ipcoHeader));
-    if (memcmp(ipcoHeader.type, "ipco", 4)) {
+    if (ipcoHeader.fourcc != AVIF_FOURCC('i', 'p', 'c', 'o')) {
         avifDiagnosticsPrintf(diag, "Failed to find Box[ipco] as the first box in Box[iprp]");
         return AVIF_FALSE;
     }
@@ -1780,7 +2325,7 @@ static avifBool avifParseItemPropertiesBox(avifMeta * meta, const uint8_t * raw,
         avifBoxHeader ipmaHeader;
         CHECK(avifROStreamReadBoxHeader(&s, &ipmaHeader));
 
-        if (!memcmp(ipmaHeader.type, "ipma", 4)) {
+        if (ipmaHeader.fourcc == AVIF_FOURCC('i', 'p', 'm', 'a')) {
             uint32_t versionAndFlags;
             CHECK(avifParseItemPropertyAssociation(meta, avifROStreamCurrent(&s), ipmaHeader.size, diag, &versionAndFlags));
             for (uint32_t i = 0; i < versionAndFlagsSeenCount; ++i) {
@@ -1863,7 +2408,7 @@ static avifBool avifParseItemInfoBox(avifMeta * meta, const uint8_t * raw, size_
         avifBoxHeader infeHeader;
         CHECK(avifROStreamReadBoxHeader(&s, &infeHeader));
 
-        if (!memcmp(infeHeader.type, "infe", 4)) {
+        if (infeHeader.fourcc == AVIF_FOURCC('i', 'n', 'f', 'e')) {
             CHECK(avifParseItemInfoEntry(meta, avifROStreamCurrent(&s), infeHeader.size, diag));
         } else {
             // These must all be type infe
@@ -1924,23 +2469,32 @@ static avifBool avifParseItemReferenceBox(avifMeta * meta, const uint8_t * raw,
                     return AVIF_FALSE;
                 }
 
-                if (!memcmp(irefHeader.type, "thmb", 4)) {
-                    item->thumbnailForID = toID;
-                } else if (!memcmp(irefHeader.type, "auxl", 4)) {
-                    item->auxForID = toID;
-                } else if (!memcmp(irefHeader.type, "cdsc", 4)) {
-                    item->descForID = toID;
-                } else if (!memcmp(irefHeader.type, "dimg", 4)) {
-                    // derived images refer in the opposite direction
-                    avifDecoderItem * dimg = avifMetaFindItem(meta, toID);
-                    if (!dimg) {
-                        avifDiagnosticsPrintf(diag, "Box[iref] has an invalid item ID dimg ref [%u]", toID);
-                        return AVIF_FALSE;
+                switch (irefHeader.fourcc) {
+                    case AVIF_FOURCC('t', 'h', 'm', 'b'):
+                        item->thumbnailForID = toID;
+                        break;
+                    case AVIF_FOURCC('a', 'u', 'x', 'l'):
+                        item->auxForID = toID;
+                        break;
+                    case AVIF_FOURCC('c', 'd', 's', 'c'):
+                        item->descForID = toID;
+                        break;
+                    case AVIF_FOURCC('d', 'i', 'm', 'g'): {
+                        // derived images refer in the opposite direction
+                        avifDecoderItem * dimg = avifMetaFindItem(meta, toID);
+                        if (!dimg) {
+                            avifDiagnosticsPrintf(diag, "Box[iref] has an invalid item ID dimg ref [%u]", toID);
+                            return AVIF_FALSE;
+                        }
+
+                        dimg->dimgForID = fromID;
+                        break;
                     }
-
-                    dimg->dimgForID = fromID;
-                } else if (!memcmp(irefHeader.type, "prem", 4)) {
-                    item->premByID = toID;
+                    case AVIF_FOURCC('p', 'r', 'e', 'm'):
+                        item->premByID = toID;
+                        break;
+                    default:
+                        break;
                 }
             }
         }
@@ -1964,7 +2518,7 @@ static avifBool avifParseMetaBox(avifMeta * meta, const uint8_t * raw, size_t ra
         CHECK(avifROStreamReadBoxHeader(&s, &header));
 
         if (firstBox) {
-            if (!memcmp(header.type, "hdlr", 4)) {
+            if (header.fourcc == AVIF_FOURCC('h', 'd', 'l', 'r')) {
                 CHECK(uniqueBoxSeen(&uniqueBoxFlags, 0, "meta", "hdlr", diag));
                 CHECK(avifParseHandlerBox(avifROStreamCurrent(&s), header.size, diag));
                 firstBox = AVIF_FALSE;
@@ -1973,24 +2527,35 @@ static avifBool avifParseMetaBox(avifMeta * meta, const uint8_t * raw, size_t ra
                 avifDiagnosticsPrintf(diag, "Box[meta] does not have a Box[hdlr] as its first child box");
                 return AVIF_FALSE;
             }
-        } else if (!memcmp(header.type, "iloc", 4)) {
-            CHECK(uniqueBoxSeen(&uniqueBoxFlags, 1, "meta", "iloc", diag));
-            CHECK(avifParseItemLocationBox(meta, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "pitm", 4)) {
-            CHECK(uniqueBoxSeen(&uniqueBoxFlags, 2, "meta", "pitm", diag));
-            CHECK(avifParsePrimaryItemBox(meta, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "idat", 4)) {
-            CHECK(uniqueBoxSeen(&uniqueBoxFlags, 3, "meta", "idat", diag));
-            CHECK(avifParseItemDataBox(meta, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "iprp", 4)) {
-            CHECK(uniqueBoxSeen(&uniqueBoxFlags, 4, "meta", "iprp", diag));
-            CHECK(avifParseItemPropertiesBox(meta, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "iinf", 4)) {
-            CHECK(uniqueBoxSeen(&uniqueBoxFlags, 5, "meta", "iinf", diag));
-            CHECK(avifParseItemInfoBox(meta, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "iref", 4)) {
-            CHECK(uniqueBoxSeen(&uniqueBoxFlags, 6, "meta", "iref", diag));
-            CHECK(avifParseItemReferenceBox(meta, avifROStreamCurrent(&s), header.size, diag));
+        } else {
+            switch (header.fourcc) {
+                case AVIF_FOURCC('i', 'l', 'o', 'c'):
+                    CHECK(uniqueBoxSeen(&uniqueBoxFlags, 1, "meta", "iloc", diag));
+                    CHECK(avifParseItemLocationBox(meta, avifROStreamCurrent(&s), header.size, diag));
+                    break;
+                case AVIF_FOURCC('p', 'i', 't', 'm'):
+                    CHECK(uniqueBoxSeen(&uniqueBoxFlags, 2, "meta", "pitm", diag));
+                    CHECK(avifParsePrimaryItemBox(meta, avifROStreamCurrent(&s), header.size, diag));
+                    break;
+                case AVIF_FOURCC('i', 'd', 'a', 't'):
+                    CHECK(uniqueBoxSeen(&uniqueBoxFlags, 3, "meta", "idat", diag));
+                    CHECK(avifParseItemDataBox(meta, avifROStreamCurrent(&s), header.size, diag));
+                    break;
+                case AVIF_FOURCC('i', 'p', 'r', 'p'):
+                    CHECK(uniqueBoxSeen(&uniqueBoxFlags, 4, "meta", "iprp", diag));
+                    CHECK(avifParseItemPropertiesBox(meta, avifROStreamCurrent(&s), header.size, diag));
+                    break;
+                case AVIF_FOURCC('i', 'i', 'n', 'f'):
+                    CHECK(uniqueBoxSeen(&uniqueBoxFlags, 5, "meta", "iinf", diag));
+                    CHECK(avifParseItemInfoBox(meta, avifROStreamCurrent(&s), header.size, diag));
+                    break;
+                case AVIF_FOURCC('i', 'r', 'e', 'f'):
+                    CHECK(uniqueBoxSeen(&uniqueBoxFlags, 6, "meta", "iref", diag));
+                    CHECK(avifParseItemReferenceBox(meta, avifROStreamCurrent(&s), header.size, diag));
+                    break;
+                default:
+                    break;
+            }
         }
 
         CHECK(avifROStreamSkip(&s, header.size));
@@ -2208,14 +2773,17 @@ static avifBool avifParseSampleDescriptionBox(avifSampleTable * sampleTable, con
         CHECK(avifROStreamReadBoxHeader(&s, &sampleEntryHeader));
 
         avifSampleDescription * description = (avifSampleDescription *)avifArrayPushPtr(&sampleTable->sampleDescriptions);
-        avifArrayCreate(&description->properties, sizeof(avifProperty), 16);
+        avifPropertyListCreate(&description->properties);
         memcpy(description->format, sampleEntryHeader.type, sizeof(description->format));
         size_t remainingBytes = avifROStreamRemainingBytes(&s);
         if (!memcmp(description->format, "av01", 4) && (remainingBytes > VISUALSAMPLEENTRY_SIZE)) {
-            CHECK(avifParseItemPropertyContainerBox(&description->properties,
+            CHECK(avifParseItemPropertyContainerBox(&description->properties.array,
                                                     avifROStreamCurrent(&s) + VISUALSAMPLEENTRY_SIZE,
                                                     remainingBytes - VISUALSAMPLEENTRY_SIZE,
                                                     diag));
+            for (uint32_t propertyIndex = 0; propertyIndex < description->properties.array.count; ++propertyIndex) {
+                avifPropertyListIndex(&description->properties, propertyIndex);
+            }
         }
 
         CHECK(avifROStreamSkip(&s, sampleEntryHeader.size));
@@ -2238,20 +2806,30 @@ static avifBool avifParseSampleTableBox(avifTrack * track, const uint8_t * raw,
         avifBoxHeader header;
         CHECK(avifROStreamReadBoxHeader(&s, &header));
 
-        if (!memcmp(header.type, "stco", 4)) {
-            CHECK(avifParseChunkOffsetBox(track->sampleTable, AVIF_FALSE, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "co64", 4)) {
-            CHECK(avifParseChunkOffsetBox(track->sampleTable, AVIF_TRUE, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "stsc", 4)) {
-            CHECK(avifParseSampleToChunkBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "stsz", 4)) {
-            CHECK(avifParseSampleSizeBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "stss", 4)) {
-            CHECK(avifParseSyncSampleBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "stts", 4)) {
-            CHECK(avifParseTimeToSampleBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "stsd", 4)) {
-            CHECK(avifParseSampleDescriptionBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
+        switch (header.fourcc) {
+            case AVIF_FOURCC('s', 't', 'c', 'o'):
+                CHECK(avifParseChunkOffsetBox(track->sampleTable, AVIF_FALSE, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_FOURCC('c', 'o', '6', '4'):
+                CHECK(avifParseChunkOffsetBox(track->sampleTable, AVIF_TRUE, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_FOURCC('s', 't', 's', 'c'):
+                CHECK(avifParseSampleToChunkBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_FOURCC('s', 't', 's', 'z'):
+                CHECK(avifParseSampleSizeBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_FOURCC('s', 't', 's', 's'):
+                CHECK(avifParseSyncSampleBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_FOURCC('s', 't', 't', 's'):
+                CHECK(avifParseTimeToSampleBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_FOURCC('s', 't', 's', 'd'):
+                CHECK(avifParseSampleDescriptionBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            default:
+                break;
         }
 
         CHECK(avifROStreamSkip(&s, header.size));
@@ -2267,7 +2845,7 @@ static avifBool avifParseMediaInformationBox(avifTrack * track, const uint8_t *
         avifBoxHeader header;
         CHECK(avifROStreamReadBoxHeader(&s, &header));
 
-        if (!memcmp(header.type, "stbl", 4)) {
+        if (header.fourcc == AVIF_FOURCC('s', 't', 'b', 'l')) {
             CHECK(avifParseSampleTableBox(track, avifROStreamCurrent(&s), header.size, diag));
         }
 
@@ -2284,10 +2862,15 @@ static avifBool avifParseMediaBox(avifTrack * track, const uint8_t * raw, size_t
         avifBoxHeader header;
         CHECK(avifROStreamReadBoxHeader(&s, &header));
 
-        if (!memcmp(header.type, "mdhd", 4)) {
-            CHECK(avifParseMediaHeaderBox(track, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "minf", 4)) {
-            CHECK(avifParseMediaInformationBox(track, avifROStreamCurrent(&s), header.size, diag));
+        switch (header.fourcc) {
+            case AVIF_FOURCC('m', 'd', 'h', 'd'):
+                CHECK(avifParseMediaHeaderBox(track, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            case AVIF_FOURCC('m', 'i', 'n', 'f'):
+                CHECK(avifParseMediaInformationBox(track, avifROStreamCurrent(&s), header.size, diag));
+                break;
+            default:
+                break;
         }
 
         CHECK(avifROStreamSkip(&s, header.size));
@@ -2303,18 +2886,24 @@ static avifBool avifTrackReferenceBox(avifTrack * track, const uint8_t * raw, si
         avifBoxHeader header;
         CHECK(avifROStreamReadBoxHeader(&s, &header));
 
-        if (!memcmp(header.type, "auxl", 4)) {
-            uint32_t toID;
-            CHECK(avifROStreamReadU32(&s, &toID));                       // unsigned int(32) track_IDs[];
-            CHECK(avifROStreamSkip(&s, header.size - sizeof(uint32_t))); // just take the first one
-            track->auxForID = toID;
-        } else if (!memcmp(header.type, "prem", 4)) {
-            uint32_t byID;
-            CHECK(avifROStreamReadU32(&s, &byID));                       // unsigned int(32) track_IDs[];
-            CHECK(avifROStreamSkip(&s, header.size - sizeof(uint32_t))); // just take the first one
-            track->premByID = byID;
-        } else {
-            CHECK(avifROStreamSkip(&s, header.size));
+        switch (header.fourcc) {
+            case AVIF_FOURCC('a', 'u', 'x', 'l'): {
+                uint32_t toID;
+                CHECK(avifROStreamReadU32(&s, &toID));                       // unsigned int(32) track_IDs[];
+                CHECK(avifROStreamSkip(&s, header.size - sizeof(uint32_t))); // just take the first one
+                track->auxForID = toID;
+                break;
+            }
+            case AVIF_FOURCC('p', 'r', 'e', 'm'): {
+                uint32_t byID;
+                CHECK(avifROStreamReadU32(&s, &byID));                       // unsigned int(32) track_IDs[];
+                CHECK(avifROStreamSkip(&s, header.size - sizeof(uint32_t))); // just take the first one
+                track->premByID = byID;
+                break;
+            }
+            default:
+                CHECK(avifROStreamSkip(&s, header.size));
+                break;
         }
     }
     return AVIF_TRUE;
@@ -2330,14 +2919,21 @@ static avifBool avifParseTrackBox(avifDecoderData * data, const uint8_t * raw, s
         avifBoxHeader header;
         CHECK(avifROStreamReadBoxHeader(&s, &header));
 
-        if (!memcmp(header.type, "tkhd", 4)) {
-            CHECK(avifParseTrackHeaderBox(track, avifROStreamCurrent(&s), header.size, data->diag));
-        } else if (!memcmp(header.type, "meta", 4)) {
-            CHECK(avifParseMetaBox(track->meta, avifROStreamCurrent(&s), header.size, data->diag));
-        } else if (!memcmp(header.type, "mdia", 4)) {
-            CHECK(avifParseMediaBox(track, avifROStreamCurrent(&s), header.size, data->diag));
-        } else if (!memcmp(header.type, "tref", 4)) {
-            CHECK(avifTrackReferenceBox(track, avifROStreamCurrent(&s), header.size, data->diag));
+        switch (header.fourcc) {
+            case AVIF_FOURCC('t', 'k', 'h', 'd'):
+                CHECK(avifParseTrackHeaderBox(track, avifROStreamCurrent(&s), header.size, data->diag));
+                break;
+            case AVIF_FOURCC('m', 'e', 't', 'a'):
+                CHECK(avifParseMetaBox(track->meta, avifROStreamCurrent(&s), header.size, data->diag));
+                break;
+            case AVIF_FOURCC('m', 'd', 'i', 'a'):
+                CHECK(avifParseMediaBox(track, avifROStreamCurrent(&s), header.size, data->diag));
+                break;
+            case AVIF_FOURCC('t', 'r', 'e', 'f'):
+                CHECK(avifTrackReferenceBox(track, avifROStreamCurrent(&s), header.size, data->diag));
+                break;
+            default:
+                break;
         }
 
         CHECK(avifROStreamSkip(&s, header.size));
@@ -2353,7 +2949,7 @@ static avifBool avifParseMoovBox(avifDecoderData * data, const uint8_t * raw, si
         avifBoxHeader header;
         CHECK(avifROStreamReadBoxHeader(&s, &header));
 
-        if (!memcmp(header.type, "trak", 4)) {
+        if (header.fourcc == AVIF_FOURCC('t', 'r', 'a', 'k')) {
             CHECK(avifParseTrackBox(data, avifROStreamCurrent(&s), header.size, diag));
         }
 
@@ -2424,8 +3020,10 @@ static avifResult avifParse(avifDecoder * decoder)
         // Try to get the remainder of the box, if necessary
         avifROData boxContents = AVIF_DATA_EMPTY;
 
-        // TODO: reorg this code to only do these memcmps once each
-        if (!memcmp(header.type, "ftyp", 4) || !memcmp(header.type, "meta", 4) || !memcmp(header.type, "moov", 4)) {
+        const avifBool isParsedBox = (header.fourcc == AVIF_FOURCC('f', 't', 'y', 'p')) ||
+                                     (header.fourcc == AVIF_FOURCC('m', 'e', 't', 'a')) ||
+                                     (header.fourcc == AVIF_FOURCC('m', 'o', 'o', 'v'));
+        if (isParsedBox) {
             readResult = decoder->io->read(decoder->io, 0, parseOffset, header.size, &boxContents);
             if (readResult != AVIF_RESULT_OK) {
                 return readResult;
@@ -2434,29 +3032,44 @@ static avifResult avifParse(avifDecoder * decoder)
                 // A truncated box, bail out
                 return AVIF_RESULT_TRUNCATED_DATA;
             }
+
+            // Remember where the parsed boxes are and what they hold, for avifDecoderExportIndex()
+            avifExtent * containerBox = (avifExtent *)avifArrayPushPtr(&data->containerBoxes);
+            containerBox->offset = parseOffset;
+            containerBox->size = boxContents.size;
+            data->containerHash = avifHashBytes(data->containerHash, boxContents.data, boxContents.size);
         } else if (header.size > (UINT64_MAX - parseOffset)) {
             return AVIF_RESULT_BMFF_PARSE_FAILED;
         }
         parseOffset += header.size;
 
-        if (!memcmp(header.type, "ftyp", 4)) {
-            CHECKERR(!ftypSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
-            avifFileType ftyp;
-            CHECKERR(avifParseFileTypeBox(&ftyp, boxContents.data, boxContents.size, data->diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            if (!avifFileTypeIsCompatible(&ftyp)) {
-                return AVIF_RESULT_INVALID_FTYP;
-            }
-            ftypSeen = AVIF_TRUE;
-            needsMeta = avifFileTypeHasBrand(&ftyp, "avif");
-            needsMoov = avifFileTypeHasBrand(&ftyp, "avis");
-        } else if (!memcmp(header.type, "meta", 4)) {
-            CHECKERR(!metaSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
-            CHECKERR(avifParseMetaBox(data->meta, boxContents.data, boxContents.size, data->diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            metaSeen = AVIF_TRUE;
-        } else if (!memcmp(header.type, "moov", 4)) {
-            CHECKERR(!moovSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
-            CHECKERR(avifParseMoovBox(data, boxContents.data, boxContents.size, data->diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            moovSeen = AVIF_TRUE;
+        switch (header.fourcc) {
+            case AVIF_FOURCC('f', 't', 'y', 'p'): {
+                CHECKERR(!ftypSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
+                avifFileType ftyp;
+                CHECKERR(avifParseFileTypeBox(&ftyp, boxContents.data, boxContents.size, data->diag),
+                         AVIF_RESULT_BMFF_PARSE_FAILED);
+                if (!avifFileTypeIsCompatible(&ftyp)) {
+                    return AVIF_RESULT_INVALID_FTYP;
+                }
+                ftypSeen = AVIF_TRUE;
+                needsMeta = avifFileTypeHasBrand(&ftyp, "avif");
+                needsMoov = avifFileTypeHasBrand(&ftyp, "avis");
+                break;
+            }
+            case AVIF_FOURCC('m', 'e', 't', 'a'):
+                CHECKERR(!metaSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
+                CHECKERR(avifParseMetaBox(data->meta, boxContents.data, boxContents.size, data->diag),
+                         AVIF_RESULT_BMFF_PARSE_FAILED);
+                metaSeen = AVIF_TRUE;
+                break;
+            case AVIF_FOURCC('m', 'o', 'o', 'v'):
+                CHECKERR(!moovSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
+                CHECKERR(avifParseMoovBox(data, boxContents.data, boxContents.size, data->diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                moovSeen = AVIF_TRUE;
+                break;
+            default:
+                break;
         }
 
         // See if there is enough information to consider Parse() a success and early-out:
@@ -2503,7 +3116,7 @@ avifBool avifPeekCompatibleFileType(const avifROData * input)
 
     avifBoxHeader header;
     CHECK(avifROStreamReadBoxHeader(&s, &header));
-    if (memcmp(header.type, "ftyp", 4)) {
+    if (header.fourcc != AVIF_FOURCC('f', 't', 'y', 'p')) {
         return AVIF_FALSE;
     }
 
@@ -2517,119 +3130,785 @@ avifBool avifPeekCompatibleFileType(const avifROData * input)
 }
 
 // ---------------------------------------------------------------------------
+// avifPeekImageInfo
 
-avifDecoder * avifDecoderCreate(void)
+// An allocation-free view of a meta box: the payloads of the child boxes avifPeekImageInfo() needs,
+// which are walked again for every lookup instead of being parsed into avifDecoderItems.
+typedef struct avifPeekMeta
 {
-    avifDecoder * decoder = (avifDecoder *)avifAlloc(sizeof(avifDecoder));
-    memset(decoder, 0, sizeof(avifDecoder));
-    decoder->maxThreads = 1;
-    decoder->imageCountLimit = AVIF_DEFAULT_IMAGE_COUNT_LIMIT;
-    decoder->strictFlags = AVIF_STRICT_ENABLED;
-    return decoder;
-}
+    uint32_t primaryItemID;
+    avifROData iinf;
+    avifROData iloc;
+    avifROData iref;
+    avifROData iprp;
+    avifROData idat;
+} avifPeekMeta;
+
+// The parts of a trak box avifPeekImageInfo() reports on
+typedef struct avifPeekTrack
+{
+    uint32_t id;
+    uint32_t width;
+    uint32_t height;
+    uint32_t auxForID;
+    uint32_t sampleCount;
+    avifBool hasAV1C;
+    avifCodecConfigurationBox av1C;
+} avifPeekTrack;
 
-static void avifDecoderCleanup(avifDecoder * decoder)
+// Finds the first child box of the given type in raw (a sequence of boxes).
+static avifBool avifPeekFindChildBox(const uint8_t * raw, size_t rawLen, const char * type, avifROData * outPayload)
 {
-    if (decoder->data) {
-        avifDecoderDataDestroy(decoder->data);
-        decoder->data = NULL;
-    }
+    BEGIN_STREAM(s, raw, rawLen, NULL, NULL);
 
-    if (decoder->image) {
-        avifImageDestroy(decoder->image);
-        decoder->image = NULL;
+    const uint32_t fourcc = AVIF_FOURCC(type[0], type[1], type[2], type[3]);
+    while (avifROStreamHasBytesLeft(&s, 1)) {
+        avifBoxHeader header;
+        CHECK(avifROStreamReadBoxHeader(&s, &header));
+        if (header.fourcc == fourcc) {
+            outPayload->data = avifROStreamCurrent(&s);
+            outPayload->size = header.size;
+            return AVIF_TRUE;
+        }
+        CHECK(avifROStreamSkip(&s, header.size));
     }
-    avifDiagnosticsClearError(&decoder->diag);
+    return AVIF_FALSE;
 }
 
-void avifDecoderDestroy(avifDecoder * decoder)
+static avifBool avifPeekParseMetaBox(avifPeekMeta * meta, const uint8_t * raw, size_t rawLen)
 {
-    avifDecoderCleanup(decoder);
-    avifIODestroy(decoder->io);
-    avifFree(decoder);
-}
+    BEGIN_STREAM(s, raw, rawLen, NULL, NULL);
 
-avifResult avifDecoderSetSource(avifDecoder * decoder, avifDecoderSource source)
-{
-    decoder->requestedSource = source;
-    return avifDecoderReset(decoder);
-}
+    memset(meta, 0, sizeof(avifPeekMeta));
+    CHECK(avifROStreamReadAndEnforceVersion(&s, 0));
 
-void avifDecoderSetIO(avifDecoder * decoder, avifIO * io)
-{
-    avifIODestroy(decoder->io);
-    decoder->io = io;
-}
+    while (avifROStreamHasBytesLeft(&s, 1)) {
+        avifBoxHeader header;
+        CHECK(avifROStreamReadBoxHeader(&s, &header));
 
-avifResult avifDecoderSetIOMemory(avifDecoder * decoder, const uint8_t * data, size_t size)
-{
-    avifIO * io = avifIOCreateMemoryReader(data, size);
-    assert(io);
-    avifDecoderSetIO(decoder, io);
-    return AVIF_RESULT_OK;
-}
+        avifROData * payload = NULL;
+        switch (header.fourcc) {
+            case AVIF_FOURCC('p', 'i', 't', 'm'): {
+                BEGIN_STREAM(pitm, avifROStreamCurrent(&s), header.size, NULL, NULL);
+                uint8_t version;
+                CHECK(avifROStreamReadVersionAndFlags(&pitm, &version, NULL));
+                if (version == 0) {
+                    uint16_t tmp16;
+                    CHECK(avifROStreamReadU16(&pitm, &tmp16)); // unsigned int(16) item_ID;
+                    meta->primaryItemID = tmp16;
+                } else {
+                    CHECK(avifROStreamReadU32(&pitm, &meta->primaryItemID)); // unsigned int(32) item_ID;
+                }
+                break;
+            }
+            case AVIF_FOURCC('i', 'i', 'n', 'f'):
+                payload = &meta->iinf;
+                break;
+            case AVIF_FOURCC('i', 'l', 'o', 'c'):
+                payload = &meta->iloc;
+                break;
+            case AVIF_FOURCC('i', 'r', 'e', 'f'):
+                payload = &meta->iref;
+                break;
+            case AVIF_FOURCC('i', 'p', 'r', 'p'):
+                payload = &meta->iprp;
+                break;
+            case AVIF_FOURCC('i', 'd', 'a', 't'):
+                payload = &meta->idat;
+                break;
+            default:
+                break;
+        }
+        if (payload) {
+            payload->data = avifROStreamCurrent(&s);
+            payload->size = header.size;
+        }
 
-avifResult avifDecoderSetIOFile(avifDecoder * decoder, const char * filename)
-{
-    avifIO * io = avifIOCreateFileReader(filename);
-    if (!io) {
-        return AVIF_RESULT_IO_ERROR;
+        CHECK(avifROStreamSkip(&s, header.size));
     }
-    avifDecoderSetIO(decoder, io);
-    return AVIF_RESULT_OK;
+    return AVIF_TRUE;
 }
 
-// 0-byte extents are ignored/overwritten during the merge, as they are the signal from helper
-// functions that no extent was necessary for this given sample. If both provided extents are
-// >0 bytes, this will set dst to be an extent that bounds both supplied extents.
-static avifResult avifExtentMerge(avifExtent * dst, const avifExtent * src)
+static avifBool avifPeekMetaGetItemType(const avifPeekMeta * meta, uint32_t itemID, uint8_t outType[4])
 {
-    if (!dst->size) {
-        memcpy(dst, src, sizeof(avifExtent));
-        return AVIF_RESULT_OK;
-    }
-    if (!src->size) {
-        return AVIF_RESULT_OK;
+    BEGIN_STREAM(s, meta->iinf.data, meta->iinf.size, NULL, NULL);
+
+    uint8_t version;
+    CHECK(avifROStreamReadVersionAndFlags(&s, &version, NULL));
+    uint32_t entryCount;
+    if (version == 0) {
+        uint16_t tmp;
+        CHECK(avifROStreamReadU16(&s, &tmp)); // unsigned int(16) entry_count;
+        entryCount = tmp;
+    } else {
+        CHECK(avifROStreamReadU32(&s, &entryCount)); // unsigned int(32) entry_count;
     }
 
-    const uint64_t minExtent1 = dst->offset;
-    const uint64_t maxExtent1 = dst->offset + dst->size;
-    const uint64_t minExtent2 = src->offset;
-    const uint64_t maxExtent2 = src->offset + src->size;
-    dst->offset = AVIF_MIN(minExtent1, minExtent2);
-    const uint64_t extentLength = AVIF_MAX(maxExtent1, maxExtent2) - dst->offset;
-    if (extentLength > SIZE_MAX) {
-        return AVIF_RESULT_BMFF_PARSE_FAILED;
+    for (uint32_t entryIndex = 0; entryIndex < entryCount; ++entryIndex) {
+        avifBoxHeader infeHeader;
+        CHECK(avifROStreamReadBoxHeader(&s, &infeHeader));
+
+        BEGIN_STREAM(infe, avifROStreamCurrent(&s), infeHeader.size, NULL, NULL);
+        uint8_t infeVersion;
+        CHECK(avifROStreamReadVersionAndFlags(&infe, &infeVersion, NULL));
+        if (infeVersion == 2) {
+            uint16_t entryItemID, itemProtectionIndex;
+            CHECK(avifROStreamReadU16(&infe, &entryItemID));         // unsigned int(16) item_ID;
+            CHECK(avifROStreamReadU16(&infe, &itemProtectionIndex)); // unsigned int(16) item_protection_index;
+            if (entryItemID == itemID) {
+                return avifROStreamRead(&infe, outType, 4); // unsigned int(32) item_type;
+            }
+        }
+
+        CHECK(avifROStreamSkip(&s, infeHeader.size));
     }
-    dst->size = (size_t)extentLength;
-    return AVIF_RESULT_OK;
+    return AVIF_FALSE;
 }
 
-avifResult avifDecoderNthImageMaxExtent(const avifDecoder * decoder, uint32_t frameIndex, avifExtent * outExtent)
+// Finds the property of the given type associated with itemID.
+static avifBool avifPeekMetaFindItemProperty(const avifPeekMeta * meta,
+                                             uint32_t itemID,
+                                             const char * type,
+                                             avifROData * outPayload)
 {
-    if (!decoder->data) {
-        // Nothing has been parsed yet
-        return AVIF_RESULT_NO_CONTENT;
-    }
+    avifROData ipco;
+    CHECK(avifPeekFindChildBox(meta->iprp.data, meta->iprp.size, "ipco", &ipco));
+    const uint32_t fourcc = AVIF_FOURCC(type[0], type[1], type[2], type[3]);
 
-    memset(outExtent, 0, sizeof(avifExtent));
+    BEGIN_STREAM(s, meta->iprp.data, meta->iprp.size, NULL, NULL);
+    while (avifROStreamHasBytesLeft(&s, 1)) {
+        avifBoxHeader header;
+        CHECK(avifROStreamReadBoxHeader(&s, &header));
+        if (header.fourcc != AVIF_FOURCC('i', 'p', 'm', 'a')) {
+            CHECK(avifROStreamSkip(&s, header.size));
+            continue;
+        }
 
-    uint32_t startFrameIndex = avifDecoderNearestKeyframe(decoder, frameIndex);
-    uint32_t endFrameIndex = frameIndex;
-    for (uint32_t currentFrameIndex = startFrameIndex; currentFrameIndex <= endFrameIndex; ++currentFrameIndex) {
-        for (unsigned int tileIndex = 0; tileIndex < decoder->data->tiles.count; ++tileIndex) {
-            avifTile * tile = &decoder->data->tiles.tile[tileIndex];
-            if (currentFrameIndex >= tile->input->samples.count) {
-                return AVIF_RESULT_NO_IMAGES_REMAINING;
+        BEGIN_STREAM(ipma, avifROStreamCurrent(&s), header.size, NULL, NULL);
+        uint8_t version;
+        uint32_t flags;
+        CHECK(avifROStreamReadVersionAndFlags(&ipma, &version, &flags));
+        const avifBool propertyIndexIsU16 = ((flags & 0x1) != 0);
+        uint32_t entryCount;
+        CHECK(avifROStreamReadU32(&ipma, &entryCount));
+        for (uint32_t entryIndex = 0; entryIndex < entryCount; ++entryIndex) {
+            uint32_t entryItemID;
+            if (version < 1) {
+                uint16_t tmp;
+                CHECK(avifROStreamReadU16(&ipma, &tmp));
+                entryItemID = tmp;
+            } else {
+                CHECK(avifROStreamReadU32(&ipma, &entryItemID));
             }
+            uint8_t associationCount;
+            CHECK(avifROStreamRead(&ipma, &associationCount, 1));
+            for (uint8_t associationIndex = 0; associationIndex < associationCount; ++associationIndex) {
+                uint16_t propertyIndex;
+                if (propertyIndexIsU16) {
+                    CHECK(avifROStreamReadU16(&ipma, &propertyIndex));
+                    propertyIndex &= 0x7fff;
+                } else {
+                    uint8_t tmp;
+                    CHECK(avifROStreamRead(&ipma, &tmp, 1));
+                    propertyIndex = tmp & 0x7f;
+                }
+                if ((entryItemID != itemID) || (propertyIndex == 0)) {
+                    continue;
+                }
 
-            avifDecodeSample * sample = &tile->input->samples.sample[currentFrameIndex];
-            avifExtent sampleExtent;
+                // Walk ipco to the (1-indexed) associated property
+                BEGIN_STREAM(props, ipco.data, ipco.size, NULL, NULL);
+                avifBoxHeader propHeader;
+                for (uint16_t i = 0; i < propertyIndex; ++i) {
+                    if (i > 0) {
+                        CHECK(avifROStreamSkip(&props, propHeader.size));
+                    }
+                    CHECK(avifROStreamReadBoxHeader(&props, &propHeader));
+                }
+                if (propHeader.fourcc == fourcc) {
+                    outPayload->data = avifROStreamCurrent(&props);
+                    outPayload->size = propHeader.size;
+                    return AVIF_TRUE;
+                }
+            }
+        }
+        CHECK(avifROStreamSkip(&s, header.size));
+    }
+    return AVIF_FALSE;
+}
+
+// Finds the referenceIndex'th reference of the given type from fromID to toID, either of which may be
+// 0 to match any item.
+static avifBool avifPeekMetaFindReference(const avifPeekMeta * meta,
+                                          const char * type,
+                                          uint32_t fromID,
+                                          uint32_t toID,
+                                          uint32_t referenceIndex,
+                                          uint32_t * outFromID,
+                                          uint32_t * outToID)
+{
+    BEGIN_STREAM(s, meta->iref.data, meta->iref.size, NULL, NULL);
+
+    const uint32_t fourcc = AVIF_FOURCC(type[0], type[1], type[2], type[3]);
+    uint8_t version;
+    CHECK(avifROStreamReadVersionAndFlags(&s, &version, NULL));
+    if (version > 1) {
+        return AVIF_FALSE;
+    }
+
+    while (avifROStreamHasBytesLeft(&s, 1)) {
+        avifBoxHeader irefHeader;
+        CHECK(avifROStreamReadBoxHeader(&s, &irefHeader));
+
+        BEGIN_STREAM(ref, avifROStreamCurrent(&s), irefHeader.size, NULL, NULL);
+        uint32_t refFromID;
+        if (version == 0) {
+            uint16_t tmp;
+            CHECK(avifROStreamReadU16(&ref, &tmp)); // unsigned int(16) from_item_ID;
+            refFromID = tmp;
+        } else {
+            CHECK(avifROStreamReadU32(&ref, &refFromID)); // unsigned int(32) from_item_ID;
+        }
+        uint16_t referenceCount;
+        CHECK(avifROStreamReadU16(&ref, &referenceCount)); // unsigned int(16) reference_count;
+        for (uint16_t refIndex = 0; refIndex < referenceCount; ++refIndex) {
+            uint32_t refToID;
+            if (version == 0) {
+                uint16_t tmp;
+                CHECK(avifROStreamReadU16(&ref, &tmp)); // unsigned int(16) to_item_ID;
+                refToID = tmp;
+            } else {
+                CHECK(avifROStreamReadU32(&ref, &refToID)); // unsigned int(32) to_item_ID;
+            }
+            if ((irefHeader.fourcc != fourcc) || (fromID && (refFromID != fromID)) || (toID && (refToID != toID))) {
+                continue;
+            }
+            if (referenceIndex == 0) {
+                *outFromID = refFromID;
+                *outToID = refToID;
+                return AVIF_TRUE;
+            }
+            --referenceIndex;
+        }
+
+        CHECK(avifROStreamSkip(&s, irefHeader.size));
+    }
+    return AVIF_FALSE;
+}
+
+// Copies the contents of a small item (such as a grid) into buffer. The item's extents may lie beyond
+// the end of input, in which case *bytesNeeded is raised to cover them and the caller has to retry.
+static avifBool avifPeekMetaReadItem(const avifPeekMeta * meta,
+                                     const avifROData * input,
+                                     uint32_t itemID,
+                                     uint8_t * buffer,
+                                     size_t bufferSize,
+                                     size_t * outSize,
+                                     size_t * bytesNeeded)
+{
+    BEGIN_STREAM(s, meta->iloc.data, meta->iloc.size, NULL, NULL);
+
+    uint8_t version;
+    CHECK(avifROStreamReadVersionAndFlags(&s, &version, NULL));
+    CHECK(version <= 2);
+    uint8_t offsetSizeAndLengthSize, baseOffsetSizeAndIndexSize;
+    CHECK(avifROStreamRead(&s, &offsetSizeAndLengthSize, 1));
+    CHECK(avifROStreamRead(&s, &baseOffsetSizeAndIndexSize, 1));
+    const uint8_t offsetSize = (offsetSizeAndLengthSize >> 4) & 0xf;        // unsigned int(4) offset_size;
+    const uint8_t lengthSize = (offsetSizeAndLengthSize >> 0) & 0xf;        // unsigned int(4) length_size;
+    const uint8_t baseOffsetSize = (baseOffsetSizeAndIndexSize >> 4) & 0xf; // unsigned int(4) base_offset_size;
+    CHECK((version == 0) || ((baseOffsetSizeAndIndexSize & 0xf) == 0)); // extent_index unsupported
+
+    uint32_t itemCount;
+    if (version < 2) {
+        uint16_t tmp16;
+        CHECK(avifROStreamReadU16(&s, &tmp16)); // unsigned int(16) item_count;
+        itemCount = tmp16;
+    } else {
+        CHECK(avifROStreamReadU32(&s, &itemCount)); // unsigned int(32) item_count;
+    }
+    for (uint32_t i = 0; i < itemCount; ++i) {
+        uint32_t entryItemID;
+        if (version < 2) {
+            uint16_t tmp16;
+            CHECK(avifROStreamReadU16(&s, &tmp16)); // unsigned int(16) item_ID;
+            entryItemID = tmp16;
+        } else {
+            CHECK(avifROStreamReadU32(&s, &entryItemID)); // unsigned int(32) item_ID;
+        }
+        uint8_t constructionMethod = 0;
+        if ((version == 1) || (version == 2)) {
+            uint8_t ignored;
+            CHECK(avifROStreamRead(&s, &ignored, 1));            // unsigned int(12) reserved = 0;
+            CHECK(avifROStreamRead(&s, &constructionMethod, 1)); // unsigned int(4) construction_method;
+            constructionMethod = constructionMethod & 0xf;
+        }
+        uint16_t dataReferenceIndex;                                 // unsigned int(16) data_reference_index;
+        CHECK(avifROStreamReadU16(&s, &dataReferenceIndex));         //
+        uint64_t baseOffset;                                         // unsigned int(base_offset_size*8) base_offset;
+        CHECK(avifROStreamReadUX8(&s, &baseOffset, baseOffsetSize)); //
+        uint16_t extentCount;                                        // unsigned int(16) extent_count;
+        CHECK(avifROStreamReadU16(&s, &extentCount));                //
+
+        *outSize = 0;
+        for (uint16_t extentIter = 0; extentIter < extentCount; ++extentIter) {
+            uint64_t extentOffset; // unsigned int(offset_size*8) extent_offset;
+            CHECK(avifROStreamReadUX8(&s, &extentOffset, offsetSize));
+            uint64_t extentLength; // unsigned int(length_size*8) extent_length;
+            CHECK(avifROStreamReadUX8(&s, &extentLength, lengthSize));
+            if (entryItemID != itemID) {
+                continue;
+            }
+
+            CHECK(extentOffset <= UINT64_MAX - baseOffset);
+            const uint64_t offset = baseOffset + extentOffset;
+            CHECK(extentLength <= (bufferSize - *outSize));
+            CHECK(offset <= (SIZE_MAX - extentLength));
+            const size_t extentEnd = (size_t)(offset + extentLength);
+
+            const uint8_t * extentData;
+            if (constructionMethod == 1) {
+                CHECK(extentEnd <= meta->idat.size);
+                extentData = meta->idat.data + offset;
+            } else {
+                CHECK(constructionMethod == 0);
+                *bytesNeeded = AVIF_MAX(*bytesNeeded, extentEnd);
+                if (extentEnd > input->size) {
+                    // Keep going, in case a later extent reaches even further into the file
+                    continue;
+                }
+                extentData = input->data + offset;
+            }
+            memcpy(buffer + *outSize, extentData, (size_t)extentLength);
+            *outSize += (size_t)extentLength;
+        }
+        if (entryItemID == itemID) {
+            return AVIF_TRUE;
+        }
+    }
+    return AVIF_FALSE;
+}
+
+static avifBool avifPeekParseTrackBox(avifPeekTrack * track, const uint8_t * raw, size_t rawLen)
+{
+    memset(track, 0, sizeof(avifPeekTrack));
+
+    avifROData tkhd;
+    if (avifPeekFindChildBox(raw, rawLen, "tkhd", &tkhd)) {
+        avifTrack trackHeader;
+        memset(&trackHeader, 0, sizeof(trackHeader));
+        CHECK(avifParseTrackHeaderBox(&trackHeader, tkhd.data, tkhd.size, NULL));
+        track->id = trackHeader.id;
+        track->width = trackHeader.width;
+        track->height = trackHeader.height;
+    }
+
+    avifROData tref, auxl;
+    if (avifPeekFindChildBox(raw, rawLen, "tref", &tref) && avifPeekFindChildBox(tref.data, tref.size, "auxl", &auxl)) {
+        BEGIN_STREAM(s, auxl.data, auxl.size, NULL, NULL);
+        CHECK(avifROStreamReadU32(&s, &track->auxForID)); // unsigned int(32) track_IDs[]; (just take the first one)
+    }
+
+    avifROData mdia, minf, stbl;
+    if (!avifPeekFindChildBox(raw, rawLen, "mdia", &mdia) || !avifPeekFindChildBox(mdia.data, mdia.size, "minf", &minf) ||
+        !avifPeekFindChildBox(minf.data, minf.size, "stbl", &stbl)) {
+        // Not a track libavif can use, but not an error either
+        return AVIF_TRUE;
+    }
+
+    avifROData stsd;
+    if (avifPeekFindChildBox(stbl.data, stbl.size, "stsd", &stsd)) {
+        BEGIN_STREAM(s, stsd.data, stsd.size, NULL, NULL);
+        CHECK(avifROStreamReadAndEnforceVersion(&s, 0));
+        uint32_t entryCount;
+        CHECK(avifROStreamReadU32(&s, &entryCount)); // unsigned int(32) entry_count;
+        for (uint32_t i = 0; (i < entryCount) && !track->hasAV1C; ++i) {
+            avifBoxHeader sampleEntryHeader;
+            CHECK(avifROStreamReadBoxHeader(&s, &sampleEntryHeader));
+            avifROData av1C;
+            if ((sampleEntryHeader.fourcc == AVIF_FOURCC('a', 'v', '0', '1')) &&
+                (sampleEntryHeader.size > VISUALSAMPLEENTRY_SIZE) &&
+                avifPeekFindChildBox(avifROStreamCurrent(&s) + VISUALSAMPLEENTRY_SIZE,
+                                     sampleEntryHeader.size - VISUALSAMPLEENTRY_SIZE,
+                                     "av1C",
+                                     &av1C)) {
+                CHECK(avifParseAV1CodecConfigurationBox(av1C.data, av1C.size, &track->av1C, NULL));
+                track->hasAV1C = AVIF_TRUE;
+            }
+            CHECK(avifROStreamSkip(&s, sampleEntryHeader.size));
+        }
+    }
+
+    // Count samples the same way avifCodecDecodeInputSetSampleTable() does: from the chunk count and
+    // the samples per chunk of each stsc entry.
+    avifROData stco, stsc;
+    uint32_t chunkCount = 0;
+    if (avifPeekFindChildBox(stbl.data, stbl.size, "stco", &stco) || avifPeekFindChildBox(stbl.data, stbl.size, "co64", &stco)) {
+        BEGIN_STREAM(s, stco.data, stco.size, NULL, NULL);
+        CHECK(avifROStreamReadAndEnforceVersion(&s, 0));
+        CHECK(avifROStreamReadU32(&s, &chunkCount)); // unsigned int(32) entry_count;
+    }
+    if ((chunkCount > 0) && avifPeekFindChildBox(stbl.data, stbl.size, "stsc", &stsc)) {
+        BEGIN_STREAM(s, stsc.data, stsc.size, NULL, NULL);
+        CHECK(avifROStreamReadAndEnforceVersion(&s, 0));
+        uint32_t entryCount;
+        CHECK(avifROStreamReadU32(&s, &entryCount)); // unsigned int(32) entry_count;
+        uint64_t sampleCount = 0;
+        uint32_t firstChunk = 0, samplesPerChunk = 0, sampleDescriptionIndex;
+        for (uint32_t i = 0; i <= entryCount; ++i) {
+            uint32_t nextFirstChunk = chunkCount + 1;
+            uint32_t nextSamplesPerChunk = 0;
+            if (i < entryCount) {
+                CHECK(avifROStreamReadU32(&s, &nextFirstChunk));         // unsigned int(32) first_chunk;
+                CHECK(avifROStreamReadU32(&s, &nextSamplesPerChunk));    // unsigned int(32) samples_per_chunk;
+                CHECK(avifROStreamReadU32(&s, &sampleDescriptionIndex)); // unsigned int(32) sample_description_index;
+                CHECK((i > 0) || (nextFirstChunk == 1));
+                nextFirstChunk = AVIF_MIN(nextFirstChunk, chunkCount + 1);
+                CHECK(nextFirstChunk > firstChunk);
+            }
+            if (firstChunk > 0) {
+                sampleCount += (uint64_t)(nextFirstChunk - firstChunk) * samplesPerChunk;
+            }
+            firstChunk = nextFirstChunk;
+            samplesPerChunk = nextSamplesPerChunk;
+            if (firstChunk > chunkCount) {
+                break;
+            }
+        }
+        CHECK(sampleCount <= UINT32_MAX);
+        track->sampleCount = (uint32_t)sampleCount;
+    }
+    return AVIF_TRUE;
+}
+
+// Finds the first usable track which is an auxiliary track for auxForID (or is not an auxiliary
+// track, if auxForID is 0), like avifDecoderReset() does.
+static avifBool avifPeekFindTrack(const avifROData * moov, uint32_t auxForID, avifPeekTrack * outTrack)
+{
+    BEGIN_STREAM(s, moov->data, moov->size, NULL, NULL);
+
+    while (avifROStreamHasBytesLeft(&s, 1)) {
+        avifBoxHeader header;
+        CHECK(avifROStreamReadBoxHeader(&s, &header));
+        if ((header.fourcc == AVIF_FOURCC('t', 'r', 'a', 'k')) &&
+            avifPeekParseTrackBox(outTrack, avifROStreamCurrent(&s), header.size) &&
+            outTrack->id && outTrack->sampleCount && outTrack->hasAV1C && (outTrack->auxForID == auxForID)) {
+            return AVIF_TRUE;
+        }
+        CHECK(avifROStreamSkip(&s, header.size));
+    }
+    return AVIF_FALSE;
+}
+
+static void avifPeekSetConfiguration(avifImageInfo * info, const avifCodecConfigurationBox * av1C)
+{
+    info->depth = avifCodecConfigurationBoxGetDepth(av1C);
+    info->yuvFormat = avifCodecConfigurationBoxGetFormat(av1C);
+}
+
+avifResult avifPeekImageInfo(const avifROData * input, avifImageInfo * info)
+{
+    memset(info, 0, sizeof(avifImageInfo));
+
+    // Walk the top-level boxes just like avifParse(), skipping over everything but ftyp, meta and moov
+    avifROData meta = AVIF_DATA_EMPTY;
+    avifROData moov = AVIF_DATA_EMPTY;
+    avifBool ftypSeen = AVIF_FALSE;
+    avifBool needsMeta = AVIF_FALSE;
+    avifBool needsMoov = AVIF_FALSE;
+    size_t offset = 0;
+    while (!ftypSeen || (needsMeta && !meta.data) || (needsMoov && !moov.data)) {
+        if (offset > input->size) {
+            // The previous box (probably mdat) reaches past the end of input
+            info->bytesNeeded = offset + 32;
+            return AVIF_RESULT_TRUNCATED_DATA;
+        }
+        BEGIN_STREAM(s, input->data + offset, input->size - offset, NULL, NULL);
+        avifBoxHeader header;
+        if (!avifROStreamReadBoxHeaderPartial(&s, &header)) {
+            // A box header is at most 32 bytes long
+            if (avifROStreamRemainingBytes(&s) < 32) {
+                info->bytesNeeded = offset + 32;
+                return AVIF_RESULT_TRUNCATED_DATA;
+            }
+            return AVIF_RESULT_BMFF_PARSE_FAILED;
+        }
+        const size_t headerSize = avifROStreamOffset(&s);
+        CHECKERR(header.size <= (SIZE_MAX - offset - headerSize), AVIF_RESULT_BMFF_PARSE_FAILED);
+        const size_t boxEnd = offset + headerSize + header.size;
+
+        const avifBool isParsedBox = (header.fourcc == AVIF_FOURCC('f', 't', 'y', 'p')) ||
+                                     (header.fourcc == AVIF_FOURCC('m', 'e', 't', 'a')) ||
+                                     (header.fourcc == AVIF_FOURCC('m', 'o', 'o', 'v'));
+        if (isParsedBox) {
+            if (boxEnd > input->size) {
+                info->bytesNeeded = boxEnd;
+                return AVIF_RESULT_TRUNCATED_DATA;
+            }
+            info->bytesNeeded = boxEnd;
+        }
+        const avifROData payload = { avifROStreamCurrent(&s), header.size };
+
+        switch (header.fourcc) {
+            case AVIF_FOURCC('f', 't', 'y', 'p'): {
+                CHECKERR(!ftypSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
+                avifFileType ftyp;
+                CHECKERR(avifParseFileTypeBox(&ftyp, payload.data, payload.size, NULL), AVIF_RESULT_BMFF_PARSE_FAILED);
+                if (!avifFileTypeIsCompatible(&ftyp)) {
+                    return AVIF_RESULT_INVALID_FTYP;
+                }
+                ftypSeen = AVIF_TRUE;
+                needsMeta = avifFileTypeHasBrand(&ftyp, "avif");
+                needsMoov = avifFileTypeHasBrand(&ftyp, "avis");
+                break;
+            }
+            case AVIF_FOURCC('m', 'e', 't', 'a'):
+                CHECKERR(!meta.data, AVIF_RESULT_BMFF_PARSE_FAILED);
+                meta = payload;
+                break;
+            case AVIF_FOURCC('m', 'o', 'o', 'v'):
+                CHECKERR(!moov.data, AVIF_RESULT_BMFF_PARSE_FAILED);
+                moov = payload;
+                break;
+            default:
+                break;
+        }
+        offset = boxEnd;
+    }
+
+    if (moov.data) {
+        avifPeekTrack colorTrack;
+        if (avifPeekFindTrack(&moov, 0, &colorTrack)) {
+            avifPeekTrack alphaTrack;
+            info->width = colorTrack.width;
+            info->height = colorTrack.height;
+            avifPeekSetConfiguration(info, &colorTrack.av1C);
+            info->alphaPresent = avifPeekFindTrack(&moov, colorTrack.id, &alphaTrack);
+            info->imageCount = colorTrack.sampleCount;
+            return AVIF_RESULT_OK;
+        }
+    }
+    if (!meta.data) {
+        return AVIF_RESULT_NO_CONTENT;
+    }
+
+    avifPeekMeta peekMeta;
+    CHECKERR(avifPeekParseMetaBox(&peekMeta, meta.data, meta.size), AVIF_RESULT_BMFF_PARSE_FAILED);
+    uint8_t colorType[4];
+    if (!peekMeta.primaryItemID || !avifPeekMetaGetItemType(&peekMeta, peekMeta.primaryItemID, colorType) ||
+        (memcmp(colorType, "av01", 4) && memcmp(colorType, "grid", 4))) {
+        return AVIF_RESULT_NO_AV1_ITEMS_FOUND;
+    }
+    const uint32_t colorID = peekMeta.primaryItemID;
+    info->imageCount = 1;
+
+    avifROData propertyPayload;
+    if (avifPeekMetaFindItemProperty(&peekMeta, colorID, "ispe", &propertyPayload)) {
+        avifProperty ispe;
+        if (!avifParseImageSpatialExtentsProperty(&ispe, propertyPayload.data, propertyPayload.size, NULL)) {
+            return AVIF_RESULT_BMFF_PARSE_FAILED;
+        }
+        info->width = ispe.u.ispe.width;
+        info->height = ispe.u.ispe.height;
+    }
+
+    // A grid's av1C normally mirrors its tiles'; fall back to the first tile's if it's missing.
+    uint32_t configItemID = colorID;
+    if (!memcmp(colorType, "grid", 4)) {
+        uint8_t gridPayload[16];
+        size_t gridPayloadSize;
+        if (!avifPeekMetaReadItem(&peekMeta,
+                                  input,
+                                  colorID,
+                                  gridPayload,
+                                  sizeof(gridPayload),
+                                  &gridPayloadSize,
+                                  &info->bytesNeeded)) {
+            return AVIF_RESULT_INVALID_IMAGE_GRID;
+        }
+        if (info->bytesNeeded > input->size) {
+            return AVIF_RESULT_TRUNCATED_DATA;
+        }
+        avifImageGrid grid;
+        CHECKERR(avifParseImageGridBox(&grid, gridPayload, gridPayloadSize, NULL), AVIF_RESULT_INVALID_IMAGE_GRID);
+        info->gridRows = grid.rows;
+        info->gridColumns = grid.columns;
+
+        uint32_t gridID, firstTileID;
+        if (!avifPeekMetaFindItemProperty(&peekMeta, colorID, "av1C", &propertyPayload) &&
+            avifPeekMetaFindReference(&peekMeta, "dimg", colorID, 0, 0, &gridID, &firstTileID)) {
+            configItemID = firstTileID;
+        }
+    }
+    avifCodecConfigurationBox av1C;
+    if (!avifPeekMetaFindItemProperty(&peekMeta, configItemID, "av1C", &propertyPayload) ||
+        !avifParseAV1CodecConfigurationBox(propertyPayload.data, propertyPayload.size, &av1C, NULL)) {
+        // An av1C box is mandatory in all valid AVIF configurations.
+        return AVIF_RESULT_BMFF_PARSE_FAILED;
+    }
+    avifPeekSetConfiguration(info, &av1C);
+
+    // Find the alpha auxiliary item of the primary item, if any
+    uint32_t alphaID, auxForID;
+    for (uint32_t referenceIndex = 0; !info->alphaPresent; ++referenceIndex) {
+        if (!avifPeekMetaFindReference(&peekMeta, "auxl", 0, colorID, referenceIndex, &alphaID, &auxForID)) {
+            break;
+        }
+        uint8_t alphaType[4];
+        if (!avifPeekMetaGetItemType(&peekMeta, alphaID, alphaType) ||
+            (memcmp(alphaType, "av01", 4) && memcmp(alphaType, "grid", 4))) {
+            continue;
+        }
+        avifProperty auxC;
+        info->alphaPresent = avifPeekMetaFindItemProperty(&peekMeta, alphaID, "auxC", &propertyPayload) &&
+                             avifParseAuxiliaryTypeProperty(&auxC, propertyPayload.data, propertyPayload.size, NULL) &&
+                             isAlphaURN(auxC.u.auxC.auxType);
+    }
+    return AVIF_RESULT_OK;
+}
+
+// ---------------------------------------------------------------------------
+
+avifDecoder * avifDecoderCreate(void)
+{
+    avifDecoder * decoder = (avifDecoder *)avifAlloc(sizeof(avifDecoder));
+    memset(decoder, 0, sizeof(avifDecoder));
+    decoder->maxThreads = 1;
+    decoder->imageCountLimit = AVIF_DEFAULT_IMAGE_COUNT_LIMIT;
+    decoder->strictFlags = AVIF_STRICT_ENABLED;
+    return decoder;
+}
+
+static void avifDecoderCleanup(avifDecoder * decoder)
+{
+    if (decoder->data) {
+        avifDecoderDataDestroy(decoder->data);
+        decoder->data = NULL;
+    }
+
+    if (decoder->image) {
+        avifImageDestroy(decoder->image);
+        decoder->image = NULL;
+    }
+    avifDiagnosticsClearError(&decoder->diag);
+}
+
+void avifDecoderDestroy(avifDecoder * decoder)
+{
+    avifDecoderCleanup(decoder);
+    avifIODestroy(decoder->io);
+    avifFree(decoder);
+}
+
+avifResult avifDecoderSetSource(avifDecoder * decoder, avifDecoderSource source)
+{
+    decoder->requestedSource = source;
+    return avifDecoderReset(decoder);
+}
+
+void avifDecoderSetIO(avifDecoder * decoder, avifIO * io)
+{
+    avifIODestroy(decoder->io);
+    decoder->io = io;
+}
+
+avifResult avifDecoderSetIOMemory(avifDecoder * decoder, const uint8_t * data, size_t size)
+{
+    avifIO * io = avifIOCreateMemoryReader(data, size);
+    assert(io);
+    avifDecoderSetIO(decoder, io);
+    return AVIF_RESULT_OK;
+}
+
+avifResult avifDecoderSetIOFile(avifDecoder * decoder, const char * filename)
+{
+    avifIO * io = avifIOCreateFileReader(filename);
+    if (!io) {
+        return AVIF_RESULT_IO_ERROR;
+    }
+    avifDecoderSetIO(decoder, io);
+    return AVIF_RESULT_OK;
+}
+
+// 0-byte extents are ignored/overwritten during the merge, as they are the signal from helper
+// functions that no extent was necessary for this given sample. If both provided extents are
+// >0 bytes, this will set dst to be an extent that bounds both supplied extents.
+static avifResult avifExtentMerge(avifExtent * dst, const avifExtent * src)
+{
+    if (!dst->size) {
+        memcpy(dst, src, sizeof(avifExtent));
+        return AVIF_RESULT_OK;
+    }
+    if (!src->size) {
+        return AVIF_RESULT_OK;
+    }
+
+    const uint64_t minExtent1 = dst->offset;
+    const uint64_t maxExtent1 = dst->offset + dst->size;
+    const uint64_t minExtent2 = src->offset;
+    const uint64_t maxExtent2 = src->offset + src->size;
+    dst->offset = AVIF_MIN(minExtent1, minExtent2);
+    const uint64_t extentLength = AVIF_MAX(maxExtent1, maxExtent2) - dst->offset;
+    if (extentLength > SIZE_MAX) {
+        return AVIF_RESULT_BMFF_PARSE_FAILED;
+    }
+    dst->size = (size_t)extentLength;
+    return AVIF_RESULT_OK;
+}
+
+// Returns true if tile has no sample of its own for imageIndex although the image exists. This is the
+// case for an alpha item that isn't split into layers next to a progressive color item: it is decoded
+// once along with the first color layer, and its planes are kept for the later ones.
+static avifBool avifDecoderTileSkipsImage(const avifDecoder * decoder, const avifTile * tile, uint32_t imageIndex)
+{
+    return !tile->input->sampleTable && (imageIndex >= tile->input->samples.count) &&
+           (imageIndex < (uint32_t)decoder->imageCount);
+}
+
+avifResult avifDecoderNthImageMaxExtent(const avifDecoder * decoder, uint32_t frameIndex, avifExtent * outExtent)
+{
+    if (!decoder->data) {
+        // Nothing has been parsed yet
+        return AVIF_RESULT_NO_CONTENT;
+    }
+
+    memset(outExtent, 0, sizeof(avifExtent));
+
+    uint32_t startFrameIndex = avifDecoderNearestKeyframe(decoder, frameIndex);
+    uint32_t endFrameIndex = frameIndex;
+    for (uint32_t currentFrameIndex = startFrameIndex; currentFrameIndex <= endFrameIndex; ++currentFrameIndex) {
+        for (unsigned int tileIndex = 0; tileIndex < decoder->data->tiles.count; ++tileIndex) {
+            avifTile * tile = &decoder->data->tiles.tile[tileIndex];
+            if (avifDecoderTileSkipsImage(decoder, tile, currentFrameIndex)) {
+                continue;
+            }
+            if (currentFrameIndex >= avifCodecDecodeInputSampleCount(tile->input)) {
+                return AVIF_RESULT_NO_IMAGES_REMAINING;
+            }
+
+            // Resolve sequence samples without touching the tile's cached sample, which may be holding
+            // data for the frame currently being decoded.
+            avifDecodeSample lazySample;
+            const avifDecodeSample * sample;
+            if (tile->input->sampleTable) {
+                if (!avifSampleTableFindSample(tile->input->sampleTable,
+                                               currentFrameIndex,
+                                               NULL,
+                                               0,
+                                               &lazySample,
+                                               decoder->data->diag)) {
+                    return AVIF_RESULT_BMFF_PARSE_FAILED;
+                }
+                sample = &lazySample;
+            } else {
+                sample = &tile->input->samples.sample[currentFrameIndex];
+            }
+            avifExtent sampleExtent;
             if (sample->itemID) {
                 // The data comes from an item. Let avifDecoderItemMaxExtent() do the heavy lifting.
 
                 avifDecoderItem * item = avifMetaFindItem(decoder->data->meta, sample->itemID);
-                avifResult maxExtentResult = avifDecoderItemMaxExtent(item, &sampleExtent);
+                avifResult maxExtentResult = avifDecoderItemMaxExtent(item, sample->offset + sample->size, &sampleExtent);
                 if (maxExtentResult != AVIF_RESULT_OK) {
                     return maxExtentResult;
                 }
@@ -2661,18 +3940,29 @@ static avifResult avifDecoderPrepareSample(avifDecoder * decoder, avifDecodeSamp
         if (sample->itemID) {
             // The data comes from an item. Let avifDecoderItemRead() do the heavy lifting.
 
+            // A sample may only cover part of the item (a layer of a progressive item), starting
+            // sample->offset bytes in. Only read as far into the item as the sample needs.
+            const size_t bytesToRead = (partialByteCount && (partialByteCount < sample->size)) ? partialByteCount : sample->size;
+            if (sample->offset > SIZE_MAX - bytesToRead) {
+                return AVIF_RESULT_BMFF_PARSE_FAILED;
+            }
             avifDecoderItem * item = avifMetaFindItem(decoder->data->meta, sample->itemID);
             avifROData itemContents;
-            avifResult readResult = avifDecoderItemRead(item, decoder->io, &itemContents, partialByteCount, &decoder->diag);
+            avifResult readResult =
+                avifDecoderItemRead(item, decoder->io, &itemContents, (size_t)sample->offset + bytesToRead, &decoder->diag);
             if (readResult != AVIF_RESULT_OK) {
                 return readResult;
             }
+            if (itemContents.size < sample->offset + bytesToRead) {
+                return AVIF_RESULT_TRUNCATED_DATA;
+            }
 
             // avifDecoderItemRead is guaranteed to already be persisted by either the underlying IO
             // or by mergedExtents; just reuse the buffer here.
-            memcpy(&sample->data, &itemContents, sizeof(avifROData));
+            sample->data.data = itemContents.data + sample->offset;
+            sample->data.size = bytesToRead;
             sample->ownsData = AVIF_FALSE;
-            sample->partialData = item->partialMergedExtents;
+            sample->partialData = (bytesToRead != sample->size);
         } else {
             // The data likely comes from a sample table. Pull the sample and make a copy if necessary.
 
@@ -2705,7 +3995,429 @@ static avifResult avifDecoderPrepareSample(avifDecoder * decoder, avifDecodeSamp
     return AVIF_RESULT_OK;
 }
 
-avifResult avifDecoderParse(avifDecoder * decoder)
+// Frees the in-memory copy of a sample (see avifDecoderPrepareSample()) once its codec has consumed it.
+// Codecs that keep unconsumed data across getNextImage() calls (dav1d) work on their own copy of it,
+// so none of them read sample data after getNextImage() returns, and a sample is only needed
+// again after seeking back to it, in which case avifDecoderPrepareSample() simply reads it again. This
+// keeps sequence playback from non-persistent IO from accumulating every frame's payload in memory.
+static void avifDecodeSampleReleaseData(avifDecodeSample * sample)
+{
+    if (sample->ownsData) {
+        avifRWDataFree((avifRWData *)&sample->data);
+        sample->ownsData = AVIF_FALSE;
+        sample->partialData = AVIF_FALSE;
+    } else if (sample->itemID) {
+        // Points into the item's mergedExtents, which a later read of more of the item (the next
+        // layer of a progressive item) may reallocate. Forget it so that it is looked up again.
+        memset(&sample->data, 0, sizeof(sample->data));
+        sample->partialData = AVIF_FALSE;
+    }
+}
+
+avifResult avifDecoderParse(avifDecoder * decoder)
+{
+    avifDiagnosticsClearError(&decoder->diag);
+
+    if (!decoder->io || !decoder->io->read) {
+        return AVIF_RESULT_IO_NOT_SET;
+    }
+
+    // Cleanup anything lingering in the decoder
+    avifDecoderCleanup(decoder);
+
+    // -----------------------------------------------------------------------
+    // Parse BMFF boxes
+
+    decoder->data = avifDecoderDataCreate();
+    decoder->data->diag = &decoder->diag;
+
+    avifResult parseResult = avifParse(decoder);
+    if (parseResult != AVIF_RESULT_OK) {
+        return parseResult;
+    }
+
+    return avifDecoderReset(decoder);
+}
+
+// ---------------------------------------------------------------------------
+// Decoder index
+
+// Bump this whenever the layout written by avifDecoderExportIndex() changes.
+#define AVIF_DECODER_INDEX_VERSION 2
+
+// Every index ends with avifHashBytes() of everything before it, stored as a U64
+#define AVIF_DECODER_INDEX_HASH_SIZE 8
+
+// Used to view any AVIF_ARRAY_DECLARE() array generically
+AVIF_ARRAY_DECLARE(avifIndexArray, uint8_t, ptr);
+
+// Arrays of plain structs are stored as an element count followed by their raw contents, which is
+// why an index is only valid for the libavif build that wrote it.
+static void avifIndexWriteArray(avifRWStream * s, const void * arrayStruct)
+{
+    const avifIndexArray * arr = (const avifIndexArray *)arrayStruct;
+    avifRWStreamWriteU32(s, arr->count);
+    avifRWStreamWrite(s, arr->ptr, (size_t)arr->count * arr->elementSize);
+}
+
+static avifBool avifIndexReadArray(avifROStream * s, void * arrayStruct)
+{
+    avifIndexArray * arr = (avifIndexArray *)arrayStruct;
+    uint32_t count;
+    CHECK(avifROStreamReadU32(s, &count));
+    CHECK(count <= (avifROStreamRemainingBytes(s) / arr->elementSize));
+    if (count > arr->capacity) {
+        avifFree(arr->ptr);
+        arr->ptr = (uint8_t *)avifAlloc((size_t)count * arr->elementSize);
+        arr->capacity = count;
+    }
+    CHECK(avifROStreamRead(s, arr->ptr, (size_t)count * arr->elementSize));
+    arr->count = count;
+    return AVIF_TRUE;
+}
+
+static void avifIndexWriteProperties(avifRWStream * s, const avifPropertyList * properties)
+{
+    avifRWStreamWriteU32(s, properties->array.count);
+    for (uint32_t i = 0; i < properties->array.count; ++i) {
+        const avifProperty * prop = &properties->array.prop[i];
+        if (prop->type == AVIF_FOURCC('c', 'o', 'l', 'r')) {
+            // The ICC profile points into the parsed meta box, so store the profile itself after the
+            // property (with the pointer cleared, so that the index is reproducible)
+            avifProperty colr;
+            memcpy(&colr, prop, sizeof(avifProperty));
+            colr.u.colr.icc = NULL;
+            avifRWStreamWrite(s, &colr, sizeof(avifProperty));
+            if (prop->u.colr.hasICC) {
+                avifRWStreamWriteU64(s, prop->u.colr.iccSize);
+                avifRWStreamWrite(s, prop->u.colr.icc, prop->u.colr.iccSize);
+            }
+        } else {
+            avifRWStreamWrite(s, prop, sizeof(avifProperty));
+        }
+    }
+}
+
+// Properties are restored from raw memory, so recheck what their avifParse*Property() functions
+// reject, as the rest of the decoder relies on it (array bounds, reserved bits).
+static avifBool avifIndexCheckProperty(const avifProperty * prop)
+{
+    switch (prop->type) {
+        case AVIF_FOURCC('c', 'l', 'a', 'p'):
+        case AVIF_FOURCC('i', 's', 'p', 'e'):
+        case AVIF_FOURCC('p', 'a', 's', 'p'):
+        case AVIF_FOURCC('a', 'u', 'x', 'C'):
+        case AVIF_FOURCC('a', 'v', '1', 'C'):
+        case AVIF_FOURCC('a', '1', 'l', 'x'):
+            return AVIF_TRUE;
+        case AVIF_FOURCC('c', 'o', 'l', 'r'):
+            return (prop->u.colr.hasICC <= 1) && (prop->u.colr.hasNCLX <= 1);
+        case AVIF_FOURCC('i', 'r', 'o', 't'):
+            return (prop->u.irot.angle & 0xfc) == 0;
+        case AVIF_FOURCC('i', 'm', 'i', 'r'):
+            return (prop->u.imir.axis & 0xfe) == 0;
+        case AVIF_FOURCC('p', 'i', 'x', 'i'):
+            return prop->u.pixi.planeCount <= MAX_PIXI_PLANE_DEPTHS;
+        case AVIF_FOURCC('a', '1', 'o', 'p'):
+            return prop->u.a1op.opIndex <= 31;
+        case AVIF_FOURCC('l', 's', 'e', 'l'):
+            return (prop->u.lsel.layerID == AVIF_LAYER_ID_ALL) || (prop->u.lsel.layerID < MAX_AV1_LAYER_COUNT);
+        default:
+            // Never parsed, so never looked at
+            return AVIF_TRUE;
+    }
+}
+
+// s must read from memory that outlives properties (avifDecoderData.index), as ICC profiles are
+// referenced in place.
+static avifBool avifIndexReadProperties(avifROStream * s, avifPropertyList * properties)
+{
+    uint32_t propertyCount;
+    CHECK(avifROStreamReadU32(s, &propertyCount));
+    for (uint32_t i = 0; i < propertyCount; ++i) {
+        avifProperty prop;
+        CHECK(avifROStreamRead(s, (uint8_t *)&prop, sizeof(avifProperty)));
+        if (prop.type == AVIF_FOURCC('a', 'u', 'x', 'C')) {
+            prop.u.auxC.auxType[AUXTYPE_SIZE - 1] = '\0';
+        } else if ((prop.type == AVIF_FOURCC('c', 'o', 'l', 'r')) && prop.u.colr.hasICC) {
+            uint64_t iccSize;
+            CHECK(avifROStreamReadU64(s, &iccSize));
+            CHECK(iccSize <= avifROStreamRemainingBytes(s));
+            prop.u.colr.icc = avifROStreamCurrent(s);
+            prop.u.colr.iccSize = (size_t)iccSize;
+            CHECK(avifROStreamSkip(s, prop.u.colr.iccSize));
+        } else if (prop.type == AVIF_FOURCC('c', 'o', 'l', 'r')) {
+            prop.u.colr.icc = NULL;
+            prop.u.colr.iccSize = 0;
+        }
+        CHECK(avifIndexCheckProperty(&prop));
+        avifPropertyListAdd(properties, &prop);
+    }
+    return AVIF_TRUE;
+}
+
+static void avifIndexWriteMeta(avifRWStream * s, const avifMeta * meta)
+{
+    avifRWStreamWriteU32(s, meta->primaryItemID);
+    avifRWStreamWriteU32(s, meta->idatID);
+
+    avifRWStreamWriteU32(s, meta->idats.count);
+    for (uint32_t i = 0; i < meta->idats.count; ++i) {
+        const avifDecoderItemData * idat = &meta->idats.idat[i];
+        avifRWStreamWriteU32(s, idat->id);
+        avifRWStreamWriteU64(s, idat->data.size);
+        avifRWStreamWrite(s, idat->data.data, idat->data.size);
+    }
+
+    avifRWStreamWriteU32(s, meta->items.count);
+    for (uint32_t i = 0; i < meta->items.count; ++i) {
+        const avifDecoderItem * item = &meta->items.item[i];
+        avifRWStreamWriteU32(s, item->id);
+        avifRWStreamWrite(s, item->type, 4);
+        avifRWStreamWriteU64(s, item->size);
+        avifRWStreamWriteU32(s, item->idatID);
+        avifRWStreamWrite(s, item->contentType.contentType, CONTENTTYPE_SIZE);
+        avifIndexWriteProperties(s, &item->properties);
+        avifIndexWriteArray(s, &item->extents);
+        avifRWStreamWriteU32(s, item->thumbnailForID);
+        avifRWStreamWriteU32(s, item->auxForID);
+        avifRWStreamWriteU32(s, item->descForID);
+        avifRWStreamWriteU32(s, item->dimgForID);
+        avifRWStreamWriteU32(s, item->premByID);
+        avifRWStreamWriteU8(s, item->hasUnsupportedEssentialProperty ? 1 : 0);
+        avifRWStreamWriteU8(s, item->ipmaSeen ? 1 : 0);
+    }
+}
+
+static avifBool avifIndexReadMeta(avifROStream * s, avifMeta * meta)
+{
+    CHECK(avifROStreamReadU32(s, &meta->primaryItemID));
+    CHECK(avifROStreamReadU32(s, &meta->idatID));
+
+    uint32_t idatCount;
+    CHECK(avifROStreamReadU32(s, &idatCount));
+    for (uint32_t i = 0; i < idatCount; ++i) {
+        uint32_t id;
+        uint64_t size;
+        CHECK(avifROStreamReadU32(s, &id));
+        CHECK(avifROStreamReadU64(s, &size));
+        CHECK(size <= avifROStreamRemainingBytes(s));
+        avifDecoderItemData * idat = (avifDecoderItemData *)avifArrayPushPtr(&meta->idats);
+        idat->id = id;
+        avifRWDataSet(&idat->data, avifROStreamCurrent(s), (size_t)size);
+        CHECK(avifROStreamSkip(s, (size_t)size));
+    }
+
+    uint32_t itemCount;
+    CHECK(avifROStreamReadU32(s, &itemCount));
+    for (uint32_t i = 0; i < itemCount; ++i) {
+        uint32_t id;
+        CHECK(avifROStreamReadU32(s, &id));
+        avifDecoderItem * item = avifMetaFindItem(meta, id);
+        CHECK(item && (meta->items.count == (i + 1))); // IDs are unique and never 0
+        CHECK(avifROStreamRead(s, item->type, 4));
+        uint64_t size;
+        CHECK(avifROStreamReadU64(s, &size));
+        CHECK(size <= SIZE_MAX);
+        item->size = (size_t)size;
+        CHECK(avifROStreamReadU32(s, &item->idatID));
+        CHECK(avifROStreamRead(s, (uint8_t *)item->contentType.contentType, CONTENTTYPE_SIZE));
+        item->contentType.contentType[CONTENTTYPE_SIZE - 1] = '\0';
+        CHECK(avifIndexReadProperties(s, &item->properties));
+        CHECK(avifIndexReadArray(s, &item->extents));
+        CHECK(avifROStreamReadU32(s, &item->thumbnailForID));
+        CHECK(avifROStreamReadU32(s, &item->auxForID));
+        CHECK(avifROStreamReadU32(s, &item->descForID));
+        CHECK(avifROStreamReadU32(s, &item->dimgForID));
+        CHECK(avifROStreamReadU32(s, &item->premByID));
+        uint8_t flag;
+        CHECK(avifROStreamRead(s, &flag, 1));
+        item->hasUnsupportedEssentialProperty = flag ? AVIF_TRUE : AVIF_FALSE;
+        CHECK(avifROStreamRead(s, &flag, 1));
+        item->ipmaSeen = flag ? AVIF_TRUE : AVIF_FALSE;
+    }
+    return AVIF_TRUE;
+}
+
+static void avifIndexWriteSampleTable(avifRWStream * s, const avifSampleTable * sampleTable)
+{
+    avifIndexWriteArray(s, &sampleTable->chunks);
+    avifIndexWriteArray(s, &sampleTable->sampleToChunks);
+    avifIndexWriteArray(s, &sampleTable->sampleSizes);
+    avifIndexWriteArray(s, &sampleTable->timeToSamples);
+    avifIndexWriteArray(s, &sampleTable->syncSamples);
+    avifRWStreamWriteU32(s, sampleTable->allSamplesSize);
+
+    avifRWStreamWriteU32(s, sampleTable->sampleDescriptions.count);
+    for (uint32_t i = 0; i < sampleTable->sampleDescriptions.count; ++i) {
+        const avifSampleDescription * description = &sampleTable->sampleDescriptions.description[i];
+        avifRWStreamWrite(s, description->format, 4);
+        avifIndexWriteProperties(s, &description->properties);
+    }
+}
+
+static avifBool avifIndexReadSampleTable(avifROStream * s, avifSampleTable * sampleTable)
+{
+    CHECK(avifIndexReadArray(s, &sampleTable->chunks));
+    CHECK(avifIndexReadArray(s, &sampleTable->sampleToChunks));
+    // avifCodecDecodeInputSetSampleTable() relies on avifParseSampleToChunkBox()'s checks
+    for (uint32_t i = 0; i < sampleTable->sampleToChunks.count; ++i) {
+        const uint32_t firstChunk = sampleTable->sampleToChunks.sampleToChunk[i].firstChunk;
+        CHECK((i == 0) ? (firstChunk == 1) : (firstChunk > sampleTable->sampleToChunks.sampleToChunk[i - 1].firstChunk));
+    }
+    CHECK(avifIndexReadArray(s, &sampleTable->sampleSizes));
+    CHECK(avifIndexReadArray(s, &sampleTable->timeToSamples));
+    CHECK(avifIndexReadArray(s, &sampleTable->syncSamples));
+    CHECK(avifROStreamReadU32(s, &sampleTable->allSamplesSize));
+
+    uint32_t descriptionCount;
+    CHECK(avifROStreamReadU32(s, &descriptionCount));
+    for (uint32_t i = 0; i < descriptionCount; ++i) {
+        avifSampleDescription * description = (avifSampleDescription *)avifArrayPushPtr(&sampleTable->sampleDescriptions);
+        avifPropertyListCreate(&description->properties);
+        CHECK(avifROStreamRead(s, description->format, 4));
+        CHECK(avifIndexReadProperties(s, &description->properties));
+    }
+    return AVIF_TRUE;
+}
+
+avifResult avifDecoderExportIndex(const avifDecoder * decoder, avifRWData * outIndex)
+{
+    const avifDecoderData * data = decoder->data;
+    if (!data || !decoder->io) {
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+
+    avifRWStream s;
+    avifRWStreamStart(&s, outIndex);
+    avifRWStreamWriteU32(&s, AVIF_FOURCC('a', 'v', 'i', 'x'));
+    avifRWStreamWriteU32(&s, AVIF_DECODER_INDEX_VERSION);
+    avifRWStreamWriteU32(&s, AVIF_VERSION);
+    avifRWStreamWriteU32(&s, (uint32_t)sizeof(avifProperty)); // catches builds with a different struct layout
+    avifRWStreamWriteU64(&s, decoder->io->sizeHint);
+    avifRWStreamWriteU64(&s, data->containerHash);
+    avifIndexWriteArray(&s, &data->containerBoxes);
+
+    avifIndexWriteMeta(&s, data->meta);
+    avifRWStreamWriteU32(&s, data->tracks.count);
+    for (uint32_t i = 0; i < data->tracks.count; ++i) {
+        const avifTrack * track = &data->tracks.track[i];
+        avifRWStreamWriteU32(&s, track->id);
+        avifRWStreamWriteU32(&s, track->auxForID);
+        avifRWStreamWriteU32(&s, track->premByID);
+        avifRWStreamWriteU32(&s, track->mediaTimescale);
+        avifRWStreamWriteU64(&s, track->mediaDuration);
+        avifRWStreamWriteU32(&s, track->width);
+        avifRWStreamWriteU32(&s, track->height);
+        avifRWStreamWriteU8(&s, track->sampleTable ? 1 : 0);
+        if (track->sampleTable) {
+            avifIndexWriteSampleTable(&s, track->sampleTable);
+        }
+        avifIndexWriteMeta(&s, track->meta);
+    }
+    avifRWStreamWriteU64(&s, avifHashBytes(AVIF_HASH_SEED, outIndex->data, avifRWStreamOffset(&s)));
+    avifRWStreamFinishWrite(&s);
+    return AVIF_RESULT_OK;
+}
+
+// Checks that the decoder's IO holds the file the index was exported from: same size, and the same
+// contents in the ftyp/meta/moov boxes that avifParse() would have read.
+static avifResult avifDecoderCheckIndexFile(avifDecoder * decoder, uint64_t sizeHint, uint64_t containerHash)
+{
+    avifDecoderData * data = decoder->data;
+    if (sizeHint != decoder->io->sizeHint) {
+        avifDiagnosticsPrintf(&decoder->diag, "Decoder index does not match this file (size differs)");
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+
+    uint64_t hash = AVIF_HASH_SEED;
+    for (uint32_t i = 0; i < data->containerBoxes.count; ++i) {
+        const avifExtent * containerBox = &data->containerBoxes.extent[i];
+        avifROData boxContents;
+        avifResult readResult = decoder->io->read(decoder->io, 0, containerBox->offset, containerBox->size, &boxContents);
+        if (readResult != AVIF_RESULT_OK) {
+            return readResult;
+        }
+        if (boxContents.size != containerBox->size) {
+            return AVIF_RESULT_TRUNCATED_DATA;
+        }
+        hash = avifHashBytes(hash, boxContents.data, boxContents.size);
+    }
+    if (hash != containerHash) {
+        avifDiagnosticsPrintf(&decoder->diag, "Decoder index does not match this file (contents differ)");
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+    data->containerHash = hash;
+    return AVIF_RESULT_OK;
+}
+
+static avifResult avifDecoderImportIndex(avifDecoder * decoder, const avifROData * index)
+{
+    avifDecoderData * data = decoder->data;
+
+    // Catch indices that were truncated or corrupted since they were exported. This is no defense
+    // against a crafted index, which must never be passed in (see avif.h).
+    if (index->size < AVIF_DECODER_INDEX_HASH_SIZE) {
+        avifDiagnosticsPrintf(&decoder->diag, "Decoder index is truncated");
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+    const size_t payloadSize = index->size - AVIF_DECODER_INDEX_HASH_SIZE;
+    BEGIN_STREAM(hashStream, index->data + payloadSize, AVIF_DECODER_INDEX_HASH_SIZE, &decoder->diag, "Decoder index");
+    uint64_t payloadHash;
+    CHECKERR(avifROStreamReadU64(&hashStream, &payloadHash), AVIF_RESULT_INVALID_ARGUMENT);
+    if (payloadHash != avifHashBytes(AVIF_HASH_SEED, index->data, payloadSize)) {
+        avifDiagnosticsPrintf(&decoder->diag, "Decoder index is corrupted");
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+
+    // Keep a copy of the index; ICC profiles are referenced from it rather than copied again
+    avifRWDataSet(&data->index, index->data, payloadSize);
+    BEGIN_STREAM(s, data->index.data, data->index.size, &decoder->diag, "Decoder index");
+
+    uint32_t magic, indexVersion, libraryVersion, propertySize;
+    uint64_t sizeHint, containerHash;
+    CHECKERR(avifROStreamReadU32(&s, &magic), AVIF_RESULT_INVALID_ARGUMENT);
+    CHECKERR(avifROStreamReadU32(&s, &indexVersion), AVIF_RESULT_INVALID_ARGUMENT);
+    CHECKERR(avifROStreamReadU32(&s, &libraryVersion), AVIF_RESULT_INVALID_ARGUMENT);
+    CHECKERR(avifROStreamReadU32(&s, &propertySize), AVIF_RESULT_INVALID_ARGUMENT);
+    if ((magic != AVIF_FOURCC('a', 'v', 'i', 'x')) || (indexVersion != AVIF_DECODER_INDEX_VERSION) ||
+        (libraryVersion != AVIF_VERSION) || (propertySize != sizeof(avifProperty))) {
+        avifDiagnosticsPrintf(&decoder->diag, "Decoder index was not written by this build of libavif");
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+    CHECKERR(avifROStreamReadU64(&s, &sizeHint), AVIF_RESULT_INVALID_ARGUMENT);
+    CHECKERR(avifROStreamReadU64(&s, &containerHash), AVIF_RESULT_INVALID_ARGUMENT);
+    CHECKERR(avifIndexReadArray(&s, &data->containerBoxes), AVIF_RESULT_INVALID_ARGUMENT);
+    avifResult checkResult = avifDecoderCheckIndexFile(decoder, sizeHint, containerHash);
+    if (checkResult != AVIF_RESULT_OK) {
+        return checkResult;
+    }
+
+    CHECKERR(avifIndexReadMeta(&s, data->meta), AVIF_RESULT_INVALID_ARGUMENT);
+    uint32_t trackCount;
+    CHECKERR(avifROStreamReadU32(&s, &trackCount), AVIF_RESULT_INVALID_ARGUMENT);
+    for (uint32_t i = 0; i < trackCount; ++i) {
+        avifTrack * track = avifDecoderDataCreateTrack(data);
+        CHECKERR(avifROStreamReadU32(&s, &track->id), AVIF_RESULT_INVALID_ARGUMENT);
+        CHECKERR(avifROStreamReadU32(&s, &track->auxForID), AVIF_RESULT_INVALID_ARGUMENT);
+        CHECKERR(avifROStreamReadU32(&s, &track->premByID), AVIF_RESULT_INVALID_ARGUMENT);
+        CHECKERR(avifROStreamReadU32(&s, &track->mediaTimescale), AVIF_RESULT_INVALID_ARGUMENT);
+        CHECKERR(avifROStreamReadU64(&s, &track->mediaDuration), AVIF_RESULT_INVALID_ARGUMENT);
+        CHECKERR(avifROStreamReadU32(&s, &track->width), AVIF_RESULT_INVALID_ARGUMENT);
+        CHECKERR(avifROStreamReadU32(&s, &track->height), AVIF_RESULT_INVALID_ARGUMENT);
+        uint8_t hasSampleTable;
+        CHECKERR(avifROStreamRead(&s, &hasSampleTable, 1), AVIF_RESULT_INVALID_ARGUMENT);
+        if (hasSampleTable) {
+            track->sampleTable = avifSampleTableCreate();
+            CHECKERR(avifIndexReadSampleTable(&s, track->sampleTable), AVIF_RESULT_INVALID_ARGUMENT);
+        }
+        CHECKERR(avifIndexReadMeta(&s, track->meta), AVIF_RESULT_INVALID_ARGUMENT);
+    }
+    CHECKERR(avifROStreamRemainingBytes(&s) == 0, AVIF_RESULT_INVALID_ARGUMENT);
+    return AVIF_RESULT_OK;
+}
+
+avifResult avifDecoderParseWithIndex(avifDecoder * decoder, const avifROData * index)
 {
     avifDiagnosticsClearError(&decoder->diag);
 
@@ -2716,15 +4428,12 @@ avifResult avifDecoderParse(avifDecoder * decoder)
     // Cleanup anything lingering in the decoder
     avifDecoderCleanup(decoder);
 
-    // -----------------------------------------------------------------------
-    // Parse BMFF boxes
-
     decoder->data = avifDecoderDataCreate();
     decoder->data->diag = &decoder->diag;
 
-    avifResult parseResult = avifParse(decoder);
-    if (parseResult != AVIF_RESULT_OK) {
-        return parseResult;
+    avifResult importResult = avifDecoderImportIndex(decoder, index);
+    if (importResult != AVIF_RESULT_OK) {
+        return importResult;
     }
 
     return avifDecoderReset(decoder);
@@ -2735,17 +4444,84 @@ static avifCodec * avifCodecCreateInternal(avifCodecChoice choice)
     return avifCodecCreate(choice, AVIF_CODEC_FLAG_CAN_DECODE);
 }
 
+// A tile decoder can hardly keep more than one thread busy per this many pixels
+#define AVIF_DECODER_PIXELS_PER_THREAD (256 * 256)
+
+// Splits threads between the tiles decoded at once (*tileConcurrency) and the threads given to
+// each tile's codec (*codecThreads). Separate tiles decode in parallel with no overhead, so they
+// are spread over the threads first, and the rest goes to the codecs, up to what a tile of
+// tileWidth x tileHeight can use (no limit if its size is unknown, that is 0).
+static void avifDecoderSplitThreads(int threads,
+                                    uint32_t tileCount,
+                                    uint32_t tileWidth,
+                                    uint32_t tileHeight,
+                                    uint32_t * tileConcurrency,
+                                    int * codecThreads)
+{
+    threads = AVIF_MAX(threads, 1);
+    *tileConcurrency = AVIF_CLAMP(tileCount, 1, (uint32_t)threads);
+    *codecThreads = threads / (int)*tileConcurrency;
+    if ((tileWidth > 0) && (tileHeight > 0)) {
+        const uint64_t usefulThreads = ((uint64_t)tileWidth * tileHeight) / AVIF_DECODER_PIXELS_PER_THREAD;
+        *codecThreads = (int)AVIF_CLAMP(usefulThreads, 1, (uint64_t)*codecThreads);
+    }
+}
+
 static avifResult avifDecoderFlush(avifDecoder * decoder)
 {
-    avifDecoderDataResetCodec(decoder->data);
+    avifDecoderData * data = decoder->data;
+    avifDecoderDataResetCodec(data);
+    if (!decoder->image->imageOwnsAlphaPlane) {
+        // An alpha plane kept across layers (see avifDecoderNextImage()) points into a frame of the
+        // codecs that were just destroyed
+        avifImageFreePlanes(decoder->image, AVIF_PLANES_A);
+    }
+
+    // Several tiles (grid cells, or color and alpha) decode concurrently if there are threads to
+    // spare, on the decoder's own pool if it wasn't given one.
+    avifThreadPool * threadPool = decoder->threadPool;
+    if (!threadPool && (decoder->maxThreads > 1) && (data->tiles.count > 1)) {
+        if (data->ownedThreadPool && (data->ownedThreadPoolSize != decoder->maxThreads)) {
+            avifThreadPoolDestroy(data->ownedThreadPool);
+            data->ownedThreadPool = NULL;
+        }
+        if (!data->ownedThreadPool) {
+            data->ownedThreadPool = avifThreadPoolCreate(decoder->maxThreads);
+            data->ownedThreadPoolSize = decoder->maxThreads;
+        }
+        threadPool = data->ownedThreadPool;
+    }
+    int threads = decoder->maxThreads;
+    if (threadPool && (data->tiles.count > 0)) {
+        data->threadPool = threadPool;
+        data->reservedThreads = avifThreadPoolReserve(threadPool, decoder->maxThreads);
+        threads = data->reservedThreads;
+    }
+
+    // Frame parallel decoding spreads the threads over frames, so the size of a tile doesn't limit them
+    uint32_t tileWidth = 0;
+    uint32_t tileHeight = 0;
+    if (!decoder->frameParallel || !data->sourceSampleTable) {
+        const avifImageGrid * grid = &data->colorGrid;
+        const avifBool isGrid = (grid->rows > 0) && (grid->columns > 0);
+        tileWidth = isGrid ? ((grid->outputWidth + grid->columns - 1) / grid->columns) : decoder->image->width;
+        tileHeight = isGrid ? ((grid->outputHeight + grid->rows - 1) / grid->rows) : decoder->image->height;
+    }
+    int codecThreads;
+    avifDecoderSplitThreads(threads, data->tiles.count, tileWidth, tileHeight, &data->tileConcurrency, &codecThreads);
 
-    for (unsigned int i = 0; i < decoder->data->tiles.count; ++i) {
-        avifTile * tile = &decoder->data->tiles.tile[i];
+    for (unsigned int i = 0; i < data->tiles.count; ++i) {
+        avifTile * tile = &data->tiles.tile[i];
         tile->codec = avifCodecCreateInternal(decoder->codecChoice);
         if (!tile->codec) {
             return AVIF_RESULT_NO_CODEC_AVAILABLE;
         }
         tile->codec->diag = &decoder->diag;
+        tile->codec->maxThreads = codecThreads;
+        tile->codec->operatingPoint = tile->operatingPoint;
+        tile->codec->allLayers = tile->input->allLayers;
+        tile->codec->imageSequence = (tile->input->sampleTable != NULL);
+        tile->prefetchIndex = 0;
         if (!tile->codec->open(tile->codec, decoder)) {
             return AVIF_RESULT_DECODE_COLOR_FAILED;
         }
@@ -2753,6 +4529,52 @@ static avifResult avifDecoderFlush(avifDecoder * decoder)
     return AVIF_RESULT_OK;
 }
 
+static int avifCompareFrameIndices(const void * a, const void * b)
+{
+    const uint32_t indexA = *(const uint32_t *)a;
+    const uint32_t indexB = *(const uint32_t *)b;
+    return (indexA > indexB) - (indexA < indexB);
+}
+
+// Fills data->keyframes from the source sample table's stss entries (item sources only ever have
+// frame 0), so that avifDecoderIsKeyframe() and avifDecoderNearestKeyframe() can binary search it.
+static void avifDecoderDataBuildKeyframeIndex(avifDecoderData * data, uint32_t imageCount)
+{
+    data->keyframes.count = 0;
+
+    // Assume frame 0 is sync, just in case the stss box is absent in the BMFF.
+    *(uint32_t *)avifArrayPushPtr(&data->keyframes) = 0;
+
+    if (data->sourceSampleTable) {
+        const avifSyncSampleArray * syncSamples = &data->sourceSampleTable->syncSamples;
+        avifBool sorted = AVIF_TRUE;
+        for (uint32_t syncSampleIndex = 0; syncSampleIndex < syncSamples->count; ++syncSampleIndex) {
+            const uint32_t sampleNumber = syncSamples->syncSample[syncSampleIndex].sampleNumber;
+            if ((sampleNumber <= 1) || (sampleNumber > imageCount)) {
+                // Frame 0 is already in, and anything past imageCount can't be decoded anyway
+                continue;
+            }
+            const uint32_t frameIndex = sampleNumber - 1; // sampleNumber is 1-based
+            if (frameIndex <= data->keyframes.frameIndex[data->keyframes.count - 1]) {
+                sorted = AVIF_FALSE;
+            }
+            *(uint32_t *)avifArrayPushPtr(&data->keyframes) = frameIndex;
+        }
+
+        if (!sorted) {
+            // stss entries are required to be strictly increasing; tolerate files that aren't.
+            qsort(data->keyframes.frameIndex, data->keyframes.count, sizeof(uint32_t), avifCompareFrameIndices);
+            uint32_t uniqueCount = 1;
+            for (uint32_t i = 1; i < data->keyframes.count; ++i) {
+                if (data->keyframes.frameIndex[i] != data->keyframes.frameIndex[uniqueCount - 1]) {
+                    data->keyframes.frameIndex[uniqueCount++] = data->keyframes.frameIndex[i];
+                }
+            }
+            data->keyframes.count = uniqueCount;
+        }
+    }
+}
+
 avifResult avifDecoderReset(avifDecoder * decoder)
 {
     avifDiagnosticsClearError(&decoder->diag);
@@ -2766,6 +4588,7 @@ avifResult avifDecoderReset(avifDecoder * decoder)
     memset(&data->colorGrid, 0, sizeof(data->colorGrid));
     memset(&data->alphaGrid, 0, sizeof(data->alphaGrid));
     avifDecoderDataClearTiles(data);
+    data->keyframes.count = 0;
 
     // Prepare / cleanup decoded image state
     if (decoder->image) {
@@ -2773,8 +4596,12 @@ avifResult avifDecoderReset(avifDecoder * decoder)
     }
     decoder->image = avifImageCreateEmpty();
     data->cicpSet = AVIF_FALSE;
+    data->colorProperties = NULL;
+    data->metadataMeta = NULL;
+    data->metadataColorID = 0;
 
     memset(&decoder->ioStats, 0, sizeof(decoder->ioStats));
+    decoder->progressiveState = AVIF_PROGRESSIVE_STATE_UNAVAILABLE;
 
     // -----------------------------------------------------------------------
     // Build decode input
@@ -2790,7 +4617,7 @@ avifResult avifDecoderReset(avifDecoder * decoder)
         data->source = decoder->requestedSource;
     }
 
-    const avifPropertyArray * colorProperties = NULL;
+    const avifPropertyList * colorProperties = NULL;
     if (data->source == AVIF_DECODER_SOURCE_TRACKS) {
         avifTrack * colorTrack = NULL;
         avifTrack * alphaTrack = NULL;
@@ -2831,9 +4658,12 @@ avifResult avifDecoderReset(avifDecoder * decoder)
         }
 
         // Find Exif and/or XMP metadata, if any
+        // (see the comment above avifDecoderFindMetadata() for the explanation of using 0 here)
+        data->metadataMeta = colorTrack->meta;
+        data->metadataColorID = 0;
         if (colorTrack->meta) {
-            // See the comment above avifDecoderFindMetadata() for the explanation of using 0 here
-            avifResult findResult = avifDecoderFindMetadata(decoder, colorTrack->meta, decoder->image, 0);
+            avifResult findResult =
+                avifDecoderFindMetadata(decoder, colorTrack->meta, decoder->image, 0, decoder->ignoreExif, decoder->ignoreXMP);
             if (findResult != AVIF_RESULT_OK) {
                 return findResult;
             }
@@ -2864,18 +4694,20 @@ avifResult avifDecoderReset(avifDecoder * decoder)
         }
 
         avifTile * colorTile = avifDecoderDataCreateTile(data);
-        if (!avifCodecDecodeInputGetSamples(colorTile->input, colorTrack->sampleTable, decoder->imageCountLimit, decoder->io->sizeHint, data->diag)) {
+        if (!avifCodecDecodeInputSetSampleTable(colorTile->input,
+                                                colorTrack->sampleTable,
+                                                decoder->imageCountLimit,
+                                                data->diag)) {
             return AVIF_RESULT_BMFF_PARSE_FAILED;
         }
         data->colorTileCount = 1;
 
         if (alphaTrack) {
             avifTile * alphaTile = avifDecoderDataCreateTile(data);
-            if (!avifCodecDecodeInputGetSamples(alphaTile->input,
-                                                alphaTrack->sampleTable,
-                                                decoder->imageCountLimit,
-                                                decoder->io->sizeHint,
-                                                data->diag)) {
+            if (!avifCodecDecodeInputSetSampleTable(alphaTile->input,
+                                                    alphaTrack->sampleTable,
+                                                    decoder->imageCountLimit,
+                                                    data->diag)) {
                 return AVIF_RESULT_BMFF_PARSE_FAILED;
             }
             alphaTile->input->alpha = AVIF_TRUE;
@@ -2887,7 +4719,7 @@ avifResult avifDecoderReset(avifDecoder * decoder)
 
         // Image sequence timing
         decoder->imageIndex = -1;
-        decoder->imageCount = colorTile->input->samples.count;
+        decoder->imageCount = avifCodecDecodeInputSampleCount(colorTile->input);
         decoder->timescale = colorTrack->mediaTimescale;
         decoder->durationInTimescales = colorTrack->mediaDuration;
         if (colorTrack->mediaTimescale) {
@@ -2928,13 +4760,20 @@ avifResult avifDecoderReset(avifDecoder * decoder)
                 // probably exif or some other data
                 continue;
             }
-            if (item->thumbnailForID != 0) {
-                // It's a thumbnail, skip it
-                continue;
-            }
-            if (item->id != data->meta->primaryItemID) {
-                // This is not the primary item, skip it
-                continue;
+            if (data->source == AVIF_DECODER_SOURCE_THUMBNAIL_ITEM) {
+                if (item->thumbnailForID != data->meta->primaryItemID) {
+                    // This is not a thumbnail of the primary item, skip it
+                    continue;
+                }
+            } else {
+                if (item->thumbnailForID != 0) {
+                    // It's a thumbnail, skip it
+                    continue;
+                }
+                if (item->id != data->meta->primaryItemID) {
+                    // This is not the primary item, skip it
+                    continue;
+                }
             }
 
             if (isGrid) {
@@ -2953,6 +4792,10 @@ avifResult avifDecoderReset(avifDecoder * decoder)
         }
 
         if (!colorItem) {
+            if (data->source == AVIF_DECODER_SOURCE_THUMBNAIL_ITEM) {
+                avifDiagnosticsPrintf(&decoder->diag, "Thumbnail item not found");
+                return AVIF_RESULT_NO_AV1_ITEMS_FOUND;
+            }
             avifDiagnosticsPrintf(&decoder->diag, "Primary item not found");
             return AVIF_RESULT_NO_AV1_ITEMS_FOUND;
         }
@@ -2975,7 +4818,7 @@ avifResult avifDecoderReset(avifDecoder * decoder)
             }
 
             // Is this an alpha auxiliary item of whatever we chose for colorItem?
-            const avifProperty * auxCProp = avifPropertyArrayFind(&item->properties, "auxC");
+            const avifProperty * auxCProp = avifPropertyListFind(&item->properties, AVIF_PROPERTY_AUXC);
             if (auxCProp && isAlphaURN(auxCProp->u.auxC.auxType) && (item->auxForID == colorItem->id)) {
                 if (isGrid) {
                     avifROData readData;
@@ -2994,7 +4837,15 @@ avifResult avifDecoderReset(avifDecoder * decoder)
         }
 
         // Find Exif and/or XMP metadata, if any
-        avifResult findResult = avifDecoderFindMetadata(decoder, data->meta, decoder->image, colorItem->id);
+        // (metadata describes the primary item, even when its thumbnail is being decoded)
+        data->metadataMeta = data->meta;
+        data->metadataColorID = data->meta->primaryItemID;
+        avifResult findResult = avifDecoderFindMetadata(decoder,
+                                                        data->meta,
+                                                        decoder->image,
+                                                        data->meta->primaryItemID,
+                                                        decoder->ignoreExif,
+                                                        decoder->ignoreXMP);
         if (findResult != AVIF_RESULT_OK) {
             return findResult;
         }
@@ -3009,12 +4860,18 @@ avifResult avifDecoderReset(avifDecoder * decoder)
                 return AVIF_RESULT_NO_AV1_ITEMS_FOUND;
             }
 
+            if (avifDecoderItemIsProgressive(colorItem)) {
+                decoder->progressiveState = decoder->allowProgressive ? AVIF_PROGRESSIVE_STATE_ACTIVE
+                                                                      : AVIF_PROGRESSIVE_STATE_AVAILABLE;
+            }
+
             avifTile * colorTile = avifDecoderDataCreateTile(data);
-            avifDecodeSample * colorSample = (avifDecodeSample *)avifArrayPushPtr(&colorTile->input->samples);
-            colorSample->itemID = colorItem->id;
-            colorSample->offset = 0;
-            colorSample->size = colorItem->size;
-            colorSample->sync = AVIF_TRUE;
+            if (!avifDecoderDataFillItemTile(data,
+                                             colorTile,
+                                             colorItem,
+                                             decoder->progressiveState == AVIF_PROGRESSIVE_STATE_ACTIVE)) {
+                return AVIF_RESULT_BMFF_PARSE_FAILED;
+            }
             data->colorTileCount = 1;
         }
 
@@ -3029,12 +4886,23 @@ avifResult avifDecoderReset(avifDecoder * decoder)
                     return AVIF_RESULT_NO_AV1_ITEMS_FOUND;
                 }
 
+                // Alpha is only split into layers alongside color, and only if both have the same number
+                // of them. Otherwise the whole alpha item is decoded with the first color layer.
+                avifBool alphaProgressive = AVIF_FALSE;
+                if ((decoder->progressiveState == AVIF_PROGRESSIVE_STATE_ACTIVE) && avifDecoderItemIsProgressive(alphaItem)) {
+                    size_t layerSizes[MAX_AV1_LAYER_COUNT];
+                    uint32_t colorLayerCount, alphaLayerCount;
+                    if (!avifDecoderItemGetLayerSizes(colorItem, layerSizes, &colorLayerCount, data->diag) ||
+                        !avifDecoderItemGetLayerSizes(alphaItem, layerSizes, &alphaLayerCount, data->diag)) {
+                        return AVIF_RESULT_BMFF_PARSE_FAILED;
+                    }
+                    alphaProgressive = (colorLayerCount == alphaLayerCount);
+                }
+
                 avifTile * alphaTile = avifDecoderDataCreateTile(data);
-                avifDecodeSample * alphaSample = (avifDecodeSample *)avifArrayPushPtr(&alphaTile->input->samples);
-                alphaSample->itemID = alphaItem->id;
-                alphaSample->offset = 0;
-                alphaSample->size = alphaItem->size;
-                alphaSample->sync = AVIF_TRUE;
+                if (!avifDecoderDataFillItemTile(data, alphaTile, alphaItem, alphaProgressive)) {
+                    return AVIF_RESULT_BMFF_PARSE_FAILED;
+                }
                 alphaTile->input->alpha = AVIF_TRUE;
                 data->alphaTileCount = 1;
             }
@@ -3051,11 +4919,15 @@ avifResult avifDecoderReset(avifDecoder * decoder)
         decoder->timescale = 1;
         decoder->duration = 1;
         decoder->durationInTimescales = 1;
+        if (decoder->progressiveState == AVIF_PROGRESSIVE_STATE_ACTIVE) {
+            // Each layer of the color item is presented as its own frame, the last one being the full image
+            decoder->imageCount = data->tiles.tile[0].input->samples.count;
+        }
 
         decoder->ioStats.colorOBUSize = colorItem->size;
         decoder->ioStats.alphaOBUSize = alphaItem ? alphaItem->size : 0;
 
-        const avifProperty * ispeProp = avifPropertyArrayFind(colorProperties, "ispe");
+        const avifProperty * ispeProp = avifPropertyListFind(colorProperties, AVIF_PROPERTY_ISPE);
         if (ispeProp) {
             decoder->image->width = ispeProp->u.ispe.width;
             decoder->image->height = ispeProp->u.ispe.height;
@@ -3078,7 +4950,9 @@ avifResult avifDecoderReset(avifDecoder * decoder)
         }
     }
 
-    // Sanity check tiles
+    avifDecoderDataBuildKeyframeIndex(data, (uint32_t)decoder->imageCount);
+
+    // Sanity check tiles (sequence samples are checked by avifSampleTableFindSample() as they are resolved)
     for (uint32_t tileIndex = 0; tileIndex < data->tiles.count; ++tileIndex) {
         avifTile * tile = &data->tiles.tile[tileIndex];
         for (uint32_t sampleIndex = 0; sampleIndex < tile->input->samples.count; ++sampleIndex) {
@@ -3090,20 +4964,24 @@ avifResult avifDecoderReset(avifDecoder * decoder)
         }
     }
 
+    data->colorProperties = colorProperties;
+
     // Find and adopt all colr boxes "at most one for a given value of colour type" (HEIF 6.5.5.1, from Amendment 3)
     // Accept one of each type, and bail out if more than one of a given type is provided.
     avifBool colrICCSeen = AVIF_FALSE;
     avifBool colrNCLXSeen = AVIF_FALSE;
-    for (uint32_t propertyIndex = 0; propertyIndex < colorProperties->count; ++propertyIndex) {
-        avifProperty * prop = &colorProperties->prop[propertyIndex];
+    for (uint32_t propertyIndex = 0; propertyIndex < colorProperties->array.count; ++propertyIndex) {
+        const avifProperty * prop = &colorProperties->array.prop[propertyIndex];
 
-        if (!memcmp(prop->type, "colr", 4)) {
+        if (prop->type == AVIF_FOURCC('c', 'o', 'l', 'r')) {
             if (prop->u.colr.hasICC) {
                 if (colrICCSeen) {
                     return AVIF_RESULT_BMFF_PARSE_FAILED;
                 }
                 colrICCSeen = AVIF_TRUE;
-                avifImageSetProfileICC(decoder->image, prop->u.colr.icc, prop->u.colr.iccSize);
+                if (!decoder->ignoreICC) {
+                    avifImageSetProfileICC(decoder->image, prop->u.colr.icc, prop->u.colr.iccSize);
+                }
             }
             if (prop->u.colr.hasNCLX) {
                 if (colrNCLXSeen) {
@@ -3120,22 +4998,22 @@ avifResult avifDecoderReset(avifDecoder * decoder)
     }
 
     // Transformations
-    const avifProperty * paspProp = avifPropertyArrayFind(colorProperties, "pasp");
+    const avifProperty * paspProp = avifPropertyListFind(colorProperties, AVIF_PROPERTY_PASP);
     if (paspProp) {
         decoder->image->transformFlags |= AVIF_TRANSFORM_PASP;
         memcpy(&decoder->image->pasp, &paspProp->u.pasp, sizeof(avifPixelAspectRatioBox));
     }
-    const avifProperty * clapProp = avifPropertyArrayFind(colorProperties, "clap");
+    const avifProperty * clapProp = avifPropertyListFind(colorProperties, AVIF_PROPERTY_CLAP);
     if (clapProp) {
         decoder->image->transformFlags |= AVIF_TRANSFORM_CLAP;
         memcpy(&decoder->image->clap, &clapProp->u.clap, sizeof(avifCleanApertureBox));
     }
-    const avifProperty * irotProp = avifPropertyArrayFind(colorProperties, "irot");
+    const avifProperty * irotProp = avifPropertyListFind(colorProperties, AVIF_PROPERTY_IROT);
     if (irotProp) {
         decoder->image->transformFlags |= AVIF_TRANSFORM_IROT;
         memcpy(&decoder->image->irot, &irotProp->u.irot, sizeof(avifImageRotation));
     }
-    const avifProperty * imirProp = avifPropertyArrayFind(colorProperties, "imir");
+    const avifProperty * imirProp = avifPropertyListFind(colorProperties, AVIF_PROPERTY_IMIR);
     if (imirProp) {
         decoder->image->transformFlags |= AVIF_TRANSFORM_IMIR;
         memcpy(&decoder->image->imir, &imirProp->u.imir, sizeof(avifImageMirror));
@@ -3143,8 +5021,18 @@ avifResult avifDecoderReset(avifDecoder * decoder)
 
     if (!data->cicpSet && (data->tiles.count > 0)) {
         avifTile * firstTile = &data->tiles.tile[0];
-        if (firstTile->input->samples.count > 0) {
-            avifDecodeSample * sample = &firstTile->input->samples.sample[0];
+        avifDecodeSample * sample = NULL;
+        if (avifCodecDecodeInputSampleCount(firstTile->input) > 0) {
+            avifResult sampleResult = avifCodecDecodeInputGetSample(firstTile->input,
+                                                                    0,
+                                                                    decoder->io->sizeHint,
+                                                                    data->diag,
+                                                                    &sample);
+            if (sampleResult != AVIF_RESULT_OK) {
+                return sampleResult;
+            }
+        }
+        if (sample) {
 
             // Harvest CICP from the AV1's sequence header, which should be very close to the front
             // of the first sample. Read in successively larger chunks until we successfully parse the sequence.
@@ -3175,7 +5063,7 @@ avifResult avifDecoderReset(avifDecoder * decoder)
         }
     }
 
-    const avifProperty * av1CProp = avifPropertyArrayFind(colorProperties, "av1C");
+    const avifProperty * av1CProp = avifPropertyListFind(colorProperties, AVIF_PROPERTY_AV1C);
     if (av1CProp) {
         decoder->image->depth = avifCodecConfigurationBoxGetDepth(&av1CProp->u.av1C);
         if (av1CProp->u.av1C.monochrome) {
@@ -3199,45 +5087,216 @@ avifResult avifDecoderReset(avifDecoder * decoder)
     return avifDecoderFlush(decoder);
 }
 
-avifResult avifDecoderNextImage(avifDecoder * decoder)
+// Acquire all sample data for the given image first, allowing for any read call to bail out
+// with AVIF_RESULT_WAITING_ON_IO harmlessly / idempotently.
+// Only tileCount tiles starting at firstTile are considered.
+static avifResult avifDecoderPrepareTileSamples(avifDecoder * decoder,
+                                                uint32_t imageIndex,
+                                                uint32_t firstTile,
+                                                uint32_t tileCount)
 {
-    avifDiagnosticsClearError(&decoder->diag);
+    for (uint32_t tileIndex = firstTile; tileIndex < firstTile + tileCount; ++tileIndex) {
+        avifTile * tile = &decoder->data->tiles.tile[tileIndex];
+        if (avifDecoderTileSkipsImage(decoder, tile, imageIndex)) {
+            continue;
+        }
+        avifDecodeSample * sample;
+        avifResult sampleResult = avifCodecDecodeInputGetSample(tile->input,
+                                                                imageIndex,
+                                                                decoder->io->sizeHint,
+                                                                &decoder->diag,
+                                                                &sample);
+        if (sampleResult != AVIF_RESULT_OK) {
+            return sampleResult;
+        }
 
-    if (!decoder->data) {
-        // Nothing has been parsed yet
-        return AVIF_RESULT_NO_CONTENT;
+        avifResult prepareResult = avifDecoderPrepareSample(decoder, sample, 0);
+        if (prepareResult != AVIF_RESULT_OK) {
+            return prepareResult;
+        }
     }
+    return AVIF_RESULT_OK;
+}
 
-    if (!decoder->io || !decoder->io->read) {
-        return AVIF_RESULT_IO_NOT_SET;
+static avifResult avifDecoderAdvanceImageIndex(avifDecoder * decoder, uint32_t imageIndex)
+{
+    decoder->imageIndex = imageIndex;
+    if (decoder->data->sourceSampleTable) {
+        // Decoding from a track! Provide timing information.
+
+        avifResult timingResult = avifDecoderNthImageTiming(decoder, decoder->imageIndex, &decoder->imageTiming);
+        if (timingResult != AVIF_RESULT_OK) {
+            return timingResult;
+        }
     }
+    return AVIF_RESULT_OK;
+}
 
-    const uint32_t nextImageIndex = (uint32_t)(decoder->imageIndex + 1);
+// Hands the samples following imageIndex to a codec that decodes several frames at once (see
+// avifDecoder.frameParallel), so that they decode while the caller is busy with the current frame.
+// Failures are not reported here: prefetching stops, and the sample is fed to getNextImage() (and
+// its error surfaced) when its frame is actually requested.
+static void avifDecoderPrefetchTileSamples(avifDecoder * decoder, avifTile * tile, uint32_t imageIndex)
+{
+    const uint32_t sampleCount = avifCodecDecodeInputSampleCount(tile->input);
+    const uint32_t endIndex = (uint32_t)AVIF_MIN((uint64_t)imageIndex + 1 + tile->codec->lookahead, sampleCount);
+    for (uint32_t sampleIndex = AVIF_MAX(tile->prefetchIndex, imageIndex + 1); sampleIndex < endIndex; ++sampleIndex) {
+        avifDecodeSample sample;
+        if (!avifSampleTableFindSample(tile->input->sampleTable, sampleIndex, NULL, decoder->io->sizeHint, &sample, NULL) ||
+            (avifDecoderPrepareSample(decoder, &sample, 0) != AVIF_RESULT_OK)) {
+            return;
+        }
+        const avifBool accepted = tile->codec->prefetch(tile->codec, &sample);
+        avifDecodeSampleReleaseData(&sample);
+        if (!accepted) {
+            return;
+        }
+        tile->prefetchIndex = sampleIndex + 1;
+    }
+}
 
-    // Acquire all sample data for the current image first, allowing for any read call to bail out
-    // with AVIF_RESULT_WAITING_ON_IO harmlessly / idempotently.
-    for (unsigned int tileIndex = 0; tileIndex < decoder->data->tiles.count; ++tileIndex) {
-        avifTile * tile = &decoder->data->tiles.tile[tileIndex];
-        if (nextImageIndex >= tile->input->samples.count) {
-            return AVIF_RESULT_NO_IMAGES_REMAINING;
+// The tiles decoded by avifDecoderDecodeTileRange(): colorTileCount color tiles starting at
+// firstColorTile, followed by alpha tiles starting at firstAlphaTile.
+typedef struct avifTileDecodeTask
+{
+    avifDecoder * decoder;
+    uint32_t imageIndex;
+    uint32_t firstColorTile;
+    uint32_t colorTileCount;
+    uint32_t firstAlphaTile;
+} avifTileDecodeTask;
+
+static uint32_t avifTileDecodeTaskTileIndex(const avifTileDecodeTask * task, uint32_t taskTileIndex)
+{
+    if (taskTileIndex < task->colorTileCount) {
+        return task->firstColorTile + taskTileIndex;
+    }
+    return task->firstAlphaTile + (taskTileIndex - task->colorTileCount);
+}
+
+// avifThreadPoolTaskFunc feeding a tile's sample to its codec; tiles only share read-only state
+// here, so they can be decoded concurrently.
+static void avifDecoderDecodeTile(void * userData, uint32_t taskTileIndex)
+{
+    const avifTileDecodeTask * task = (const avifTileDecodeTask *)userData;
+    avifDecoder * decoder = task->decoder;
+    avifTile * tile = &decoder->data->tiles.tile[avifTileDecodeTaskTileIndex(task, taskTileIndex)];
+    tile->decodeResult = AVIF_RESULT_OK;
+    avifDiagnosticsClearError(&tile->diag);
+    if (avifDecoderTileSkipsImage(decoder, tile, task->imageIndex)) {
+        return;
+    }
+
+    // Already resolved by avifDecoderPrepareTileSamples(), so this is just a lookup.
+    avifDecodeSample * sample;
+    tile->decodeResult =
+        avifCodecDecodeInputGetSample(tile->input, task->imageIndex, decoder->io->sizeHint, &tile->diag, &sample);
+    if (tile->decodeResult != AVIF_RESULT_OK) {
+        return;
+    }
+
+    tile->codec->diag = &tile->diag;
+    const avifBool decoded = tile->codec->getNextImage(tile->codec, sample, tile->input->alpha, tile->image);
+    tile->codec->diag = &decoder->diag;
+    avifDecodeSampleReleaseData(sample);
+    if (!decoded) {
+        tile->decodeResult = tile->input->alpha ? AVIF_RESULT_DECODE_ALPHA_FAILED : AVIF_RESULT_DECODE_COLOR_FAILED;
+    }
+}
+
+// Feeds the samples of the tiles described by task (tileCount of them) to their codecs, leaving the
+// decoded planes in the tiles' images. The samples must have been prepared with
+// avifDecoderPrepareTileSamples().
+static avifResult avifDecoderDecodeTileRange(avifDecoder * decoder, const avifTileDecodeTask * task, uint32_t tileCount)
+{
+    avifDecoderData * data = decoder->data;
+    avifThreadPoolRun(data->threadPool, tileCount, data->tileConcurrency, avifDecoderDecodeTile, (void *)task);
+    for (uint32_t taskTileIndex = 0; taskTileIndex < tileCount; ++taskTileIndex) {
+        avifTile * tile = &data->tiles.tile[avifTileDecodeTaskTileIndex(task, taskTileIndex)];
+        if (tile->decodeResult != AVIF_RESULT_OK) {
+            // Report the error of the first tile that failed, as decoding them one after the other would
+            if (tile->diag.error[0] != '\0') {
+                avifDiagnosticsPrintf(&decoder->diag, "%s", tile->diag.error);
+            }
+            return tile->decodeResult;
         }
 
-        avifDecodeSample * sample = &tile->input->samples.sample[nextImageIndex];
-        avifResult prepareResult = avifDecoderPrepareSample(decoder, sample, 0);
-        if (prepareResult != AVIF_RESULT_OK) {
-            return prepareResult;
+        // Reads from the avifIO, so this stays on the calling thread
+        if ((tile->codec->lookahead > 0) && !avifDecoderTileSkipsImage(decoder, tile, task->imageIndex)) {
+            avifDecoderPrefetchTileSamples(decoder, tile, task->imageIndex);
+        }
+    }
+    return AVIF_RESULT_OK;
+}
+
+// Frees what a tile holds once its pixels have been copied out and the decoder has no later image
+// to decode: its codec, with the frame it decoded into, and the copy of its item's data read from a
+// non-persistent avifIO, if any. The tile's image keeps its properties, but not its planes.
+static void avifDecoderReleaseTile(avifDecoderData * data, avifTile * tile)
+{
+    avifImageFreePlanes(tile->image, AVIF_PLANES_ALL); // forget any pointers into codec image buffers
+    avifCodecDestroy(tile->codec);
+    tile->codec = NULL;
+    for (uint32_t sampleIndex = 0; sampleIndex < tile->input->samples.count; ++sampleIndex) {
+        const uint32_t itemID = tile->input->samples.sample[sampleIndex].itemID;
+        avifDecoderItem * item = itemID ? avifMetaFindItem(data->meta, itemID) : NULL;
+        if (item && item->ownsMergedExtents) {
+            avifRWDataFree(&item->mergedExtents);
+            item->ownsMergedExtents = AVIF_FALSE;
+            item->partialMergedExtents = AVIF_FALSE;
         }
     }
+    data->tilesReleased = AVIF_TRUE;
+}
+
+// Decoding an image again after avifDecoderNextImageRGBRows() released some of its tiles (it failed
+// or returned AVIF_RESULT_WAITING_ON_IO part way through) starts over with new codecs.
+static avifResult avifDecoderRecreateReleasedTiles(avifDecoder * decoder, uint32_t imageIndex)
+{
+    if (!decoder->data->tilesReleased || (imageIndex >= (uint32_t)decoder->imageCount)) {
+        return AVIF_RESULT_OK;
+    }
+    return avifDecoderFlush(decoder);
+}
+
+// Feeds every tile's sample for imageIndex to its codec, leaving the decoded planes in the tiles'
+// images. Nothing is assembled into decoder->image.
+static avifResult avifDecoderDecodeTiles(avifDecoder * decoder, uint32_t imageIndex)
+{
+    avifResult recreateResult = avifDecoderRecreateReleasedTiles(decoder, imageIndex);
+    if (recreateResult != AVIF_RESULT_OK) {
+        return recreateResult;
+    }
+
+    avifDecoderData * data = decoder->data;
+    avifResult prepareResult = avifDecoderPrepareTileSamples(decoder, imageIndex, 0, data->tiles.count);
+    if (prepareResult != AVIF_RESULT_OK) {
+        return prepareResult;
+    }
 
     // Decode all tiles now that the sample data is ready.
-    for (unsigned int tileIndex = 0; tileIndex < decoder->data->tiles.count; ++tileIndex) {
-        avifTile * tile = &decoder->data->tiles.tile[tileIndex];
+    const avifTileDecodeTask task = { decoder, imageIndex, 0, data->colorTileCount, data->colorTileCount };
+    return avifDecoderDecodeTileRange(decoder, &task, data->tiles.count);
+}
 
-        const avifDecodeSample * sample = &tile->input->samples.sample[nextImageIndex];
+avifResult avifDecoderNextImage(avifDecoder * decoder)
+{
+    avifDiagnosticsClearError(&decoder->diag);
 
-        if (!tile->codec->getNextImage(tile->codec, sample, tile->input->alpha, tile->image)) {
-            return tile->input->alpha ? AVIF_RESULT_DECODE_ALPHA_FAILED : AVIF_RESULT_DECODE_COLOR_FAILED;
-        }
+    if (!decoder->data) {
+        // Nothing has been parsed yet
+        return AVIF_RESULT_NO_CONTENT;
+    }
+
+    if (!decoder->io || !decoder->io->read) {
+        return AVIF_RESULT_IO_NOT_SET;
+    }
+
+    const uint32_t nextImageIndex = (uint32_t)(decoder->imageIndex + 1);
+
+    avifResult decodeResult = avifDecoderDecodeTiles(decoder, nextImageIndex);
+    if (decodeResult != AVIF_RESULT_OK) {
+        return decodeResult;
     }
 
     if (decoder->data->tiles.count != (decoder->data->colorTileCount + decoder->data->alphaTileCount)) {
@@ -3299,27 +5358,238 @@ avifResult avifDecoderNextImage(avifDecoder * decoder)
                 return AVIF_RESULT_DECODE_ALPHA_FAILED;
             }
 
-            avifImage * srcAlpha = decoder->data->tiles.tile[decoder->data->colorTileCount].image;
-            if ((decoder->image->width != srcAlpha->width) || (decoder->image->height != srcAlpha->height) ||
-                (decoder->image->depth != srcAlpha->depth)) {
-                return AVIF_RESULT_DECODE_ALPHA_FAILED;
+            // Keep the alpha plane decoded along with an earlier layer of the color item, unless
+            // avifDecoderNthImage() went past that layer without taking it; the alpha tile's codec
+            // still holds it then, as it had nothing else to decode since.
+            avifTile * alphaTile = &decoder->data->tiles.tile[decoder->data->colorTileCount];
+            if (!avifDecoderTileSkipsImage(decoder, alphaTile, nextImageIndex) || !decoder->image->alphaPlane) {
+                avifImage * srcAlpha = alphaTile->image;
+                if (!srcAlpha->alphaPlane || (decoder->image->width != srcAlpha->width) ||
+                    (decoder->image->height != srcAlpha->height) || (decoder->image->depth != srcAlpha->depth)) {
+                    return AVIF_RESULT_DECODE_ALPHA_FAILED;
+                }
+
+                avifImageStealPlanes(decoder->image, srcAlpha, AVIF_PLANES_A);
+                decoder->image->alphaRange = srcAlpha->alphaRange;
             }
+        }
+    }
+
+    return avifDecoderAdvanceImageIndex(decoder, nextImageIndex);
+}
 
-            avifImageStealPlanes(decoder->image, srcAlpha, AVIF_PLANES_A);
-            decoder->image->alphaRange = srcAlpha->alphaRange;
+static avifResult avifDecoderEmitRGBRows(avifRGBConverter * converter,
+                                         const avifImage * yuv,
+                                         uint32_t rowIndex,
+                                         avifRGBImage * strip,
+                                         avifRGBRowsFunc rowsFunc,
+                                         void * userData)
+{
+    strip->height = yuv->height;
+    avifResult result = avifRGBConverterYUVToRGB(converter, yuv, strip);
+    if (result != AVIF_RESULT_OK) {
+        return result;
+    }
+    return rowsFunc(userData, rowIndex, strip->pixels, strip->rowBytes, yuv->height);
+}
+
+avifResult avifDecoderNextImageRGBRows(avifDecoder * decoder, avifRGBImage * rgb, avifRGBRowsFunc rowsFunc, void * userData)
+{
+    avifDiagnosticsClearError(&decoder->diag);
+
+    if (!decoder->data) {
+        // Nothing has been parsed yet
+        return AVIF_RESULT_NO_CONTENT;
+    }
+
+    if (!decoder->io || !decoder->io->read) {
+        return AVIF_RESULT_IO_NOT_SET;
+    }
+
+    if (!rowsFunc) {
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+
+    avifDecoderData * data = decoder->data;
+    const avifImageGrid * grid = &data->colorGrid;
+    const avifImageGrid * alphaGrid = &data->alphaGrid;
+    const avifBool colorIsGrid = (grid->rows > 0) && (grid->columns > 0);
+    const avifBool alphaMatchesGrid =
+        (data->alphaTileCount == 0) ||
+        ((alphaGrid->rows == grid->rows) && (alphaGrid->columns == grid->columns) &&
+         (alphaGrid->outputWidth == grid->outputWidth) && (alphaGrid->outputHeight == grid->outputHeight));
+
+    avifRGBImage strip;
+    memcpy(&strip, rgb, sizeof(avifRGBImage));
+    strip.pixels = NULL;
+    strip.rowBytes = 0;
+
+    if (!colorIsGrid || !alphaMatchesGrid) {
+        // A single tile is decoded in one piece by the codec anyway; decode it as usual and only
+        // convert it to RGB in strips.
+        avifResult result = avifDecoderNextImage(decoder);
+        if (result != AVIF_RESULT_OK) {
+            return result;
         }
+
+        const avifImage * image = decoder->image;
+        strip.width = image->width;
+        strip.height = AVIF_MIN(RGB_ROWS_STRIP_HEIGHT, image->height);
+        avifRGBImageAllocatePixels(&strip);
+        avifRGBConverter * converter = avifRGBConverterCreate();
+        for (uint32_t y = 0; (result == AVIF_RESULT_OK) && (y < image->height); y += RGB_ROWS_STRIP_HEIGHT) {
+            avifImage view;
+            avifImageSetView(&view, image, 0, y, image->width, AVIF_MIN(RGB_ROWS_STRIP_HEIGHT, image->height - y));
+            result = avifDecoderEmitRGBRows(converter, &view, y, &strip, rowsFunc, userData);
+        }
+        avifRGBConverterDestroy(converter);
+        avifRGBImageFreePixels(&strip);
+        rgb->width = image->width;
+        rgb->height = image->height;
+        return result;
     }
 
-    decoder->imageIndex = nextImageIndex;
-    if (decoder->data->sourceSampleTable) {
-        // Decoding from a track! Provide timing information.
+    // Grid path: read and decode one row of tiles at a time (with the same per-tile decoding,
+    // threading and prefetching as avifDecoderNextImage()) and assemble it into a single
+    // tile-row-sized YUV(A) strip. Unless a later image still needs them, the row's tiles are then
+    // released, except for the first color and alpha tiles, which the tiles of later rows are checked
+    // against and which are released once the whole image is done.
 
-        avifResult timingResult = avifDecoderNthImageTiming(decoder, decoder->imageIndex, &decoder->imageTiming);
-        if (timingResult != AVIF_RESULT_OK) {
-            return timingResult;
+    if (data->tiles.count != (data->colorTileCount + data->alphaTileCount)) {
+        return AVIF_RESULT_UNKNOWN_ERROR;
+    }
+
+    const uint32_t nextImageIndex = (uint32_t)(decoder->imageIndex + 1);
+    avifResult result = avifDecoderRecreateReleasedTiles(decoder, nextImageIndex);
+    if (result != AVIF_RESULT_OK) {
+        return result;
+    }
+    const avifBool releaseTiles = ((uint64_t)nextImageIndex + 1 >= (uint64_t)decoder->imageCount);
+
+    const int planeCount = (data->alphaTileCount > 0) ? 2 : 1;
+    const avifImage * firstTileImages[2] = { data->tiles.tile[0].image, NULL };
+    if (data->alphaTileCount > 0) {
+        firstTileImages[1] = data->tiles.tile[data->colorTileCount].image;
+    }
+    avifImage * stripImage = avifImageCreateEmpty();
+    avifRGBConverter * converter = avifRGBConverterCreate();
+    for (unsigned int rowIndex = 0; rowIndex < grid->rows; ++rowIndex) {
+        const uint32_t firstRowTile = rowIndex * grid->columns;
+        const uint32_t firstRowAlphaTile = data->colorTileCount + firstRowTile;
+        result = avifDecoderPrepareTileSamples(decoder, nextImageIndex, firstRowTile, grid->columns);
+        if ((result == AVIF_RESULT_OK) && (planeCount > 1)) {
+            result = avifDecoderPrepareTileSamples(decoder, nextImageIndex, firstRowAlphaTile, grid->columns);
+        }
+        if (result != AVIF_RESULT_OK) {
+            goto cleanup;
+        }
+        const avifTileDecodeTask task = { decoder, nextImageIndex, firstRowTile, grid->columns, firstRowAlphaTile };
+        result = avifDecoderDecodeTileRange(decoder, &task, grid->columns * planeCount);
+        if (result != AVIF_RESULT_OK) {
+            goto cleanup;
+        }
+
+        if (rowIndex == 0) {
+            for (int plane = 0; plane < planeCount; ++plane) {
+                const avifBool alpha = (plane == 1);
+                if (!avifDecoderDataValidateImageGrid(data, grid, firstTileImages[plane], alpha) ||
+                    !avifDecoderDataPrepareImageGrid(data, grid, decoder->image, firstTileImages[plane], alpha)) {
+                    result = AVIF_RESULT_INVALID_IMAGE_GRID;
+                    goto cleanup;
+                }
+            }
+            if ((planeCount > 1) && ((firstTileImages[1]->width != firstTileImages[0]->width) ||
+                                     (firstTileImages[1]->height != firstTileImages[0]->height))) {
+                avifDiagnosticsPrintf(data->diag, "Alpha grid tiles must match color grid tiles to be decoded in rows");
+                result = AVIF_RESULT_INVALID_IMAGE_GRID;
+                goto cleanup;
+            }
+
+            stripImage->width = grid->outputWidth;
+            stripImage->height = firstTileImages[0]->height;
+            stripImage->depth = decoder->image->depth;
+            stripImage->yuvFormat = decoder->image->yuvFormat;
+            stripImage->yuvRange = decoder->image->yuvRange;
+            stripImage->yuvChromaSamplePosition = decoder->image->yuvChromaSamplePosition;
+            stripImage->alphaRange = decoder->image->alphaRange;
+            stripImage->alphaPremultiplied = decoder->image->alphaPremultiplied;
+            stripImage->colorPrimaries = decoder->image->colorPrimaries;
+            stripImage->transferCharacteristics = decoder->image->transferCharacteristics;
+            stripImage->matrixCoefficients = decoder->image->matrixCoefficients;
+            avifImageAllocatePlanes(stripImage, (planeCount > 1) ? AVIF_PLANES_ALL : AVIF_PLANES_YUV);
+
+            strip.width = stripImage->width;
+            strip.height = stripImage->height;
+            avifRGBImageAllocatePixels(&strip);
+        }
+
+        for (int plane = 0; plane < planeCount; ++plane) {
+            const avifBool alpha = (plane == 1);
+            const unsigned int firstTileIndex = (alpha ? data->colorTileCount : 0) + firstRowTile;
+            for (unsigned int colIndex = 0; colIndex < grid->columns; ++colIndex) {
+                avifTile * tile = &data->tiles.tile[firstTileIndex + colIndex];
+                if (!avifImageGridTilesMatch(tile->image, firstTileImages[plane])) {
+                    avifDiagnosticsPrintf(data->diag, "Grid image contains mismatched tiles");
+                    result = AVIF_RESULT_INVALID_IMAGE_GRID;
+                    goto cleanup;
+                }
+                avifDecoderDataCopyImageGridTile(grid, tile->image, rowIndex, colIndex, stripImage, 0, alpha);
+                if (releaseTiles && (tile->image != firstTileImages[plane])) {
+                    avifDecoderReleaseTile(data, tile);
+                }
+            }
+        }
+
+        const uint32_t tileHeight = firstTileImages[0]->height;
+        const uint32_t rowY = rowIndex * tileHeight;
+        avifImage view;
+        avifImageSetView(&view, stripImage, 0, 0, stripImage->width, AVIF_MIN(tileHeight, grid->outputHeight - rowY));
+        result = avifDecoderEmitRGBRows(converter, &view, rowY, &strip, rowsFunc, userData);
+        if (result != AVIF_RESULT_OK) {
+            goto cleanup;
         }
     }
-    return AVIF_RESULT_OK;
+
+    if (releaseTiles) {
+        avifDecoderReleaseTile(data, &data->tiles.tile[0]);
+        if (planeCount > 1) {
+            avifDecoderReleaseTile(data, &data->tiles.tile[data->colorTileCount]);
+        }
+    }
+    rgb->width = decoder->image->width;
+    rgb->height = decoder->image->height;
+    result = avifDecoderAdvanceImageIndex(decoder, nextImageIndex);
+
+cleanup:
+    avifRGBConverterDestroy(converter);
+    avifRGBImageFreePixels(&strip);
+    avifImageDestroy(stripImage);
+    return result;
+}
+
+avifResult avifDecoderReadMetadata(avifDecoder * decoder, avifImage * image)
+{
+    avifDiagnosticsClearError(&decoder->diag);
+
+    avifDecoderData * data = decoder->data;
+    if (!data || !data->colorProperties) {
+        // Nothing has been parsed yet
+        return AVIF_RESULT_NO_CONTENT;
+    }
+
+    // avifDecoderReset() already rejected files with more than one ICC profile
+    for (uint32_t propertyIndex = 0; propertyIndex < data->colorProperties->array.count; ++propertyIndex) {
+        const avifProperty * prop = &data->colorProperties->array.prop[propertyIndex];
+        if ((prop->type == AVIF_FOURCC('c', 'o', 'l', 'r')) && prop->u.colr.hasICC) {
+            avifImageSetProfileICC(image, prop->u.colr.icc, prop->u.colr.iccSize);
+            break;
+        }
+    }
+
+    if (!data->metadataMeta) {
+        return AVIF_RESULT_OK;
+    }
+    return avifDecoderFindMetadata(decoder, data->metadataMeta, image, data->metadataColorID, AVIF_FALSE, AVIF_FALSE);
 }
 
 avifResult avifDecoderNthImageTiming(const avifDecoder * decoder, uint32_t frameIndex, avifImageTiming * outTiming)
@@ -3389,17 +5659,21 @@ avifResult avifDecoderNthImage(avifDecoder * decoder, uint32_t frameIndex)
         decoder->imageIndex = nearestKeyFrame - 1; // prepare to read nearest keyframe
         avifDecoderFlush(decoder);
     }
-    for (;;) {
-        avifResult result = avifDecoderNextImage(decoder);
+
+    // The frames in between only need to reach the codecs (as references for the requested frame), so
+    // skip the grid assembly / plane stealing and timing avifDecoderNextImage() would do for each of them.
+    if (!decoder->data || !decoder->io || !decoder->io->read) {
+        return avifDecoderNextImage(decoder); // let it report the error
+    }
+    while ((decoder->imageIndex + 1) < requestedIndex) {
+        const uint32_t nextImageIndex = (uint32_t)(decoder->imageIndex + 1);
+        avifResult result = avifDecoderDecodeTiles(decoder, nextImageIndex);
         if (result != AVIF_RESULT_OK) {
             return result;
         }
-
-        if (requestedIndex == decoder->imageIndex) {
-            break;
-        }
+        decoder->imageIndex = (int)nextImageIndex;
     }
-    return AVIF_RESULT_OK;
+    return avifDecoderNextImage(decoder);
 }
 
 avifBool avifDecoderIsKeyframe(const avifDecoder * decoder, uint32_t frameIndex)
@@ -3409,12 +5683,10 @@ avifBool avifDecoderIsKeyframe(const avifDecoder * decoder, uint32_t frameIndex)
         return AVIF_FALSE;
     }
 
-    if ((decoder->data->tiles.count > 0) && decoder->data->tiles.tile[0].input) {
-        if (frameIndex < decoder->data->tiles.tile[0].input->samples.count) {
-            return decoder->data->tiles.tile[0].input->samples.sample[frameIndex].sync;
-        }
+    if ((decoder->imageCount <= 0) || (frameIndex >= (uint32_t)decoder->imageCount)) {
+        return AVIF_FALSE;
     }
-    return AVIF_FALSE;
+    return avifDecoderNearestKeyframe(decoder, frameIndex) == frameIndex;
 }
 
 uint32_t avifDecoderNearestKeyframe(const avifDecoder * decoder, uint32_t frameIndex)
@@ -3424,12 +5696,22 @@ uint32_t avifDecoderNearestKeyframe(const avifDecoder * decoder, uint32_t frameI
         return 0;
     }
 
-    for (; frameIndex != 0; --frameIndex) {
-        if (avifDecoderIsKeyframe(decoder, frameIndex)) {
-            break;
+    // Binary search for the last keyframe at or before frameIndex. keyframes always contains 0.
+    const avifFrameIndexArray * keyframes = &decoder->data->keyframes;
+    if (keyframes->count == 0) {
+        return 0;
+    }
+    uint32_t lo = 0;
+    uint32_t hi = keyframes->count;
+    while ((hi - lo) > 1) {
+        const uint32_t mid = lo + ((hi - lo) / 2);
+        if (keyframes->frameIndex[mid] <= frameIndex) {
+            lo = mid;
+        } else {
+            hi = mid;
         }
     }
-    return frameIndex;
+    return keyframes->frameIndex[lo];
 }
 
 avifResult avifDecoderRead(avifDecoder * decoder, avifImage * image)
@@ -409,6 +409,255 @@ avifResult avifImageRGBToYUV(avifImage * image, const avifRGBImage * rgb)
     return AVIF_RESULT_OK;
 }
 
+// Computes the normalized Cb and Cr of pixel (i, j) of image, upsampling chroma as requested. Only
+// called for images with color.
+static inline void avifImageYUVPixelToCbCr(const avifImage * image,
+                                           const avifReformatState * state,
+                                           const avifChromaUpsampling chromaUpsampling,
+                                           uint32_t i,
+                                           uint32_t j,
+                                           float * Cb,
+                                           float * Cr)
+{
+    // Aliases for some state
+    const float * const unormFloatTableUV = state->unormFloatTableUV;
+    const uint32_t yuvChannelBytes = state->yuvChannelBytes;
+    const uint16_t yuvMaxChannel = (uint16_t)state->yuvMaxChannel;
+
+    // Aliases for plane data
+    const uint8_t * uPlane = image->yuvPlanes[AVIF_CHAN_U];
+    const uint8_t * vPlane = image->yuvPlanes[AVIF_CHAN_V];
+    const uint32_t uRowBytes = image->yuvRowBytes[AVIF_CHAN_U];
+    const uint32_t vRowBytes = image->yuvRowBytes[AVIF_CHAN_V];
+
+    const uint32_t uvI = i >> state->formatInfo.chromaShiftX;
+    const uint32_t uvJ = j >> state->formatInfo.chromaShiftY;
+    const uint8_t * ptrU8 = &uPlane[(uvJ * uRowBytes)];
+    const uint8_t * ptrV8 = &vPlane[(uvJ * vRowBytes)];
+    const uint16_t * ptrU16 = (const uint16_t *)ptrU8;
+    const uint16_t * ptrV16 = (const uint16_t *)ptrV8;
+
+    if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV444) {
+        uint16_t unormU, unormV;
+
+        if (image->depth == 8) {
+            unormU = ptrU8[uvI];
+            unormV = ptrV8[uvI];
+        } else {
+            // clamp incoming data to protect against bad LUT lookups
+            unormU = AVIF_MIN(ptrU16[uvI], yuvMaxChannel);
+            unormV = AVIF_MIN(ptrV16[uvI], yuvMaxChannel);
+        }
+
+        *Cb = unormFloatTableUV[unormU];
+        *Cr = unormFloatTableUV[unormV];
+    } else {
+        // Upsample to 444:
+        //
+        // *   *   *   *
+        //   A       B
+        // *   1   2   *
+        //
+        // *   3   4   *
+        //   C       D
+        // *   *   *   *
+        //
+        // When converting from YUV420 to RGB, for any given "high-resolution" RGB
+        // coordinate (1,2,3,4,*), there are up to four "low-resolution" UV samples
+        // (A,B,C,D) that are "nearest" to the pixel. For RGB pixel #1, A is the closest
+        // UV sample, B and C are "adjacent" to it on the same row and column, and D is
+        // the diagonal. For RGB pixel 3, C is the closest UV sample, A and D are
+        // adjacent, and B is the diagonal. Sometimes the adjacent pixel on the same row
+        // is to the left or right, and sometimes the adjacent pixel on the same column
+        // is up or down. For any edge or corner, there might only be only one or two
+        // samples nearby, so they'll be duplicated.
+        //
+        // The following code attempts to find all four nearest UV samples and put them
+        // in the following unormU and unormV grid as follows:
+        //
+        // unorm[0][0] = closest         ( weights: bilinear: 9/16, nearest: 1 )
+        // unorm[1][0] = adjacent col    ( weights: bilinear: 3/16, nearest: 0 )
+        // unorm[0][1] = adjacent row    ( weights: bilinear: 3/16, nearest: 0 )
+        // unorm[1][1] = diagonal        ( weights: bilinear: 1/16, nearest: 0 )
+        //
+        // It then weights them according to the requested upsampling set in avifRGBImage.
+
+        uint16_t unormU[2][2], unormV[2][2];
+
+        // How many bytes to add to a uint8_t pointer index to get to the adjacent (lesser) sample in a given direction
+        int uAdjCol, vAdjCol, uAdjRow, vAdjRow;
+        if ((i == 0) || ((i == (image->width - 1)) && ((i % 2) != 0))) {
+            uAdjCol = 0;
+            vAdjCol = 0;
+        } else {
+            if ((i % 2) != 0) {
+                uAdjCol = yuvChannelBytes;
+                vAdjCol = yuvChannelBytes;
+            } else {
+                uAdjCol = -1 * yuvChannelBytes;
+                vAdjCol = -1 * yuvChannelBytes;
+            }
+        }
+
+        // For YUV422, uvJ will always be a fresh value (always corresponds to j), so
+        // we'll simply duplicate the sample as if we were on the top or bottom row and
+        // it'll behave as plain old linear (1D) upsampling, which is all we want.
+        if ((j == 0) || ((j == (image->height - 1)) && ((j % 2) != 0)) || (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV422)) {
+            uAdjRow = 0;
+            vAdjRow = 0;
+        } else {
+            if ((j % 2) != 0) {
+                uAdjRow = (int)uRowBytes;
+                vAdjRow = (int)vRowBytes;
+            } else {
+                uAdjRow = -1 * (int)uRowBytes;
+                vAdjRow = -1 * (int)vRowBytes;
+            }
+        }
+
+        if (image->depth == 8) {
+            unormU[0][0] = uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes)];
+            unormV[0][0] = vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes)];
+            unormU[1][0] = uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjCol];
+            unormV[1][0] = vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjCol];
+            unormU[0][1] = uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjRow];
+            unormV[0][1] = vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjRow];
+            unormU[1][1] = uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjCol + uAdjRow];
+            unormV[1][1] = vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjCol + vAdjRow];
+        } else {
+            unormU[0][0] = *((const uint16_t *)&uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes)]);
+            unormV[0][0] = *((const uint16_t *)&vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes)]);
+            unormU[1][0] = *((const uint16_t *)&uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjCol]);
+            unormV[1][0] = *((const uint16_t *)&vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjCol]);
+            unormU[0][1] = *((const uint16_t *)&uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjRow]);
+            unormV[0][1] = *((const uint16_t *)&vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjRow]);
+            unormU[1][1] = *((const uint16_t *)&uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjCol + uAdjRow]);
+            unormV[1][1] = *((const uint16_t *)&vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjCol + vAdjRow]);
+
+            // clamp incoming data to protect against bad LUT lookups
+            for (int bJ = 0; bJ < 2; ++bJ) {
+                for (int bI = 0; bI < 2; ++bI) {
+                    unormU[bI][bJ] = AVIF_MIN(unormU[bI][bJ], yuvMaxChannel);
+                    unormV[bI][bJ] = AVIF_MIN(unormV[bI][bJ], yuvMaxChannel);
+                }
+            }
+        }
+
+        if (chromaUpsampling == AVIF_CHROMA_UPSAMPLING_BILINEAR) {
+            // Bilinear filtering with weights
+            *Cb = (unormFloatTableUV[unormU[0][0]] * (9.0f / 16.0f)) + (unormFloatTableUV[unormU[1][0]] * (3.0f / 16.0f)) +
+                  (unormFloatTableUV[unormU[0][1]] * (3.0f / 16.0f)) + (unormFloatTableUV[unormU[1][1]] * (1.0f / 16.0f));
+            *Cr = (unormFloatTableUV[unormV[0][0]] * (9.0f / 16.0f)) + (unormFloatTableUV[unormV[1][0]] * (3.0f / 16.0f)) +
+                  (unormFloatTableUV[unormV[0][1]] * (3.0f / 16.0f)) + (unormFloatTableUV[unormV[1][1]] * (1.0f / 16.0f));
+        } else {
+            assert(chromaUpsampling == AVIF_CHROMA_UPSAMPLING_NEAREST);
+
+            // Nearest neighbor; ignore all UVs but the closest one
+            *Cb = unormFloatTableUV[unormU[0][0]];
+            *Cr = unormFloatTableUV[unormV[0][0]];
+        }
+    }
+}
+
+// Converts row j of image to normalized R, G, B, A floats (four per pixel, each clamped to [0-1]),
+// upsampling chroma as requested. A is only read from the alpha plane when readAlpha is set, and is
+// 1.0 otherwise. This does not perform any alpha (un)multiply.
+static void avifImageYUVRowToRGBFloat(const avifImage * image,
+                                      const avifReformatState * state,
+                                      const avifChromaUpsampling chromaUpsampling,
+                                      avifBool readAlpha,
+                                      uint32_t j,
+                                      float * rgba)
+{
+    // Aliases for some state
+    const float kr = state->kr;
+    const float kg = state->kg;
+    const float kb = state->kb;
+    const float * const unormFloatTableY = state->unormFloatTableY;
+
+    // Aliases for plane data
+    const uint8_t * yPlane = image->yuvPlanes[AVIF_CHAN_Y];
+    const uint8_t * uPlane = image->yuvPlanes[AVIF_CHAN_U];
+    const uint8_t * vPlane = image->yuvPlanes[AVIF_CHAN_V];
+    const uint8_t * aPlane = image->alphaPlane;
+    const uint32_t yRowBytes = image->yuvRowBytes[AVIF_CHAN_Y];
+    const uint32_t aRowBytes = image->alphaRowBytes;
+
+    // Various observations and limits
+    const avifBool hasColor = (uPlane && vPlane && (image->yuvFormat != AVIF_PIXEL_FORMAT_YUV400));
+    const uint16_t yuvMaxChannel = (uint16_t)state->yuvMaxChannel;
+
+    // These are the only supported built-ins
+    assert((chromaUpsampling == AVIF_CHROMA_UPSAMPLING_BILINEAR) || (chromaUpsampling == AVIF_CHROMA_UPSAMPLING_NEAREST));
+
+    const uint8_t * ptrY8 = &yPlane[j * yRowBytes];
+    const uint8_t * ptrA8 = (readAlpha && aPlane) ? &aPlane[j * aRowBytes] : NULL;
+    const uint16_t * ptrY16 = (const uint16_t *)ptrY8;
+    const uint16_t * ptrA16 = (const uint16_t *)ptrA8;
+
+    for (uint32_t i = 0; i < image->width; ++i) {
+        float Y, Cb = 0.5f, Cr = 0.5f;
+
+        // Calculate Y
+        uint16_t unormY;
+        if (image->depth == 8) {
+            unormY = ptrY8[i];
+        } else {
+            // clamp incoming data to protect against bad LUT lookups
+            unormY = AVIF_MIN(ptrY16[i], yuvMaxChannel);
+        }
+        Y = unormFloatTableY[unormY];
+
+        // Calculate Cb and Cr
+        if (hasColor) {
+            avifImageYUVPixelToCbCr(image, state, chromaUpsampling, i, j, &Cb, &Cr);
+        }
+
+        float R, G, B;
+        if (hasColor) {
+            if (state->mode == AVIF_REFORMAT_MODE_IDENTITY) {
+                // Identity (GBR): Formulas 41,42,43 from https://www.itu.int/rec/T-REC-H.273-201612-I/en
+                G = Y;
+                B = Cb;
+                R = Cr;
+            } else if (state->mode == AVIF_REFORMAT_MODE_YCGCO) {
+                // YCgCo: Formulas 47,48,49,50 from https://www.itu.int/rec/T-REC-H.273-201612-I/en
+                const float t = Y - Cb;
+                G = Y + Cb;
+                B = t - Cr;
+                R = t + Cr;
+            } else {
+                // Normal YUV
+                R = Y + (2 * (1 - kr)) * Cr;
+                B = Y + (2 * (1 - kb)) * Cb;
+                G = Y - ((2 * ((kr * (1 - kr) * Cr) + (kb * (1 - kb) * Cb))) / kg);
+            }
+        } else {
+            // Monochrome: just populate all channels with luma (identity mode is irrelevant)
+            R = Y;
+            G = Y;
+            B = Y;
+        }
+
+        rgba[0] = AVIF_CLAMP(R, 0.0f, 1.0f);
+        rgba[1] = AVIF_CLAMP(G, 0.0f, 1.0f);
+        rgba[2] = AVIF_CLAMP(B, 0.0f, 1.0f);
+        rgba[3] = 1.0f;
+        if (ptrA8) {
+            // Calculate A
+            uint16_t unormA;
+            if (image->depth == 8) {
+                unormA = ptrA8[i];
+            } else {
+                unormA = AVIF_MIN(ptrA16[i], yuvMaxChannel);
+            }
+            const float A = (unormA - state->biasA) / state->rangeA;
+            rgba[3] = AVIF_CLAMP(A, 0.0f, 1.0f);
+        }
+        rgba += 4;
+    }
+}
+
 // Note: This function handles alpha (un)multiply.
 static avifResult avifImageYUVAnyToRGBAnySlow(const avifImage * image,
                                               avifRGBImage * rgb,
@@ -420,8 +669,6 @@ static avifResult avifImageYUVAnyToRGBAnySlow(const avifImage * image,
     const float kg = state->kg;
     const float kb = state->kb;
     const float * const unormFloatTableY = state->unormFloatTableY;
-    const float * const unormFloatTableUV = state->unormFloatTableUV;
-    const uint32_t yuvChannelBytes = state->yuvChannelBytes;
     const uint32_t rgbPixelBytes = state->rgbPixelBytes;
 
     // Aliases for plane data
@@ -430,8 +677,6 @@ static avifResult avifImageYUVAnyToRGBAnySlow(const avifImage * image,
     const uint8_t * vPlane = image->yuvPlanes[AVIF_CHAN_V];
     const uint8_t * aPlane = image->alphaPlane;
     const uint32_t yRowBytes = image->yuvRowBytes[AVIF_CHAN_Y];
-    const uint32_t uRowBytes = image->yuvRowBytes[AVIF_CHAN_U];
-    const uint32_t vRowBytes = image->yuvRowBytes[AVIF_CHAN_V];
     const uint32_t aRowBytes = image->alphaRowBytes;
 
     // Various observations and limits
@@ -443,14 +688,9 @@ static avifResult avifImageYUVAnyToRGBAnySlow(const avifImage * image,
     assert((chromaUpsampling == AVIF_CHROMA_UPSAMPLING_BILINEAR) || (chromaUpsampling == AVIF_CHROMA_UPSAMPLING_NEAREST));
 
     for (uint32_t j = 0; j < image->height; ++j) {
-        const uint32_t uvJ = j >> state->formatInfo.chromaShiftY;
         const uint8_t * ptrY8 = &yPlane[j * yRowBytes];
-        const uint8_t * ptrU8 = uPlane ? &uPlane[(uvJ * uRowBytes)] : NULL;
-        const uint8_t * ptrV8 = vPlane ? &vPlane[(uvJ * vRowBytes)] : NULL;
         const uint8_t * ptrA8 = aPlane ? &aPlane[j * aRowBytes] : NULL;
         const uint16_t * ptrY16 = (const uint16_t *)ptrY8;
-        const uint16_t * ptrU16 = (const uint16_t *)ptrU8;
-        const uint16_t * ptrV16 = (const uint16_t *)ptrV8;
         const uint16_t * ptrA16 = (const uint16_t *)ptrA8;
 
         uint8_t * ptrR = &rgb->pixels[state->rgbOffsetBytesR + (j * rgb->rowBytes)];
@@ -458,7 +698,6 @@ static avifResult avifImageYUVAnyToRGBAnySlow(const avifImage * image,
         uint8_t * ptrB = &rgb->pixels[state->rgbOffsetBytesB + (j * rgb->rowBytes)];
 
         for (uint32_t i = 0; i < image->width; ++i) {
-            uint32_t uvI = i >> state->formatInfo.chromaShiftX;
             float Y, Cb = 0.5f, Cr = 0.5f;
 
             // Calculate Y
@@ -473,126 +712,7 @@ static avifResult avifImageYUVAnyToRGBAnySlow(const avifImage * image,
 
             // Calculate Cb and Cr
             if (hasColor) {
-                if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV444) {
-                    uint16_t unormU, unormV;
-
-                    if (image->depth == 8) {
-                        unormU = ptrU8[uvI];
-                        unormV = ptrV8[uvI];
-                    } else {
-                        // clamp incoming data to protect against bad LUT lookups
-                        unormU = AVIF_MIN(ptrU16[uvI], yuvMaxChannel);
-                        unormV = AVIF_MIN(ptrV16[uvI], yuvMaxChannel);
-                    }
-
-                    Cb = unormFloatTableUV[unormU];
-                    Cr = unormFloatTableUV[unormV];
-                } else {
-                    // Upsample to 444:
-                    //
-                    // *   *   *   *
-                    //   A       B
-                    // *   1   2   *
-                    //
-                    // *   3   4   *
-                    //   C       D
-                    // *   *   *   *
-                    //
-                    // When converting from YUV420 to RGB, for any given "high-resolution" RGB
-                    // coordinate (1,2,3,4,*), there are up to four "low-resolution" UV samples
-                    // (A,B,C,D) that are "nearest" to the pixel. For RGB pixel #1, A is the closest
-                    // UV sample, B and C are "adjacent" to it on the same row and column, and D is
-                    // the diagonal. For RGB pixel 3, C is the closest UV sample, A and D are
-                    // adjacent, and B is the diagonal. Sometimes the adjacent pixel on the same row
-                    // is to the left or right, and sometimes the adjacent pixel on the same column
-                    // is up or down. For any edge or corner, there might only be only one or two
-                    // samples nearby, so they'll be duplicated.
-                    //
-                    // The following code attempts to find all four nearest UV samples and put them
-                    // in the following unormU and unormV grid as follows:
-                    //
-                    // unorm[0][0] = closest         ( weights: bilinear: 9/16, nearest: 1 )
-                    // unorm[1][0] = adjacent col    ( weights: bilinear: 3/16, nearest: 0 )
-                    // unorm[0][1] = adjacent row    ( weights: bilinear: 3/16, nearest: 0 )
-                    // unorm[1][1] = diagonal        ( weights: bilinear: 1/16, nearest: 0 )
-                    //
-                    // It then weights them according to the requested upsampling set in avifRGBImage.
-
-                    uint16_t unormU[2][2], unormV[2][2];
-
-                    // How many bytes to add to a uint8_t pointer index to get to the adjacent (lesser) sample in a given direction
-                    int uAdjCol, vAdjCol, uAdjRow, vAdjRow;
-                    if ((i == 0) || ((i == (image->width - 1)) && ((i % 2) != 0))) {
-                        uAdjCol = 0;
-                        vAdjCol = 0;
-                    } else {
-                        if ((i % 2) != 0) {
-                            uAdjCol = yuvChannelBytes;
-                            vAdjCol = yuvChannelBytes;
-                        } else {
-                            uAdjCol = -1 * yuvChannelBytes;
-                            vAdjCol = -1 * yuvChannelBytes;
-                        }
-                    }
-
-                    // For YUV422, uvJ will always be a fresh value (always corresponds to j), so
-                    // we'll simply duplicate the sample as if we were on the top or bottom row and
-                    // it'll behave as plain old linear (1D) upsampling, which is all we want.
-                    if ((j == 0) || ((j == (image->height - 1)) && ((j % 2) != 0)) || (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV422)) {
-                        uAdjRow = 0;
-                        vAdjRow = 0;
-                    } else {
-                        if ((j % 2) != 0) {
-                            uAdjRow = (int)uRowBytes;
-                            vAdjRow = (int)vRowBytes;
-                        } else {
-                            uAdjRow = -1 * (int)uRowBytes;
-                            vAdjRow = -1 * (int)vRowBytes;
-                        }
-                    }
-
-                    if (image->depth == 8) {
-                        unormU[0][0] = uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes)];
-                        unormV[0][0] = vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes)];
-                        unormU[1][0] = uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjCol];
-                        unormV[1][0] = vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjCol];
-                        unormU[0][1] = uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjRow];
-                        unormV[0][1] = vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjRow];
-                        unormU[1][1] = uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjCol + uAdjRow];
-                        unormV[1][1] = vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjCol + vAdjRow];
-                    } else {
-                        unormU[0][0] = *((const uint16_t *)&uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes)]);
-                        unormV[0][0] = *((const uint16_t *)&vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes)]);
-                        unormU[1][0] = *((const uint16_t *)&uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjCol]);
-                        unormV[1][0] = *((const uint16_t *)&vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjCol]);
-                        unormU[0][1] = *((const uint16_t *)&uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjRow]);
-                        unormV[0][1] = *((const uint16_t *)&vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjRow]);
-                        unormU[1][1] = *((const uint16_t *)&uPlane[(uvJ * uRowBytes) + (uvI * yuvChannelBytes) + uAdjCol + uAdjRow]);
-                        unormV[1][1] = *((const uint16_t *)&vPlane[(uvJ * vRowBytes) + (uvI * yuvChannelBytes) + vAdjCol + vAdjRow]);
-
-                        // clamp incoming data to protect against bad LUT lookups
-                        for (int bJ = 0; bJ < 2; ++bJ) {
-                            for (int bI = 0; bI < 2; ++bI) {
-                                unormU[bI][bJ] = AVIF_MIN(unormU[bI][bJ], yuvMaxChannel);
-                                unormV[bI][bJ] = AVIF_MIN(unormV[bI][bJ], yuvMaxChannel);
-                            }
-                        }
-                    }
-
-                    if (chromaUpsampling == AVIF_CHROMA_UPSAMPLING_BILINEAR) {
-                        // Bilinear filtering with weights
-                        Cb = (unormFloatTableUV[unormU[0][0]] * (9.0f / 16.0f)) + (unormFloatTableUV[unormU[1][0]] * (3.0f / 16.0f)) +
-                             (unormFloatTableUV[unormU[0][1]] * (3.0f / 16.0f)) + (unormFloatTableUV[unormU[1][1]] * (1.0f / 16.0f));
-                        Cr = (unormFloatTableUV[unormV[0][0]] * (9.0f / 16.0f)) + (unormFloatTableUV[unormV[1][0]] * (3.0f / 16.0f)) +
-                             (unormFloatTableUV[unormV[0][1]] * (3.0f / 16.0f)) + (unormFloatTableUV[unormV[1][1]] * (1.0f / 16.0f));
-                    } else {
-                        assert(chromaUpsampling == AVIF_CHROMA_UPSAMPLING_NEAREST);
-
-                        // Nearest neighbor; ignore all UVs but the closest one
-                        Cb = unormFloatTableUV[unormU[0][0]];
-                        Cr = unormFloatTableUV[unormV[0][0]];
-                    }
-                }
+                avifImageYUVPixelToCbCr(image, state, chromaUpsampling, i, j, &Cb, &Cr);
             }
 
             float R, G, B;
@@ -680,6 +800,219 @@ static avifResult avifImageYUVAnyToRGBAnySlow(const avifImage * image,
     return AVIF_RESULT_OK;
 }
 
+// Writes one output pixel from premultiplied (RGB * A) values, matching the alpha state requested
+// in rgb. Output formats without alpha (or with ignoreAlpha) keep the premultiplied values, which
+// is the same as rendering the image over a black background.
+static void avifRGBImageWriteScaledPixel(avifRGBImage * rgb,
+                                         const avifReformatState * state,
+                                         uint32_t i,
+                                         uint32_t j,
+                                         const float pixel[4])
+{
+    const avifBool writeAlpha = avifRGBFormatHasAlpha(rgb->format) && !rgb->ignoreAlpha;
+    float R = pixel[0];
+    float G = pixel[1];
+    float B = pixel[2];
+    const float A = AVIF_CLAMP(pixel[3], 0.0f, 1.0f);
+    if (writeAlpha && !rgb->alphaPremultiplied && (A < 1.0f)) {
+        if (A == 0.0f) {
+            R = 0.0f;
+            G = 0.0f;
+            B = 0.0f;
+        } else {
+            R /= A;
+            G /= A;
+            B /= A;
+        }
+    }
+    R = AVIF_CLAMP(R, 0.0f, 1.0f);
+    G = AVIF_CLAMP(G, 0.0f, 1.0f);
+    B = AVIF_CLAMP(B, 0.0f, 1.0f);
+
+    uint8_t * ptr = &rgb->pixels[(j * rgb->rowBytes) + (i * state->rgbPixelBytes)];
+    if (rgb->depth == 8) {
+        ptr[state->rgbOffsetBytesR] = (uint8_t)(0.5f + (R * state->rgbMaxChannelF));
+        ptr[state->rgbOffsetBytesG] = (uint8_t)(0.5f + (G * state->rgbMaxChannelF));
+        ptr[state->rgbOffsetBytesB] = (uint8_t)(0.5f + (B * state->rgbMaxChannelF));
+        if (writeAlpha) {
+            ptr[state->rgbOffsetBytesA] = (uint8_t)(0.5f + (A * state->rgbMaxChannelF));
+        }
+    } else {
+        *((uint16_t *)&ptr[state->rgbOffsetBytesR]) = (uint16_t)(0.5f + (R * state->rgbMaxChannelF));
+        *((uint16_t *)&ptr[state->rgbOffsetBytesG]) = (uint16_t)(0.5f + (G * state->rgbMaxChannelF));
+        *((uint16_t *)&ptr[state->rgbOffsetBytesB]) = (uint16_t)(0.5f + (B * state->rgbMaxChannelF));
+        if (writeAlpha) {
+            *((uint16_t *)&ptr[state->rgbOffsetBytesA]) = (uint16_t)(0.5f + (A * state->rgbMaxChannelF));
+        }
+    }
+}
+
+// Converts row j of image with avifImageYUVRowToRGBFloat(), then premultiplies it (if the image has
+// unmultiplied alpha) so that it can be filtered without color bleeding from transparent pixels.
+static void avifImageYUVRowToPremultipliedFloat(const avifImage * image,
+                                                const avifReformatState * state,
+                                                const avifChromaUpsampling chromaUpsampling,
+                                                uint32_t j,
+                                                float * rgba)
+{
+    avifImageYUVRowToRGBFloat(image, state, chromaUpsampling, AVIF_TRUE, j, rgba);
+    if (image->alphaPlane && !image->alphaPremultiplied) {
+        for (uint32_t i = 0; i < image->width; ++i, rgba += 4) {
+            rgba[0] *= rgba[3];
+            rgba[1] *= rgba[3];
+            rgba[2] *= rgba[3];
+        }
+    }
+}
+
+// Converts image into the smaller rgb->width x rgb->height, filtering in (premultiplied) RGB space
+// with the filter chosen in rgb->downscaling.
+// Note: This function handles alpha (un)multiply and filling/reformatting the alpha channel.
+static avifResult avifImageYUVAnyToRGBAnyScaled(const avifImage * image,
+                                                avifRGBImage * rgb,
+                                                avifReformatState * state,
+                                                const avifChromaUpsampling chromaUpsampling)
+{
+    const uint32_t srcW = image->width;
+    const uint32_t srcH = image->height;
+    const uint32_t dstW = rgb->width;
+    const uint32_t dstH = rgb->height;
+
+    float * rows[2];
+    rows[0] = (float *)avifAlloc(sizeof(float) * 4 * srcW);
+    rows[1] = (float *)avifAlloc(sizeof(float) * 4 * srcW);
+    uint32_t * srcX = (uint32_t *)avifAlloc(sizeof(uint32_t) * dstW);
+    float pixel[4];
+
+    if (rgb->downscaling == AVIF_DOWNSCALING_BOX) {
+        // Every output pixel is the average of the block of input pixels it covers. Input columns
+        // are mapped to output columns once (srcX holds the first input column of each output
+        // column), so integral ratios (power-of-two or not) cost a single add per input sample.
+        float * sums = (float *)avifAlloc(sizeof(float) * 4 * dstW);
+        uint32_t * dstX = (uint32_t *)avifAlloc(sizeof(uint32_t) * srcW);
+        for (uint32_t i = 0; i < dstW; ++i) {
+            srcX[i] = (uint32_t)(((uint64_t)i * srcW) / dstW);
+        }
+        for (uint32_t i = 0; i < dstW; ++i) {
+            const uint32_t endX = (i + 1 < dstW) ? srcX[i + 1] : srcW;
+            for (uint32_t x = srcX[i]; x < endX; ++x) {
+                dstX[x] = i;
+            }
+        }
+
+        for (uint32_t j = 0; j < dstH; ++j) {
+            const uint32_t startY = (uint32_t)(((uint64_t)j * srcH) / dstH);
+            const uint32_t endY = (uint32_t)(((uint64_t)(j + 1) * srcH) / dstH);
+            memset(sums, 0, sizeof(float) * 4 * dstW);
+            for (uint32_t y = startY; y < endY; ++y) {
+                avifImageYUVRowToPremultipliedFloat(image, state, chromaUpsampling, y, rows[0]);
+                const float * src = rows[0];
+                for (uint32_t x = 0; x < srcW; ++x, src += 4) {
+                    float * sum = &sums[dstX[x] * 4];
+                    sum[0] += src[0];
+                    sum[1] += src[1];
+                    sum[2] += src[2];
+                    sum[3] += src[3];
+                }
+            }
+            for (uint32_t i = 0; i < dstW; ++i) {
+                const uint32_t endX = (i + 1 < dstW) ? srcX[i + 1] : srcW;
+                const float scale = 1.0f / (float)((endX - srcX[i]) * (endY - startY));
+                for (int c = 0; c < 4; ++c) {
+                    pixel[c] = sums[(i * 4) + c] * scale;
+                }
+                avifRGBImageWriteScaledPixel(rgb, state, i, j, pixel);
+            }
+        }
+        avifFree(dstX);
+        avifFree(sums);
+    } else if (rgb->downscaling == AVIF_DOWNSCALING_BILINEAR) {
+        // Interpolate between the four input pixels surrounding each output pixel's center.
+        float * weightX = (float *)avifAlloc(sizeof(float) * dstW);
+        for (uint32_t i = 0; i < dstW; ++i) {
+            float x = (((float)i + 0.5f) * (float)srcW / (float)dstW) - 0.5f;
+            x = AVIF_CLAMP(x, 0.0f, (float)(srcW - 1));
+            srcX[i] = (uint32_t)x;
+            weightX[i] = x - (float)srcX[i];
+        }
+
+        uint32_t rowY[2] = { UINT32_MAX, UINT32_MAX };
+        for (uint32_t j = 0; j < dstH; ++j) {
+            float y = (((float)j + 0.5f) * (float)srcH / (float)dstH) - 0.5f;
+            y = AVIF_CLAMP(y, 0.0f, (float)(srcH - 1));
+            const uint32_t y0 = (uint32_t)y;
+            const uint32_t y1 = AVIF_MIN(y0 + 1, srcH - 1);
+            const float weightY = y - (float)y0;
+
+            // Reuse the previous output row's input rows when they are still needed.
+            if (rowY[1] == y0) {
+                float * t = rows[0];
+                rows[0] = rows[1];
+                rows[1] = t;
+                rowY[0] = y0;
+                rowY[1] = UINT32_MAX;
+            }
+            if (rowY[0] != y0) {
+                avifImageYUVRowToPremultipliedFloat(image, state, chromaUpsampling, y0, rows[0]);
+                rowY[0] = y0;
+            }
+            if (rowY[1] != y1) {
+                avifImageYUVRowToPremultipliedFloat(image, state, chromaUpsampling, y1, rows[1]);
+                rowY[1] = y1;
+            }
+
+            for (uint32_t i = 0; i < dstW; ++i) {
+                const uint32_t x0 = srcX[i];
+                const uint32_t x1 = AVIF_MIN(x0 + 1, srcW - 1);
+                const float * p00 = &rows[0][x0 * 4];
+                const float * p10 = &rows[0][x1 * 4];
+                const float * p01 = &rows[1][x0 * 4];
+                const float * p11 = &rows[1][x1 * 4];
+                for (int c = 0; c < 4; ++c) {
+                    const float top = p00[c] + ((p10[c] - p00[c]) * weightX[i]);
+                    const float bottom = p01[c] + ((p11[c] - p01[c]) * weightX[i]);
+                    pixel[c] = top + ((bottom - top) * weightY);
+                }
+                avifRGBImageWriteScaledPixel(rgb, state, i, j, pixel);
+            }
+        }
+        avifFree(weightX);
+    } else {
+        // AVIF_DOWNSCALING_NEAREST: Sample the input pixel under each output pixel's center.
+        for (uint32_t i = 0; i < dstW; ++i) {
+            srcX[i] = (uint32_t)((((uint64_t)i * 2 + 1) * srcW) / ((uint64_t)dstW * 2));
+        }
+        for (uint32_t j = 0; j < dstH; ++j) {
+            const uint32_t y = (uint32_t)((((uint64_t)j * 2 + 1) * srcH) / ((uint64_t)dstH * 2));
+            avifImageYUVRowToPremultipliedFloat(image, state, chromaUpsampling, y, rows[0]);
+            for (uint32_t i = 0; i < dstW; ++i) {
+                avifRGBImageWriteScaledPixel(rgb, state, i, j, &rows[0][srcX[i] * 4]);
+            }
+        }
+    }
+
+    avifFree(srcX);
+    avifFree(rows[0]);
+    avifFree(rows[1]);
+    return AVIF_RESULT_OK;
+}
+
+// Runs state->toRGBAlphaMode over row j of rgb while it is still hot in cache, so the fast paths below
+// don't need a separate (un)premultiply pass. Expects the alpha channel to already be in rgb.
+static void avifReformatStateMultiplyAlphaRow(const avifReformatState * state, avifRGBImage * rgb, uint32_t j)
+{
+    if (!avifRGBFormatHasAlpha(rgb->format)) {
+        return;
+    }
+
+    uint8_t * row = &rgb->pixels[j * rgb->rowBytes];
+    if (state->toRGBAlphaMode == AVIF_ALPHA_MULTIPLY_MODE_MULTIPLY) {
+        avifRGBRowPremultiplyAlpha(row, rgb->width, rgb->depth, rgb->format);
+    } else if (state->toRGBAlphaMode == AVIF_ALPHA_MULTIPLY_MODE_UNMULTIPLY) {
+        avifRGBRowUnpremultiplyAlpha(row, rgb->width, rgb->depth, rgb->format);
+    }
+}
+
 static avifResult avifImageYUV16ToRGB16Color(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
 {
     const float kr = state->kr;
@@ -728,6 +1061,7 @@ static avifResult avifImageYUV16ToRGB16Color(const avifImage * image, avifRGBIma
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        avifReformatStateMultiplyAlphaRow(state, rgb, j);
     }
     return AVIF_RESULT_OK;
 }
@@ -772,6 +1106,7 @@ static avifResult avifImageYUV16ToRGB16Mono(const avifImage * image, avifRGBImag
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        avifReformatStateMultiplyAlphaRow(state, rgb, j);
     }
     return AVIF_RESULT_OK;
 }
@@ -824,6 +1159,7 @@ static avifResult avifImageYUV16ToRGB8Color(const avifImage * image, avifRGBImag
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        avifReformatStateMultiplyAlphaRow(state, rgb, j);
     }
     return AVIF_RESULT_OK;
 }
@@ -868,6 +1204,7 @@ static avifResult avifImageYUV16ToRGB8Mono(const avifImage * image, avifRGBImage
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        avifReformatStateMultiplyAlphaRow(state, rgb, j);
     }
     return AVIF_RESULT_OK;
 }
@@ -914,6 +1251,7 @@ static avifResult avifImageYUV8ToRGB16Color(const avifImage * image, avifRGBImag
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        avifReformatStateMultiplyAlphaRow(state, rgb, j);
     }
     return AVIF_RESULT_OK;
 }
@@ -954,6 +1292,7 @@ static avifResult avifImageYUV8ToRGB16Mono(const avifImage * image, avifRGBImage
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        avifReformatStateMultiplyAlphaRow(state, rgb, j);
     }
     return AVIF_RESULT_OK;
 }
@@ -978,6 +1317,7 @@ static avifResult avifImageIdentity8ToRGB8ColorFullRange(const avifImage * image
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        avifReformatStateMultiplyAlphaRow(state, rgb, j);
     }
     return AVIF_RESULT_OK;
 }
@@ -1024,6 +1364,7 @@ static avifResult avifImageYUV8ToRGB8Color(const avifImage * image, avifRGBImage
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        avifReformatStateMultiplyAlphaRow(state, rgb, j);
     }
     return AVIF_RESULT_OK;
 }
@@ -1064,22 +1405,40 @@ static avifResult avifImageYUV8ToRGB8Mono(const avifImage * image, avifRGBImage
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        avifReformatStateMultiplyAlphaRow(state, rgb, j);
     }
     return AVIF_RESULT_OK;
 }
 
-avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
+// Everything avifImageYUVToRGB() does once state has been prepared for image and rgb.
+static avifResult avifImageYUVToRGBWithState(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
 {
-    if (!image->yuvPlanes[AVIF_CHAN_Y]) {
-        return AVIF_RESULT_REFORMAT_FAILED;
+    avifChromaUpsampling chromaUpsampling;
+    switch (rgb->chromaUpsampling) {
+        case AVIF_CHROMA_UPSAMPLING_AUTOMATIC:
+        case AVIF_CHROMA_UPSAMPLING_BEST_QUALITY:
+        case AVIF_CHROMA_UPSAMPLING_BILINEAR:
+        default:
+            chromaUpsampling = AVIF_CHROMA_UPSAMPLING_BILINEAR;
+            break;
+
+        case AVIF_CHROMA_UPSAMPLING_FASTEST:
+        case AVIF_CHROMA_UPSAMPLING_NEAREST:
+            chromaUpsampling = AVIF_CHROMA_UPSAMPLING_NEAREST;
+            break;
     }
 
-    avifReformatState state;
-    if (!avifPrepareReformatState(image, rgb, &state)) {
-        return AVIF_RESULT_REFORMAT_FAILED;
+    if ((rgb->downscaling != AVIF_DOWNSCALING_NONE) && ((rgb->width != image->width) || (rgb->height != image->height))) {
+        if (!rgb->width || !rgb->height || (rgb->width > image->width) || (rgb->height > image->height)) {
+            return AVIF_RESULT_REFORMAT_FAILED;
+        }
+
+        // None of libyuv, the fast paths or the alpha helpers below can resize, so the scaled path
+        // does all of the work (including alpha) in one pass over the YUV planes.
+        return avifImageYUVAnyToRGBAnyScaled(image, rgb, state, chromaUpsampling);
     }
 
-    avifAlphaMultiplyMode alphaMultiplyMode = state.toRGBAlphaMode;
+    avifAlphaMultiplyMode alphaMultiplyMode = state->toRGBAlphaMode;
     avifBool convertedWithLibYUV = AVIF_FALSE;
     if (alphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_NO_OP || avifRGBFormatHasAlpha(rgb->format)) {
         avifResult libyuvResult = avifImageYUVToRGBLibYUV(image, rgb);
@@ -1102,8 +1461,8 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
         params.dstRange = AVIF_RANGE_FULL;
         params.dstPlane = rgb->pixels;
         params.dstRowBytes = rgb->rowBytes;
-        params.dstOffsetBytes = state.rgbOffsetBytesA;
-        params.dstPixelBytes = state.rgbPixelBytes;
+        params.dstOffsetBytes = state->rgbOffsetBytesA;
+        params.dstPixelBytes = state->rgbPixelBytes;
 
         if (image->alphaPlane && image->alphaRowBytes) {
             params.srcDepth = image->depth;
@@ -1111,7 +1470,7 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
             params.srcPlane = image->alphaPlane;
             params.srcRowBytes = image->alphaRowBytes;
             params.srcOffsetBytes = 0;
-            params.srcPixelBytes = state.yuvChannelBytes;
+            params.srcPixelBytes = state->yuvChannelBytes;
 
             avifReformatAlpha(&params);
         } else {
@@ -1129,21 +1488,6 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
 
         avifResult convertResult = AVIF_RESULT_NOT_IMPLEMENTED;
 
-        avifChromaUpsampling chromaUpsampling;
-        switch (rgb->chromaUpsampling) {
-            case AVIF_CHROMA_UPSAMPLING_AUTOMATIC:
-            case AVIF_CHROMA_UPSAMPLING_BEST_QUALITY:
-            case AVIF_CHROMA_UPSAMPLING_BILINEAR:
-            default:
-                chromaUpsampling = AVIF_CHROMA_UPSAMPLING_BILINEAR;
-                break;
-
-            case AVIF_CHROMA_UPSAMPLING_FASTEST:
-            case AVIF_CHROMA_UPSAMPLING_NEAREST:
-                chromaUpsampling = AVIF_CHROMA_UPSAMPLING_NEAREST;
-                break;
-        }
-
         const avifBool hasColor =
             (image->yuvRowBytes[AVIF_CHAN_U] && image->yuvRowBytes[AVIF_CHAN_V] && (image->yuvFormat != AVIF_PIXEL_FORMAT_YUV400));
 
@@ -1152,17 +1496,18 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
             // Explanations on the above conditional:
             // * None of these fast paths currently support bilinear upsampling, so avoid all of them
             //   unless the YUV data isn't subsampled or they explicitly requested AVIF_CHROMA_UPSAMPLING_NEAREST.
-            // * None of these fast paths currently handle alpha (un)multiply, so avoid all of them
-            //   if we can't do alpha (un)multiply as a separated post step (destination format doesn't have alpha).
+            // * These fast paths (un)multiply alpha row by row using the alpha channel already reformatted
+            //   into rgb, so avoid all of them if alpha (un)multiply is needed and the destination format
+            //   doesn't have alpha.
 
-            if (state.mode == AVIF_REFORMAT_MODE_IDENTITY) {
+            if (state->mode == AVIF_REFORMAT_MODE_IDENTITY) {
                 if ((image->depth == 8) && (rgb->depth == 8) && (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV444) &&
                     (image->yuvRange == AVIF_RANGE_FULL)) {
-                    convertResult = avifImageIdentity8ToRGB8ColorFullRange(image, rgb, &state);
+                    convertResult = avifImageIdentity8ToRGB8ColorFullRange(image, rgb, state);
                 }
 
                 // TODO: Add more fast paths for identity
-            } else if (state.mode == AVIF_REFORMAT_MODE_YUV_COEFFICIENTS) {
+            } else if (state->mode == AVIF_REFORMAT_MODE_YUV_COEFFICIENTS) {
                 if (image->depth > 8) {
                     // yuv:u16
 
@@ -1170,17 +1515,17 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
                         // yuv:u16, rgb:u16
 
                         if (hasColor) {
-                            convertResult = avifImageYUV16ToRGB16Color(image, rgb, &state);
+                            convertResult = avifImageYUV16ToRGB16Color(image, rgb, state);
                         } else {
-                            convertResult = avifImageYUV16ToRGB16Mono(image, rgb, &state);
+                            convertResult = avifImageYUV16ToRGB16Mono(image, rgb, state);
                         }
                     } else {
                         // yuv:u16, rgb:u8
 
                         if (hasColor) {
-                            convertResult = avifImageYUV16ToRGB8Color(image, rgb, &state);
+                            convertResult = avifImageYUV16ToRGB8Color(image, rgb, state);
                         } else {
-                            convertResult = avifImageYUV16ToRGB8Mono(image, rgb, &state);
+                            convertResult = avifImageYUV16ToRGB8Mono(image, rgb, state);
                         }
                     }
                 } else {
@@ -1190,17 +1535,17 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
                         // yuv:u8, rgb:u16
 
                         if (hasColor) {
-                            convertResult = avifImageYUV8ToRGB16Color(image, rgb, &state);
+                            convertResult = avifImageYUV8ToRGB16Color(image, rgb, state);
                         } else {
-                            convertResult = avifImageYUV8ToRGB16Mono(image, rgb, &state);
+                            convertResult = avifImageYUV8ToRGB16Mono(image, rgb, state);
                         }
                     } else {
                         // yuv:u8, rgb:u8
 
                         if (hasColor) {
-                            convertResult = avifImageYUV8ToRGB8Color(image, rgb, &state);
+                            convertResult = avifImageYUV8ToRGB8Color(image, rgb, state);
                         } else {
-                            convertResult = avifImageYUV8ToRGB8Mono(image, rgb, &state);
+                            convertResult = avifImageYUV8ToRGB8Mono(image, rgb, state);
                         }
                     }
                 }
@@ -1209,12 +1554,12 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
 
         if (convertResult == AVIF_RESULT_NOT_IMPLEMENTED) {
             // If we get here, there is no fast path for this combination. Time to be slow!
-            convertResult = avifImageYUVAnyToRGBAnySlow(image, rgb, &state, chromaUpsampling);
-
-            // The slow path also handles alpha (un)multiply, so forget the operation here.
-            alphaMultiplyMode = AVIF_ALPHA_MULTIPLY_MODE_NO_OP;
+            convertResult = avifImageYUVAnyToRGBAnySlow(image, rgb, state, chromaUpsampling);
         }
 
+        // Both the fast paths and the slow path handle alpha (un)multiply, so forget the operation here.
+        alphaMultiplyMode = AVIF_ALPHA_MULTIPLY_MODE_NO_OP;
+
         if (convertResult != AVIF_RESULT_OK) {
             return convertResult;
         }
@@ -1230,6 +1575,106 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
     return AVIF_RESULT_OK;
 }
 
+avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
+{
+    if (!image->yuvPlanes[AVIF_CHAN_Y]) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+
+    avifReformatState state;
+    if (!avifPrepareReformatState(image, rgb, &state)) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    return avifImageYUVToRGBWithState(image, rgb, &state);
+}
+
+// ---------------------------------------------------------------------------
+// avifRGBConverter
+
+// Everything avifPrepareReformatState() reads from the avifImage and the avifRGBImage. The cached
+// state is reused for as long as none of these change.
+typedef struct avifRGBConverterKey
+{
+    uint32_t yuvDepth;
+    avifPixelFormat yuvFormat;
+    avifRange yuvRange;
+    avifRange alphaRange;
+    avifColorPrimaries colorPrimaries;
+    avifMatrixCoefficients matrixCoefficients;
+    avifBool hasAlphaPlane;
+    avifBool imageAlphaPremultiplied;
+
+    uint32_t rgbDepth;
+    avifRGBFormat rgbFormat;
+    avifBool ignoreAlpha;
+    avifBool rgbAlphaPremultiplied;
+} avifRGBConverterKey;
+
+struct avifRGBConverter
+{
+    avifBool valid; // AVIF_TRUE once state has been successfully prepared for key
+    avifRGBConverterKey key;
+    avifReformatState state;
+};
+
+static void avifRGBConverterKeySet(avifRGBConverterKey * key, const avifImage * image, const avifRGBImage * rgb)
+{
+    key->yuvDepth = image->depth;
+    key->yuvFormat = image->yuvFormat;
+    key->yuvRange = image->yuvRange;
+    key->alphaRange = image->alphaRange;
+    key->colorPrimaries = image->colorPrimaries;
+    key->matrixCoefficients = image->matrixCoefficients;
+    key->hasAlphaPlane = (image->alphaPlane != NULL);
+    key->imageAlphaPremultiplied = image->alphaPremultiplied;
+
+    key->rgbDepth = rgb->depth;
+    key->rgbFormat = rgb->format;
+    key->ignoreAlpha = rgb->ignoreAlpha;
+    key->rgbAlphaPremultiplied = rgb->alphaPremultiplied;
+}
+
+static avifBool avifRGBConverterKeyEquals(const avifRGBConverterKey * a, const avifRGBConverterKey * b)
+{
+    return (a->yuvDepth == b->yuvDepth) && (a->yuvFormat == b->yuvFormat) && (a->yuvRange == b->yuvRange) &&
+           (a->alphaRange == b->alphaRange) && (a->colorPrimaries == b->colorPrimaries) &&
+           (a->matrixCoefficients == b->matrixCoefficients) && (a->hasAlphaPlane == b->hasAlphaPlane) &&
+           (a->imageAlphaPremultiplied == b->imageAlphaPremultiplied) && (a->rgbDepth == b->rgbDepth) &&
+           (a->rgbFormat == b->rgbFormat) && (a->ignoreAlpha == b->ignoreAlpha) &&
+           (a->rgbAlphaPremultiplied == b->rgbAlphaPremultiplied);
+}
+
+avifRGBConverter * avifRGBConverterCreate(void)
+{
+    avifRGBConverter * converter = (avifRGBConverter *)avifAlloc(sizeof(avifRGBConverter));
+    memset(converter, 0, sizeof(avifRGBConverter));
+    return converter;
+}
+
+void avifRGBConverterDestroy(avifRGBConverter * converter)
+{
+    avifFree(converter);
+}
+
+avifResult avifRGBConverterYUVToRGB(avifRGBConverter * converter, const avifImage * image, avifRGBImage * rgb)
+{
+    if (!image->yuvPlanes[AVIF_CHAN_Y]) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+
+    avifRGBConverterKey key;
+    avifRGBConverterKeySet(&key, image, rgb);
+    if (!converter->valid || !avifRGBConverterKeyEquals(&key, &converter->key)) {
+        converter->valid = AVIF_FALSE;
+        if (!avifPrepareReformatState(image, rgb, &converter->state)) {
+            return AVIF_RESULT_REFORMAT_FAILED;
+        }
+        converter->key = key;
+        converter->valid = AVIF_TRUE;
+    }
+    return avifImageYUVToRGBWithState(image, rgb, &converter->state);
+}
+
 // Limited -> Full
 // Plan: subtract limited offset, then multiply by ratio of FULLSIZE/LIMITEDSIZE (rounding), then clamp.
 // RATIO = (FULLY - 0) / (MAXLIMITEDY - MINLIMITEDY)
@@ -38,11 +38,102 @@ unsigned int avifLibYUVVersion(void)
 #pragma clang diagnostic pop
 #endif
 
+// Turns the BGRA/RGBA output of a libyuv *ToARGBMatrix call into ABGR/ARGB in place (libyuv's ARGB -> RGBA
+// in word-order), for the conversions which have no *ToRGBAMatrix equivalent.
+static avifResult avifRGBImageARGBToRGBALibYUV(avifRGBImage * rgb)
+{
+    if (ARGBToRGBA(rgb->pixels, rgb->rowBytes, rgb->pixels, rgb->rowBytes, rgb->width, rgb->height) != 0) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    return AVIF_RESULT_OK;
+}
+
+// 10-bit YUV -> 8-bit RGB. libyuv's I010/I210/I410 converters take uint16_t planes with strides in
+// samples rather than bytes, and only exist in the *ToARGBMatrix flavor, so U/V ordering and the
+// matrix pick BGRA or RGBA (see the table in avifImageYUVToRGBLibYUV()) and the alpha-first formats are
+// shuffled afterwards.
+static avifResult avifImageYUV10ToRGB8LibYUV(const avifImage * image,
+                                             avifRGBImage * rgb,
+                                             const struct YuvConstants * matrixYUV,
+                                             const struct YuvConstants * matrixYVU)
+{
+    if ((rgb->format != AVIF_RGB_FORMAT_BGRA) && (rgb->format != AVIF_RGB_FORMAT_RGBA) &&
+        (rgb->format != AVIF_RGB_FORMAT_ABGR) && (rgb->format != AVIF_RGB_FORMAT_ARGB)) {
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+
+    const avifBool swapUV = (rgb->format == AVIF_RGB_FORMAT_RGBA) || (rgb->format == AVIF_RGB_FORMAT_ARGB);
+    const struct YuvConstants * matrix = swapUV ? matrixYVU : matrixYUV;
+    const int chanU = swapUV ? AVIF_CHAN_V : AVIF_CHAN_U;
+    const int chanV = swapUV ? AVIF_CHAN_U : AVIF_CHAN_V;
+    const uint16_t * srcY = (const uint16_t *)image->yuvPlanes[AVIF_CHAN_Y];
+    const uint16_t * srcU = (const uint16_t *)image->yuvPlanes[chanU];
+    const uint16_t * srcV = (const uint16_t *)image->yuvPlanes[chanV];
+    const int strideY = (int)(image->yuvRowBytes[AVIF_CHAN_Y] / 2);
+    const int strideU = (int)(image->yuvRowBytes[chanU] / 2);
+    const int strideV = (int)(image->yuvRowBytes[chanV] / 2);
+
+    int libyuvResult;
+    if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV420) {
+        libyuvResult = I010ToARGBMatrix(srcY,
+                                        strideY,
+                                        srcU,
+                                        strideU,
+                                        srcV,
+                                        strideV,
+                                        rgb->pixels,
+                                        rgb->rowBytes,
+                                        matrix,
+                                        image->width,
+                                        image->height);
+    } else if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV422) {
+        libyuvResult = I210ToARGBMatrix(srcY,
+                                        strideY,
+                                        srcU,
+                                        strideU,
+                                        srcV,
+                                        strideV,
+                                        rgb->pixels,
+                                        rgb->rowBytes,
+                                        matrix,
+                                        image->width,
+                                        image->height);
+    } else if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV444) {
+        // I410ToARGBMatrix was added in libyuv version 1780.
+#if LIBYUV_VERSION >= 1780
+        libyuvResult = I410ToARGBMatrix(srcY,
+                                        strideY,
+                                        srcU,
+                                        strideU,
+                                        srcV,
+                                        strideV,
+                                        rgb->pixels,
+                                        rgb->rowBytes,
+                                        matrix,
+                                        image->width,
+                                        image->height);
+#else
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+#endif
+    } else {
+        // No 10-bit YUV400 converter exists in libyuv
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+    if (libyuvResult != 0) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+
+    if ((rgb->format == AVIF_RGB_FORMAT_ABGR) || (rgb->format == AVIF_RGB_FORMAT_ARGB)) {
+        return avifRGBImageARGBToRGBALibYUV(rgb);
+    }
+    return AVIF_RESULT_OK;
+}
+
 avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb)
 {
     // See if the current settings can be accomplished with libyuv, and use it (if possible).
 
-    if ((image->depth != 8) || (rgb->depth != 8)) {
+    if (((image->depth != 8) && (image->depth != 10)) || (rgb->depth != 8)) {
         return AVIF_RESULT_NOT_IMPLEMENTED;
     }
 
@@ -182,6 +273,10 @@ avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb)
         return AVIF_RESULT_NOT_IMPLEMENTED;
     }
 
+    if (image->depth == 10) {
+        return avifImageYUV10ToRGB8LibYUV(image, rgb, matrixYUV, matrixYVU);
+    }
+
     // This following section might be a bit complicated to audit without a bit of explanation:
     //
     // libavif uses byte-order when describing pixel formats, such that the R in RGBA is the lowest address,
@@ -197,6 +292,9 @@ avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb)
     // AVIF_RGB_FORMAT_RGBA  *ToARGBMatrix   matrixYVU
     // AVIF_RGB_FORMAT_ABGR  *ToRGBAMatrix   matrixYUV
     // AVIF_RGB_FORMAT_ARGB  *ToRGBAMatrix   matrixYVU
+    //
+    // Where no *ToRGBAMatrix exists (YUV444, YUV400), the ABGR/ARGB rows instead use *ToARGBMatrix
+    // (with the BGRA/RGBA matrix and UV ordering respectively) followed by an in-place ARGBToRGBA().
 
     if (rgb->format == AVIF_RGB_FORMAT_BGRA) {
         // AVIF_RGB_FORMAT_BGRA  *ToARGBMatrix   matrixYUV
@@ -322,9 +420,7 @@ avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb)
         // AVIF_RGB_FORMAT_ABGR  *ToRGBAMatrix   matrixYUV
 
         if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV444) {
-            // This doesn't currently exist in libyuv
-#if 0
-            if (I444ToRGBAMatrix(image->yuvPlanes[AVIF_CHAN_Y],
+            if (I444ToARGBMatrix(image->yuvPlanes[AVIF_CHAN_Y],
                                  image->yuvRowBytes[AVIF_CHAN_Y],
                                  image->yuvPlanes[AVIF_CHAN_U],
                                  image->yuvRowBytes[AVIF_CHAN_U],
@@ -337,8 +433,7 @@ avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb)
                                  image->height) != 0) {
                 return AVIF_RESULT_REFORMAT_FAILED;
             }
-            return AVIF_RESULT_OK;
-#endif
+            return avifRGBImageARGBToRGBALibYUV(rgb);
         } else if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV422) {
             if (I422ToRGBAMatrix(image->yuvPlanes[AVIF_CHAN_Y],
                                  image->yuvRowBytes[AVIF_CHAN_Y],
@@ -370,9 +465,7 @@ avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb)
             }
             return AVIF_RESULT_OK;
         } else if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV400) {
-            // This doesn't currently exist in libyuv
-#if 0
-            if (I400ToRGBAMatrix(image->yuvPlanes[AVIF_CHAN_Y],
+            if (I400ToARGBMatrix(image->yuvPlanes[AVIF_CHAN_Y],
                                  image->yuvRowBytes[AVIF_CHAN_Y],
                                  rgb->pixels,
                                  rgb->rowBytes,
@@ -381,16 +474,13 @@ avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb)
                                  image->height) != 0) {
                 return AVIF_RESULT_REFORMAT_FAILED;
             }
-            return AVIF_RESULT_OK;
-#endif
+            return avifRGBImageARGBToRGBALibYUV(rgb);
         }
     } else if (rgb->format == AVIF_RGB_FORMAT_ARGB) {
         // AVIF_RGB_FORMAT_ARGB  *ToRGBAMatrix   matrixYVU
 
         if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV444) {
-            // This doesn't currently exist in libyuv
-#if 0
-            if (I444ToRGBAMatrix(image->yuvPlanes[AVIF_CHAN_Y],
+            if (I444ToARGBMatrix(image->yuvPlanes[AVIF_CHAN_Y],
                                  image->yuvRowBytes[AVIF_CHAN_Y],
                                  image->yuvPlanes[AVIF_CHAN_V],
                                  image->yuvRowBytes[AVIF_CHAN_V],
@@ -403,8 +493,7 @@ avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb)
                                  image->height) != 0) {
                 return AVIF_RESULT_REFORMAT_FAILED;
             }
-            return AVIF_RESULT_OK;
-#endif
+            return avifRGBImageARGBToRGBALibYUV(rgb);
         } else if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV422) {
             if (I422ToRGBAMatrix(image->yuvPlanes[AVIF_CHAN_Y],
                                  image->yuvRowBytes[AVIF_CHAN_Y],
@@ -436,9 +525,7 @@ avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb)
             }
             return AVIF_RESULT_OK;
         } else if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV400) {
-            // This doesn't currently exist in libyuv
-#if 0
-            if (I400ToRGBAMatrix(image->yuvPlanes[AVIF_CHAN_Y],
+            if (I400ToARGBMatrix(image->yuvPlanes[AVIF_CHAN_Y],
                                  image->yuvRowBytes[AVIF_CHAN_Y],
                                  rgb->pixels,
                                  rgb->rowBytes,
@@ -447,8 +534,7 @@ avifResult avifImageYUVToRGBLibYUV(const avifImage * image, avifRGBImage * rgb)
                                  image->height) != 0) {
                 return AVIF_RESULT_REFORMAT_FAILED;
             }
-            return AVIF_RESULT_OK;
-#endif
+            return avifRGBImageARGBToRGBALibYUV(rgb);
         }
     }
 
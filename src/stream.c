@@ -161,13 +161,14 @@ avifBool avifROStreamReadBoxHeaderPartial(avifROStream * stream, avifBoxHeader *
     uint32_t smallSize;
     CHECK(avifROStreamReadU32(stream, &smallSize));
     CHECK(avifROStreamRead(stream, header->type, 4));
+    header->fourcc = AVIF_FOURCC(header->type[0], header->type[1], header->type[2], header->type[3]);
 
     uint64_t size = smallSize;
     if (size == 1) {
         CHECK(avifROStreamReadU64(stream, &size));
     }
 
-    if (!memcmp(header->type, "uuid", 4)) {
+    if (header->fourcc == AVIF_FOURCC('u', 'u', 'i', 'd')) {
         CHECK(avifROStreamSkip(stream, 16));
     }
 
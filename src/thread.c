@@ -0,0 +1,369 @@
+// Copyright 2021 Joe Drago. All rights reserved.
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "avif/internal.h"
+
+#include <string.h>
+
+#if defined(_WIN32)
+
+#include <process.h>
+#include <windows.h>
+
+struct avifThread
+{
+    HANDLE handle;
+    avifThreadFunc func;
+    void * userData;
+};
+
+struct avifMutex
+{
+    SRWLOCK lock;
+};
+
+struct avifCond
+{
+    CONDITION_VARIABLE cond;
+};
+
+static unsigned __stdcall avifThreadMain(void * arg)
+{
+    avifThread * thread = (avifThread *)arg;
+    thread->func(thread->userData);
+    return 0;
+}
+
+avifThread * avifThreadCreate(avifThreadFunc func, void * userData)
+{
+    avifThread * thread = (avifThread *)avifAlloc(sizeof(avifThread));
+    thread->func = func;
+    thread->userData = userData;
+    thread->handle = (HANDLE)_beginthreadex(NULL, 0, avifThreadMain, thread, 0, NULL);
+    if (!thread->handle) {
+        avifFree(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void avifThreadJoin(avifThread * thread)
+{
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    avifFree(thread);
+}
+
+avifMutex * avifMutexCreate(void)
+{
+    avifMutex * mutex = (avifMutex *)avifAlloc(sizeof(avifMutex));
+    InitializeSRWLock(&mutex->lock);
+    return mutex;
+}
+
+void avifMutexDestroy(avifMutex * mutex)
+{
+    avifFree(mutex);
+}
+
+void avifMutexLock(avifMutex * mutex)
+{
+    AcquireSRWLockExclusive(&mutex->lock);
+}
+
+void avifMutexUnlock(avifMutex * mutex)
+{
+    ReleaseSRWLockExclusive(&mutex->lock);
+}
+
+avifCond * avifCondCreate(void)
+{
+    avifCond * cond = (avifCond *)avifAlloc(sizeof(avifCond));
+    InitializeConditionVariable(&cond->cond);
+    return cond;
+}
+
+void avifCondDestroy(avifCond * cond)
+{
+    avifFree(cond);
+}
+
+void avifCondWait(avifCond * cond, avifMutex * mutex)
+{
+    SleepConditionVariableSRW(&cond->cond, &mutex->lock, INFINITE, 0);
+}
+
+void avifCondSignal(avifCond * cond)
+{
+    WakeConditionVariable(&cond->cond);
+}
+
+void avifCondBroadcast(avifCond * cond)
+{
+    WakeAllConditionVariable(&cond->cond);
+}
+
+#else
+
+#include <pthread.h>
+
+struct avifThread
+{
+    pthread_t handle;
+    avifThreadFunc func;
+    void * userData;
+};
+
+struct avifMutex
+{
+    pthread_mutex_t mutex;
+};
+
+struct avifCond
+{
+    pthread_cond_t cond;
+};
+
+static void * avifThreadMain(void * arg)
+{
+    avifThread * thread = (avifThread *)arg;
+    thread->func(thread->userData);
+    return NULL;
+}
+
+avifThread * avifThreadCreate(avifThreadFunc func, void * userData)
+{
+    avifThread * thread = (avifThread *)avifAlloc(sizeof(avifThread));
+    thread->func = func;
+    thread->userData = userData;
+    if (pthread_create(&thread->handle, NULL, avifThreadMain, thread) != 0) {
+        avifFree(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void avifThreadJoin(avifThread * thread)
+{
+    pthread_join(thread->handle, NULL);
+    avifFree(thread);
+}
+
+avifMutex * avifMutexCreate(void)
+{
+    avifMutex * mutex = (avifMutex *)avifAlloc(sizeof(avifMutex));
+    pthread_mutex_init(&mutex->mutex, NULL);
+    return mutex;
+}
+
+void avifMutexDestroy(avifMutex * mutex)
+{
+    pthread_mutex_destroy(&mutex->mutex);
+    avifFree(mutex);
+}
+
+void avifMutexLock(avifMutex * mutex)
+{
+    pthread_mutex_lock(&mutex->mutex);
+}
+
+void avifMutexUnlock(avifMutex * mutex)
+{
+    pthread_mutex_unlock(&mutex->mutex);
+}
+
+avifCond * avifCondCreate(void)
+{
+    avifCond * cond = (avifCond *)avifAlloc(sizeof(avifCond));
+    pthread_cond_init(&cond->cond, NULL);
+    return cond;
+}
+
+void avifCondDestroy(avifCond * cond)
+{
+    pthread_cond_destroy(&cond->cond);
+    avifFree(cond);
+}
+
+void avifCondWait(avifCond * cond, avifMutex * mutex)
+{
+    pthread_cond_wait(&cond->cond, &mutex->mutex);
+}
+
+void avifCondSignal(avifCond * cond)
+{
+    pthread_cond_signal(&cond->cond);
+}
+
+void avifCondBroadcast(avifCond * cond)
+{
+    pthread_cond_broadcast(&cond->cond);
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// avifThreadPool
+
+// A call to avifThreadPoolRun(), living on the stack of its caller while it is listed in the pool.
+typedef struct avifThreadPoolTask
+{
+    avifThreadPoolTaskFunc func;
+    void * userData;
+    uint32_t count;
+    uint32_t nextIndex;      // next index to hand out
+    uint32_t doneCount;      // calls that have returned
+    uint32_t workerCount;    // workers currently helping
+    uint32_t maxWorkerCount; // maxConcurrency - 1
+    struct avifThreadPoolTask * next;
+} avifThreadPoolTask;
+
+struct avifThreadPool
+{
+    int maxThreads;
+    avifThread ** workers;
+    int workerCount;
+
+    // Guards everything below. cond is broadcast on every change.
+    avifMutex * mutex;
+    avifCond * cond;
+    int reservedThreads;
+    avifThreadPoolTask * tasks;
+    avifBool stopping;
+};
+
+// Returns the first listed task with an index left to hand out to a worker, or NULL.
+static avifThreadPoolTask * avifThreadPoolFindTask(avifThreadPool * threadPool)
+{
+    for (avifThreadPoolTask * task = threadPool->tasks; task; task = task->next) {
+        if ((task->nextIndex < task->count) && (task->workerCount < task->maxWorkerCount)) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+// Runs the remaining indices of task; called with the mutex held, which is released around each call.
+static void avifThreadPoolWork(avifThreadPool * threadPool, avifThreadPoolTask * task)
+{
+    while (task->nextIndex < task->count) {
+        const uint32_t index = task->nextIndex++;
+        avifMutexUnlock(threadPool->mutex);
+        task->func(task->userData, index);
+        avifMutexLock(threadPool->mutex);
+        if (++task->doneCount == task->count) {
+            avifCondBroadcast(threadPool->cond);
+        }
+    }
+}
+
+static void avifThreadPoolWorkerMain(void * userData)
+{
+    avifThreadPool * threadPool = (avifThreadPool *)userData;
+    avifMutexLock(threadPool->mutex);
+    for (;;) {
+        avifThreadPoolTask * task = avifThreadPoolFindTask(threadPool);
+        if (task) {
+            ++task->workerCount;
+            avifThreadPoolWork(threadPool, task);
+            --task->workerCount;
+            avifCondBroadcast(threadPool->cond);
+        } else if (threadPool->stopping) {
+            break;
+        } else {
+            avifCondWait(threadPool->cond, threadPool->mutex);
+        }
+    }
+    avifMutexUnlock(threadPool->mutex);
+}
+
+avifThreadPool * avifThreadPoolCreate(int maxThreads)
+{
+    avifThreadPool * threadPool = (avifThreadPool *)avifAlloc(sizeof(avifThreadPool));
+    memset(threadPool, 0, sizeof(avifThreadPool));
+    threadPool->maxThreads = AVIF_MAX(maxThreads, 1);
+    threadPool->mutex = avifMutexCreate();
+    threadPool->cond = avifCondCreate();
+
+    // The threads calling avifThreadPoolRun() do their share of the work, so at most
+    // (maxThreads - 1) workers are ever needed by a reservation. Start with fewer if the system
+    // refuses; avifThreadPoolRun() still gets everything done.
+    threadPool->workers = (avifThread **)avifAlloc(sizeof(avifThread *) * threadPool->maxThreads);
+    for (int i = 0; i < threadPool->maxThreads - 1; ++i) {
+        avifThread * worker = avifThreadCreate(avifThreadPoolWorkerMain, threadPool);
+        if (!worker) {
+            break;
+        }
+        threadPool->workers[threadPool->workerCount++] = worker;
+    }
+    return threadPool;
+}
+
+void avifThreadPoolDestroy(avifThreadPool * threadPool)
+{
+    avifMutexLock(threadPool->mutex);
+    threadPool->stopping = AVIF_TRUE;
+    avifCondBroadcast(threadPool->cond);
+    avifMutexUnlock(threadPool->mutex);
+    for (int i = 0; i < threadPool->workerCount; ++i) {
+        avifThreadJoin(threadPool->workers[i]);
+    }
+    avifFree(threadPool->workers);
+    avifCondDestroy(threadPool->cond);
+    avifMutexDestroy(threadPool->mutex);
+    avifFree(threadPool);
+}
+
+int avifThreadPoolReserve(avifThreadPool * threadPool, int wanted)
+{
+    avifMutexLock(threadPool->mutex);
+    const int reserved = AVIF_CLAMP(wanted, 0, threadPool->maxThreads - threadPool->reservedThreads);
+    threadPool->reservedThreads += reserved;
+    avifMutexUnlock(threadPool->mutex);
+    return reserved;
+}
+
+void avifThreadPoolRelease(avifThreadPool * threadPool, int count)
+{
+    avifMutexLock(threadPool->mutex);
+    threadPool->reservedThreads -= count;
+    avifMutexUnlock(threadPool->mutex);
+}
+
+void avifThreadPoolRun(avifThreadPool * threadPool,
+                       uint32_t count,
+                       uint32_t maxConcurrency,
+                       avifThreadPoolTaskFunc func,
+                       void * userData)
+{
+    if (!threadPool || (count <= 1) || (maxConcurrency <= 1) || (threadPool->workerCount == 0)) {
+        for (uint32_t index = 0; index < count; ++index) {
+            func(userData, index);
+        }
+        return;
+    }
+
+    avifThreadPoolTask task;
+    memset(&task, 0, sizeof(task));
+    task.func = func;
+    task.userData = userData;
+    task.count = count;
+    task.maxWorkerCount = maxConcurrency - 1;
+
+    avifMutexLock(threadPool->mutex);
+    task.next = threadPool->tasks;
+    threadPool->tasks = &task;
+    avifCondBroadcast(threadPool->cond);
+    avifThreadPoolWork(threadPool, &task);
+
+    // Wait for the calls still running on workers, and for the workers to let go of the task
+    while ((task.doneCount < task.count) || (task.workerCount > 0)) {
+        avifCondWait(threadPool->cond, threadPool->mutex);
+    }
+    avifThreadPoolTask ** link = &threadPool->tasks;
+    while (*link != &task) {
+        link = &(*link)->next;
+    }
+    *link = task.next;
+    avifMutexUnlock(threadPool->mutex);
+}
@@ -80,6 +80,7 @@ typedef struct avifEncoderItem
     avifCodecConfigurationBox av1C;       // Harvested in avifEncoderFinish(), if encodeOutput has samples
     uint32_t cellIndex;                   // Which row-major cell index corresponds to this item. ignored on non-av01 types
     avifBool alpha;
+    const avifImage * image; // if non-NULL, this item encodes (and is described by) this image instead of a cell (thumbnails)
 
     const char * infeName;
     size_t infeNameSize;
@@ -90,8 +91,10 @@ typedef struct avifEncoderItem
     uint16_t irefToID; // if non-zero, make an iref from this id -> irefToID
     const char * irefType;
 
-    uint32_t gridCols; // if non-zero (legal range [1-256]), this is a grid item
-    uint32_t gridRows; // if non-zero (legal range [1-256]), this is a grid item
+    uint32_t gridCols;   // if non-zero (legal range [1-256]), this is a grid item
+    uint32_t gridRows;   // if non-zero (legal range [1-256]), this is a grid item
+    uint32_t gridWidth;  // output_width of a grid item, which may crop its right column of cells
+    uint32_t gridHeight; // output_height of a grid item, which may crop its bottom row of cells
 
     uint16_t dimgFromID; // if non-zero, make an iref from dimgFromID -> this id
 
@@ -116,10 +119,18 @@ typedef struct avifEncoderData
     avifEncoderItemArray items;
     avifEncoderFrameArray frames;
     avifImage * imageMetadata;
+    avifImage * thumbnail; // if non-NULL, the downscaled image encoded by the thumbnail item(s)
     uint16_t lastItemID;
     uint16_t primaryItemID;
     avifBool singleImage; // if true, the AVIF_ADD_IMAGE_FLAG_SINGLE flag was set on the first call to avifEncoderAddImage()
     avifBool alphaPresent;
+    uint32_t layerCount; // number of AV1 samples (spatial layers) per frame of each av01 item, from extraLayerCount
+    struct avifEncoderAsync * async;  // if non-NULL, frames are being encoded on a worker thread (see asyncQueueSize)
+    avifBool asyncUnavailable;        // the worker thread couldn't be started, encode on the calling thread
+    avifThreadPool * threadPool;      // the pool the av01 items are encoded on, if any,
+    int reservedThreads;              // and the threads reserved from it for them
+    avifThreadPool * ownedThreadPool; // created by avifEncoderSetupThreads() when encoder->threadPool is NULL
+    uint32_t itemConcurrency;         // number of av01 items encoded at once
 } avifEncoderData;
 
 static avifEncoderData * avifEncoderDataCreate()
@@ -169,11 +180,106 @@ static void avifEncoderDataDestroy(avifEncoderData * data)
         avifArrayDestroy(&item->mdatFixups);
     }
     avifImageDestroy(data->imageMetadata);
+    if (data->thumbnail) {
+        avifImageDestroy(data->thumbnail);
+    }
+    if (data->threadPool) {
+        avifThreadPoolRelease(data->threadPool, data->reservedThreads);
+    }
+    if (data->ownedThreadPool) {
+        avifThreadPoolDestroy(data->ownedThreadPool);
+    }
     avifArrayDestroy(&data->items);
     avifArrayDestroy(&data->frames);
     avifFree(data);
 }
 
+// Chooses the AV1 tiling of a width x height image encoded with the given number of threads (see
+// avifEncoder.autoTiling): no more tiles than threads, as one tile per thread is what parallelizes
+// best and more would only cost size, and no tile smaller than 512x512, as small tiles are
+// particularly bad for quality. Tiles are split evenly between both dimensions, favoring the
+// longer one.
+static void avifEncoderChooseTiling(int threads, uint32_t width, uint32_t height, int * tileRowsLog2, int * tileColsLog2)
+{
+    const uint64_t minTileArea = 512 * 512;
+    const uint32_t maxTiles = 64; // 2^6, the most tileRowsLog2 + tileColsLog2 are worth to the codecs
+    uint64_t tiles = (((uint64_t)width * height) + minTileArea - 1) / minTileArea;
+    tiles = AVIF_MIN(tiles, maxTiles);
+    tiles = AVIF_MIN(tiles, (uint64_t)AVIF_MAX(threads, 1));
+
+    int tilesLog2 = 0;
+    while (tiles > 1) {
+        ++tilesLog2;
+        tiles >>= 1;
+    }
+    if (width >= height) {
+        *tileRowsLog2 = tilesLog2 / 2;
+        *tileColsLog2 = tilesLog2 - *tileRowsLog2;
+    } else {
+        *tileColsLog2 = tilesLog2 / 2;
+        *tileRowsLog2 = tilesLog2 - *tileColsLog2;
+    }
+}
+
+// Creates the codec of an av01 item. Its threads and tiling are set by avifEncoderSetupThreads().
+static avifCodec * avifEncoderCreateCodec(avifEncoder * encoder)
+{
+    avifCodec * codec = avifCodecCreate(encoder->codecChoice, AVIF_CODEC_FLAG_CAN_ENCODE);
+    if (codec) {
+        codec->csOptions = encoder->csOptions;
+        codec->diag = &encoder->diag;
+    }
+    return codec;
+}
+
+// Splits the encoder's threads between its av01 items, which are encoded concurrently, and their
+// codecs, and sets the tiling of each codec. Called once all items are created.
+static void avifEncoderSetupThreads(avifEncoder * encoder, const avifImage * firstCell)
+{
+    avifEncoderData * data = encoder->data;
+    uint32_t codecCount = 0;
+    for (uint32_t itemIndex = 0; itemIndex < data->items.count; ++itemIndex) {
+        if (data->items.item[itemIndex].codec) {
+            ++codecCount;
+        }
+    }
+
+    // Without a pool to share, build one for the items to be encoded on
+    int threads = encoder->maxThreads;
+    data->threadPool = encoder->threadPool;
+    if (!data->threadPool && (encoder->maxThreads > 1) && (codecCount > 1)) {
+        data->ownedThreadPool = avifThreadPoolCreate(encoder->maxThreads);
+        data->threadPool = data->ownedThreadPool;
+    }
+    if (data->threadPool) {
+        data->reservedThreads = avifThreadPoolReserve(data->threadPool, encoder->maxThreads);
+        threads = AVIF_MAX(data->reservedThreads, 1);
+    }
+
+    data->itemConcurrency = 1;
+    int codecThreads = threads;
+    if ((threads > 1) && (codecCount > 1)) {
+        data->itemConcurrency = AVIF_MIN(codecCount, (uint32_t)threads);
+        codecThreads = threads / (int)data->itemConcurrency;
+    }
+
+    for (uint32_t itemIndex = 0; itemIndex < data->items.count; ++itemIndex) {
+        avifEncoderItem * item = &data->items.item[itemIndex];
+        avifCodec * codec = item->codec;
+        if (!codec) {
+            continue;
+        }
+        codec->maxThreads = codecThreads;
+        if (encoder->autoTiling) {
+            const avifImage * image = item->image ? item->image : firstCell;
+            avifEncoderChooseTiling(codec->maxThreads, image->width, image->height, &codec->tileRowsLog2, &codec->tileColsLog2);
+        } else {
+            codec->tileRowsLog2 = encoder->tileRowsLog2;
+            codec->tileColsLog2 = encoder->tileColsLog2;
+        }
+    }
+}
+
 static void avifEncoderItemAddMdatFixup(avifEncoderItem * item, const avifRWStream * s)
 {
     avifOffsetFixup * fixup = (avifOffsetFixup *)avifArrayPushPtr(&item->mdatFixups);
@@ -182,6 +288,8 @@ static void avifEncoderItemAddMdatFixup(avifEncoderItem * item, const avifRWStre
 
 // ---------------------------------------------------------------------------
 
+static avifResult avifEncoderStopAsync(avifEncoderData * data, avifBool discard);
+
 avifEncoder * avifEncoderCreate(void)
 {
     avifEncoder * encoder = (avifEncoder *)avifAlloc(sizeof(avifEncoder));
@@ -193,6 +301,7 @@ avifEncoder * avifEncoderCreate(void)
     encoder->maxQuantizerAlpha = AVIF_QUANTIZER_LOSSLESS;
     encoder->tileRowsLog2 = 0;
     encoder->tileColsLog2 = 0;
+    encoder->autoTiling = AVIF_FALSE;
     encoder->speed = AVIF_SPEED_DEFAULT;
     encoder->keyframeInterval = 0;
     encoder->timescale = 1;
@@ -203,6 +312,7 @@ avifEncoder * avifEncoderCreate(void)
 
 void avifEncoderDestroy(avifEncoder * encoder)
 {
+    avifEncoderStopAsync(encoder->data, AVIF_TRUE);
     avifCodecSpecificOptionsDestroy(encoder->csOptions);
     avifEncoderDataDestroy(encoder->data);
     avifFree(encoder);
@@ -357,7 +467,7 @@ static void avifEncoderWriteTrackMetaBox(avifEncoder * encoder, avifRWStream * s
     avifRWStreamFinishBox(s, meta);
 }
 
-static void avifWriteGridPayload(avifRWData * data, uint32_t gridCols, uint32_t gridRows, const avifImage * firstCell)
+static void avifWriteGridPayload(avifRWData * data, uint32_t gridCols, uint32_t gridRows, uint32_t gridWidth, uint32_t gridHeight)
 {
     // ISO/IEC 23008-12 6.6.2.3.2
     // aligned(8) class ImageGrid {
@@ -370,8 +480,6 @@ static void avifWriteGridPayload(avifRWData * data, uint32_t gridCols, uint32_t
     //     unsigned int(FieldLength) output_height;
     // }
 
-    uint32_t gridWidth = firstCell->width * gridCols;
-    uint32_t gridHeight = firstCell->height * gridRows;
     uint8_t gridFlags = ((gridWidth > 65535) || (gridHeight > 65535)) ? 1 : 0;
 
     avifRWStream s;
@@ -392,10 +500,217 @@ static void avifWriteGridPayload(avifRWData * data, uint32_t gridCols, uint32_t
     avifRWStreamFinishWrite(&s);
 }
 
+// Box-filters one plane of the (possibly gridded) srcWidth x srcHeight source image down into the
+// same plane of thumbnail. Pass channel -1 for the alpha plane.
+static void avifThumbnailScalePlane(avifImage * thumbnail,
+                                    int channel,
+                                    uint32_t dstWidth,
+                                    uint32_t dstHeight,
+                                    uint32_t gridCols,
+                                    const avifImage * const * cellImages,
+                                    uint32_t cellPlaneWidth,
+                                    uint32_t cellPlaneHeight,
+                                    uint32_t srcWidth,
+                                    uint32_t srcHeight)
+{
+    const avifBool usesU16 = avifImageUsesU16(thumbnail);
+    uint8_t * dstPlane = (channel < 0) ? thumbnail->alphaPlane : thumbnail->yuvPlanes[channel];
+    const uint32_t dstRowBytes = (channel < 0) ? thumbnail->alphaRowBytes : thumbnail->yuvRowBytes[channel];
+
+    for (uint32_t dstY = 0; dstY < dstHeight; ++dstY) {
+        const uint32_t srcY0 = (uint32_t)(((uint64_t)dstY * srcHeight) / dstHeight);
+        const uint32_t srcY1 = AVIF_MAX(srcY0 + 1, (uint32_t)(((uint64_t)(dstY + 1) * srcHeight) / dstHeight));
+        uint8_t * dstRow = &dstPlane[(size_t)dstY * dstRowBytes];
+        for (uint32_t dstX = 0; dstX < dstWidth; ++dstX) {
+            const uint32_t srcX0 = (uint32_t)(((uint64_t)dstX * srcWidth) / dstWidth);
+            const uint32_t srcX1 = AVIF_MAX(srcX0 + 1, (uint32_t)(((uint64_t)(dstX + 1) * srcWidth) / dstWidth));
+
+            uint64_t sum = 0;
+            for (uint32_t srcY = srcY0; srcY < srcY1; ++srcY) {
+                const uint32_t cellRow = srcY / cellPlaneHeight;
+                const uint32_t cellY = srcY % cellPlaneHeight;
+                for (uint32_t srcX = srcX0; srcX < srcX1; ++srcX) {
+                    const avifImage * cell = cellImages[cellRow * gridCols + (srcX / cellPlaneWidth)];
+                    const uint8_t * srcPlane = (channel < 0) ? cell->alphaPlane : cell->yuvPlanes[channel];
+                    const uint32_t srcRowBytes = (channel < 0) ? cell->alphaRowBytes : cell->yuvRowBytes[channel];
+                    const uint8_t * srcRow = &srcPlane[(size_t)cellY * srcRowBytes];
+                    const uint32_t cellX = srcX % cellPlaneWidth;
+                    sum += usesU16 ? ((const uint16_t *)srcRow)[cellX] : srcRow[cellX];
+                }
+            }
+            const uint64_t count = (uint64_t)(srcY1 - srcY0) * (srcX1 - srcX0);
+            const uint64_t average = (sum + (count / 2)) / count;
+            if (usesU16) {
+                ((uint16_t *)dstRow)[dstX] = (uint16_t)average;
+            } else {
+                dstRow[dstX] = (uint8_t)average;
+            }
+        }
+    }
+}
+
+// Returns a downscaled copy of the (possibly gridded) fullWidth x fullHeight image whose longest
+// side is maxDimension, or NULL if the image is already no larger than that.
+static avifImage * avifImageCreateThumbnail(uint32_t gridCols,
+                                            const avifImage * const * cellImages,
+                                            uint32_t fullWidth,
+                                            uint32_t fullHeight,
+                                            avifBool alpha,
+                                            uint32_t maxDimension)
+{
+    const avifImage * firstCell = cellImages[0];
+    const uint32_t longestSide = AVIF_MAX(fullWidth, fullHeight);
+    if (longestSide <= maxDimension) {
+        return NULL;
+    }
+
+    avifImage * thumbnail = avifImageCreateEmpty();
+    avifImageCopy(thumbnail, firstCell, 0);
+    thumbnail->width = AVIF_MAX(1, (uint32_t)(((uint64_t)fullWidth * maxDimension) / longestSide));
+    thumbnail->height = AVIF_MAX(1, (uint32_t)(((uint64_t)fullHeight * maxDimension) / longestSide));
+    // The clean aperture is expressed in full size pixels, and Exif/XMP are only stored for the primary item
+    thumbnail->transformFlags &= ~AVIF_TRANSFORM_CLAP;
+    avifImageSetMetadataExif(thumbnail, NULL, 0);
+    avifImageSetMetadataXMP(thumbnail, NULL, 0);
+    avifImageAllocatePlanes(thumbnail, alpha ? AVIF_PLANES_ALL : AVIF_PLANES_YUV);
+
+    avifThumbnailScalePlane(thumbnail,
+                            AVIF_CHAN_Y,
+                            thumbnail->width,
+                            thumbnail->height,
+                            gridCols,
+                            cellImages,
+                            firstCell->width,
+                            firstCell->height,
+                            fullWidth,
+                            fullHeight);
+    if (thumbnail->yuvFormat != AVIF_PIXEL_FORMAT_YUV400) {
+        avifPixelFormatInfo formatInfo;
+        avifGetPixelFormatInfo(thumbnail->yuvFormat, &formatInfo);
+        const uint32_t uvWidth = (thumbnail->width + formatInfo.chromaShiftX) >> formatInfo.chromaShiftX;
+        const uint32_t uvHeight = (thumbnail->height + formatInfo.chromaShiftY) >> formatInfo.chromaShiftY;
+        const uint32_t cellUVWidth = (firstCell->width + formatInfo.chromaShiftX) >> formatInfo.chromaShiftX;
+        const uint32_t cellUVHeight = (firstCell->height + formatInfo.chromaShiftY) >> formatInfo.chromaShiftY;
+        const uint32_t fullUVWidth = (fullWidth + formatInfo.chromaShiftX) >> formatInfo.chromaShiftX;
+        const uint32_t fullUVHeight = (fullHeight + formatInfo.chromaShiftY) >> formatInfo.chromaShiftY;
+        for (int channel = AVIF_CHAN_U; channel <= AVIF_CHAN_V; ++channel) {
+            avifThumbnailScalePlane(thumbnail,
+                                    channel,
+                                    uvWidth,
+                                    uvHeight,
+                                    gridCols,
+                                    cellImages,
+                                    cellUVWidth,
+                                    cellUVHeight,
+                                    fullUVWidth,
+                                    fullUVHeight);
+        }
+    }
+    if (alpha) {
+        avifThumbnailScalePlane(thumbnail,
+                                -1,
+                                thumbnail->width,
+                                thumbnail->height,
+                                gridCols,
+                                cellImages,
+                                firstCell->width,
+                                firstCell->height,
+                                fullWidth,
+                                fullHeight);
+    }
+    return thumbnail;
+}
+
+// Encodes the frame made of cellImages with the codec of item
+static avifResult avifEncoderEncodeItem(avifEncoder * encoder,
+                                        avifEncoderItem * item,
+                                        const avifImage * const * cellImages,
+                                        avifAddImageFlags addImageFlags)
+{
+    const avifImage * cellImage = item->image ? item->image : cellImages[item->cellIndex];
+    avifResult encodeResult =
+        item->codec->encodeImage(item->codec, encoder, cellImage, item->alpha, addImageFlags, item->encodeOutput);
+    if (encodeResult == AVIF_RESULT_UNKNOWN_ERROR) {
+        encodeResult = item->alpha ? AVIF_RESULT_ENCODE_ALPHA_FAILED : AVIF_RESULT_ENCODE_COLOR_FAILED;
+    }
+    return encodeResult;
+}
+
+typedef struct avifEncoderItemsTask
+{
+    avifEncoder * encoder;
+    const avifImage * const * cellImages;
+    avifAddImageFlags addImageFlags;
+    avifResult * results;    // one per item
+    avifDiagnostics * diags; // one per item, as the codecs can't share encoder->diag while running concurrently
+} avifEncoderItemsTask;
+
+static void avifEncoderEncodeItemTask(void * userData, uint32_t itemIndex)
+{
+    avifEncoderItemsTask * task = (avifEncoderItemsTask *)userData;
+    avifEncoderItem * item = &task->encoder->data->items.item[itemIndex];
+    task->results[itemIndex] = AVIF_RESULT_OK;
+    if (item->codec) {
+        item->codec->diag = &task->diags[itemIndex];
+        task->results[itemIndex] = avifEncoderEncodeItem(task->encoder, item, task->cellImages, task->addImageFlags);
+        item->codec->diag = &task->encoder->diag;
+    }
+}
+
+// Encodes the frame made of cellImages with the codec of every av01 item, itemConcurrency at a time
+static avifResult avifEncoderEncodeItems(avifEncoder * encoder,
+                                         const avifImage * const * cellImages,
+                                         avifAddImageFlags addImageFlags)
+{
+    avifEncoderData * data = encoder->data;
+    if (data->itemConcurrency <= 1) {
+        for (uint32_t itemIndex = 0; itemIndex < data->items.count; ++itemIndex) {
+            avifEncoderItem * item = &data->items.item[itemIndex];
+            if (item->codec) {
+                const avifResult encodeResult = avifEncoderEncodeItem(encoder, item, cellImages, addImageFlags);
+                if (encodeResult != AVIF_RESULT_OK) {
+                    return encodeResult;
+                }
+            }
+        }
+        return AVIF_RESULT_OK;
+    }
+
+    avifEncoderItemsTask task;
+    task.encoder = encoder;
+    task.cellImages = cellImages;
+    task.addImageFlags = addImageFlags;
+    task.results = (avifResult *)avifAlloc(sizeof(avifResult) * data->items.count);
+    task.diags = (avifDiagnostics *)avifAlloc(sizeof(avifDiagnostics) * data->items.count);
+    for (uint32_t itemIndex = 0; itemIndex < data->items.count; ++itemIndex) {
+        avifDiagnosticsClearError(&task.diags[itemIndex]);
+    }
+    avifThreadPoolRun(data->threadPool, data->items.count, data->itemConcurrency, avifEncoderEncodeItemTask, &task);
+
+    // Report the error of the first item that failed, as encoding them one after the other would
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t itemIndex = 0; itemIndex < data->items.count; ++itemIndex) {
+        if (task.results[itemIndex] != AVIF_RESULT_OK) {
+            result = task.results[itemIndex];
+            if (task.diags[itemIndex].error[0] != '\0') {
+                avifDiagnosticsPrintf(&encoder->diag, "%s", task.diags[itemIndex].error);
+            }
+            break;
+        }
+    }
+    avifFree(task.diags);
+    avifFree(task.results);
+    return result;
+}
+
+// gridWidth x gridHeight is the size of the image made of the cells, which may crop the right column
+// and bottom row of cells.
 static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
                                               uint32_t gridCols,
                                               uint32_t gridRows,
                                               const avifImage * const * cellImages,
+                                              uint32_t gridWidth,
+                                              uint32_t gridHeight,
                                               uint64_t durationInTimescales,
                                               avifAddImageFlags addImageFlags)
 {
@@ -462,6 +777,17 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
         }
     }
 
+    if ((encoder->extraLayerCount < 0) || (encoder->extraLayerCount > 3)) {
+        avifDiagnosticsPrintf(&encoder->diag, "extraLayerCount [%d] must be in the range [0-3]", encoder->extraLayerCount);
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+    if ((encoder->extraLayerCount > 0) && (!(addImageFlags & AVIF_ADD_IMAGE_FLAG_SINGLE) || (cellCount > 1))) {
+        // Layers are stored as the extents of a single item; sequences and grids have no room for them.
+        avifDiagnosticsPrintf(&encoder->diag, "Layered images must be single, non-grid images");
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+    encoder->data->layerCount = (uint32_t)encoder->extraLayerCount + 1;
+
     // -----------------------------------------------------------------------
 
     if (durationInTimescales == 0) {
@@ -477,9 +803,11 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
         uint16_t gridColorID = 0;
         if (cellCount > 1) {
             avifEncoderItem * gridColorItem = avifEncoderDataCreateItem(encoder->data, "grid", "Color", 6, 0);
-            avifWriteGridPayload(&gridColorItem->metadataPayload, gridCols, gridRows, firstCell);
+            avifWriteGridPayload(&gridColorItem->metadataPayload, gridCols, gridRows, gridWidth, gridHeight);
             gridColorItem->gridCols = gridCols;
             gridColorItem->gridRows = gridRows;
+            gridColorItem->gridWidth = gridWidth;
+            gridColorItem->gridHeight = gridHeight;
 
             gridColorID = gridColorItem->id;
             encoder->data->primaryItemID = gridColorID;
@@ -487,13 +815,11 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
 
         for (uint32_t cellIndex = 0; cellIndex < cellCount; ++cellIndex) {
             avifEncoderItem * item = avifEncoderDataCreateItem(encoder->data, "av01", "Color", 6, cellIndex);
-            item->codec = avifCodecCreate(encoder->codecChoice, AVIF_CODEC_FLAG_CAN_ENCODE);
+            item->codec = avifEncoderCreateCodec(encoder);
             if (!item->codec) {
                 // Just bail out early, we're not surviving this function without an encoder compiled in
                 return AVIF_RESULT_NO_CODEC_AVAILABLE;
             }
-            item->codec->csOptions = encoder->csOptions;
-            item->codec->diag = &encoder->diag;
 
             if (cellCount > 1) {
                 item->dimgFromID = gridColorID;
@@ -527,12 +853,14 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
             uint16_t gridAlphaID = 0;
             if (cellCount > 1) {
                 avifEncoderItem * gridAlphaItem = avifEncoderDataCreateItem(encoder->data, "grid", "Alpha", 6, 0);
-                avifWriteGridPayload(&gridAlphaItem->metadataPayload, gridCols, gridRows, firstCell);
+                avifWriteGridPayload(&gridAlphaItem->metadataPayload, gridCols, gridRows, gridWidth, gridHeight);
                 gridAlphaItem->alpha = AVIF_TRUE;
                 gridAlphaItem->irefToID = encoder->data->primaryItemID;
                 gridAlphaItem->irefType = "auxl";
                 gridAlphaItem->gridCols = gridCols;
                 gridAlphaItem->gridRows = gridRows;
+                gridAlphaItem->gridWidth = gridWidth;
+                gridAlphaItem->gridHeight = gridHeight;
                 gridAlphaID = gridAlphaItem->id;
 
                 if (encoder->data->imageMetadata->alphaPremultiplied) {
@@ -545,12 +873,10 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
 
             for (uint32_t cellIndex = 0; cellIndex < cellCount; ++cellIndex) {
                 avifEncoderItem * item = avifEncoderDataCreateItem(encoder->data, "av01", "Alpha", 6, cellIndex);
-                item->codec = avifCodecCreate(encoder->codecChoice, AVIF_CODEC_FLAG_CAN_ENCODE);
+                item->codec = avifEncoderCreateCodec(encoder);
                 if (!item->codec) {
                     return AVIF_RESULT_NO_CODEC_AVAILABLE;
                 }
-                item->codec->csOptions = encoder->csOptions;
-                item->codec->diag = &encoder->diag;
                 item->alpha = AVIF_TRUE;
 
                 if (cellCount > 1) {
@@ -569,6 +895,46 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
             }
         }
 
+        // -----------------------------------------------------------------------
+        // Create thumbnail items, if requested
+
+        // Thumbnails are only written for single images. Premultiplied alpha is skipped, as the
+        // thumbnail item's only iref slot is taken by its 'thmb' reference and 'prem' wouldn't fit.
+        if ((encoder->thumbnailSize > 0) && (addImageFlags & AVIF_ADD_IMAGE_FLAG_SINGLE) &&
+            !(encoder->data->alphaPresent && encoder->data->imageMetadata->alphaPremultiplied)) {
+            encoder->data->thumbnail = avifImageCreateThumbnail(gridCols,
+                                                                cellImages,
+                                                                gridWidth,
+                                                                gridHeight,
+                                                                encoder->data->alphaPresent,
+                                                                encoder->thumbnailSize);
+        }
+        if (encoder->data->thumbnail) {
+            avifEncoderItem * thumbnailItem = avifEncoderDataCreateItem(encoder->data, "av01", "Thumbnail", 10, 0);
+            thumbnailItem->codec = avifEncoderCreateCodec(encoder);
+            if (!thumbnailItem->codec) {
+                return AVIF_RESULT_NO_CODEC_AVAILABLE;
+            }
+            thumbnailItem->image = encoder->data->thumbnail;
+            thumbnailItem->irefToID = encoder->data->primaryItemID;
+            thumbnailItem->irefType = "thmb";
+
+            if (encoder->data->alphaPresent) {
+                const uint16_t thumbnailID = thumbnailItem->id; // thumbnailItem is invalidated by the next push
+                avifEncoderItem * item = avifEncoderDataCreateItem(encoder->data, "av01", "Alpha", 6, 0);
+                item->codec = avifEncoderCreateCodec(encoder);
+                if (!item->codec) {
+                    return AVIF_RESULT_NO_CODEC_AVAILABLE;
+                }
+                item->alpha = AVIF_TRUE;
+                item->image = encoder->data->thumbnail;
+                item->irefToID = thumbnailID;
+                item->irefType = "auxl";
+            }
+        }
+
+        avifEncoderSetupThreads(encoder, firstCell);
+
         // -----------------------------------------------------------------------
         // Create metadata items (Exif, XMP)
 
@@ -632,19 +998,9 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
         addImageFlags |= AVIF_ADD_IMAGE_FLAG_FORCE_KEYFRAME;
     }
 
-    for (uint32_t itemIndex = 0; itemIndex < encoder->data->items.count; ++itemIndex) {
-        avifEncoderItem * item = &encoder->data->items.item[itemIndex];
-        if (item->codec) {
-            const avifImage * cellImage = cellImages[item->cellIndex];
-            avifResult encodeResult =
-                item->codec->encodeImage(item->codec, encoder, cellImage, item->alpha, addImageFlags, item->encodeOutput);
-            if (encodeResult == AVIF_RESULT_UNKNOWN_ERROR) {
-                encodeResult = item->alpha ? AVIF_RESULT_ENCODE_ALPHA_FAILED : AVIF_RESULT_ENCODE_COLOR_FAILED;
-            }
-            if (encodeResult != AVIF_RESULT_OK) {
-                return encodeResult;
-            }
-        }
+    const avifResult encodeResult = avifEncoderEncodeItems(encoder, cellImages, addImageFlags);
+    if (encodeResult != AVIF_RESULT_OK) {
+        return encodeResult;
     }
 
     avifEncoderFrame * frame = (avifEncoderFrame *)avifArrayPushPtr(&encoder->data->frames);
@@ -652,10 +1008,371 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
     return AVIF_RESULT_OK;
 }
 
+// ---------------------------------------------------------------------------
+// Asynchronous encoding (avifEncoder.asyncQueueSize)
+
+typedef struct avifEncoderQueuedFrame
+{
+    avifImage * image; // owned copy of the image given to avifEncoderAddImage()
+    uint64_t durationInTimescales;
+    avifAddImageFlags addImageFlags;
+} avifEncoderQueuedFrame;
+
+typedef struct avifEncoderAsync
+{
+    avifEncoder * encoder;
+    avifThread * thread;
+    avifMutex * mutex;
+    avifCond * cond; // broadcast whenever a frame is queued or dequeued, or the worker is asked to stop
+
+    // Ring buffer of frames waiting to be encoded
+    avifEncoderQueuedFrame * queue;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+
+    avifBool stopping; // the worker returns once the queue is empty
+    avifBool discard;  // dequeued frames are dropped instead of encoded
+    avifResult result; // the first error returned by avifEncoderAddImageInternal() on the worker
+} avifEncoderAsync;
+
+static void avifEncoderAsyncMain(void * userData)
+{
+    avifEncoderAsync * async = (avifEncoderAsync *)userData;
+    avifMutexLock(async->mutex);
+    for (;;) {
+        while ((async->count == 0) && !async->stopping) {
+            avifCondWait(async->cond, async->mutex);
+        }
+        if (async->count == 0) {
+            break;
+        }
+        const avifEncoderQueuedFrame frame = async->queue[async->head];
+        async->head = (async->head + 1) % async->capacity;
+        --async->count;
+        const avifBool encode = (async->result == AVIF_RESULT_OK) && !async->discard;
+        avifCondBroadcast(async->cond);
+        avifMutexUnlock(async->mutex);
+
+        // Once a frame fails, the rest of the queue is dropped; the encode can't be finished anyway.
+        avifResult result = AVIF_RESULT_OK;
+        if (encode) {
+            avifEncoder * encoder = async->encoder;
+            avifDiagnosticsClearError(&encoder->diag);
+            result = avifEncoderAddImageInternal(encoder,
+                                                 1,
+                                                 1,
+                                                 (const avifImage * const *)&frame.image,
+                                                 frame.image->width,
+                                                 frame.image->height,
+                                                 frame.durationInTimescales,
+                                                 frame.addImageFlags);
+        }
+        avifImageDestroy(frame.image);
+
+        avifMutexLock(async->mutex);
+        if (async->result == AVIF_RESULT_OK) {
+            async->result = result;
+        }
+    }
+    avifMutexUnlock(async->mutex);
+}
+
+static avifBool avifEncoderStartAsync(avifEncoder * encoder)
+{
+    avifEncoderAsync * async = (avifEncoderAsync *)avifAlloc(sizeof(avifEncoderAsync));
+    memset(async, 0, sizeof(avifEncoderAsync));
+    async->encoder = encoder;
+    async->mutex = avifMutexCreate();
+    async->cond = avifCondCreate();
+    async->capacity = encoder->asyncQueueSize;
+    async->queue = (avifEncoderQueuedFrame *)avifAlloc(sizeof(avifEncoderQueuedFrame) * async->capacity);
+    async->result = AVIF_RESULT_OK;
+    async->thread = avifThreadCreate(avifEncoderAsyncMain, async);
+    if (!async->thread) {
+        avifFree(async->queue);
+        avifCondDestroy(async->cond);
+        avifMutexDestroy(async->mutex);
+        avifFree(async);
+        return AVIF_FALSE;
+    }
+    encoder->data->async = async;
+    return AVIF_TRUE;
+}
+
+// Waits for the worker thread to go through the queue (encoding the frames, unless discard is set)
+// and shuts it down. Returns the first error the worker ran into, if any.
+static avifResult avifEncoderStopAsync(avifEncoderData * data, avifBool discard)
+{
+    avifEncoderAsync * async = data->async;
+    if (!async) {
+        return AVIF_RESULT_OK;
+    }
+    avifMutexLock(async->mutex);
+    async->stopping = AVIF_TRUE;
+    async->discard = discard;
+    avifCondBroadcast(async->cond);
+    avifMutexUnlock(async->mutex);
+    avifThreadJoin(async->thread);
+
+    const avifResult result = async->result;
+    avifFree(async->queue);
+    avifCondDestroy(async->cond);
+    avifMutexDestroy(async->mutex);
+    avifFree(async);
+    data->async = NULL;
+    return result;
+}
+
+static avifResult avifEncoderQueueImage(avifEncoder * encoder,
+                                        const avifImage * image,
+                                        uint64_t durationInTimescales,
+                                        avifAddImageFlags addImageFlags)
+{
+    avifEncoderData * data = encoder->data;
+    if (!data->async && (data->asyncUnavailable || !avifEncoderStartAsync(encoder))) {
+        data->asyncUnavailable = AVIF_TRUE;
+        avifDiagnosticsClearError(&encoder->diag);
+        return avifEncoderAddImageInternal(encoder,
+                                           1,
+                                           1,
+                                           &image,
+                                           image->width,
+                                           image->height,
+                                           durationInTimescales,
+                                           addImageFlags);
+    }
+
+    // Copy outside of the lock so that it overlaps with the encoding of the previous frames
+    avifImage * copy = avifImageCreateEmpty();
+    avifImageCopy(copy, image, AVIF_PLANES_ALL);
+
+    avifEncoderAsync * async = data->async;
+    avifMutexLock(async->mutex);
+    while ((async->count == async->capacity) && (async->result == AVIF_RESULT_OK)) {
+        avifCondWait(async->cond, async->mutex);
+    }
+    const avifResult result = async->result;
+    if (result == AVIF_RESULT_OK) {
+        avifEncoderQueuedFrame * frame = &async->queue[(async->head + async->count) % async->capacity];
+        frame->image = copy;
+        frame->durationInTimescales = durationInTimescales;
+        frame->addImageFlags = addImageFlags;
+        ++async->count;
+        avifCondBroadcast(async->cond);
+    }
+    avifMutexUnlock(async->mutex);
+
+    if (result != AVIF_RESULT_OK) {
+        avifImageDestroy(copy);
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Automatic grids (avifEncoder.gridCellSize)
+
+// Returns the largest cells single images are split into, or 0 if they are not split
+static uint32_t avifEncoderMaxGridCellSize(const avifEncoder * encoder, const avifImage * image)
+{
+    if (encoder->extraLayerCount > 0) {
+        return 0; // layered images can't be grids
+    }
+    if (encoder->gridCellSize > 0) {
+        return AVIF_MAX(encoder->gridCellSize, 128);
+    }
+    // AV1 level 6.3 (MaxPicSize, MaxHSize, MaxVSize), the largest frames AV1 decoders are expected to handle
+    if (encoder->autoTiling &&
+        ((image->width > 16384) || (image->height > 8704) || (((uint64_t)image->width * image->height) > 35651584))) {
+        return 4096;
+    }
+    return 0;
+}
+
+// Splits size pixels into *cellCount cells of *cellSize pixels, each no larger than maxCellSize, at
+// least 64 pixels and a multiple of step, as image grids require. An even split is preferred;
+// otherwise the last cell runs past the image and is cropped by the grid. Returns AVIF_FALSE if
+// there is no such split into at most 256 cells.
+static avifBool avifEncoderChooseGridSplit(uint32_t size,
+                                           uint32_t maxCellSize,
+                                           uint32_t step,
+                                           uint32_t * cellCount,
+                                           uint32_t * cellSize)
+{
+    maxCellSize -= maxCellSize % step;
+    const uint32_t minCount = (size + maxCellSize - 1) / maxCellSize;
+    if ((minCount == 0) || (minCount > 256)) {
+        return AVIF_FALSE;
+    }
+    for (uint32_t count = minCount; (count <= 256) && (count <= minCount * 2) && ((size / count) >= 64); ++count) {
+        if (((size % count) == 0) && (((size / count) % step) == 0)) {
+            *cellCount = count;
+            *cellSize = size / count;
+            return AVIF_TRUE;
+        }
+    }
+    uint32_t paddedSize = (size + minCount - 1) / minCount;
+    paddedSize += (step - (paddedSize % step)) % step;
+    if ((paddedSize < 64) || (((minCount - 1) * paddedSize) >= size)) {
+        return AVIF_FALSE;
+    }
+    *cellCount = minCount;
+    *cellSize = paddedSize;
+    return AVIF_TRUE;
+}
+
+// Copies the width x height plane at src into the dstWidth x dstHeight plane at dst, repeating its
+// last column and row over the rest
+static void avifPadPlane(uint8_t * dst,
+                         uint32_t dstRowBytes,
+                         uint32_t dstWidth,
+                         uint32_t dstHeight,
+                         const uint8_t * src,
+                         uint32_t srcRowBytes,
+                         uint32_t width,
+                         uint32_t height,
+                         uint32_t pixelBytes)
+{
+    for (uint32_t y = 0; y < dstHeight; ++y) {
+        const uint8_t * srcRow = &src[(size_t)AVIF_MIN(y, height - 1) * srcRowBytes];
+        uint8_t * dstRow = &dst[(size_t)y * dstRowBytes];
+        memcpy(dstRow, srcRow, (size_t)width * pixelBytes);
+        for (uint32_t x = width; x < dstWidth; ++x) {
+            memcpy(&dstRow[x * pixelBytes], &srcRow[(width - 1) * pixelBytes], pixelBytes);
+        }
+    }
+}
+
+// Returns a copy of the cellWidth x cellHeight cell of image at (x, y), which runs past the right or
+// bottom edge of image, padded with the edge pixels
+static avifImage * avifImageCreatePaddedCell(const avifImage * image,
+                                             uint32_t x,
+                                             uint32_t y,
+                                             uint32_t cellWidth,
+                                             uint32_t cellHeight)
+{
+    avifImage view;
+    avifImageSetView(&view, image, x, y, AVIF_MIN(cellWidth, image->width - x), AVIF_MIN(cellHeight, image->height - y));
+
+    avifImage * cell = avifImageCreateEmpty();
+    avifImageCopy(cell, &view, 0);
+    cell->width = cellWidth;
+    cell->height = cellHeight;
+    avifImageAllocatePlanes(cell, view.alphaPlane ? AVIF_PLANES_ALL : AVIF_PLANES_YUV);
+
+    const uint32_t pixelBytes = avifImageUsesU16(image) ? 2 : 1;
+    avifPixelFormatInfo formatInfo;
+    avifGetPixelFormatInfo(image->yuvFormat, &formatInfo);
+    for (int yuvPlane = 0; yuvPlane < 3; ++yuvPlane) {
+        if (!view.yuvPlanes[yuvPlane]) {
+            continue;
+        }
+        const uint32_t shiftX = (yuvPlane == AVIF_CHAN_Y) ? 0 : formatInfo.chromaShiftX;
+        const uint32_t shiftY = (yuvPlane == AVIF_CHAN_Y) ? 0 : formatInfo.chromaShiftY;
+        avifPadPlane(cell->yuvPlanes[yuvPlane],
+                     cell->yuvRowBytes[yuvPlane],
+                     (cell->width + shiftX) >> shiftX,
+                     (cell->height + shiftY) >> shiftY,
+                     view.yuvPlanes[yuvPlane],
+                     view.yuvRowBytes[yuvPlane],
+                     (view.width + shiftX) >> shiftX,
+                     (view.height + shiftY) >> shiftY,
+                     pixelBytes);
+    }
+    if (view.alphaPlane) {
+        avifPadPlane(cell->alphaPlane,
+                     cell->alphaRowBytes,
+                     cell->width,
+                     cell->height,
+                     view.alphaPlane,
+                     view.alphaRowBytes,
+                     view.width,
+                     view.height,
+                     pixelBytes);
+    }
+    return cell;
+}
+
+// Encodes a single image, as a grid of cells if it is larger than avifEncoderMaxGridCellSize().
+// The cells are views into image, except for the padded ones past its right and bottom edges.
+static avifResult avifEncoderAddSingleImage(avifEncoder * encoder,
+                                            const avifImage * image,
+                                            uint64_t durationInTimescales,
+                                            avifAddImageFlags addImageFlags)
+{
+    const uint32_t maxCellSize = avifEncoderMaxGridCellSize(encoder, image);
+    avifPixelFormatInfo formatInfo;
+    avifGetPixelFormatInfo(image->yuvFormat, &formatInfo);
+    const uint32_t stepX = formatInfo.monochrome ? 1 : (1 << formatInfo.chromaShiftX);
+    const uint32_t stepY = formatInfo.monochrome ? 1 : (1 << formatInfo.chromaShiftY);
+    uint32_t gridCols, gridRows, cellWidth, cellHeight;
+    if ((maxCellSize == 0) || ((image->width <= maxCellSize) && (image->height <= maxCellSize)) ||
+        (image->yuvFormat == AVIF_PIXEL_FORMAT_NONE) || !image->yuvPlanes[AVIF_CHAN_Y] || ((image->width % stepX) != 0) ||
+        ((image->height % stepY) != 0) || !avifEncoderChooseGridSplit(image->width, maxCellSize, stepX, &gridCols, &cellWidth) ||
+        !avifEncoderChooseGridSplit(image->height, maxCellSize, stepY, &gridRows, &cellHeight)) {
+        return avifEncoderAddImageInternal(encoder,
+                                           1,
+                                           1,
+                                           &image,
+                                           image->width,
+                                           image->height,
+                                           durationInTimescales,
+                                           addImageFlags);
+    }
+
+    const uint32_t cellCount = gridCols * gridRows;
+    avifImage * views = (avifImage *)avifAlloc(sizeof(avifImage) * cellCount);
+    avifImage ** paddedCells = (avifImage **)avifAlloc(sizeof(avifImage *) * cellCount);
+    const avifImage ** cellImages = (const avifImage **)avifAlloc(sizeof(avifImage *) * cellCount);
+    for (uint32_t cellIndex = 0; cellIndex < cellCount; ++cellIndex) {
+        const uint32_t x = (cellIndex % gridCols) * cellWidth;
+        const uint32_t y = (cellIndex / gridCols) * cellHeight;
+        paddedCells[cellIndex] = NULL;
+        if (((x + cellWidth) > image->width) || ((y + cellHeight) > image->height)) {
+            paddedCells[cellIndex] = avifImageCreatePaddedCell(image, x, y, cellWidth, cellHeight);
+            cellImages[cellIndex] = paddedCells[cellIndex];
+        } else {
+            avifImageSetView(&views[cellIndex], image, x, y, cellWidth, cellHeight);
+            cellImages[cellIndex] = &views[cellIndex];
+        }
+    }
+
+    const avifResult result = avifEncoderAddImageInternal(encoder,
+                                                          gridCols,
+                                                          gridRows,
+                                                          cellImages,
+                                                          image->width,
+                                                          image->height,
+                                                          durationInTimescales,
+                                                          addImageFlags);
+
+    for (uint32_t cellIndex = 0; cellIndex < cellCount; ++cellIndex) {
+        if (paddedCells[cellIndex]) {
+            avifImageDestroy(paddedCells[cellIndex]);
+        }
+    }
+    avifFree(cellImages);
+    avifFree(paddedCells);
+    avifFree(views);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+
 avifResult avifEncoderAddImage(avifEncoder * encoder, const avifImage * image, uint64_t durationInTimescales, avifAddImageFlags addImageFlags)
 {
+    if ((encoder->asyncQueueSize > 0) && !(addImageFlags & AVIF_ADD_IMAGE_FLAG_SINGLE)) {
+        return avifEncoderQueueImage(encoder, image, durationInTimescales, addImageFlags);
+    }
+    const avifResult asyncResult = avifEncoderStopAsync(encoder->data, AVIF_FALSE);
+    if (asyncResult != AVIF_RESULT_OK) {
+        return asyncResult;
+    }
     avifDiagnosticsClearError(&encoder->diag);
-    return avifEncoderAddImageInternal(encoder, 1, 1, &image, durationInTimescales, addImageFlags);
+    if (addImageFlags & AVIF_ADD_IMAGE_FLAG_SINGLE) {
+        return avifEncoderAddSingleImage(encoder, image, durationInTimescales, addImageFlags);
+    }
+    return avifEncoderAddImageInternal(encoder, 1, 1, &image, image->width, image->height, durationInTimescales, addImageFlags);
 }
 
 avifResult avifEncoderAddImageGrid(avifEncoder * encoder,
@@ -664,11 +1381,24 @@ avifResult avifEncoderAddImageGrid(avifEncoder * encoder,
                                    const avifImage * const * cellImages,
                                    avifAddImageFlags addImageFlags)
 {
+    const avifResult asyncResult = avifEncoderStopAsync(encoder->data, AVIF_FALSE);
+    if (asyncResult != AVIF_RESULT_OK) {
+        return asyncResult;
+    }
     avifDiagnosticsClearError(&encoder->diag);
     if ((gridCols == 0) || (gridCols > 256) || (gridRows == 0) || (gridRows > 256)) {
         return AVIF_RESULT_INVALID_IMAGE_GRID;
     }
-    return avifEncoderAddImageInternal(encoder, gridCols, gridRows, cellImages, 1, addImageFlags | AVIF_ADD_IMAGE_FLAG_SINGLE); // only single image grids are supported
+    const uint32_t gridWidth = cellImages[0]->width * gridCols;
+    const uint32_t gridHeight = cellImages[0]->height * gridRows;
+    return avifEncoderAddImageInternal(encoder,
+                                       gridCols,
+                                       gridRows,
+                                       cellImages,
+                                       gridWidth,
+                                       gridHeight,
+                                       1,
+                                       addImageFlags | AVIF_ADD_IMAGE_FLAG_SINGLE); // only single image grids are supported
 }
 
 static size_t avifEncoderFindExistingChunk(avifRWStream * s, size_t mdatStartOffset, const uint8_t * data, size_t size)
@@ -689,6 +1419,11 @@ static size_t avifEncoderFindExistingChunk(avifRWStream * s, size_t mdatStartOff
 
 avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
 {
+    // Drain the frames queued by avifEncoderAddImage(), if any. Their diagnostics are kept on error.
+    const avifResult asyncResult = avifEncoderStopAsync(encoder->data, AVIF_FALSE);
+    if (asyncResult != AVIF_RESULT_OK) {
+        return asyncResult;
+    }
     avifDiagnosticsClearError(&encoder->diag);
     if (encoder->data->items.count == 0) {
         return AVIF_RESULT_NO_CONTENT;
@@ -704,7 +1439,7 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
                 return item->alpha ? AVIF_RESULT_ENCODE_ALPHA_FAILED : AVIF_RESULT_ENCODE_COLOR_FAILED;
             }
 
-            if (item->encodeOutput->samples.count != encoder->data->frames.count) {
+            if (item->encodeOutput->samples.count != (encoder->data->frames.count * encoder->data->layerCount)) {
                 return item->alpha ? AVIF_RESULT_ENCODE_ALPHA_FAILED : AVIF_RESULT_ENCODE_COLOR_FAILED;
             }
         }
@@ -801,9 +1536,25 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
                                                                     // unsigned int(4) reserved;
     avifRWStreamWriteU16(&s, (uint16_t)encoder->data->items.count); // unsigned int(16) item_count;
 
+    const avifBool layered = (encoder->data->layerCount > 1);
     for (uint32_t itemIndex = 0; itemIndex < encoder->data->items.count; ++itemIndex) {
         avifEncoderItem * item = &encoder->data->items.item[itemIndex];
 
+        if (layered && item->codec) {
+            // One extent per layer, as the layers of all items are interleaved in mdat
+            const avifEncodeSampleArray * layers = &item->encodeOutput->samples;
+            avifRWStreamWriteU16(&s, item->id);                // unsigned int(16) item_ID;
+            avifRWStreamWriteU16(&s, 0);                       // unsigned int(16) data_reference_index;
+            avifRWStreamWriteU16(&s, (uint16_t)layers->count); // unsigned int(16) extent_count;
+            for (uint32_t layerIndex = 0; layerIndex < layers->count; ++layerIndex) {
+                const size_t layerSize = layers->sample[layerIndex].data.size;
+                avifEncoderItemAddMdatFixup(item, &s);         //
+                avifRWStreamWriteU32(&s, 0 /* set later */);   // unsigned int(offset_size*8) extent_offset;
+                avifRWStreamWriteU32(&s, (uint32_t)layerSize); // unsigned int(length_size*8) extent_length;
+            }
+            continue;
+        }
+
         uint32_t contentSize = (uint32_t)item->metadataPayload.size;
         if (item->encodeOutput->samples.count > 0) {
             // This is choosing sample 0's size as there are two cases here:
@@ -932,11 +1683,12 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
             }
         }
 
-        uint32_t imageWidth = imageMetadata->width;
-        uint32_t imageHeight = imageMetadata->height;
+        const avifImage * itemMetadata = item->image ? item->image : imageMetadata;
+        uint32_t imageWidth = itemMetadata->width;
+        uint32_t imageHeight = itemMetadata->height;
         if (isGrid) {
-            imageWidth = imageMetadata->width * item->gridCols;
-            imageHeight = imageMetadata->height * item->gridRows;
+            imageWidth = item->gridWidth;
+            imageHeight = item->gridHeight;
         }
 
         // Properties all av01 items need
@@ -947,11 +1699,11 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
         avifRWStreamFinishBox(&s, ispe);
         ipmaPush(&item->ipma, ++itemPropertyIndex, AVIF_FALSE); // ipma is 1-indexed, doing this afterwards is correct
 
-        uint8_t channelCount = (item->alpha || (imageMetadata->yuvFormat == AVIF_PIXEL_FORMAT_YUV400)) ? 1 : 3;
+        uint8_t channelCount = (item->alpha || (itemMetadata->yuvFormat == AVIF_PIXEL_FORMAT_YUV400)) ? 1 : 3;
         avifBoxMarker pixi = avifRWStreamWriteFullBox(&s, "pixi", AVIF_BOX_SIZE_TBD, 0, 0);
         avifRWStreamWriteU8(&s, channelCount); // unsigned int (8) num_channels;
         for (uint8_t chan = 0; chan < channelCount; ++chan) {
-            avifRWStreamWriteU8(&s, (uint8_t)imageMetadata->depth); // unsigned int (8) bits_per_channel;
+            avifRWStreamWriteU8(&s, (uint8_t)itemMetadata->depth); // unsigned int (8) bits_per_channel;
         }
         avifRWStreamFinishBox(&s, pixi);
         ipmaPush(&item->ipma, ++itemPropertyIndex, AVIF_FALSE);
@@ -959,6 +1711,29 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
         if (item->codec) {
             writeConfigBox(&s, &item->av1C);
             ipmaPush(&item->ipma, ++itemPropertyIndex, AVIF_TRUE);
+
+            if (layered) {
+                // The size of every layer but the last one, which is whatever remains of the item
+                const avifEncodeSampleArray * layers = &item->encodeOutput->samples;
+                uint8_t largeSize = 0;
+                for (uint32_t layerIndex = 0; layerIndex < layers->count - 1; ++layerIndex) {
+                    if (layers->sample[layerIndex].data.size > 0xffff) {
+                        largeSize = 1;
+                    }
+                }
+                avifBoxMarker a1lx = avifRWStreamWriteBox(&s, "a1lx", AVIF_BOX_SIZE_TBD);
+                avifRWStreamWriteU8(&s, largeSize); // unsigned int(7) reserved = 0; unsigned int(1) large_size;
+                for (uint32_t layerIndex = 0; layerIndex < 3; ++layerIndex) {
+                    const size_t layerSize = (layerIndex < layers->count - 1) ? layers->sample[layerIndex].data.size : 0;
+                    if (largeSize) {
+                        avifRWStreamWriteU32(&s, (uint32_t)layerSize); // unsigned int(32) layer_size[3];
+                    } else {
+                        avifRWStreamWriteU16(&s, (uint16_t)layerSize); // unsigned int(16) layer_size[3];
+                    }
+                }
+                avifRWStreamFinishBox(&s, a1lx);
+                ipmaPush(&item->ipma, ++itemPropertyIndex, AVIF_FALSE);
+            }
         }
 
         if (item->alpha) {
@@ -971,7 +1746,7 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
         } else {
             // Color specific properties
 
-            avifEncoderWriteColorProperties(&s, imageMetadata, &item->ipma, &itemPropertyIndex);
+            avifEncoderWriteColorProperties(&s, itemMetadata, &item->ipma, &itemPropertyIndex);
         }
     }
     avifRWStreamFinishBox(&s, ipco);
@@ -1258,6 +2033,10 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
                 // only process alpha payloads when alphaPass is true
                 continue;
             }
+            if (layered && item->codec) {
+                // written layer by layer below
+                continue;
+            }
 
             size_t chunkOffset = 0;
 
@@ -1297,6 +2076,35 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
             }
         }
     }
+    if (layered) {
+        // Interleave the layers of all av01 items (alpha before color, as above), so that the first
+        // layer of every item arrives first and a progressive decoder can show something early.
+        for (uint32_t layerIndex = 0; layerIndex < encoder->data->layerCount; ++layerIndex) {
+            for (int alphaPass = 1; alphaPass >= 0; --alphaPass) {
+                for (uint32_t itemIndex = 0; itemIndex < encoder->data->items.count; ++itemIndex) {
+                    avifEncoderItem * item = &encoder->data->items.item[itemIndex];
+                    if (!item->codec || (item->alpha != (avifBool)alphaPass)) {
+                        continue;
+                    }
+
+                    const size_t chunkOffset = avifRWStreamOffset(&s);
+                    const avifEncodeSample * sample = &item->encodeOutput->samples.sample[layerIndex];
+                    avifRWStreamWrite(&s, sample->data.data, sample->data.size);
+                    if (item->alpha) {
+                        encoder->ioStats.alphaOBUSize += sample->data.size;
+                    } else {
+                        encoder->ioStats.colorOBUSize += sample->data.size;
+                    }
+
+                    const avifOffsetFixup * fixup = &item->mdatFixups.fixup[layerIndex];
+                    const size_t prevOffset = avifRWStreamOffset(&s);
+                    avifRWStreamSetOffset(&s, fixup->offset);
+                    avifRWStreamWriteU32(&s, (uint32_t)chunkOffset);
+                    avifRWStreamSetOffset(&s, prevOffset);
+                }
+            }
+        }
+    }
     avifRWStreamFinishBox(&s, mdat);
 
     // -----------------------------------------------------------------------
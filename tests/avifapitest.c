@@ -0,0 +1,1047 @@
+// Copyright 2021 Joe Drago. All rights reserved.
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "avif/avif.h"
+
+#include "compare.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// avifapitest [file.avif ...]:
+// Round trips through the library's API that need no test data: every test builds its own source
+// image, encodes and/or decodes it, and compares the result with the source (or with another way of
+// decoding the same file). Tests needing a codec that isn't built in are skipped. The files given
+// on the command line (the AVIF files of tests/data) are also peeked at and parsed.
+
+static const avifCodecChoice decoderChoices[] = { AVIF_CODEC_CHOICE_DAV1D, AVIF_CODEC_CHOICE_LIBGAV1, AVIF_CODEC_CHOICE_AOM };
+static const int decoderChoiceCount = (int)(sizeof(decoderChoices) / sizeof(decoderChoices[0]));
+
+// Fills the planes with smooth gradients, which survive lossy encoding with a small error
+static avifImage * createTestImage(uint32_t width, uint32_t height, uint32_t depth, avifPixelFormat yuvFormat, avifBool alpha)
+{
+    avifImage * image = avifImageCreate((int)width, (int)height, (int)depth, yuvFormat);
+    avifImageAllocatePlanes(image, alpha ? AVIF_PLANES_ALL : AVIF_PLANES_YUV);
+
+    avifPixelFormatInfo formatInfo;
+    avifGetPixelFormatInfo(yuvFormat, &formatInfo);
+    const uint32_t maxChannel = (1 << depth) - 1;
+    for (int plane = 0; plane < 4; ++plane) {
+        // Planes 0-2 are Y, U and V, plane 3 is alpha
+        const avifBool chroma = (plane == AVIF_CHAN_U) || (plane == AVIF_CHAN_V);
+        uint8_t * pixels = (plane == 3) ? image->alphaPlane : image->yuvPlanes[plane];
+        if (!pixels) {
+            continue;
+        }
+        const uint32_t rowBytes = (plane == 3) ? image->alphaRowBytes : image->yuvRowBytes[plane];
+        const uint32_t planeWidth = chroma ? ((width + formatInfo.chromaShiftX) >> formatInfo.chromaShiftX) : width;
+        const uint32_t planeHeight = chroma ? ((height + formatInfo.chromaShiftY) >> formatInfo.chromaShiftY) : height;
+        for (uint32_t j = 0; j < planeHeight; ++j) {
+            for (uint32_t i = 0; i < planeWidth; ++i) {
+                // A different direction per plane
+                const uint32_t value = (plane & 1) ? ((i * maxChannel) / planeWidth) : ((j * maxChannel) / planeHeight);
+                const uint32_t mixed = (plane < 2) ? value : ((value + ((i + j) * maxChannel) / (planeWidth + planeHeight)) / 2);
+                if (depth > 8) {
+                    ((uint16_t *)&pixels[j * rowBytes])[i] = (uint16_t)mixed;
+                } else {
+                    pixels[i + (j * rowBytes)] = (uint8_t)mixed;
+                }
+            }
+        }
+    }
+    return image;
+}
+
+// Encodes a single image with the given encoder settings
+static avifResult encodeImage(avifEncoder * encoder, const avifImage * image, avifRWData * output)
+{
+    avifResult result = avifEncoderWrite(encoder, image, output);
+    if (result != AVIF_RESULT_OK) {
+        printf("ERROR: Encoding failed: %s (%s)\n", avifResultToString(result), encoder->diag.error);
+    }
+    return result;
+}
+
+// Returns the largest difference between any two samples of the two images (or -1 if their sizes
+// or formats don't match)
+static int maxImageDifference(const avifImage * image1, const avifImage * image2)
+{
+    ImageComparison ic;
+    if (!compareYUVA(&ic, image1, image2)) {
+        return -1;
+    }
+    return ic.maxDiff;
+}
+
+// ---------------------------------------------------------------------------
+// Layered (progressive) images
+
+// Makes the alpha item of a layered file written by libavif a single image: its a1lx property is
+// the last one (libavif writes the color item's properties first), and renaming it leaves an alpha
+// item whose single sample holds all of its layers.
+static avifBool unlayerAlpha(avifRWData * encoded)
+{
+    for (size_t i = encoded->size; i >= 4; --i) {
+        if (!memcmp(&encoded->data[i - 4], "a1lx", 4)) {
+            memcpy(&encoded->data[i - 4], "skip", 4);
+            return AVIF_TRUE;
+        }
+    }
+    return AVIF_FALSE;
+}
+
+// Encodes a layered image with libaom, then checks that every available decoder refines it layer by
+// layer, down to a lossless last layer, that it decodes as a single image when not progressive, and
+// that avifDecoderNthImage() can jump straight to any layer. Both with a layered alpha item, and with
+// one decoded once, along with the first layer of the color item.
+static int testLayeredRoundTrip(void)
+{
+    printf("Test: Layered round trip\n");
+    if (!avifCodecName(AVIF_CODEC_CHOICE_AOM, AVIF_CODEC_FLAG_CAN_ENCODE)) {
+        printf("  Skipped: needs the aom encoder\n");
+        return 0;
+    }
+
+    int retCode = 0;
+    avifImage * image = createTestImage(200, 136, 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE);
+    avifEncoder * encoder = avifEncoderCreate();
+    encoder->codecChoice = AVIF_CODEC_CHOICE_AOM;
+    encoder->extraLayerCount = 2;
+    encoder->speed = AVIF_SPEED_FASTEST;
+    encoder->minQuantizer = AVIF_QUANTIZER_LOSSLESS;
+    encoder->maxQuantizer = AVIF_QUANTIZER_LOSSLESS;
+    encoder->minQuantizerAlpha = AVIF_QUANTIZER_LOSSLESS;
+    encoder->maxQuantizerAlpha = AVIF_QUANTIZER_LOSSLESS;
+    avifRWData encoded = AVIF_DATA_EMPTY;
+    avifRWData singleAlphaEncoded = AVIF_DATA_EMPTY;
+    if (encodeImage(encoder, image, &encoded) != AVIF_RESULT_OK) {
+        retCode = 1;
+        goto cleanup;
+    }
+    avifRWDataSet(&singleAlphaEncoded, encoded.data, encoded.size);
+    if (!unlayerAlpha(&singleAlphaEncoded)) {
+        printf("  ERROR: The file has no a1lx property\n");
+        retCode = 1;
+        goto cleanup;
+    }
+    const int layerCount = encoder->extraLayerCount + 1;
+
+    for (int singleAlpha = 0; singleAlpha < 2; ++singleAlpha) {
+        const avifRWData * file = singleAlpha ? &singleAlphaEncoded : &encoded;
+        const char * alphaName = singleAlpha ? "single alpha" : "layered alpha";
+        for (int choiceIndex = 0; choiceIndex < decoderChoiceCount; ++choiceIndex) {
+            const avifCodecChoice choice = decoderChoices[choiceIndex];
+            const char * codecName = avifCodecName(choice, AVIF_CODEC_FLAG_CAN_DECODE);
+            if (!codecName) {
+                continue;
+            }
+            for (int progressive = 0; progressive < 2; ++progressive) {
+                avifDecoder * decoder = avifDecoderCreate();
+                decoder->codecChoice = choice;
+                decoder->allowProgressive = progressive;
+                avifResult result = avifDecoderSetIOMemory(decoder, file->data, file->size);
+                if (result == AVIF_RESULT_OK) {
+                    result = avifDecoderParse(decoder);
+                }
+                const int expectedImageCount = progressive ? layerCount : 1;
+                const avifProgressiveState expectedState = progressive ? AVIF_PROGRESSIVE_STATE_ACTIVE
+                                                                       : AVIF_PROGRESSIVE_STATE_AVAILABLE;
+                if ((result != AVIF_RESULT_OK) || (decoder->imageCount != expectedImageCount) ||
+                    (decoder->progressiveState != expectedState)) {
+                    printf("  ERROR: [%s, %s, %s] parse returned %s, imageCount %d, progressiveState %s\n",
+                           codecName,
+                           alphaName,
+                           progressive ? "progressive" : "single image",
+                           avifResultToString(result),
+                           decoder->imageCount,
+                           avifProgressiveStateToString(decoder->progressiveState));
+                    retCode = 1;
+                    avifDecoderDestroy(decoder);
+                    continue;
+                }
+
+                // Every layer is at least as close to the source as the previous one, and the last is lossless
+                int previousDifference = -1;
+                while ((result = avifDecoderNextImage(decoder)) == AVIF_RESULT_OK) {
+                    const int difference = maxImageDifference(image, decoder->image);
+                    const avifBool lastLayer = (decoder->imageIndex == (decoder->imageCount - 1));
+                    printf("  [%s, %s, %s] layer %d: max difference %d\n",
+                           codecName,
+                           alphaName,
+                           progressive ? "progressive" : "single image",
+                           decoder->imageIndex,
+                           difference);
+                    if ((difference < 0) || ((previousDifference >= 0) && (difference > previousDifference)) ||
+                        (lastLayer && (difference != 0))) {
+                        printf("  ERROR: Unexpected difference from the source\n");
+                        retCode = 1;
+                    }
+                    previousDifference = difference;
+                }
+                if ((result != AVIF_RESULT_NO_IMAGES_REMAINING) || (decoder->imageIndex != (expectedImageCount - 1))) {
+                    printf("  ERROR: Decoded %d images, the last call returned %s\n",
+                           decoder->imageIndex + 1,
+                           avifResultToString(result));
+                    retCode = 1;
+                }
+                avifDecoderDestroy(decoder);
+            }
+
+            // Straight to the last layer from a freshly parsed decoder, then back to the first one,
+            // forward again, and back to a layer decoded after the one alpha may have been kept from
+            avifDecoder * decoder = avifDecoderCreate();
+            decoder->codecChoice = choice;
+            decoder->allowProgressive = AVIF_TRUE;
+            avifResult result = avifDecoderSetIOMemory(decoder, file->data, file->size);
+            if (result == AVIF_RESULT_OK) {
+                result = avifDecoderParse(decoder);
+            }
+            const int seeks[] = { layerCount - 1, 0, layerCount - 1, 1 };
+            for (int seekIndex = 0; (result == AVIF_RESULT_OK) && (seekIndex < 4); ++seekIndex) {
+                result = avifDecoderNthImage(decoder, (uint32_t)seeks[seekIndex]);
+                const int difference = (result == AVIF_RESULT_OK) ? maxImageDifference(image, decoder->image) : -1;
+                printf("  [%s, %s] NthImage(%d): %s, max difference %d\n",
+                       codecName,
+                       alphaName,
+                       seeks[seekIndex],
+                       avifResultToString(result),
+                       difference);
+                if ((difference < 0) || ((seeks[seekIndex] == (layerCount - 1)) && (difference != 0))) {
+                    printf("  ERROR: Unexpected difference from the source\n");
+                    retCode = 1;
+                }
+            }
+            if (result != AVIF_RESULT_OK) {
+                retCode = 1;
+            }
+            avifDecoderDestroy(decoder);
+        }
+    }
+
+cleanup:
+    avifRWDataFree(&singleAlphaEncoded);
+    avifRWDataFree(&encoded);
+    avifEncoderDestroy(encoder);
+    avifImageDestroy(image);
+    return retCode;
+}
+
+// ---------------------------------------------------------------------------
+// Decoder index
+
+// Parses (with an index, if not NULL) and decodes the first image of encoded
+static avifResult parseAndDecode(avifDecoder * decoder, const avifRWData * encoded, const avifROData * index)
+{
+    avifResult result = avifDecoderSetIOMemory(decoder, encoded->data, encoded->size);
+    if (result == AVIF_RESULT_OK) {
+        result = index ? avifDecoderParseWithIndex(decoder, index) : avifDecoderParse(decoder);
+    }
+    if (result == AVIF_RESULT_OK) {
+        result = avifDecoderNextImage(decoder);
+    }
+    return result;
+}
+
+// Checks that an exported index restores the same image as a normal parse, and that it is rejected
+// for another file and once truncated or corrupted.
+static int testIndexRoundTrip(void)
+{
+    printf("Test: Decoder index round trip\n");
+    if (!avifCodecName(AVIF_CODEC_CHOICE_AOM, AVIF_CODEC_FLAG_CAN_ENCODE)) {
+        printf("  Skipped: needs the aom encoder\n");
+        return 0;
+    }
+
+    int retCode = 0;
+    // The ICC profile is restored from the index itself; its contents don't matter here
+    const uint8_t icc[] = { 'N', 'o', 't', ' ', 'a', 'n', ' ', 'I', 'C', 'C', ' ', 'p', 'r', 'o', 'f', 'i', 'l', 'e' };
+    avifImage * image = createTestImage(64, 48, 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE);
+    avifImageSetProfileICC(image, icc, sizeof(icc));
+    avifImage * otherImage = createTestImage(48, 64, 8, AVIF_PIXEL_FORMAT_YUV444, AVIF_FALSE);
+    avifRWData encoded = AVIF_DATA_EMPTY;
+    avifRWData otherEncoded = AVIF_DATA_EMPTY;
+    avifRWData index = AVIF_DATA_EMPTY;
+    avifRWData reexportedIndex = AVIF_DATA_EMPTY;
+    avifRWData damagedIndex = AVIF_DATA_EMPTY;
+    avifDecoder * decoder = avifDecoderCreate();
+    avifDecoder * indexedDecoder = avifDecoderCreate();
+    for (int i = 0; i < 2; ++i) {
+        // An encoder writes a single file
+        avifEncoder * encoder = avifEncoderCreate();
+        encoder->codecChoice = AVIF_CODEC_CHOICE_AOM;
+        encoder->speed = AVIF_SPEED_FASTEST;
+        const avifResult encodeResult = encodeImage(encoder, i ? otherImage : image, i ? &otherEncoded : &encoded);
+        avifEncoderDestroy(encoder);
+        if (encodeResult != AVIF_RESULT_OK) {
+            retCode = 1;
+            goto cleanup;
+        }
+    }
+
+    avifResult result = parseAndDecode(decoder, &encoded, NULL);
+    if (result == AVIF_RESULT_OK) {
+        result = avifDecoderExportIndex(decoder, &index);
+    }
+    if (result != AVIF_RESULT_OK) {
+        printf("  ERROR: Parsing and exporting the index failed: %s (%s)\n", avifResultToString(result), decoder->diag.error);
+        retCode = 1;
+        goto cleanup;
+    }
+    const avifROData indexData = { index.data, index.size };
+
+    // The index restores the same image, and the same index can be exported again from it
+    result = parseAndDecode(indexedDecoder, &encoded, &indexData);
+    if (result == AVIF_RESULT_OK) {
+        result = avifDecoderExportIndex(indexedDecoder, &reexportedIndex);
+    }
+    if (result != AVIF_RESULT_OK) {
+        printf("  ERROR: Decoding with the index failed: %s (%s)\n", avifResultToString(result), indexedDecoder->diag.error);
+        retCode = 1;
+        goto cleanup;
+    }
+    if ((maxImageDifference(decoder->image, indexedDecoder->image) != 0) || (indexedDecoder->image->icc.size != sizeof(icc)) ||
+        memcmp(indexedDecoder->image->icc.data, icc, sizeof(icc)) || (reexportedIndex.size != index.size) ||
+        memcmp(reexportedIndex.data, index.data, index.size)) {
+        printf("  ERROR: Decoding with the index doesn't match a normal parse\n");
+        retCode = 1;
+    }
+
+    // Another file
+    result = parseAndDecode(indexedDecoder, &otherEncoded, &indexData);
+    if (result != AVIF_RESULT_INVALID_ARGUMENT) {
+        printf("  ERROR: The index of another file returned %s\n", avifResultToString(result));
+        retCode = 1;
+    }
+
+    // Truncated, at every length
+    for (size_t size = 0; size < index.size; ++size) {
+        const avifROData truncatedIndex = { index.data, size };
+        result = parseAndDecode(indexedDecoder, &encoded, &truncatedIndex);
+        if (result != AVIF_RESULT_INVALID_ARGUMENT) {
+            printf("  ERROR: The index truncated to %zu bytes returned %s\n", size, avifResultToString(result));
+            retCode = 1;
+            break;
+        }
+    }
+
+    // Corrupted, at every byte
+    avifRWDataSet(&damagedIndex, index.data, index.size);
+    for (size_t offset = 0; offset < index.size; ++offset) {
+        damagedIndex.data[offset] ^= 0x10;
+        const avifROData corruptedIndex = { damagedIndex.data, damagedIndex.size };
+        result = parseAndDecode(indexedDecoder, &encoded, &corruptedIndex);
+        damagedIndex.data[offset] ^= 0x10;
+        if (result != AVIF_RESULT_INVALID_ARGUMENT) {
+            printf("  ERROR: The index corrupted at byte %zu returned %s\n", offset, avifResultToString(result));
+            retCode = 1;
+            break;
+        }
+    }
+
+cleanup:
+    avifDecoderDestroy(indexedDecoder);
+    avifDecoderDestroy(decoder);
+    avifRWDataFree(&damagedIndex);
+    avifRWDataFree(&reexportedIndex);
+    avifRWDataFree(&index);
+    avifRWDataFree(&otherEncoded);
+    avifRWDataFree(&encoded);
+    avifImageDestroy(otherImage);
+    avifImageDestroy(image);
+    return retCode;
+}
+
+// ---------------------------------------------------------------------------
+// Automatic grids
+
+// Returns AVIF_TRUE if the file has an item of the given type (good enough for files written by
+// libavif, whose infe boxes are the only place item types appear)
+static avifBool hasItemType(const avifRWData * encoded, const char type[4])
+{
+    for (size_t i = 0; (i + 4) <= encoded->size; ++i) {
+        if (!memcmp(&encoded->data[i], type, 4)) {
+            return AVIF_TRUE;
+        }
+    }
+    return AVIF_FALSE;
+}
+
+// Encodes images losslessly with avifEncoder.gridCellSize, split into cells both evenly and with
+// padded right and bottom cells, and checks that they decode to the source.
+static int testGridCellSizeRoundTrip(void)
+{
+    printf("Test: Grid cell size round trip\n");
+    if (!avifCodecName(AVIF_CODEC_CHOICE_AOM, AVIF_CODEC_FLAG_CAN_ENCODE) ||
+        !avifCodecName(AVIF_CODEC_CHOICE_AUTO, AVIF_CODEC_FLAG_CAN_DECODE)) {
+        printf("  Skipped: needs the aom encoder and a decoder\n");
+        return 0;
+    }
+
+    static const struct
+    {
+        const char * name;
+        uint32_t width;
+        uint32_t height;
+        uint32_t depth;
+        avifPixelFormat yuvFormat;
+        avifBool alpha;
+    } cases[] = {
+        // 2x2 cells of 128x96
+        { "even, 4:2:0", 256, 192, 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE },
+        // 2x2 cells of 128x128
+        { "even, 10-bit 4:4:4", 256, 256, 10, AVIF_PIXEL_FORMAT_YUV444, AVIF_FALSE },
+        // 3x2 cells of 88x66, 2 columns and 2 rows past the edges
+        { "padded, 4:2:0", 262, 130, 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE },
+        // 3x1 cells of 88x100, 4 columns past the edge
+        { "padded, 12-bit 4:2:2", 260, 100, 12, AVIF_PIXEL_FORMAT_YUV422, AVIF_TRUE },
+    };
+
+    int retCode = 0;
+    for (size_t caseIndex = 0; caseIndex < (sizeof(cases) / sizeof(cases[0])); ++caseIndex) {
+        avifImage * image = createTestImage(cases[caseIndex].width,
+                                            cases[caseIndex].height,
+                                            cases[caseIndex].depth,
+                                            cases[caseIndex].yuvFormat,
+                                            cases[caseIndex].alpha);
+        avifEncoder * encoder = avifEncoderCreate();
+        encoder->codecChoice = AVIF_CODEC_CHOICE_AOM;
+        encoder->speed = AVIF_SPEED_FASTEST;
+        encoder->gridCellSize = 128;
+        encoder->minQuantizer = AVIF_QUANTIZER_LOSSLESS;
+        encoder->maxQuantizer = AVIF_QUANTIZER_LOSSLESS;
+        encoder->minQuantizerAlpha = AVIF_QUANTIZER_LOSSLESS;
+        encoder->maxQuantizerAlpha = AVIF_QUANTIZER_LOSSLESS;
+        avifRWData encoded = AVIF_DATA_EMPTY;
+        avifImage * decoded = avifImageCreateEmpty();
+        avifDecoder * decoder = avifDecoderCreate();
+        if (encodeImage(encoder, image, &encoded) != AVIF_RESULT_OK) {
+            retCode = 1;
+        } else if (!hasItemType(&encoded, "grid")) {
+            printf("  ERROR: [%s] The image wasn't split into a grid\n", cases[caseIndex].name);
+            retCode = 1;
+        } else {
+            const avifResult result = avifDecoderReadMemory(decoder, decoded, encoded.data, encoded.size);
+            const int difference = (result == AVIF_RESULT_OK) ? maxImageDifference(image, decoded) : -1;
+            printf("  [%s] %s, max difference %d\n", cases[caseIndex].name, avifResultToString(result), difference);
+            if (difference != 0) {
+                printf("  ERROR: The grid doesn't decode to the source\n");
+                retCode = 1;
+            }
+        }
+        avifDecoderDestroy(decoder);
+        avifImageDestroy(decoded);
+        avifRWDataFree(&encoded);
+        avifEncoderDestroy(encoder);
+        avifImageDestroy(image);
+    }
+    return retCode;
+}
+
+// ---------------------------------------------------------------------------
+// Image views
+
+// Returns AVIF_TRUE if view is the rect region of image: same format, rect's size, and every plane
+// pointing at rect's first sample in image's plane, with image's row bytes
+static avifBool isViewOf(const avifImage * view, const avifImage * image, const avifCropRect * rect)
+{
+    if ((view->width != rect->width) || (view->height != rect->height) || (view->depth != image->depth) ||
+        (view->yuvFormat != image->yuvFormat) || (view->yuvRange != image->yuvRange) || view->imageOwnsYUVPlanes ||
+        view->imageOwnsAlphaPlane) {
+        return AVIF_FALSE;
+    }
+    avifPixelFormatInfo formatInfo;
+    avifGetPixelFormatInfo(image->yuvFormat, &formatInfo);
+    const uint32_t pixelBytes = (image->depth > 8) ? 2 : 1;
+    for (int plane = 0; plane < 4; ++plane) {
+        // Planes 0-2 are Y, U and V, plane 3 is alpha
+        const avifBool chroma = (plane == AVIF_CHAN_U) || (plane == AVIF_CHAN_V);
+        const uint8_t * imagePixels = (plane == 3) ? image->alphaPlane : image->yuvPlanes[plane];
+        const uint8_t * viewPixels = (plane == 3) ? view->alphaPlane : view->yuvPlanes[plane];
+        const uint32_t imageRowBytes = (plane == 3) ? image->alphaRowBytes : image->yuvRowBytes[plane];
+        const uint32_t viewRowBytes = (plane == 3) ? view->alphaRowBytes : view->yuvRowBytes[plane];
+        if (!imagePixels) {
+            if (viewPixels) {
+                return AVIF_FALSE;
+            }
+            continue;
+        }
+        const uint32_t x = chroma ? (rect->x >> formatInfo.chromaShiftX) : rect->x;
+        const uint32_t y = chroma ? (rect->y >> formatInfo.chromaShiftY) : rect->y;
+        const uint8_t * expectedPixels = &imagePixels[((size_t)y * imageRowBytes) + ((size_t)x * pixelBytes)];
+        if ((viewPixels != expectedPixels) || (viewRowBytes != imageRowBytes)) {
+            return AVIF_FALSE;
+        }
+    }
+    return AVIF_TRUE;
+}
+
+// Checks the views avifImageSetViewRect() makes of images of each format, and the rects it rejects
+static int testImageSetViewRect(void)
+{
+    printf("Test: avifImageSetViewRect\n");
+
+    static const struct
+    {
+        const char * name;
+        uint32_t depth;
+        avifPixelFormat yuvFormat;
+        avifBool alpha;
+        avifCropRect rect;
+        avifResult expectedResult;
+    } cases[] = {
+        // Source images are 64x48
+        { "whole image", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 0, 0, 64, 48 }, AVIF_RESULT_OK },
+        { "bottom right corner", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 62, 46, 2, 2 }, AVIF_RESULT_OK },
+        { "odd size", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 10, 20, 33, 21 }, AVIF_RESULT_OK },
+        { "10-bit 4:4:4, odd position", 10, AVIF_PIXEL_FORMAT_YUV444, AVIF_FALSE, { 1, 3, 17, 9 }, AVIF_RESULT_OK },
+        { "12-bit 4:2:2, odd row", 12, AVIF_PIXEL_FORMAT_YUV422, AVIF_TRUE, { 8, 5, 40, 11 }, AVIF_RESULT_OK },
+        { "4:0:0, odd position", 8, AVIF_PIXEL_FORMAT_YUV400, AVIF_FALSE, { 7, 13, 5, 5 }, AVIF_RESULT_OK },
+        { "empty width", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 0, 0, 0, 48 }, AVIF_RESULT_INVALID_ARGUMENT },
+        { "empty height", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 0, 0, 64, 0 }, AVIF_RESULT_INVALID_ARGUMENT },
+        { "too wide", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 0, 0, 65, 48 }, AVIF_RESULT_INVALID_ARGUMENT },
+        { "too tall", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 0, 0, 64, 49 }, AVIF_RESULT_INVALID_ARGUMENT },
+        { "past the right edge", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 2, 0, 63, 48 }, AVIF_RESULT_INVALID_ARGUMENT },
+        { "past the bottom edge", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 0, 48, 64, 1 }, AVIF_RESULT_INVALID_ARGUMENT },
+        { "overflowing x", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 0xFFFFFFFE, 0, 4, 4 }, AVIF_RESULT_INVALID_ARGUMENT },
+        { "overflowing y", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 0, 0xFFFFFFFE, 4, 4 }, AVIF_RESULT_INVALID_ARGUMENT },
+        { "4:2:0, odd column", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 1, 0, 8, 8 }, AVIF_RESULT_INVALID_ARGUMENT },
+        { "4:2:0, odd row", 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE, { 0, 1, 8, 8 }, AVIF_RESULT_INVALID_ARGUMENT },
+        { "4:2:2, odd column", 10, AVIF_PIXEL_FORMAT_YUV422, AVIF_FALSE, { 3, 0, 8, 8 }, AVIF_RESULT_INVALID_ARGUMENT },
+    };
+    const uint8_t viewICC[] = { 'v', 'i', 'e', 'w' };
+    const uint8_t imageICC[] = { 'i', 'm', 'a', 'g', 'e' };
+
+    int retCode = 0;
+    for (size_t caseIndex = 0; caseIndex < (sizeof(cases) / sizeof(cases[0])); ++caseIndex) {
+        avifImage * image = createTestImage(64, 48, cases[caseIndex].depth, cases[caseIndex].yuvFormat, cases[caseIndex].alpha);
+        avifImageSetProfileICC(image, imageICC, sizeof(imageICC));
+        // The view starts out as an image with planes of its own, which are freed or kept untouched
+        avifImage * view = createTestImage(16, 16, 8, AVIF_PIXEL_FORMAT_YUV444, AVIF_TRUE);
+        avifImageSetProfileICC(view, viewICC, sizeof(viewICC));
+        const uint8_t * viewY = view->yuvPlanes[AVIF_CHAN_Y];
+
+        const avifResult result = avifImageSetViewRect(view, image, &cases[caseIndex].rect);
+        avifBool passed = (result == cases[caseIndex].expectedResult) && (view->icc.size == sizeof(viewICC)) &&
+                          !memcmp(view->icc.data, viewICC, sizeof(viewICC));
+        if (result == AVIF_RESULT_OK) {
+            passed = passed && isViewOf(view, image, &cases[caseIndex].rect);
+        } else {
+            passed = passed && (view->width == 16) && (view->yuvPlanes[AVIF_CHAN_Y] == viewY) && view->imageOwnsYUVPlanes;
+        }
+        if (!passed) {
+            printf("  ERROR: [%s] returned %s\n", cases[caseIndex].name, avifResultToString(result));
+            retCode = 1;
+        }
+        avifImageDestroy(view);
+        avifImageDestroy(image);
+    }
+    return retCode;
+}
+
+// ---------------------------------------------------------------------------
+// Concurrent grid decoding
+
+// Rows the decoder hands to compareRows(), checked against a full RGB conversion
+typedef struct RGBRowsComparison
+{
+    const avifRGBImage * expected;
+    uint32_t nextRowIndex;
+    avifBool matches;
+} RGBRowsComparison;
+
+static avifResult compareRows(void * userData,
+                              uint32_t rowIndex,
+                              const uint8_t * pixels,
+                              uint32_t rowBytes,
+                              uint32_t rowCount)
+{
+    RGBRowsComparison * comparison = (RGBRowsComparison *)userData;
+    const avifRGBImage * expected = comparison->expected;
+    if ((rowIndex != comparison->nextRowIndex) || (rowCount > (expected->height - rowIndex))) {
+        comparison->matches = AVIF_FALSE;
+        return AVIF_RESULT_UNKNOWN_ERROR;
+    }
+    for (uint32_t j = 0; j < rowCount; ++j) {
+        const uint8_t * expectedRow = &expected->pixels[(size_t)(rowIndex + j) * expected->rowBytes];
+        if (memcmp(&pixels[(size_t)j * rowBytes], expectedRow, expected->rowBytes)) {
+            comparison->matches = AVIF_FALSE;
+        }
+    }
+    comparison->nextRowIndex += rowCount;
+    return AVIF_RESULT_OK;
+}
+
+// Decodes a grid with alpha with maxThreads 1 and again with its tiles decoded concurrently (on a
+// thread pool of the decoder's own or a shared one), and checks that the images are identical, as
+// are the RGB rows of avifDecoderNextImageRGBRows() and a conversion of the whole image.
+static int testGridThreads(void)
+{
+    printf("Test: Concurrent grid decoding\n");
+    if (!avifCodecName(AVIF_CODEC_CHOICE_AOM, AVIF_CODEC_FLAG_CAN_ENCODE)) {
+        printf("  Skipped: needs the aom encoder\n");
+        return 0;
+    }
+
+    int retCode = 0;
+    // 4x3 cells of 128x128
+    avifImage * image = createTestImage(512, 384, 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE);
+    avifEncoder * encoder = avifEncoderCreate();
+    encoder->codecChoice = AVIF_CODEC_CHOICE_AOM;
+    encoder->speed = AVIF_SPEED_FASTEST;
+    encoder->gridCellSize = 128;
+    avifRWData encoded = AVIF_DATA_EMPTY;
+    avifThreadPool * threadPool = avifThreadPoolCreate(3);
+    if (encodeImage(encoder, image, &encoded) != AVIF_RESULT_OK) {
+        retCode = 1;
+        goto cleanup;
+    }
+
+    for (int choiceIndex = 0; choiceIndex < decoderChoiceCount; ++choiceIndex) {
+        const avifCodecChoice choice = decoderChoices[choiceIndex];
+        const char * codecName = avifCodecName(choice, AVIF_CODEC_FLAG_CAN_DECODE);
+        if (!codecName) {
+            continue;
+        }
+
+        avifDecoder * referenceDecoder = avifDecoderCreate();
+        referenceDecoder->codecChoice = choice;
+        referenceDecoder->maxThreads = 1;
+        avifResult result = avifDecoderSetIOMemory(referenceDecoder, encoded.data, encoded.size);
+        if (result == AVIF_RESULT_OK) {
+            result = avifDecoderParse(referenceDecoder);
+        }
+        if (result == AVIF_RESULT_OK) {
+            result = avifDecoderNextImage(referenceDecoder);
+        }
+        if (result != AVIF_RESULT_OK) {
+            printf("  ERROR: [%s] Decoding with 1 thread failed: %s\n", codecName, avifResultToString(result));
+            retCode = 1;
+            avifDecoderDestroy(referenceDecoder);
+            continue;
+        }
+        avifRGBImage referenceRGB;
+        avifRGBImageSetDefaults(&referenceRGB, referenceDecoder->image);
+        referenceRGB.chromaUpsampling = AVIF_CHROMA_UPSAMPLING_NEAREST; // the same across strips
+        avifRGBImageAllocatePixels(&referenceRGB);
+        avifImageYUVToRGB(referenceDecoder->image, &referenceRGB);
+
+        for (int shared = 0; shared < 2; ++shared) {
+            for (int rgbRows = 0; rgbRows < 2; ++rgbRows) {
+                avifDecoder * decoder = avifDecoderCreate();
+                decoder->codecChoice = choice;
+                decoder->maxThreads = shared ? 8 : 4;
+                decoder->threadPool = shared ? threadPool : NULL;
+                RGBRowsComparison comparison = { &referenceRGB, 0, AVIF_TRUE };
+                result = avifDecoderSetIOMemory(decoder, encoded.data, encoded.size);
+                if (result == AVIF_RESULT_OK) {
+                    result = avifDecoderParse(decoder);
+                }
+                if ((result == AVIF_RESULT_OK) && rgbRows) {
+                    avifRGBImage rgb;
+                    avifRGBImageSetDefaults(&rgb, decoder->image);
+                    rgb.chromaUpsampling = AVIF_CHROMA_UPSAMPLING_NEAREST;
+                    result = avifDecoderNextImageRGBRows(decoder, &rgb, compareRows, &comparison);
+                    comparison.matches = comparison.matches && (comparison.nextRowIndex == referenceRGB.height);
+                } else if (result == AVIF_RESULT_OK) {
+                    result = avifDecoderNextImage(decoder);
+                    comparison.matches = (result == AVIF_RESULT_OK) &&
+                                         (maxImageDifference(referenceDecoder->image, decoder->image) == 0);
+                }
+                printf("  [%s, %d threads%s, %s] %s\n",
+                       codecName,
+                       decoder->maxThreads,
+                       shared ? " from a pool of 3" : "",
+                       rgbRows ? "RGB rows" : "YUV",
+                       avifResultToString(result));
+                if ((result != AVIF_RESULT_OK) || !comparison.matches) {
+                    printf("  ERROR: The image doesn't match the one decoded with 1 thread\n");
+                    retCode = 1;
+                }
+                avifDecoderDestroy(decoder);
+            }
+        }
+        avifRGBImageFreePixels(&referenceRGB);
+        avifDecoderDestroy(referenceDecoder);
+    }
+
+cleanup:
+    avifThreadPoolDestroy(threadPool);
+    avifRWDataFree(&encoded);
+    avifEncoderDestroy(encoder);
+    avifImageDestroy(image);
+    return retCode;
+}
+
+// ---------------------------------------------------------------------------
+// Grid decoding in RGB rows from streamed IO
+
+// Reads from memory that is not persistent and of which only the first availableSize bytes have
+// arrived so far
+typedef struct StreamedIO
+{
+    avifIO io;
+    avifROData data;
+    size_t availableSize;
+} StreamedIO;
+
+static avifResult streamedIORead(avifIO * io, uint32_t readFlags, uint64_t offset, size_t size, avifROData * out)
+{
+    const StreamedIO * streamedIO = (const StreamedIO *)io;
+    if (readFlags || (offset > streamedIO->data.size)) {
+        return AVIF_RESULT_IO_ERROR;
+    }
+    if (size > (streamedIO->data.size - offset)) {
+        size = streamedIO->data.size - (size_t)offset;
+    }
+    if ((offset + size) > streamedIO->availableSize) {
+        return AVIF_RESULT_WAITING_ON_IO;
+    }
+    out->data = streamedIO->data.data + offset;
+    out->size = size;
+    return AVIF_RESULT_OK;
+}
+
+// avifDecoderNextImageRGBRows() releases the tiles of a grid once their rows are out. Runs out of
+// data part way through the grid, then decodes the image again once all of it has arrived, either
+// in RGB rows (which start over from the first row) or with avifDecoderNextImage(), and checks the
+// result against a decode of the whole file in one go.
+static int testGridRGBRowsStreamed(void)
+{
+    printf("Test: Grid decoding in RGB rows from streamed IO\n");
+    if (!avifCodecName(AVIF_CODEC_CHOICE_AOM, AVIF_CODEC_FLAG_CAN_ENCODE)) {
+        printf("  Skipped: needs the aom encoder\n");
+        return 0;
+    }
+
+    int retCode = 0;
+    // 4x3 cells of 128x128
+    avifImage * image = createTestImage(512, 384, 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_TRUE);
+    avifEncoder * encoder = avifEncoderCreate();
+    encoder->codecChoice = AVIF_CODEC_CHOICE_AOM;
+    encoder->speed = AVIF_SPEED_FASTEST;
+    encoder->gridCellSize = 128;
+    avifRWData encoded = AVIF_DATA_EMPTY;
+    if (encodeImage(encoder, image, &encoded) != AVIF_RESULT_OK) {
+        retCode = 1;
+        goto cleanup;
+    }
+
+    for (int choiceIndex = 0; choiceIndex < decoderChoiceCount; ++choiceIndex) {
+        const avifCodecChoice choice = decoderChoices[choiceIndex];
+        const char * codecName = avifCodecName(choice, AVIF_CODEC_FLAG_CAN_DECODE);
+        if (!codecName) {
+            continue;
+        }
+
+        avifDecoder * referenceDecoder = avifDecoderCreate();
+        referenceDecoder->codecChoice = choice;
+        avifResult result = avifDecoderSetIOMemory(referenceDecoder, encoded.data, encoded.size);
+        if (result == AVIF_RESULT_OK) {
+            result = avifDecoderParse(referenceDecoder);
+        }
+        if (result == AVIF_RESULT_OK) {
+            result = avifDecoderNextImage(referenceDecoder);
+        }
+        if (result != AVIF_RESULT_OK) {
+            printf("  ERROR: [%s] Decoding from memory failed: %s\n", codecName, avifResultToString(result));
+            retCode = 1;
+            avifDecoderDestroy(referenceDecoder);
+            continue;
+        }
+        avifRGBImage referenceRGB;
+        avifRGBImageSetDefaults(&referenceRGB, referenceDecoder->image);
+        referenceRGB.chromaUpsampling = AVIF_CHROMA_UPSAMPLING_NEAREST; // the same across strips
+        avifRGBImageAllocatePixels(&referenceRGB);
+        avifImageYUVToRGB(referenceDecoder->image, &referenceRGB);
+
+        for (int rgbRowsAgain = 0; rgbRowsAgain < 2; ++rgbRowsAgain) {
+            StreamedIO streamedIO = { { NULL, streamedIORead, NULL, encoded.size, AVIF_FALSE, NULL },
+                                      { encoded.data, encoded.size },
+                                      0 };
+            avifDecoder * decoder = avifDecoderCreate();
+            decoder->codecChoice = choice;
+            avifDecoderSetIO(decoder, &streamedIO.io);
+            RGBRowsComparison comparison = { &referenceRGB, 0, AVIF_TRUE };
+            avifRGBImage rgb;
+            avifBool parsed = AVIF_FALSE;
+            uint32_t partialRowCount = 0;
+            // Let the file arrive in 16 parts until some, but not all, of the rows could be decoded.
+            // The alpha tiles are stored after all the color tiles, so that may take most of the file.
+            result = AVIF_RESULT_WAITING_ON_IO;
+            for (int part = 1; (part < 16) && (result == AVIF_RESULT_WAITING_ON_IO) && (partialRowCount == 0); ++part) {
+                streamedIO.availableSize = (encoded.size * part) / 16;
+                if (!parsed) {
+                    result = avifDecoderParse(decoder);
+                    parsed = (result == AVIF_RESULT_OK);
+                    avifRGBImageSetDefaults(&rgb, decoder->image);
+                    rgb.chromaUpsampling = AVIF_CHROMA_UPSAMPLING_NEAREST;
+                }
+                if (parsed) {
+                    comparison.nextRowIndex = 0;
+                    result = avifDecoderNextImageRGBRows(decoder, &rgb, compareRows, &comparison);
+                    partialRowCount = comparison.nextRowIndex;
+                }
+            }
+            if ((result != AVIF_RESULT_WAITING_ON_IO) || (partialRowCount == 0) || !comparison.matches) {
+                printf("  ERROR: [%s] Decoding %u of %u rows from part of the file returned %s\n",
+                       codecName,
+                       partialRowCount,
+                       referenceRGB.height,
+                       avifResultToString(result));
+                retCode = 1;
+                avifDecoderDestroy(decoder);
+                continue;
+            }
+
+            streamedIO.availableSize = encoded.size;
+            if (rgbRowsAgain) {
+                comparison.nextRowIndex = 0;
+                result = avifDecoderNextImageRGBRows(decoder, &rgb, compareRows, &comparison);
+                comparison.matches = comparison.matches && (comparison.nextRowIndex == referenceRGB.height);
+            } else {
+                result = avifDecoderNextImage(decoder);
+                comparison.matches = (result == AVIF_RESULT_OK) &&
+                                     (maxImageDifference(referenceDecoder->image, decoder->image) == 0);
+            }
+            const avifResult endResult = avifDecoderNextImage(decoder);
+            printf("  [%s, %u rows, then %s] %s\n",
+                   codecName,
+                   partialRowCount,
+                   rgbRowsAgain ? "RGB rows" : "YUV",
+                   avifResultToString(result));
+            if ((result != AVIF_RESULT_OK) || !comparison.matches || (endResult != AVIF_RESULT_NO_IMAGES_REMAINING)) {
+                printf("  ERROR: The image doesn't match the one decoded from memory\n");
+                retCode = 1;
+            }
+            avifDecoderDestroy(decoder);
+        }
+        avifRGBImageFreePixels(&referenceRGB);
+        avifDecoderDestroy(referenceDecoder);
+    }
+
+cleanup:
+    avifRWDataFree(&encoded);
+    avifEncoderDestroy(encoder);
+    avifImageDestroy(image);
+    return retCode;
+}
+
+// ---------------------------------------------------------------------------
+// Peeking at image info
+
+static void printImageInfo(const char * label, const avifImageInfo * info)
+{
+    printf("    %s: %ux%u, %u-bit %s%s, %u image(s), %ux%u grid\n",
+           label,
+           info->width,
+           info->height,
+           info->depth,
+           avifPixelFormatToString(info->yuvFormat),
+           info->alphaPresent ? " with alpha" : "",
+           info->imageCount,
+           info->gridColumns,
+           info->gridRows);
+}
+
+static avifBool imageInfosMatch(const avifImageInfo * info1, const avifImageInfo * info2)
+{
+    return (info1->width == info2->width) && (info1->height == info2->height) && (info1->depth == info2->depth) &&
+           (info1->yuvFormat == info2->yuvFormat) && (info1->alphaPresent == info2->alphaPresent) &&
+           (info1->imageCount == info2->imageCount) && (info1->gridRows == info2->gridRows) &&
+           (info1->gridColumns == info2->gridColumns);
+}
+
+// Parses input with avifDecoderParse() and fills in what avifPeekImageInfo() should report for it.
+// The grid geometry isn't public, so it is given by the caller.
+static avifResult parseImageInfo(const avifROData * input, uint32_t gridRows, uint32_t gridColumns, avifImageInfo * info)
+{
+    avifDecoder * decoder = avifDecoderCreate();
+    avifResult result = avifDecoderSetIOMemory(decoder, input->data, input->size);
+    if (result == AVIF_RESULT_OK) {
+        result = avifDecoderParse(decoder);
+    }
+    if (result == AVIF_RESULT_OK) {
+        memset(info, 0, sizeof(avifImageInfo));
+        info->width = decoder->image->width;
+        info->height = decoder->image->height;
+        info->depth = decoder->image->depth;
+        info->yuvFormat = decoder->image->yuvFormat;
+        info->alphaPresent = decoder->alphaPresent;
+        info->imageCount = (uint32_t)decoder->imageCount;
+        info->gridRows = gridRows;
+        info->gridColumns = gridColumns;
+    }
+    avifDecoderDestroy(decoder);
+    return result;
+}
+
+// Checks avifPeekImageInfo() and avifPeekCompatibleFileType() against avifDecoderParse() for a file
+// and for every prefix of it. Each prefix must either be reported as too short, asking for more
+// bytes than it has (and avifDecoderParse() must not succeed with it either), or give the same info as
+// a parse of the whole file. Following bytesNeeded from an empty prefix must get there in a few reads.
+static int checkPeek(const char * name, const avifROData * input, uint32_t gridRows, uint32_t gridColumns)
+{
+    avifImageInfo expected;
+    avifResult result = parseImageInfo(input, gridRows, gridColumns, &expected);
+    if (result != AVIF_RESULT_OK) {
+        printf("  ERROR: [%s] Parsing failed: %s\n", name, avifResultToString(result));
+        return 1;
+    }
+    avifImageInfo info;
+    result = avifPeekImageInfo(input, &info);
+    printf("  [%s, %zu bytes] %s, needs %zu bytes\n", name, input->size, avifResultToString(result), info.bytesNeeded);
+    if ((result != AVIF_RESULT_OK) || !imageInfosMatch(&info, &expected) || (info.bytesNeeded > input->size) ||
+        !avifPeekCompatibleFileType(input)) {
+        printf("  ERROR: Peeking at the whole file doesn't match a parse\n");
+        printImageInfo("parsed", &expected);
+        printImageInfo("peeked", &info);
+        return 1;
+    }
+    const size_t bytesNeeded = info.bytesNeeded;
+
+    for (size_t size = 0; size < input->size; ++size) {
+        const avifROData prefix = { input->data, size };
+        memset(&info, 0xFF, sizeof(info));
+        result = avifPeekImageInfo(&prefix, &info);
+        avifBool passed;
+        if (result == AVIF_RESULT_TRUNCATED_DATA) {
+            avifImageInfo parsed;
+            passed = (size < bytesNeeded) && (info.bytesNeeded > size) && (info.bytesNeeded <= bytesNeeded) &&
+                     (parseImageInfo(&prefix, gridRows, gridColumns, &parsed) != AVIF_RESULT_OK);
+        } else {
+            passed = (result == AVIF_RESULT_OK) && (size >= bytesNeeded) && imageInfosMatch(&info, &expected) &&
+                     (info.bytesNeeded == bytesNeeded) && avifPeekCompatibleFileType(&prefix);
+        }
+        if (!passed) {
+            printf("  ERROR: Peeking at the first %zu bytes returned %s (needs %zu bytes)\n",
+                   size,
+                   avifResultToString(result),
+                   info.bytesNeeded);
+            return 1;
+        }
+    }
+
+    size_t readCount = 0;
+    info.bytesNeeded = 0;
+    do {
+        const avifROData prefix = { input->data, (info.bytesNeeded < input->size) ? info.bytesNeeded : input->size };
+        result = avifPeekImageInfo(&prefix, &info);
+        ++readCount;
+    } while ((result == AVIF_RESULT_TRUNCATED_DATA) && (readCount < 8));
+    if (result != AVIF_RESULT_OK) {
+        printf("  ERROR: Following bytesNeeded from an empty prefix still returned %s after %zu reads\n",
+               avifResultToString(result),
+               readCount);
+        return 1;
+    }
+    return 0;
+}
+
+static avifBool readFile(const char * filename, avifRWData * output)
+{
+    FILE * f = fopen(filename, "rb");
+    if (!f) {
+        return AVIF_FALSE;
+    }
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    avifBool success = AVIF_FALSE;
+    if (size > 0) {
+        avifRWDataRealloc(output, (size_t)size);
+        success = (fread(output->data, 1, (size_t)size, f) == (size_t)size);
+    }
+    fclose(f);
+    return success;
+}
+
+// Peeks at the files given on the command line (the AVIF files of tests/data) and, if the aom encoder
+// is available, at a grid with alpha and an image sequence with alpha written here.
+static int testPeekImageInfo(int fileCount, char * filenames[])
+{
+    printf("Test: Peeking at image info\n");
+    if (!avifCodecName(AVIF_CODEC_CHOICE_AUTO, AVIF_CODEC_FLAG_CAN_DECODE)) {
+        printf("  Skipped: avifDecoderParse() needs a decoder\n");
+        return 0;
+    }
+
+    int retCode = 0;
+    avifRWData encoded = AVIF_DATA_EMPTY;
+    for (int fileIndex = 0; fileIndex < fileCount; ++fileIndex) {
+        if (!readFile(filenames[fileIndex], &encoded)) {
+            printf("  ERROR: Can't read %s\n", filenames[fileIndex]);
+            retCode = 1;
+            continue;
+        }
+        const avifROData input = { encoded.data, encoded.size };
+        retCode |= checkPeek(filenames[fileIndex], &input, 0, 0);
+    }
+    if (fileCount == 0) {
+        printf("  No files given, only peeking at files written here\n");
+    }
+
+    if (!avifCodecName(AVIF_CODEC_CHOICE_AOM, AVIF_CODEC_FLAG_CAN_ENCODE)) {
+        printf("  Skipped files written here: needs the aom encoder\n");
+        avifRWDataFree(&encoded);
+        return retCode;
+    }
+    for (int sequence = 0; sequence < 2; ++sequence) {
+        // A 3x2 grid of 128x128 cells, or a sequence of 3 frames
+        avifImage * image = createTestImage(sequence ? 64 : 384, sequence ? 48 : 256, 10, AVIF_PIXEL_FORMAT_YUV444, AVIF_TRUE);
+        avifEncoder * encoder = avifEncoderCreate();
+        encoder->codecChoice = AVIF_CODEC_CHOICE_AOM;
+        encoder->speed = AVIF_SPEED_FASTEST;
+        avifResult result = AVIF_RESULT_OK;
+        if (sequence) {
+            for (int frameIndex = 0; (frameIndex < 3) && (result == AVIF_RESULT_OK); ++frameIndex) {
+                result = avifEncoderAddImage(encoder, image, 1, AVIF_ADD_IMAGE_FLAG_NONE);
+            }
+            if (result == AVIF_RESULT_OK) {
+                avifRWDataFree(&encoded);
+                result = avifEncoderFinish(encoder, &encoded);
+            }
+        } else {
+            encoder->gridCellSize = 128;
+            avifRWDataFree(&encoded);
+            result = encodeImage(encoder, image, &encoded);
+        }
+        avifEncoderDestroy(encoder);
+        avifImageDestroy(image);
+        if (result != AVIF_RESULT_OK) {
+            printf("  ERROR: Encoding the %s failed: %s\n", sequence ? "sequence" : "grid", avifResultToString(result));
+            retCode = 1;
+            continue;
+        }
+        const avifROData input = { encoded.data, encoded.size };
+        retCode |= checkPeek(sequence ? "sequence with alpha" : "grid with alpha", &input, sequence ? 0 : 2, sequence ? 0 : 3);
+    }
+    avifRWDataFree(&encoded);
+    return retCode;
+}
+
+// ---------------------------------------------------------------------------
+
+int main(int argc, char * argv[])
+{
+    setbuf(stdout, NULL);
+
+    char codecVersions[256];
+    avifCodecVersions(codecVersions);
+    printf("Codec Versions: %s\n", codecVersions);
+
+    int failedCount = 0;
+    failedCount += testLayeredRoundTrip();
+    failedCount += testIndexRoundTrip();
+    failedCount += testGridCellSizeRoundTrip();
+    failedCount += testImageSetViewRect();
+    failedCount += testGridThreads();
+    failedCount += testGridRGBRowsStreamed();
+    failedCount += testPeekImageInfo(argc - 1, &argv[1]);
+
+    if (failedCount == 0) {
+        printf("avifapitest: Complete.\n");
+        return 0;
+    }
+    printf("avifapitest: %d test(s) failed.\n", failedCount);
+    return 1;
+}
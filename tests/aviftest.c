@@ -373,9 +373,11 @@ static int runIOTests(const char * dataDir)
         avifIOTestReader * io = avifIOCreateTestReader(fileBuffer.data, fileBuffer.size);
         avifDecoderSetIO(decoder, (avifIO *)io);
 
-        for (int pass = 0; pass < 4; ++pass) {
+        for (int pass = 0; pass < 6; ++pass) {
             io->io.persistent = ((pass % 2) == 0);
             decoder->ignoreExif = decoder->ignoreXMP = (pass < 2);
+            // The last two passes decode layered images one layer at a time, from the bytes streamed in so far
+            decoder->allowProgressive = (pass >= 4);
 
             // Slowly pretend to have streamed-in / downloaded more and more bytes
             avifResult parseResult = AVIF_RESULT_UNKNOWN_ERROR;
@@ -388,50 +390,57 @@ static int runIOTests(const char * dataDir)
                     retCode = 1;
                 }
 
-                printf("File: [%s @ %zu / %" PRIu64 " bytes, %s, %s] parse returned: %s\n",
+                printf("File: [%s @ %zu / %" PRIu64 " bytes, %s, %s, %s] parse returned: %s\n",
                        filename,
                        io->availableBytes,
                        io->io.sizeHint,
                        io->io.persistent ? "Persistent" : "NonPersistent",
                        decoder->ignoreExif ? "IgnoreMetadata" : "Metadata",
+                       decoder->allowProgressive ? "Progressive" : "NonProgressive",
                        avifResultToString(parseResult));
                 break;
             }
 
             if (parseResult == AVIF_RESULT_OK) {
-                for (; io->availableBytes <= io->io.sizeHint; ++io->availableBytes) {
-                    avifExtent extent;
-                    avifResult extentResult = avifDecoderNthImageMaxExtent(decoder, 0, &extent);
-                    if (extentResult != AVIF_RESULT_OK) {
-                        retCode = 1;
-
-                        printf("File: [%s @ %zu / %" PRIu64 " bytes, %s, %s] maxExtent returned: %s\n",
-                               filename,
-                               io->availableBytes,
-                               io->io.sizeHint,
-                               io->io.persistent ? "Persistent" : "NonPersistent",
-                               decoder->ignoreExif ? "IgnoreMetadata" : "Metadata",
-                               avifResultToString(extentResult));
-                    } else {
-                        avifResult nextImageResult = avifDecoderNextImage(decoder);
-                        if (nextImageResult == AVIF_RESULT_WAITING_ON_IO) {
-                            continue;
-                        }
-                        if (nextImageResult != AVIF_RESULT_OK) {
+                for (int imageIndex = 0; imageIndex < decoder->imageCount; ++imageIndex) {
+                    for (; io->availableBytes <= io->io.sizeHint; ++io->availableBytes) {
+                        avifExtent extent;
+                        avifResult extentResult = avifDecoderNthImageMaxExtent(decoder, imageIndex, &extent);
+                        if (extentResult != AVIF_RESULT_OK) {
                             retCode = 1;
-                        }
 
-                        printf("File: [%s @ %zu / %" PRIu64 " bytes, %s, %s] nextImage [MaxExtent off %" PRIu64 ", size %zu] returned: %s\n",
-                               filename,
-                               io->availableBytes,
-                               io->io.sizeHint,
-                               io->io.persistent ? "Persistent" : "NonPersistent",
-                               decoder->ignoreExif ? "IgnoreMetadata" : "Metadata",
-                               extent.offset,
-                               extent.size,
-                               avifResultToString(nextImageResult));
+                            printf("File: [%s @ %zu / %" PRIu64 " bytes, %s, %s, %s] maxExtent returned: %s\n",
+                                   filename,
+                                   io->availableBytes,
+                                   io->io.sizeHint,
+                                   io->io.persistent ? "Persistent" : "NonPersistent",
+                                   decoder->ignoreExif ? "IgnoreMetadata" : "Metadata",
+                                   decoder->allowProgressive ? "Progressive" : "NonProgressive",
+                                   avifResultToString(extentResult));
+                        } else {
+                            avifResult nextImageResult = avifDecoderNextImage(decoder);
+                            if (nextImageResult == AVIF_RESULT_WAITING_ON_IO) {
+                                continue;
+                            }
+                            if (nextImageResult != AVIF_RESULT_OK) {
+                                retCode = 1;
+                            }
+
+                            printf("File: [%s @ %zu / %" PRIu64 " bytes, %s, %s, %s] nextImage %d [MaxExtent off %" PRIu64
+                                   ", size %zu] returned: %s\n",
+                                   filename,
+                                   io->availableBytes,
+                                   io->io.sizeHint,
+                                   io->io.persistent ? "Persistent" : "NonPersistent",
+                                   decoder->ignoreExif ? "IgnoreMetadata" : "Metadata",
+                                   decoder->allowProgressive ? "Progressive" : "NonProgressive",
+                                   imageIndex,
+                                   extent.offset,
+                                   extent.size,
+                                   avifResultToString(nextImageResult));
+                        }
+                        break;
                     }
-                    break;
                 }
             }
         }
@@ -74,6 +74,8 @@ int main(int argc, char * argv[])
                 mode = 2;
             } else if (!strcmp(arg, "premultiply")) {
                 mode = 3;
+            } else if (!strcmp(arg, "libyuv")) {
+                mode = 4;
             } else {
                 mode = atoi(arg);
             }
@@ -530,6 +532,144 @@ int main(int argc, char * argv[])
                 }
             }
         }
+    } else if (mode == 4) {
+        // libyuv vs. built-in YUV->RGB conversion test. Every combination below which libyuv can handle goes through
+        // libyuv with AVIF_CHROMA_UPSAMPLING_FASTEST, and through the built-in converter with
+        // AVIF_CHROMA_UPSAMPLING_NEAREST (which libyuv refuses), so both sides replicate chroma the same way.
+        if (avifLibYUVVersion() == 0) {
+            printf("libyuv is unavailable, skipping.\n");
+            return 0;
+        }
+
+        const uint32_t libyuvDepths[2] = { 8, 10 };
+        const avifPixelFormat yuvFormats[4] = { AVIF_PIXEL_FORMAT_YUV444,
+                                                AVIF_PIXEL_FORMAT_YUV422,
+                                                AVIF_PIXEL_FORMAT_YUV420,
+                                                AVIF_PIXEL_FORMAT_YUV400 };
+        const avifMatrixCoefficients matrixCoefficientsList[3] = { AVIF_MATRIX_COEFFICIENTS_BT601,
+                                                                   AVIF_MATRIX_COEFFICIENTS_BT709,
+                                                                   AVIF_MATRIX_COEFFICIENTS_BT2020_NCL };
+        const float matrixKB[3] = { 0.114f, 0.0722f, 0.0593f };
+        const avifRGBFormat rgbFormats[4] = {
+            AVIF_RGB_FORMAT_RGBA, AVIF_RGB_FORMAT_ARGB, AVIF_RGB_FORMAT_BGRA, AVIF_RGB_FORMAT_ABGR
+        };
+
+        // Odd dimensions, so the last subsampled chroma sample only covers one luma sample
+        const uint32_t width = 67;
+        const uint32_t height = 35;
+        int failureCount = 0;
+        for (int depthIndex = 0; depthIndex < 2; ++depthIndex) {
+            const uint32_t yuvDepth = libyuvDepths[depthIndex];
+            for (int formatIndex = 0; formatIndex < 4; ++formatIndex) {
+                for (int rangeIndex = 0; rangeIndex < 2; ++rangeIndex) {
+                    const avifRange range = ranges[rangeIndex];
+                    for (int matrixIndex = 0; matrixIndex < 3; ++matrixIndex) {
+                        // libyuv stores its U->B gain as a signed 8-bit value with 6 fractional bits, capping it at 2.0.
+                        // Limited range BT.709 and BT.2020 need more than that, so saturated blues come out darker
+                        // than with the built-in converter, by up to (gain - 2.0) * 112 codepoints.
+                        float gainUB = 2.0f * (1.0f - matrixKB[matrixIndex]);
+                        if (range == AVIF_RANGE_LIMITED) {
+                            gainUB *= 255.0f / 224.0f;
+                        }
+                        const int allowedDrift = MAX_DRIFT + ((gainUB > 2.0f) ? (int)((gainUB - 2.0f) * 112.0f + 1.0f) : 0);
+
+                        avifImage * image = avifImageCreate(width, height, yuvDepth, yuvFormats[formatIndex]);
+                        image->yuvRange = range;
+                        image->matrixCoefficients = matrixCoefficientsList[matrixIndex];
+                        avifImageAllocatePlanes(image, AVIF_PLANES_YUV);
+
+                        // Fill the planes with in-range pseudo-random samples
+                        avifPixelFormatInfo formatInfo;
+                        avifGetPixelFormatInfo(image->yuvFormat, &formatInfo);
+                        const uint32_t shift = yuvDepth - 8;
+                        uint32_t seed = 1;
+                        for (int c = AVIF_CHAN_Y; c <= AVIF_CHAN_V; ++c) {
+                            if (!image->yuvPlanes[c]) {
+                                continue;
+                            }
+                            const uint32_t shiftX = (c == AVIF_CHAN_Y) ? 0 : (uint32_t)formatInfo.chromaShiftX;
+                            const uint32_t shiftY = (c == AVIF_CHAN_Y) ? 0 : (uint32_t)formatInfo.chromaShiftY;
+                            const uint32_t planeWidth = (width + shiftX) >> shiftX;
+                            const uint32_t planeHeight = (height + shiftY) >> shiftY;
+                            uint32_t minSample = 0;
+                            uint32_t maxSample = (1U << yuvDepth) - 1;
+                            if (range == AVIF_RANGE_LIMITED) {
+                                minSample = 16U << shift;
+                                maxSample = ((c == AVIF_CHAN_Y) ? 235U : 240U) << shift;
+                            }
+                            for (uint32_t j = 0; j < planeHeight; ++j) {
+                                for (uint32_t i = 0; i < planeWidth; ++i) {
+                                    seed = seed * 1103515245 + 12345;
+                                    const uint32_t sample = minSample + ((seed >> 8) % (maxSample - minSample + 1));
+                                    if (yuvDepth > 8) {
+                                        uint16_t * row = (uint16_t *)&image->yuvPlanes[c][j * image->yuvRowBytes[c]];
+                                        row[i] = (uint16_t)sample;
+                                    } else {
+                                        image->yuvPlanes[c][i + j * image->yuvRowBytes[c]] = (uint8_t)sample;
+                                    }
+                                }
+                            }
+                        }
+
+                        for (int rgbFormatIndex = 0; rgbFormatIndex < 4; ++rgbFormatIndex) {
+                            avifRGBImage libyuvRGB;
+                            avifRGBImageSetDefaults(&libyuvRGB, image);
+                            libyuvRGB.format = rgbFormats[rgbFormatIndex];
+                            libyuvRGB.depth = 8;
+                            libyuvRGB.chromaUpsampling = AVIF_CHROMA_UPSAMPLING_FASTEST;
+                            avifRGBImageAllocatePixels(&libyuvRGB);
+
+                            avifRGBImage builtinRGB = libyuvRGB;
+                            builtinRGB.chromaUpsampling = AVIF_CHROMA_UPSAMPLING_NEAREST;
+                            builtinRGB.pixels = NULL;
+                            avifRGBImageAllocatePixels(&builtinRGB);
+
+                            int maxDrift = 0;
+                            if ((avifImageYUVToRGB(image, &libyuvRGB) != AVIF_RESULT_OK) ||
+                                (avifImageYUVToRGB(image, &builtinRGB) != AVIF_RESULT_OK)) {
+                                maxDrift = 256;
+                            } else {
+                                for (uint32_t j = 0; j < height; ++j) {
+                                    const uint8_t * libyuvRow = &libyuvRGB.pixels[j * libyuvRGB.rowBytes];
+                                    const uint8_t * builtinRow = &builtinRGB.pixels[j * builtinRGB.rowBytes];
+                                    for (uint32_t i = 0; i < width * 4; ++i) {
+                                        const int drift = abs((int)libyuvRow[i] - (int)builtinRow[i]);
+                                        if (maxDrift < drift) {
+                                            maxDrift = drift;
+                                        }
+                                    }
+                                }
+                            }
+
+                            const avifBool failed = (maxDrift >= allowedDrift);
+                            if (failed || verbose) {
+                                printf("%s * YUV depth: %d, format: %s, range: %s, matrixCoeffs: %d, RGB format: %s, "
+                                       "maxDrift: %2d (allowed: < %d)\n",
+                                       failed ? "ERROR:" : "",
+                                       yuvDepth,
+                                       avifPixelFormatToString(image->yuvFormat),
+                                       (range == AVIF_RANGE_FULL) ? "Full" : "Limited",
+                                       image->matrixCoefficients,
+                                       rgbFormatToString(libyuvRGB.format),
+                                       maxDrift,
+                                       allowedDrift);
+                            }
+                            if (failed) {
+                                ++failureCount;
+                            }
+
+                            avifRGBImageFreePixels(&libyuvRGB);
+                            avifRGBImageFreePixels(&builtinRGB);
+                        }
+                        avifImageDestroy(image);
+                    }
+                }
+            }
+        }
+        printf(" * libyuv version: %u, conversions with too large a difference: %d\n", avifLibYUVVersion(), failureCount);
+        if (failureCount) {
+            return 1;
+        }
     }
     return 0;
 }
@@ -50,7 +50,7 @@ avifBool compareYUVA(ImageComparison * ic, const avifImage * image1, const avifI
                 }
                 uint8_t A2 = maxChannel;
                 if (image2->alphaPlane) {
-                    A2 = image2->alphaPlane[i + (j * image1->alphaRowBytes)];
+                    A2 = image2->alphaPlane[i + (j * image2->alphaRowBytes)];
                 }
 
                 int aDiff = abs(A1 - A2);
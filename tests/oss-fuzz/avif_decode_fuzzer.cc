@@ -3,6 +3,8 @@
 
 #include "avif/avif.h"
 
+#include <cstdlib>
+
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t * Data, size_t Size)
 {
     static avifRGBFormat rgbFormats[] = { AVIF_RGB_FORMAT_RGB, AVIF_RGB_FORMAT_RGBA };
@@ -17,11 +19,24 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t * Data, size_t Size)
     static uint32_t yuvDepths[] = { 8, 10 };
     static size_t yuvDepthsCount = sizeof(yuvDepths) / sizeof(yuvDepths[0]);
 
+    const avifROData input = { Data, Size };
+    avifImageInfo info;
+    const avifResult peekResult = avifPeekImageInfo(&input, &info);
+    (void)avifPeekCompatibleFileType(&input);
+
     avifDecoder * decoder = avifDecoderCreate();
     avifResult result = avifDecoderSetIOMemory(decoder, Data, Size);
     if (result == AVIF_RESULT_OK) {
         result = avifDecoderParse(decoder);
     }
+    if ((result == AVIF_RESULT_OK) && (peekResult == AVIF_RESULT_OK)) {
+        // Peeking validates far less than parsing, but selects the same items or tracks
+        if ((info.width != decoder->image->width) || (info.height != decoder->image->height) ||
+            (info.depth != decoder->image->depth) || (info.yuvFormat != decoder->image->yuvFormat) ||
+            (info.alphaPresent != decoder->alphaPresent) || (info.imageCount != (uint32_t)decoder->imageCount)) {
+            abort();
+        }
+    }
     if (result == AVIF_RESULT_OK) {
         for (int loop = 0; loop < 2; ++loop) {
             while (avifDecoderNextImage(decoder) == AVIF_RESULT_OK) {